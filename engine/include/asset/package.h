@@ -0,0 +1,116 @@
+#pragma once
+#include <base/mapped_file.h>
+#include <base/result.h>
+#include <base/tasks.h>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace w::asset {
+// Package layout, little endian:
+//   package_header
+//   package_entry[entry_count], sorted by name_hash
+//   blobs, each starting at a multiple of the alignment
+// A compressed blob starts with the uint32_t end offset of every chunk, relative to the end of that table,
+// followed by the chunks. Every chunk but the last holds chunk_size bytes once decompressed,
+// a chunk that did not shrink is stored as is. Chunks decompress independently of each other.
+static_assert(std::endian::native == std::endian::little, "packages are read in place");
+
+enum class compression : uint32_t {
+    none,
+    lz4,
+};
+
+struct package_header {
+    static constexpr uint32_t magic_value = 0x4B415057; // "WPAK"
+    static constexpr uint32_t current_version = 1;
+
+    uint32_t magic = magic_value;
+    uint32_t version = current_version;
+    uint32_t entry_count = 0;
+    uint32_t alignment = 0;
+    uint32_t chunk_size = 0;
+    uint32_t reserved = 0;
+    uint64_t toc_offset = 0;
+};
+static_assert(sizeof(package_header) == 32);
+
+struct package_entry {
+    uint64_t name_hash = 0;
+    uint64_t offset = 0; // from the start of the package
+    uint64_t stored_size = 0;
+    uint64_t size = 0; // once decompressed
+    compression codec = compression::none;
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(package_entry) == 40);
+
+// FNV-1a, names are relative paths with '/' separators, e.g. "textures/stone.dds"
+constexpr uint64_t hash_name(std::string_view name) noexcept
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : name) {
+        hash = (hash ^ uint8_t(c)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Bytes of a loaded asset, either a view into the mapped package or an owned decompressed copy
+struct asset_data {
+    std::unique_ptr<std::byte[]> storage; // empty if bytes point into the package
+    std::span<const std::byte> bytes;
+};
+
+// Package opened through a read-only mapping.
+// Uncompressed blobs are handed out in place, compressed ones are decompressed chunk by chunk on the thread pool.
+class package
+{
+public:
+    package() noexcept = default;
+
+public:
+    // validates the header and the table of contents, blobs are checked when they are loaded
+    static w::result<package> open(const std::filesystem::path& path) noexcept;
+
+    std::span<const package_entry> entries() const noexcept
+    {
+        return toc;
+    }
+    uint32_t chunk_size() const noexcept
+    {
+        return header.chunk_size;
+    }
+    // binary search over the sorted table, nullptr if there is no such asset
+    const package_entry* find(uint64_t name_hash) const noexcept;
+    const package_entry* find(std::string_view name) const noexcept
+    {
+        return find(hash_name(name));
+    }
+
+    // The stored blob, the asset itself for uncompressed entries, without copying
+    std::span<const std::byte> stored_bytes(const package_entry& entry) const noexcept
+    {
+        return file.bytes().subspan(entry.offset, entry.stored_size);
+    }
+    // The asset in place, empty if the entry is compressed
+    std::span<const std::byte> view(const package_entry& entry) const noexcept
+    {
+        return entry.codec == compression::none ? stored_bytes(entry) : std::span<const std::byte>{};
+    }
+
+    // Loads the asset, chunks of compressed assets are decompressed in parallel.
+    // The package has to stay alive while the task runs and as long as a view is used.
+    w::task<w::result<asset_data>> load_async(const package_entry& entry) const;
+    // decompresses a single chunk, false if the data is corrupted
+    bool decompress_chunk(const package_entry& entry, size_t chunk, std::span<std::byte> out) const noexcept;
+
+private:
+    base::mapped_file file;
+    package_header header;
+    std::span<const package_entry> toc; // points into the mapping
+};
+} // namespace w::asset
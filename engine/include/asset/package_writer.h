@@ -0,0 +1,54 @@
+#pragma once
+#include <asset/package.h>
+#include <base/result.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace w::asset {
+// Builds a package, see package.h for the layout.
+// Assets are collected first and streamed to the file one by one on write.
+class package_writer
+{
+public:
+    static constexpr uint32_t default_alignment = 64;
+    static constexpr uint32_t default_chunk_size = 256 << 10;
+
+public:
+    // alignment is rounded up to a power of two
+    explicit package_writer(uint32_t alignment = default_alignment, uint32_t chunk_size = default_chunk_size) noexcept;
+
+public:
+    // copies the data, fails if the name hash is taken already
+    w::error_message add(std::string_view name, std::span<const std::byte> data, compression codec = compression::none);
+    // the file is read on write
+    w::error_message add_file(std::string_view name, std::filesystem::path source, compression codec = compression::none);
+    // Adds every regular file below the directory, named by its relative path
+    w::error_message add_directory(const std::filesystem::path& directory, compression codec = compression::none);
+
+    // Compressed assets that do not shrink are stored uncompressed
+    w::error_message write(const std::filesystem::path& path) const;
+
+    size_t size() const noexcept
+    {
+        return pending.size();
+    }
+
+private:
+    struct pending_asset {
+        uint64_t name_hash;
+        std::vector<std::byte> data; // empty if read from source
+        std::filesystem::path source;
+        compression codec;
+    };
+    w::error_message add(pending_asset asset);
+
+private:
+    uint32_t alignment;
+    uint32_t chunk_size;
+    std::vector<pending_asset> pending;
+};
+} // namespace w::asset
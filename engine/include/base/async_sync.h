@@ -0,0 +1,447 @@
+#pragma once
+#include <base/await.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+
+namespace w {
+namespace detail {
+// Intrusive node of a waiter list, lives in the awaiter inside the suspended coroutine frame
+struct async_waiter {
+    std::coroutine_handle<> handle;
+    async_waiter* next = nullptr;
+};
+
+// Waiters are pushed in LIFO order, resumed in FIFO order
+inline async_waiter* reverse_waiters(async_waiter* list) noexcept
+{
+    async_waiter* reversed = nullptr;
+    while (list) {
+        auto* next = list->next;
+        list->next = reversed;
+        reversed = list;
+        list = next;
+    }
+    return reversed;
+}
+
+// Queues the whole chain on the pool, a bulk submission per batch
+inline void resume_waiters(async_waiter* list) noexcept
+{
+    std::array<std::coroutine_handle<>, 32> batch;
+    size_t count = 0;
+    while (list) {
+        auto* next = list->next; // the node is gone once its coroutine runs
+        batch[count++] = list->handle;
+        list = next;
+        if (count == batch.size() || !list) {
+            detail::resume_background(std::span{ batch }.first(count));
+            count = 0;
+        }
+    }
+}
+
+// Waiters of a counting primitive.
+// Waiters push themselves onto a lock-free stack. Wakeups are counted, and the thread that raises
+// the count from zero drains them, moving the stack into a FIFO list only it touches.
+// A waiter is always pushed before it is counted as waiting, so a counted wakeup always finds one.
+class waiter_queue
+{
+public:
+    // the waiter may be resumed by a concurrent wake as soon as this returns
+    void push(async_waiter* waiter) noexcept
+    {
+        auto* head = pushed.load(std::memory_order::relaxed);
+        do {
+            waiter->next = head;
+        } while (!pushed.compare_exchange_weak(head, waiter, std::memory_order::release, std::memory_order::relaxed));
+    }
+    void wake(size_t count) noexcept
+    {
+        if (pending.fetch_add(count, std::memory_order::acq_rel) != 0) {
+            return; // the active drainer picks them up
+        }
+        do {
+            async_waiter* woken = nullptr;
+            async_waiter** tail = &woken;
+            for (size_t i = 0; i < count; ++i) {
+                if (!ready) {
+                    ready = reverse_waiters(pushed.exchange(nullptr, std::memory_order::acquire));
+                }
+                *tail = std::exchange(ready, ready->next);
+                tail = &(*tail)->next;
+            }
+            *tail = nullptr;
+            resume_waiters(woken);
+            count = pending.fetch_sub(count, std::memory_order::acq_rel) - count;
+        } while (count != 0);
+    }
+
+private:
+    std::atomic<async_waiter*> pushed{ nullptr };
+    std::atomic<size_t> pending{ 0 };
+    async_waiter* ready = nullptr; // owned by the drainer
+};
+} // namespace detail
+
+class async_mutex;
+
+/// @brief Owns a locked async_mutex, unlocks it on destruction
+class [[nodiscard]] async_lock_guard
+{
+public:
+    explicit async_lock_guard(async_mutex& mutex) noexcept
+        : mutex(&mutex)
+    {
+    }
+    async_lock_guard(async_lock_guard&& other) noexcept
+        : mutex(std::exchange(other.mutex, nullptr))
+    {
+    }
+    async_lock_guard& operator=(async_lock_guard&& other) noexcept;
+    ~async_lock_guard() noexcept;
+
+private:
+    async_mutex* mutex;
+};
+
+/// @brief Mutex for coroutines, waiting suspends the coroutine instead of blocking the worker
+/// Unlocking hands the lock directly to the oldest waiter, which is resumed on the thread pool.
+/// The state is a single word: unlocked, locked, or locked with the head of a stack of new waiters.
+class async_mutex
+{
+    static constexpr uintptr_t not_locked = 1;
+    static constexpr uintptr_t locked_no_waiters = 0;
+
+    struct lock_awaitable : detail::async_waiter {
+        async_mutex& mutex;
+
+    public:
+        explicit lock_awaitable(async_mutex& mutex) noexcept
+            : mutex(mutex)
+        {
+        }
+
+    public:
+        bool await_ready() noexcept
+        {
+            return mutex.try_lock();
+        }
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle = awaiting;
+            auto old = mutex.state.load(std::memory_order::relaxed);
+            while (true) {
+                if (old == not_locked) {
+                    if (mutex.state.compare_exchange_weak(old, locked_no_waiters, std::memory_order::acquire, std::memory_order::relaxed)) {
+                        return false; // unlocked in the meantime, continue with the lock held
+                    }
+                } else {
+                    next = reinterpret_cast<detail::async_waiter*>(old);
+                    if (mutex.state.compare_exchange_weak(old, reinterpret_cast<uintptr_t>(this), std::memory_order::release, std::memory_order::relaxed)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    struct scoped_lock_awaitable : lock_awaitable {
+        using lock_awaitable::lock_awaitable;
+        async_lock_guard await_resume() const noexcept
+        {
+            return async_lock_guard{ mutex };
+        }
+    };
+
+public:
+    async_mutex() noexcept = default;
+    async_mutex(const async_mutex&) = delete;
+    async_mutex& operator=(const async_mutex&) = delete;
+
+public:
+    bool try_lock() noexcept
+    {
+        auto expected = not_locked;
+        return state.compare_exchange_strong(expected, locked_no_waiters, std::memory_order::acquire, std::memory_order::relaxed);
+    }
+    /// @brief Acquires the lock, has to be released with unlock()
+    [[nodiscard]] auto lock() noexcept
+    {
+        return lock_awaitable{ *this };
+    }
+    /// @brief Acquires the lock
+    /// @return Awaitable that yields a guard releasing the lock
+    [[nodiscard]] auto scoped_lock() noexcept
+    {
+        return scoped_lock_awaitable{ *this };
+    }
+    void unlock() noexcept
+    {
+        auto* head = waiters;
+        if (!head) {
+            auto expected = locked_no_waiters;
+            if (state.compare_exchange_strong(expected, not_locked, std::memory_order::release, std::memory_order::relaxed)) {
+                return;
+            }
+            // new waiters arrived, move them into the FIFO list of the lock holder
+            head = detail::reverse_waiters(reinterpret_cast<detail::async_waiter*>(state.exchange(locked_no_waiters, std::memory_order::acquire)));
+        }
+        waiters = head->next;
+        detail::resume_background(head->handle); // still locked, the lock passes to the waiter
+    }
+
+private:
+    std::atomic<uintptr_t> state{ not_locked };
+    detail::async_waiter* waiters = nullptr; // owned by the lock holder
+};
+
+inline async_lock_guard& async_lock_guard::operator=(async_lock_guard&& other) noexcept
+{
+    if (this != &other) {
+        if (mutex) {
+            mutex->unlock();
+        }
+        mutex = std::exchange(other.mutex, nullptr);
+    }
+    return *this;
+}
+
+inline async_lock_guard::~async_lock_guard() noexcept
+{
+    if (mutex) {
+        mutex->unlock();
+    }
+}
+
+/// @brief Counting semaphore for coroutines, e.g. to limit concurrent device calls
+/// The count goes negative by the number of suspended waiters, releases wake them in FIFO order.
+class async_semaphore
+{
+    struct acquire_awaitable : detail::async_waiter {
+        async_semaphore& semaphore;
+
+    public:
+        explicit acquire_awaitable(async_semaphore& semaphore) noexcept
+            : semaphore(semaphore)
+        {
+        }
+
+    public:
+        bool await_ready() noexcept
+        {
+            return semaphore.try_acquire();
+        }
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            auto& owner = semaphore; // this may be resumed and gone right after the push
+            handle = awaiting;
+            owner.waiters.push(this);
+            if (owner.count.fetch_sub(1, std::memory_order::acq_rel) > 0) {
+                owner.waiters.wake(1); // a permit arrived before the count was taken, resume a waiter
+            }
+            return true;
+        }
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+public:
+    /// @param initial Permits available at the start
+    /// @param max Upper bound of the permits, release() beyond it is ignored
+    explicit async_semaphore(int64_t initial, int64_t max = std::numeric_limits<int64_t>::max()) noexcept
+        : count(initial)
+        , max(max)
+    {
+    }
+    async_semaphore(const async_semaphore&) = delete;
+    async_semaphore& operator=(const async_semaphore&) = delete;
+
+public:
+    bool try_acquire() noexcept
+    {
+        auto current = count.load(std::memory_order::relaxed);
+        while (current > 0) {
+            if (count.compare_exchange_weak(current, current - 1, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    [[nodiscard]] auto acquire() noexcept
+    {
+        return acquire_awaitable{ *this };
+    }
+    void release(int64_t permits = 1) noexcept
+    {
+        auto current = count.load(std::memory_order::relaxed);
+        int64_t added;
+        do {
+            // current is negative while coroutines wait, max - current would overflow
+            added = current >= max ? 0 : std::min(permits, max - std::max<int64_t>(current, 0));
+            if (added <= 0) {
+                return;
+            }
+        } while (!count.compare_exchange_weak(current, current + added, std::memory_order::acq_rel, std::memory_order::relaxed));
+
+        if (current < 0) {
+            waiters.wake(size_t(std::min(added, -current)));
+        }
+    }
+    /// @brief Permits available, negative while coroutines are waiting
+    int64_t available() const noexcept
+    {
+        return count.load(std::memory_order::relaxed);
+    }
+
+private:
+    std::atomic<int64_t> count;
+    int64_t max;
+    detail::waiter_queue waiters;
+};
+
+/// @brief Event that stays set until reset, set() resumes all waiters at once
+class async_event
+{
+    static constexpr uintptr_t not_set = 0;
+    static constexpr uintptr_t is_set_state = 1;
+
+    struct wait_awaitable : detail::async_waiter {
+        async_event& event;
+
+    public:
+        explicit wait_awaitable(async_event& event) noexcept
+            : event(event)
+        {
+        }
+
+    public:
+        bool await_ready() const noexcept
+        {
+            return event.is_set();
+        }
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle = awaiting;
+            auto old = event.state.load(std::memory_order::acquire);
+            do {
+                if (old == is_set_state) {
+                    return false;
+                }
+                next = reinterpret_cast<detail::async_waiter*>(old);
+            } while (!event.state.compare_exchange_weak(old, reinterpret_cast<uintptr_t>(this), std::memory_order::release, std::memory_order::acquire));
+            return true;
+        }
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+public:
+    explicit async_event(bool initially_set = false) noexcept
+        : state(initially_set ? is_set_state : not_set)
+    {
+    }
+    async_event(const async_event&) = delete;
+    async_event& operator=(const async_event&) = delete;
+
+public:
+    bool is_set() const noexcept
+    {
+        return state.load(std::memory_order::acquire) == is_set_state;
+    }
+    void set() noexcept
+    {
+        auto old = state.exchange(is_set_state, std::memory_order::acq_rel);
+        if (old != is_set_state) {
+            detail::resume_waiters(detail::reverse_waiters(reinterpret_cast<detail::async_waiter*>(old)));
+        }
+    }
+    // waiters that are already queued still run
+    void reset() noexcept
+    {
+        auto expected = is_set_state;
+        state.compare_exchange_strong(expected, not_set, std::memory_order::relaxed);
+    }
+    [[nodiscard]] auto wait() noexcept
+    {
+        return wait_awaitable{ *this };
+    }
+
+private:
+    std::atomic<uintptr_t> state;
+};
+
+/// @brief Event that releases a single waiter per set() and resets itself
+/// Setting it while it is set already has no effect, like a semaphore with a single permit.
+class async_auto_reset_event
+{
+public:
+    explicit async_auto_reset_event(bool initially_set = false) noexcept
+        : permit(initially_set ? 1 : 0, 1)
+    {
+    }
+
+public:
+    bool is_set() const noexcept
+    {
+        return permit.available() > 0;
+    }
+    void set() noexcept
+    {
+        permit.release();
+    }
+    void reset() noexcept
+    {
+        (void)permit.try_acquire();
+    }
+    [[nodiscard]] auto wait() noexcept
+    {
+        return permit.acquire();
+    }
+
+private:
+    async_semaphore permit;
+};
+
+/// @brief Single use countdown, waiters are resumed once it reaches zero
+class async_latch
+{
+public:
+    explicit async_latch(ptrdiff_t count) noexcept
+        : count(count)
+        , ready(count <= 0)
+    {
+    }
+
+public:
+    void count_down(ptrdiff_t n = 1) noexcept
+    {
+        if (count.fetch_sub(n, std::memory_order::acq_rel) <= n) {
+            ready.set();
+        }
+    }
+    bool try_wait() const noexcept
+    {
+        return ready.is_set();
+    }
+    [[nodiscard]] auto wait() noexcept
+    {
+        return ready.wait();
+    }
+
+private:
+    std::atomic<ptrdiff_t> count;
+    async_event ready;
+};
+} // namespace w
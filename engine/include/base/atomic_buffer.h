@@ -1,7 +1,10 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <bit>
+#include <memory>
 #include <new>
+#include <utility>
 
 namespace w::base {
 namespace detail {
@@ -48,9 +51,177 @@ public:
 
     static constexpr std::size_t capacity() noexcept { return Capacity; }
     static constexpr bool can_grow() noexcept { return false; }
-    void grow(std::size_t, std::size_t) noexcept { }
+    bool grow(std::size_t, std::size_t) noexcept { return false; }
+
+    // fixed storage is never retired, so readers need no protection
+    struct read_guard {
+    };
+    [[nodiscard]] read_guard enter_read() const noexcept { return {}; }
+    void reclaim() noexcept { }
 
 private:
     std::atomic<T> _items[Capacity];
 };
+
+// Fixed ring buffer with the capacity chosen at construction, rounded up to a power of two.
+template<class T>
+    requires std::atomic<T>::is_always_lock_free
+struct runtime_atomic_buffer {
+    static constexpr T nullval = {};
+
+public:
+    explicit runtime_atomic_buffer(std::size_t capacity) noexcept
+        : _mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+        , _items(new (std::nothrow) std::atomic<T>[_mask + 1]())
+    {
+    }
+
+public:
+    T get_unchecked(std::size_t idx, std::memory_order order) const noexcept { return _items[idx & _mask].load(order); }
+    T get(std::size_t idx, std::memory_order order) noexcept { return _items[idx & _mask].exchange(nullval, std::memory_order::relaxed); }
+    void put_unchecked(std::size_t idx, T value, std::memory_order order) noexcept { _items[idx & _mask].store(value, order); }
+    bool try_put(std::size_t idx, T value, std::memory_order order) noexcept
+    {
+        auto xn = nullval;
+        return _items[idx & _mask].compare_exchange_strong(xn, value, order, std::memory_order::relaxed);
+    }
+
+    // 0 if the allocation failed, every push fails then
+    std::size_t capacity() const noexcept { return _items ? _mask + 1 : 0; }
+    static constexpr bool can_grow() noexcept { return false; }
+    bool grow(std::size_t, std::size_t) noexcept { return false; }
+
+    struct read_guard {
+    };
+    [[nodiscard]] read_guard enter_read() const noexcept { return {}; }
+    void reclaim() noexcept { }
+
+private:
+    std::size_t _mask;
+    std::unique_ptr<std::atomic<T>[]> _items;
+};
+
+// Chase-Lev growable ring buffer.
+// Only the owner thread may put, grow and reclaim; any thread may read under a read_guard.
+// Retired rings are kept alive until no reader is inside a guard, then released by the owner.
+template<class T, std::size_t InitialCapacity = 256>
+    requires((InitialCapacity & (InitialCapacity - 1)) == 0 && std::atomic<T>::is_always_lock_free) // capacity has to be a power of two
+struct growable_atomic_buffer {
+    static constexpr T nullval = {};
+
+private:
+    struct ring {
+        std::size_t mask;
+        std::atomic<T>* items;
+        ring* retired; // previous ring, owned by this one
+
+        ~ring() noexcept
+        {
+            delete[] items;
+            delete retired;
+        }
+        static ring* create(std::size_t capacity, ring* retired = nullptr) noexcept
+        {
+            auto* items = new (std::nothrow) std::atomic<T>[capacity]();
+            if (!items) {
+                return nullptr;
+            }
+            auto* r = new (std::nothrow) ring{ capacity - 1, items, retired };
+            if (!r) {
+                delete[] items;
+            }
+            return r;
+        }
+    };
+
+public:
+    growable_atomic_buffer() noexcept
+        : _current(ring::create(InitialCapacity))
+    {
+    }
+    // initial capacity is rounded up to a power of two
+    explicit growable_atomic_buffer(std::size_t initial_capacity) noexcept
+        : _current(ring::create(std::bit_ceil(std::max<std::size_t>(initial_capacity, 2))))
+    {
+    }
+    growable_atomic_buffer(const growable_atomic_buffer&) = delete;
+    growable_atomic_buffer& operator=(const growable_atomic_buffer&) = delete;
+    ~growable_atomic_buffer() noexcept
+    {
+        delete _current.load(std::memory_order::relaxed);
+    }
+
+public:
+    T get_unchecked(std::size_t idx, std::memory_order order) const noexcept
+    {
+        auto* r = _current.load(std::memory_order::seq_cst); // pairs with grow and reclaim
+        return r->items[idx & r->mask].load(order);
+    }
+    void put_unchecked(std::size_t idx, T value, std::memory_order order) noexcept
+    {
+        auto* r = _current.load(std::memory_order::relaxed); // only the owner replaces the ring
+        r->items[idx & r->mask].store(value, order);
+    }
+
+    // 0 if the initial allocation failed, every push fails then
+    std::size_t capacity() const noexcept
+    {
+        auto* r = _current.load(std::memory_order::relaxed);
+        return r ? r->mask + 1 : 0;
+    }
+    static constexpr bool can_grow() noexcept { return true; }
+
+    // copies live range [top, bottom) into a ring of twice the size, old ring is retired
+    // returns false only if the allocation failed
+    bool grow(std::size_t bottom, std::size_t top) noexcept
+    {
+        auto* old = _current.load(std::memory_order::relaxed);
+        if (!old) {
+            return false;
+        }
+        reclaim();
+
+        auto* next = ring::create((old->mask + 1) * 2, old);
+        if (!next) {
+            return false;
+        }
+        for (std::size_t i = top; i != bottom; ++i) {
+            next->items[i & next->mask].store(old->items[i & old->mask].load(std::memory_order::relaxed), std::memory_order::relaxed);
+        }
+        _current.store(next, std::memory_order::seq_cst);
+        return true;
+    }
+
+    struct read_guard {
+        explicit read_guard(std::atomic<std::size_t>& readers) noexcept
+            : readers(readers)
+        {
+            readers.fetch_add(1, std::memory_order::seq_cst);
+        }
+        read_guard(const read_guard&) = delete;
+        read_guard& operator=(const read_guard&) = delete;
+        ~read_guard() noexcept
+        {
+            readers.fetch_sub(1, std::memory_order::release);
+        }
+
+    private:
+        std::atomic<std::size_t>& readers;
+    };
+    [[nodiscard]] read_guard enter_read() const noexcept { return read_guard{ _readers }; }
+
+    // Frees retired rings if no reader is active.
+    // A reader that enters after the check observes the current ring, since the ring was published before.
+    void reclaim() noexcept
+    {
+        auto* r = _current.load(std::memory_order::relaxed);
+        if (r && r->retired && _readers.load(std::memory_order::seq_cst) == 0) {
+            delete std::exchange(r->retired, nullptr);
+        }
+    }
+
+private:
+    std::atomic<ring*> _current;
+    alignas(std::hardware_destructive_interference_size) mutable std::atomic<std::size_t> _readers{ 0 };
+};
 } // namespace w::base
\ No newline at end of file
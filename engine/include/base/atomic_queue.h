@@ -1,14 +1,15 @@
 #pragma once
 #include <base/atomic_buffer.h>
+#include <concepts>
 #include <optional>
 
 namespace w::base {
 
 // MPSC queue
-template<class T, size_t buffer_size>
+template<class T, size_t buffer_size, class Container = w::base::atomic_buffer<T, buffer_size>>
 struct atomic_queue {
     using value_type = T;
-    using container = w::base::atomic_buffer<T, buffer_size>;
+    using container = Container;
 
     // could have used concepts, but this is more readable
     static_assert(buffer_size > 0 && (buffer_size & (buffer_size - 1)) == 0, "buffer_size must be a power of two");
@@ -16,6 +17,12 @@ struct atomic_queue {
 
 public:
     atomic_queue() = default;
+    // for containers sized at runtime
+    explicit atomic_queue(std::size_t capacity) noexcept
+        requires std::constructible_from<Container, std::size_t>
+        : _items(capacity)
+    {
+    }
 
 public:
     [[nodiscard]] bool try_push(value_type item) noexcept;
@@ -33,9 +40,13 @@ private:
     container _items;
 };
 
+// MPSC queue with the capacity chosen at construction
+template<class T>
+using runtime_atomic_queue = atomic_queue<T, 1, w::base::runtime_atomic_buffer<T>>;
+
 // push may be called from only a single thread, so it can use relaxed synchronization
-template<class T, size_t buffer_size>
-bool atomic_queue<T, buffer_size>::try_push(value_type item) noexcept
+template<class T, size_t buffer_size, class Container>
+bool atomic_queue<T, buffer_size, Container>::try_push(value_type item) noexcept
 {
     std::size_t b;
     do {
@@ -52,11 +63,11 @@ bool atomic_queue<T, buffer_size>::try_push(value_type item) noexcept
 
 // pop is only called from a single thread.
 // edge case: steal vs pop, don't care if nullval is returned
-template<class T, size_t buffer_size>
-std::optional<typename atomic_queue<T, buffer_size>::value_type>
-atomic_queue<T, buffer_size>::try_pop() noexcept
+template<class T, size_t buffer_size, class Container>
+std::optional<typename atomic_queue<T, buffer_size, Container>::value_type>
+atomic_queue<T, buffer_size, Container>::try_pop() noexcept
 {
-    auto b = _bottom.load(std::memory_order_relaxed);
+    auto b = _bottom.load(std::memory_order_acquire); // pairs with the release in try_push, the item is visible
     auto t = _top.load(std::memory_order_relaxed);
     if (b == t) {
         return std::nullopt;
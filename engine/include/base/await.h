@@ -1,22 +1,99 @@
 #pragma once
 #include <base/await_traits.h>
+#include <base/cancellation.h>
+#include <base/priority.h>
+#include <base/timer_wheel.h>
+#include <atomic>
+#include <cassert>
+#include <chrono>
 #include <coroutine>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
 #include <utility>
 
 namespace w {
 namespace detail {
 /// @brief Resumes the coroutine on the background thread pool
 /// @param handle Coroutine handle to resume
-void resume_background(std::coroutine_handle<> handle) noexcept;
-void resume_affine(std::coroutine_handle<> handle, size_t thread_index) noexcept;
+/// @param lane Priority lane of the coroutine
+void resume_background(std::coroutine_handle<> handle, priority lane = priority::normal) noexcept;
+/// @brief Resumes the coroutine on the current worker ahead of queued work once the deadline is reached
+/// @param handle Coroutine handle to resume
+/// @param deadline Latest time the coroutine should start
+void resume_background(std::coroutine_handle<> handle, std::chrono::steady_clock::time_point deadline) noexcept;
+/// @brief Resumes all coroutines on the background thread pool with a single submission
+/// @param handles Coroutine handles to resume
+/// @param lane Priority lane of the coroutines
+void resume_background(std::span<const std::coroutine_handle<>> handles, priority lane = priority::normal) noexcept;
+/// @brief Queues the coroutine on a worker configured as affine
+/// @return false if the worker has no affine queue
+bool resume_affine(std::coroutine_handle<> handle, size_t thread_index) noexcept;
+/// @brief Resumes the coroutine of the timer on the thread pool once its deadline passed
+/// @param timer Timer with the deadline and the handle, has to stay alive until it is resumed
+void resume_at(base::timer_node* timer) noexcept;
+bool cancel_timer(base::timer_node* timer) noexcept;
 size_t current() noexcept;
 } // namespace detail
 
+namespace detail {
+// Hop to the pool that reports cancellation.
+// Inside a task or action the token of the coroutine is inherited, unless one was given explicitly.
+struct background_awaitable {
+    bool await_ready() const noexcept
+    {
+        return token.is_cancelled(); // no point in queueing work that is going to return early
+    }
+
+    /// @return False if the work was cancelled, the caller is expected to return early
+    bool await_resume() const noexcept
+    {
+        return !token.is_cancelled();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        detail::resume_background(handle, lane);
+    }
+
+    void inherit_cancellation(const cancellation_token& parent) noexcept
+    {
+        if (!token.can_be_cancelled()) {
+            token = parent;
+        }
+    }
+
+    priority lane;
+    cancellation_token token{};
+};
+} // namespace detail
+
 /// @brief Resumes the coroutine on the background thread pool
 /// Current coroutine execution will be suspended and resumed on the background thread pool
 /// Suspension means that the control will be returned to the caller, and the coroutine will be resumed later
+/// @param lane Priority lane, higher lanes are drained and stolen first
+/// @return Awaitable object, yields false if the cancellation token of the awaiting coroutine was cancelled
+[[nodiscard]] inline auto resume_background(priority lane = priority::normal) noexcept
+{
+    return detail::background_awaitable{ lane };
+}
+
+/// @brief Resumes the coroutine on the background thread pool unless the token is cancelled
+/// Does not suspend at all if the token is cancelled already
+/// @param token Token checked before queueing and after resuming
+/// @param lane Priority lane, higher lanes are drained and stolen first
+/// @return Awaitable object, yields false if the token was cancelled
+[[nodiscard]] inline auto resume_background(cancellation_token token, priority lane = priority::normal) noexcept
+{
+    return detail::background_awaitable{ lane, std::move(token) };
+}
+
+/// @brief Resumes the coroutine on the current worker before the deadline
+/// Once the deadline is reached, the coroutine preempts the queued work of the worker
+/// @param deadline Latest time the coroutine should start
 /// @return Awaitable object
-[[nodiscard]] inline auto resume_background() noexcept
+[[nodiscard]] inline auto resume_background(std::chrono::steady_clock::time_point deadline) noexcept
 {
     struct awaitable {
         bool await_ready() const noexcept
@@ -30,13 +107,91 @@ size_t current() noexcept;
 
         void await_suspend(std::coroutine_handle<> handle) const
         {
-            detail::resume_background(handle);
+            detail::resume_background(handle, deadline);
+        }
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    return awaitable{ deadline };
+}
+
+namespace detail {
+// Suspends on the timer wheel of the pool, the timer lives in the awaiter inside the suspended frame.
+// A cancellable token registers a stop callback that takes the timer out of the wheel and resumes the coroutine early.
+struct timer_awaitable : base::timer_node {
+    struct canceller {
+        timer_awaitable* timer;
+
+        void operator()() const noexcept
+        {
+            if (detail::cancel_timer(timer)) {
+                detail::resume_background(timer->handle); // the wheel lost the node, nobody else resumes it
+            }
         }
     };
 
-    return awaitable{};
+    bool await_ready() const noexcept
+    {
+        return token.is_cancelled() || deadline <= std::chrono::steady_clock::now();
+    }
+
+    /// @return False if the work was cancelled, the caller is expected to return early
+    bool await_resume() const noexcept
+    {
+        // resumed before await_suspend registered the callback, the awaiter has to stay until it let go
+        while (suspending.load(std::memory_order::acquire)) {
+            std::this_thread::yield();
+        }
+        return !token.is_cancelled();
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle = awaiting;
+        suspending.store(true, std::memory_order::relaxed); // published with the node
+        detail::resume_at(this);
+        if (token.can_be_cancelled()) {
+            on_cancel.emplace(token.get_stop_token(), canceller{ this }); // runs right here if cancelled meanwhile
+        }
+        suspending.store(false, std::memory_order::release);
+    }
+
+    void inherit_cancellation(const cancellation_token& parent) noexcept
+    {
+        if (!token.can_be_cancelled()) {
+            token = parent;
+        }
+    }
+
+    cancellation_token token{};
+    std::optional<std::stop_callback<canceller>> on_cancel{};
+    std::atomic<bool> suspending{ false };
+};
+} // namespace detail
+
+/// @brief Suspends the coroutine until the time point, without blocking a worker
+/// The coroutine is resumed on the thread pool, by the worker that services the timers,
+/// or right away by the thread that cancels its token.
+/// @param time Time point to resume at, a time point in the past continues right away
+/// @return Awaitable object, yields false if the cancellation token of the awaiting coroutine was cancelled
+[[nodiscard]] inline auto resume_at(std::chrono::steady_clock::time_point time) noexcept
+{
+    return detail::timer_awaitable{ { .deadline = time } };
 }
 
+/// @brief Suspends the coroutine for the duration, see resume_at
+/// @param duration Time to sleep
+/// @return Awaitable object, yields false if the cancellation token of the awaiting coroutine was cancelled
+[[nodiscard]] inline auto sleep_for(std::chrono::steady_clock::duration duration) noexcept
+{
+    return resume_at(std::chrono::steady_clock::now() + duration);
+}
+
+/// @brief Resumes the coroutine on the given worker
+/// The worker must be listed in thread_pool_config::affine_workers.
+/// Any other index asserts, release builds continue on the current thread
+/// @param thread_index Index of the worker
+/// @return Awaitable object
 [[nodiscard]] inline auto resume_affine(size_t thread_index) noexcept
 {
     struct awaitable {
@@ -49,9 +204,11 @@ size_t current() noexcept;
         {
         }
 
-        void await_suspend(std::coroutine_handle<> handle) const
+        bool await_suspend(std::coroutine_handle<> handle) const
         {
-            detail::resume_affine(handle, thread_index);
+            bool queued = detail::resume_affine(handle, thread_index);
+            assert(queued && "worker is not affine");
+            return queued;
         }
         size_t thread_index;
     };
@@ -0,0 +1,78 @@
+#pragma once
+#include <stop_token>
+#include <utility>
+
+namespace w {
+/// @brief Observes a cancellation_source
+/// Cancellation is cooperative, the holder checks the token at its suspension points and returns early.
+/// A default constructed token is never cancelled.
+class cancellation_token
+{
+public:
+    cancellation_token() noexcept = default;
+    explicit cancellation_token(std::stop_token token) noexcept
+        : token(std::move(token))
+    {
+    }
+
+public:
+    bool is_cancelled() const noexcept
+    {
+        return token.stop_requested();
+    }
+    /// @brief False for a default constructed token, or once every source is gone without cancelling
+    bool can_be_cancelled() const noexcept
+    {
+        return token.stop_possible();
+    }
+    const std::stop_token& get_stop_token() const noexcept
+    {
+        return token;
+    }
+
+private:
+    std::stop_token token;
+};
+
+/// @brief Owner side of a cancellation, hands out tokens and cancels all of them at once
+class cancellation_source
+{
+public:
+    cancellation_source() = default;
+
+public:
+    cancellation_token get_token() const noexcept
+    {
+        return cancellation_token{ source.get_token() };
+    }
+    /// @brief Cancels all tokens of this source
+    /// @return False if it was cancelled before
+    bool cancel() noexcept
+    {
+        return source.request_stop();
+    }
+    bool is_cancelled() const noexcept
+    {
+        return source.stop_requested();
+    }
+    /// @brief Shares the state, e.g. to let when_any cancel the losers through this source
+    operator std::stop_source() const noexcept
+    {
+        return source;
+    }
+
+private:
+    std::stop_source source;
+};
+
+/// @brief Awaited inside a task or action, yields the cancellation token of the coroutine
+struct get_cancellation_token_t {
+};
+
+/// @brief Returns the tag that yields the token of the awaiting coroutine
+/// Usage: auto token = co_await w::get_cancellation_token();
+[[nodiscard]] inline constexpr get_cancellation_token_t get_cancellation_token() noexcept
+{
+    return {};
+}
+} // namespace w
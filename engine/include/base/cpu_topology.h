@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace w::base {
+// How far apart two logical cpus are, smaller is closer
+enum class cpu_distance : uint8_t {
+    same_core, // SMT siblings
+    shared_l2,
+    shared_l3,
+    same_node,
+    remote,
+    count
+};
+
+struct cpu_info {
+    uint32_t id = 0; // logical cpu index used for pinning
+    uint32_t core = 0; // lowest logical cpu of the physical core
+    uint32_t l2 = 0; // lowest logical cpu sharing the L2
+    uint32_t l3 = 0; // lowest logical cpu sharing the L3
+    uint32_t node = 0; // NUMA node
+};
+
+class cpu_topology
+{
+public:
+    cpu_topology() noexcept = default;
+    explicit cpu_topology(std::vector<cpu_info> cpus) noexcept
+        : cpus(std::move(cpus))
+    {
+    }
+
+public:
+    // Reads /sys/devices/system/cpu and /sys/devices/system/node on Linux and GetLogicalProcessorInformationEx on Windows,
+    // limited to the cpus in the process affinity. Other platforms and failed queries produce a flat topology
+    static cpu_topology detect() noexcept;
+    // every cpu is a separate core on a single node
+    static cpu_topology flat(uint32_t cpu_count) noexcept;
+    // synthetic machine, for testing placement and stealing on a single socket host
+    static cpu_topology simulated(uint32_t nodes, uint32_t l3_per_node, uint32_t cores_per_l3, uint32_t threads_per_core) noexcept;
+
+public:
+    std::span<const cpu_info> get_cpus() const noexcept
+    {
+        return cpus;
+    }
+    size_t cpu_count() const noexcept
+    {
+        return cpus.size();
+    }
+    size_t physical_core_count() const noexcept;
+    size_t node_count() const noexcept;
+
+    static cpu_distance distance(const cpu_info& a, const cpu_info& b) noexcept
+    {
+        if (a.core == b.core) {
+            return cpu_distance::same_core;
+        }
+        if (a.l2 == b.l2) {
+            return cpu_distance::shared_l2;
+        }
+        if (a.l3 == b.l3) {
+            return cpu_distance::shared_l3;
+        }
+        return a.node == b.node ? cpu_distance::same_node : cpu_distance::remote;
+    }
+
+    // Cpus in the order workers should be placed on them:
+    // one thread per physical core first, grouped by node and cache, then the SMT siblings
+    std::vector<cpu_info> placement_order() const noexcept;
+
+private:
+    std::vector<cpu_info> cpus;
+};
+
+// Pins the calling thread to a single logical cpu.
+// Returns false if the cpu is outside the affinity the thread started with or the platform refused
+bool pin_current_thread(uint32_t cpu) noexcept;
+} // namespace w::base
@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <optional>
+#include <utility>
+
+namespace w::base {
+// Single thread fixed capacity min-heap, ordered by deadline.
+// Used as the per worker deadline lane, so no synchronization is needed.
+template<class T, size_t Capacity>
+struct deadline_heap {
+    using clock = std::chrono::steady_clock;
+    using value_type = T;
+
+    struct entry {
+        clock::time_point deadline;
+        value_type value;
+    };
+
+public:
+    [[nodiscard]] bool try_push(value_type value, clock::time_point deadline) noexcept
+    {
+        if (count == Capacity) {
+            return false;
+        }
+        // sift up
+        size_t i = count++;
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (items[parent].deadline <= deadline) {
+                break;
+            }
+            items[i] = items[parent];
+            i = parent;
+        }
+        items[i] = { deadline, value };
+        return true;
+    }
+    [[nodiscard]] std::optional<value_type> try_pop() noexcept
+    {
+        if (count == 0) {
+            return std::nullopt;
+        }
+        auto top = items[0].value;
+        auto last = items[--count];
+
+        // sift down
+        size_t i = 0;
+        while (true) {
+            size_t child = i * 2 + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && items[child + 1].deadline < items[child].deadline) {
+                ++child;
+            }
+            if (last.deadline <= items[child].deadline) {
+                break;
+            }
+            items[i] = items[child];
+            i = child;
+        }
+        items[i] = last;
+        return top;
+    }
+    // pops the earliest entry only if its deadline has been reached
+    [[nodiscard]] std::optional<value_type> try_pop_due(clock::time_point now) noexcept
+    {
+        if (count == 0 || items[0].deadline > now) {
+            return std::nullopt;
+        }
+        return try_pop();
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return count == 0; }
+    [[nodiscard]] size_t size() const noexcept { return count; }
+    [[nodiscard]] static constexpr size_t capacity() noexcept { return Capacity; }
+
+private:
+    std::array<entry, Capacity> items{};
+    size_t count = 0;
+};
+} // namespace w::base
@@ -1,24 +1,49 @@
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <cstddef>
 
 namespace w::base {
 class event_count
 {
 public:
+    // skips the wake syscall if nobody is between prepare_wait and wait
     void notify_one() noexcept
     {
-        epoch.fetch_add(1, std::memory_order::acq_rel);
-        epoch.notify_one();
+        epoch.fetch_add(1, std::memory_order::seq_cst);
+        if (wcount.load(std::memory_order::seq_cst) != 0) {
+            epoch.notify_one();
+            wake_others();
+        }
     }
     void notify_all() noexcept
     {
-        epoch.fetch_add(1, std::memory_order::acq_rel);
+        epoch.fetch_add(1, std::memory_order::seq_cst);
         epoch.notify_all();
+        wake_others();
+    }
+    // wakes up to count waiters with a single epoch bump
+    void notify_many(size_t count) noexcept
+    {
+        epoch.fetch_add(1, std::memory_order::seq_cst);
+        auto waiters = wcount.load(std::memory_order::seq_cst);
+        if (waiters == 0) {
+            return;
+        }
+        if (count >= waiters) {
+            epoch.notify_all();
+            wake_others();
+            return;
+        }
+        while (count--) {
+            epoch.notify_one();
+        }
+        wake_others();
     }
     uint32_t prepare_wait() noexcept
     {
-        wcount.fetch_add(1, std::memory_order::acq_rel);
-        return epoch.load(std::memory_order::acquire);
+        wcount.fetch_add(1, std::memory_order::seq_cst);
+        return epoch.load(std::memory_order::seq_cst);
     }
     void cancel_wait() noexcept
     {
@@ -31,9 +56,50 @@ public:
         }
         wcount.fetch_sub(1, std::memory_order::seq_cst);
     }
+    // like wait, but gives up at the deadline, false if it timed out
+    bool wait_until(uint32_t old_epoch, std::chrono::steady_clock::time_point deadline) noexcept;
+
+    using external_wake = void (*)(void* context) noexcept;
+    // Wakes waits that block somewhere else, see wait_external. Set before anybody waits.
+    void set_external_wake(external_wake wake, void* context) noexcept
+    {
+        wake_external = wake;
+        wake_context = context;
+    }
+    // Blocks in block() instead of on the epoch, e.g. inside an io ring that also delivers completions.
+    // Every notification calls the external wake, which has to make block() return.
+    template<typename Block>
+    void wait_external(uint32_t old_epoch, Block&& block) noexcept
+    {
+        external_waiters.fetch_add(1, std::memory_order::seq_cst);
+        if (epoch.load(std::memory_order::seq_cst) == old_epoch) {
+            block();
+        }
+        external_waiters.fetch_sub(1, std::memory_order::relaxed);
+        wcount.fetch_sub(1, std::memory_order::seq_cst);
+    }
+
+private:
+    // Timed and external waits bypass std::atomic::wait, whose notify does not know about them.
+    // Timed ones sleep on a separate word, so waking them does not wake the untimed waiters too.
+    void wake_others() noexcept
+    {
+        if (timed_waiters.load(std::memory_order::seq_cst) != 0) {
+            wake_timed_waiters();
+        }
+        if (external_waiters.load(std::memory_order::seq_cst) != 0) {
+            wake_external(wake_context);
+        }
+    }
+    void wake_timed_waiters() noexcept;
 
 private:
     std::atomic<uint32_t> wcount{ 0 };
     std::atomic<uint32_t> epoch{ 0 };
+    std::atomic<uint32_t> timed_waiters{ 0 };
+    std::atomic<uint32_t> timed_epoch{ 0 };
+    std::atomic<uint32_t> external_waiters{ 0 };
+    external_wake wake_external = nullptr;
+    void* wake_context = nullptr;
 };
 } // namespace w::base
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace w::base {
+// Coroutine frame allocation.
+// Small frames come from per-thread size class free lists, a frame freed on another thread
+// goes back to the owning thread through a lock-free return stack.
+// Large frames use the global operator new, frames may also be placed in a std::pmr::memory_resource.
+class frame_allocator
+{
+public:
+    static constexpr size_t header_size = 16; // keeps the frame aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__
+    static constexpr size_t min_class_size = 64;
+    static constexpr size_t class_count = 7;
+    static constexpr size_t max_class_size = min_class_size << (class_count - 1); // 4096 with the header
+    static constexpr uint32_t max_cached_blocks = 256; // per size class and thread, the rest is released
+
+public:
+    [[nodiscard]] static void* allocate(size_t size);
+    [[nodiscard]] static void* allocate(size_t size, std::pmr::memory_resource* resource);
+    static void deallocate(void* frame) noexcept;
+
+    static constexpr size_t size_class(size_t size_with_header) noexcept
+    {
+        size_t cls = 0;
+        while ((min_class_size << cls) < size_with_header) {
+            ++cls;
+        }
+        return cls;
+    }
+};
+
+// Base of promise types, routes the frame allocation through frame_allocator.
+// Pass std::allocator_arg, std::pmr::memory_resource* as the first coroutine arguments
+// to place the frame in the resource instead, e.g. a per-frame arena.
+struct frame_allocated {
+    static void* operator new(size_t size)
+    {
+        return frame_allocator::allocate(size);
+    }
+    template<typename... Args>
+    static void* operator new(size_t size, std::allocator_arg_t, std::pmr::memory_resource* resource, Args&...)
+    {
+        return frame_allocator::allocate(size, resource);
+    }
+    // member function coroutines, the object comes first
+    template<typename Self, typename... Args>
+    static void* operator new(size_t size, Self&, std::allocator_arg_t, std::pmr::memory_resource* resource, Args&...)
+    {
+        return frame_allocator::allocate(size, resource);
+    }
+    static void operator delete(void* frame) noexcept
+    {
+        frame_allocator::deallocate(frame);
+    }
+};
+} // namespace w::base
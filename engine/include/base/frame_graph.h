@@ -0,0 +1,112 @@
+#pragma once
+#include <base/tasks.h>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace w::base {
+// The work of a frame as a graph of systems.
+// Each system declares the resources it reads and writes. compile() orders conflicting systems
+// the way they were added and leaves the rest free to overlap: a reader waits for the last writer before it,
+// a writer for the last writer and every reader since.
+// run() starts each system on the thread pool as soon as its dependencies finished,
+// a system that releases a dependent continues with it on the same worker.
+// The graph is built once and run() reuses its arrays every frame, coroutine frames come from the frame allocator.
+class frame_graph
+{
+public:
+    using resource = uint32_t;
+    using system = uint32_t;
+
+public:
+    frame_graph() noexcept = default;
+    frame_graph(const frame_graph&) = delete;
+    frame_graph& operator=(const frame_graph&) = delete;
+
+public:
+    resource add_resource() noexcept
+    {
+        return resource_count++;
+    }
+
+    // f is a plain function or returns w::task<void>, e.g. to split its own work across the pool.
+    // Systems must not throw.
+    template<typename F>
+        requires std::invocable<F&>
+    system add_system(F&& f, std::span<const resource> reads, std::span<const resource> writes = {})
+    {
+        system_data data{ {}, {}, { reads.begin(), reads.end() }, { writes.begin(), writes.end() } };
+        if constexpr (std::is_void_v<std::invoke_result_t<F&>>) {
+            data.run = std::forward<F>(f);
+        } else {
+            data.run_async = std::forward<F>(f);
+        }
+        return add_system(std::move(data));
+    }
+    template<typename F>
+        requires std::invocable<F&>
+    system add_system(F&& f, std::initializer_list<resource> reads, std::initializer_list<resource> writes = {})
+    {
+        return add_system(std::forward<F>(f), std::span{ reads.begin(), reads.size() }, std::span{ writes.begin(), writes.size() });
+    }
+
+    // builds the dependencies, again after adding systems or resources
+    void compile();
+
+    // Runs every system once, the awaiting coroutine continues on the worker that finished the last one.
+    // The graph must not change until the task finishes, one frame runs at a time.
+    w::task<void> run();
+
+public:
+    size_t size() const noexcept
+    {
+        return systems.size();
+    }
+    // systems waiting for s, as of the last compile()
+    std::span<const system> dependents(system s) const noexcept
+    {
+        return std::span{ dependent_list }.subspan(dependent_begin[s], dependent_begin[s + 1] - dependent_begin[s]);
+    }
+
+private:
+    struct system_data {
+        std::function<void()> run;
+        std::function<w::task<void>()> run_async;
+        std::vector<resource> reads;
+        std::vector<resource> writes;
+    };
+    struct system_runner;
+    struct start_awaitable;
+
+    system add_system(system_data data);
+    static system_runner run_system(frame_graph& graph, system s);
+    std::coroutine_handle<> start(std::coroutine_handle<> awaiting) noexcept;
+    std::coroutine_handle<> finish(system s) noexcept;
+
+private:
+    std::vector<system_data> systems;
+    resource resource_count = 0;
+    bool compiled = false;
+
+    // by system, dependents of s at [dependent_begin[s], dependent_begin[s + 1])
+    std::vector<uint32_t> dependent_begin;
+    std::vector<system> dependent_list;
+    std::vector<uint32_t> dependency_count;
+    std::vector<system> roots;
+
+    // per frame state
+    std::unique_ptr<std::atomic<uint32_t>[]> pending; // dependencies left by system
+    std::vector<std::coroutine_handle<>> ready; // scratch of finish(), one slot per dependent
+    std::vector<std::coroutine_handle<>> ready_roots;
+    std::atomic<size_t> remaining = 0; // systems left, plus one while start() submits
+    std::coroutine_handle<> continuation;
+};
+} // namespace w::base
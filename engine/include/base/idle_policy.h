@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <immintrin.h>
+
+namespace w::base {
+enum class idle_mode {
+    latency, // frame-critical pools, spin long before parking
+    power_saving // background pools, park almost immediately
+};
+
+// Thresholds for the spin -> backoff -> park sequence of an idle worker.
+// A round is one failed steal attempt, followed by a pause backoff of growing length.
+struct idle_policy {
+    uint32_t min_spin_rounds = 0; // budget when steals never succeed
+    uint32_t max_spin_rounds = 0; // budget when steals always succeed
+    uint32_t max_pause_count = 0; // cap of the exponential _mm_pause backoff per round
+    uint32_t yield_rounds = 0; // rounds after the spin budget that yield instead of pausing
+
+public:
+    static constexpr idle_policy latency() noexcept
+    {
+        return { .min_spin_rounds = 64, .max_spin_rounds = 1024, .max_pause_count = 32, .yield_rounds = 16 };
+    }
+    static constexpr idle_policy power_saving() noexcept
+    {
+        return { .min_spin_rounds = 4, .max_spin_rounds = 64, .max_pause_count = 8, .yield_rounds = 0 };
+    }
+    static constexpr idle_policy from_mode(idle_mode mode) noexcept
+    {
+        return mode == idle_mode::latency ? latency() : power_saving();
+    }
+};
+
+// Per worker adaptive state.
+// Keeps an exponential moving average of the steal success rate of idle episodes
+// and scales the spin budget between the policy bounds with it.
+class idle_state
+{
+    static constexpr uint32_t rate_one = 1024; // fixed point 1.0
+    static constexpr uint32_t rate_shift = 3; // EMA weight of 1/8
+
+public:
+    constexpr idle_state() noexcept = default;
+    explicit constexpr idle_state(idle_policy policy) noexcept
+        : policy(policy)
+    {
+    }
+
+public:
+    // one idle episode, from the first failed steal until a task is found or the worker parks
+    class episode
+    {
+    public:
+        explicit episode(const idle_state& state) noexcept
+            : policy(state.policy), spin_limit(state.spin_limit())
+        {
+        }
+
+    public:
+        // backs off after a failed round, false means the worker should park
+        bool backoff() noexcept
+        {
+            ++round;
+            if (round <= spin_limit) {
+                for (uint32_t i = 0; i < pause_count; ++i) {
+                    _mm_pause();
+                }
+                pause_count = std::min(pause_count * 2, policy.max_pause_count);
+                return true;
+            }
+            if (round <= spin_limit + policy.yield_rounds) {
+                std::this_thread::yield();
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        idle_policy policy;
+        uint32_t spin_limit;
+        uint32_t round = 0;
+        uint32_t pause_count = 1;
+    };
+
+public:
+    void record(bool found_task) noexcept
+    {
+        success_rate = success_rate - (success_rate >> rate_shift) + (found_task ? rate_one >> rate_shift : 0);
+    }
+    uint32_t spin_limit() const noexcept
+    {
+        return policy.min_spin_rounds + uint32_t((uint64_t(policy.max_spin_rounds - policy.min_spin_rounds) * success_rate) / rate_one);
+    }
+    uint32_t steal_success_rate() const noexcept // fixed point, 1024 is 100%
+    {
+        return success_rate;
+    }
+
+private:
+    idle_policy policy = idle_policy::latency();
+    uint32_t success_rate = rate_one / 2;
+};
+} // namespace w::base
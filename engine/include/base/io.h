@@ -0,0 +1,127 @@
+#pragma once
+#include <base/io_ring.h>
+#include <base/result.h>
+#include <base/tasks.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace w::io {
+/// @brief Read-only file for asynchronous reads, closed on destruction
+class file
+{
+public:
+    file() noexcept = default;
+    file(file&& other) noexcept
+        : handle(std::exchange(other.handle, invalid_handle))
+    {
+    }
+    file& operator=(file&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            handle = std::exchange(other.handle, invalid_handle);
+        }
+        return *this;
+    }
+    ~file() noexcept
+    {
+        close();
+    }
+
+public:
+    /// @brief Opens an existing file for reading
+    /// @return The file, or an error if it could not be opened
+    static w::result<file> open(const std::filesystem::path& path) noexcept;
+
+    bool is_open() const noexcept
+    {
+        return handle != invalid_handle;
+    }
+    /// @brief Size of the file in bytes, 0 if it is not open
+    uint64_t size() const noexcept;
+    /// @brief File descriptor, or HANDLE on Windows
+    intptr_t native_handle() const noexcept
+    {
+        return handle;
+    }
+
+private:
+    static constexpr intptr_t invalid_handle = -1; // also INVALID_HANDLE_VALUE
+
+    explicit file(intptr_t handle) noexcept
+        : handle(handle)
+    {
+    }
+    void close() noexcept;
+
+private:
+    intptr_t handle = invalid_handle;
+};
+
+/// @brief Contents of a whole file, see read_file_async
+struct file_contents {
+    std::unique_ptr<std::byte[]> data;
+    size_t size = 0;
+
+public:
+    std::span<const std::byte> bytes() const noexcept
+    {
+        return { data.get(), size };
+    }
+};
+
+namespace detail {
+/// @brief Submits the read to the io ring of the thread pool
+/// @param request Read with the handle to resume, has to stay alive until it is resumed
+void submit_read(base::io_request* request) noexcept;
+
+// The request lives in the awaiter, so in the frame of the suspended coroutine
+struct read_awaitable : base::io_request {
+    bool await_ready() const noexcept
+    {
+        return size == 0;
+    }
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle = awaiting;
+        submit_read(this);
+    }
+    /// @return Bytes read, 0 at the end of the file
+    w::result<size_t> await_resume() const noexcept
+    {
+        if (result < 0) {
+            return { "read failed", w::error };
+        }
+        return size_t(result);
+    }
+};
+} // namespace detail
+
+/// @brief Reads up to buffer.size() bytes at the offset, the coroutine resumes on a worker of the thread pool.
+/// The read may be short, reads larger than 1 GiB always are.
+/// @param file File to read, has to stay open until the read finished
+/// @param buffer Destination, has to stay alive until the read finished
+/// @param offset Position in the file
+/// @return Awaitable that yields the number of bytes read, 0 at the end of the file
+[[nodiscard]] inline detail::read_awaitable read_at_async(const file& file, std::span<std::byte> buffer, uint64_t offset) noexcept
+{
+    constexpr size_t max_read = size_t(1) << 30;
+    detail::read_awaitable read;
+    read.file = file.native_handle();
+    read.buffer = buffer.data();
+    read.size = uint32_t(std::min(buffer.size(), max_read));
+    read.offset = offset;
+    return read;
+}
+
+/// @brief Reads the whole file, large files are split into chunks that are read concurrently
+/// @param path File to read
+/// @param chunk_size Bytes per read
+/// @return Task that yields the contents, or an error if the file could not be opened or read
+w::task<w::result<file_contents>> read_file_async(std::filesystem::path path, size_t chunk_size = size_t(8) << 20);
+} // namespace w::io
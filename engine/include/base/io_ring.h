@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace w::base {
+// One read, lives in the awaiter inside the suspended coroutine frame
+struct io_request {
+    intptr_t file = -1; // fd, or HANDLE on Windows
+    void* buffer = nullptr;
+    uint32_t size = 0;
+    uint64_t offset = 0;
+    int64_t result = 0; // bytes read, or a negative error code
+    std::coroutine_handle<> handle; // resumed once the read completed
+    io_request* next = nullptr;
+};
+
+// Asynchronous reads for the thread pool.
+// On Linux requests go to an io_uring and idle workers reap the completions,
+// the worker that would park while reads are in flight waits inside the ring instead.
+// Other platforms, and kernels without io_uring, hand the reads to a single fallback thread,
+// its completions are reaped by the workers the same way.
+class io_ring
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using wake_callback = void (*)(void* context) noexcept; // wakes a parked worker to reap
+
+public:
+    io_ring(wake_callback wake_workers, void* context, uint32_t entries = 256) noexcept;
+    ~io_ring() noexcept;
+    io_ring(const io_ring&) = delete;
+    io_ring& operator=(const io_ring&) = delete;
+
+public:
+    // any thread, the request has to stay alive until its handle is resumed
+    void submit(io_request* request) noexcept;
+    // completed requests, linked through next, nullptr if none or another thread is reaping
+    io_request* reap() noexcept;
+    // submitted and not reaped yet
+    bool has_in_flight() const noexcept
+    {
+        return in_flight.load(std::memory_order::seq_cst) != 0;
+    }
+    // completed and not reaped yet
+    bool has_completions() const noexcept;
+    // true if wait() can block on completions, false for the fallback thread
+    bool can_wait() const noexcept
+    {
+        return ring != nullptr;
+    }
+    // blocks until a completion, wake() or the deadline
+    void wait(clock::time_point deadline) noexcept;
+    // makes a blocked wait() return, called for every pool notification while a worker waits in the ring
+    void wake() noexcept;
+
+private:
+    void push_completed(io_request* request) noexcept;
+
+private:
+    struct uring;
+    struct fallback;
+
+    std::unique_ptr<uring> ring;
+    std::unique_ptr<fallback> thread;
+    std::atomic<size_t> in_flight{ 0 };
+    std::atomic_flag reaping;
+    std::atomic<io_request*> completed{ nullptr }; // fallback completions
+    wake_callback wake_workers;
+    void* context;
+};
+} // namespace w::base
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+namespace w::base::lz4 {
+// LZ4 block format, interchangeable with LZ4_compress_default / LZ4_decompress_safe.
+// The frame format, dictionaries and high compression levels are not supported.
+inline constexpr size_t max_input_size = 0x7E000000;
+
+// Worst case size of the compressed block
+constexpr size_t compress_bound(size_t size) noexcept
+{
+    return size + size / 255 + 16;
+}
+
+// Greedy single pass compression, returns the compressed size, 0 if dst is too small or the input too large
+size_t compress(std::span<const std::byte> src, std::span<std::byte> dst) noexcept;
+
+// Decompresses a whole block, false if it is malformed or does not fill dst exactly.
+// Safe against corrupted input, never reads or writes out of the spans.
+bool decompress(std::span<const std::byte> src, std::span<std::byte> dst) noexcept;
+} // namespace w::base::lz4
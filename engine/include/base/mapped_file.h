@@ -0,0 +1,58 @@
+#pragma once
+#include <base/result.h>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+namespace w::base {
+// Read-only memory mapping of a whole file, unmapped on destruction.
+// Pages are loaded on first touch, the mapping stays valid while the object lives.
+class mapped_file
+{
+public:
+    mapped_file() noexcept = default;
+    mapped_file(mapped_file&& other) noexcept
+        : data(std::exchange(other.data, nullptr))
+        , size(std::exchange(other.size, 0))
+    {
+    }
+    mapped_file& operator=(mapped_file&& other) noexcept
+    {
+        if (this != &other) {
+            unmap();
+            data = std::exchange(other.data, nullptr);
+            size = std::exchange(other.size, 0);
+        }
+        return *this;
+    }
+    ~mapped_file() noexcept
+    {
+        unmap();
+    }
+
+public:
+    static w::result<mapped_file> open(const std::filesystem::path& path) noexcept;
+
+    std::span<const std::byte> bytes() const noexcept
+    {
+        return { data, size };
+    }
+    bool is_open() const noexcept
+    {
+        return data != nullptr;
+    }
+
+private:
+    mapped_file(const std::byte* data, size_t size) noexcept
+        : data(data)
+        , size(size)
+    {
+    }
+    void unmap() noexcept;
+
+private:
+    const std::byte* data = nullptr;
+    size_t size = 0;
+};
+} // namespace w::base
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <string_view>
+
+namespace w::base {
+// Joining thread with a stop source, like std::jthread,
+// but created through the platform API so the stack size can be chosen.
+class native_thread
+{
+public:
+    native_thread() noexcept = default;
+    native_thread(const native_thread&) = delete;
+    native_thread& operator=(const native_thread&) = delete;
+    ~native_thread() noexcept
+    {
+        if (joinable()) {
+            request_stop();
+            join();
+        }
+    }
+
+public:
+    // stack_size of 0 uses the platform default, returns false if the thread could not be created
+    bool start(std::function<void()> func, size_t stack_size = 0) noexcept;
+    void join() noexcept;
+    bool joinable() const noexcept
+    {
+        return handle != 0;
+    }
+
+    void request_stop() noexcept
+    {
+        stop.request_stop();
+    }
+    std::stop_token get_stop_token() const noexcept
+    {
+        return stop.get_token();
+    }
+
+private:
+    std::stop_source stop;
+    std::function<void()> func; // owned here, the thread only borrows it
+    uintptr_t handle = 0;
+};
+
+// Name shown by debuggers and profilers, truncated to 15 characters on Linux
+void set_current_thread_name(std::string_view name) noexcept;
+} // namespace w::base
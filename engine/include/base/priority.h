@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace w {
+/// @brief Scheduling lane of a task in the thread pool
+/// Workers drain higher lanes first and look for high priority work on every worker before stealing anything else
+enum class priority : uint8_t {
+    high,
+    normal,
+    low
+};
+inline constexpr size_t priority_count = 3;
+} // namespace w
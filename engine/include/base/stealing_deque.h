@@ -1,25 +1,44 @@
 // Based on: https://github.com/mpoeter/xenium/blob/master/xenium/chase_work_stealing_deque.hpp
 #pragma once
 #include <base/atomic_buffer.h>
+#include <algorithm>
+#include <concepts>
 #include <optional>
+#include <span>
 
 namespace w::base {
-template<class T, size_t buffer_size>
+template<class T, size_t buffer_size, class Container = w::base::atomic_buffer<T, buffer_size>>
 struct stealing_deque {
     using value_type = T;
-    using container = w::base::atomic_buffer<T, buffer_size>;
+    using container = Container;
 
     // could have used concepts, but this is more readable
     static_assert(buffer_size > 0 && (buffer_size & (buffer_size - 1)) == 0, "buffer_size must be a power of two");
     static_assert(std::atomic<T>::is_always_lock_free, "T must be lock-free");
 
+    // Upper bound of items a thief may take in one CAS.
+    // A batch is sized from a bottom the owner may have popped below since, so while a batch steal is in flight
+    // the owner pops from the bottom only if at least this many items are left above top,
+    // closer to top it claims items through top, the same way thieves do. Otherwise only the last item needs the CAS.
+    static constexpr std::size_t steal_batch_limit = 32;
+
 public:
     stealing_deque() = default;
+    // for containers sized at runtime
+    explicit stealing_deque(std::size_t capacity) noexcept
+        requires std::constructible_from<Container, std::size_t>
+        : _items(capacity)
+    {
+    }
 
 public:
     [[nodiscard]] bool try_push(value_type item) noexcept;
+    [[nodiscard]] bool try_push_bulk(std::span<const value_type> items) noexcept;
     [[nodiscard]] std::optional<value_type> try_pop() noexcept;
     [[nodiscard]] std::optional<value_type> try_steal() noexcept;
+    // steals up to half of the queue (at most steal_batch_limit and out.size()) in one CAS
+    // nullopt if the queue is empty, 0 if the race was lost
+    [[nodiscard]] std::optional<std::size_t> try_steal_half(std::span<value_type> out) noexcept;
     [[nodiscard]] std::size_t capacity() const noexcept { return _items.capacity(); }
     [[nodiscard]] std::size_t size() const noexcept // useless, but for completeness
     {
@@ -30,17 +49,22 @@ public:
 private:
     alignas(std::hardware_destructive_interference_size) std::atomic<std::size_t> _bottom{ 0 };
     alignas(std::hardware_destructive_interference_size) std::atomic<std::size_t> _top{ 0 };
+    std::atomic<std::size_t> _batch_thieves{ 0 }; // inside try_steal_half, next to top since the owner reads both
     container _items;
 };
 
+// Deque that doubles its buffer instead of failing, push only fails if the allocation does
+template<class T, size_t initial_size = 256>
+using growable_stealing_deque = stealing_deque<T, initial_size, w::base::growable_atomic_buffer<T, initial_size>>;
+
 // push may be called from only a single thread, so it can use relaxed synchronization
-template<class T, size_t buffer_size>
-bool stealing_deque<T, buffer_size>::try_push(value_type item) noexcept
+template<class T, size_t buffer_size, class Container>
+bool stealing_deque<T, buffer_size, Container>::try_push(value_type item) noexcept
 {
     auto b = _bottom.load(std::memory_order_relaxed);
-    auto t = _top.load(std::memory_order_relaxed);
+    auto t = _top.load(std::memory_order_acquire);
     auto size = b - t;
-    if (size >= _items.capacity()) {
+    if (size >= _items.capacity() && !_items.grow(b, t)) {
         return false;
     }
 
@@ -49,51 +73,115 @@ bool stealing_deque<T, buffer_size>::try_push(value_type item) noexcept
     return true;
 }
 
+// publishes the whole batch with a single bottom store
+template<class T, size_t buffer_size, class Container>
+bool stealing_deque<T, buffer_size, Container>::try_push_bulk(std::span<const value_type> items) noexcept
+{
+    auto b = _bottom.load(std::memory_order_relaxed);
+    auto t = _top.load(std::memory_order_acquire);
+    auto size = b - t;
+    while (size + items.size() > _items.capacity()) {
+        if (!_items.grow(b, t)) {
+            return false;
+        }
+    }
+
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        _items.put_unchecked(b + i, items[i], std::memory_order_relaxed);
+    }
+    _bottom.store(b + items.size(), std::memory_order_release);
+    return true;
+}
+
 // pop is only called from a single thread.
 // edge case: steal vs pop, don't care if nullval is returned
-template<class T, size_t buffer_size>
-std::optional<typename stealing_deque<T, buffer_size>::value_type>
-stealing_deque<T, buffer_size>::try_pop() noexcept
+template<class T, size_t buffer_size, class Container>
+std::optional<typename stealing_deque<T, buffer_size, Container>::value_type>
+stealing_deque<T, buffer_size, Container>::try_pop() noexcept
 {
     auto b = _bottom.load(std::memory_order_relaxed);
     auto t = _top.load(std::memory_order_relaxed);
     if (b == t) {
+        _items.reclaim(); // empty queue is a good moment to release retired buffers
         return std::nullopt;
     }
 
     --b;
     _bottom.store(b, std::memory_order_seq_cst);
+    // before top: a batch steal that finished already is visible in top then
+    bool batch_stealing = _batch_thieves.load(std::memory_order_seq_cst) != 0;
+    t = _top.load(std::memory_order_seq_cst); // thieves may have advanced since the first load
 
-    value_type item = _items.get_unchecked(b, std::memory_order_relaxed);
-    if (b > t) {
-        return item;
+    if (b < t) {
+        _bottom.store(t, std::memory_order_relaxed);
+        return _items.nullval;
+    }
+    if (b > t && (!batch_stealing || b >= t + steal_batch_limit)) {
+        // single steals take top only, a batch started from now on sees the new bottom, and no older batch reaches this slot
+        return _items.get_unchecked(b, std::memory_order_relaxed);
     }
 
-    if (b == t) {
-        if (_top.compare_exchange_strong(t, t + 1, std::memory_order_relaxed)) {
-            _bottom.store(t + 1, std::memory_order_relaxed);
-            return item;
-        }
+    // a thief may be about to take [t, t + batch), claim the oldest item through top instead
+    _bottom.store(b + 1, std::memory_order_relaxed);
+    value_type item = _items.get_unchecked(t, std::memory_order_relaxed);
+    if (_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return item;
     }
-    _bottom.store(t, std::memory_order_relaxed);
     return _items.nullval;
 }
 
-template<class T, size_t buffer_size>
-std::optional<typename stealing_deque<T, buffer_size>::value_type>
-stealing_deque<T, buffer_size>::try_steal() noexcept
+template<class T, size_t buffer_size, class Container>
+std::optional<typename stealing_deque<T, buffer_size, Container>::value_type>
+stealing_deque<T, buffer_size, Container>::try_steal() noexcept
 {
-    auto t = _top.load(std::memory_order_relaxed);
+    auto t = _top.load(std::memory_order_seq_cst);
     auto b = _bottom.load(std::memory_order_seq_cst);
     auto size = static_cast<std::intptr_t>(b) - static_cast<std::intptr_t>(t);
     if (size <= 0) {
         return std::nullopt;
     }
 
+    [[maybe_unused]] auto guard = _items.enter_read(); // keeps a ring retired by grow alive
     auto item = _items.get_unchecked(t, std::memory_order_relaxed);
     if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
         return _items.nullval;
     }
     return item;
 }
+
+template<class T, size_t buffer_size, class Container>
+std::optional<std::size_t>
+stealing_deque<T, buffer_size, Container>::try_steal_half(std::span<value_type> out) noexcept
+{
+    auto t = _top.load(std::memory_order_seq_cst);
+    auto b = _bottom.load(std::memory_order_seq_cst);
+    if (static_cast<std::intptr_t>(b) - static_cast<std::intptr_t>(t) <= 0) {
+        return std::nullopt; // empty queues are not announced
+    }
+
+    // announced before top and bottom are read again: an owner that missed it has already published its bottom
+    _batch_thieves.fetch_add(1, std::memory_order_seq_cst);
+    auto steal = [&]() -> std::optional<std::size_t> {
+        t = _top.load(std::memory_order_seq_cst);
+        b = _bottom.load(std::memory_order_seq_cst);
+        auto size = static_cast<std::intptr_t>(b) - static_cast<std::intptr_t>(t);
+        if (size <= 0) {
+            return std::nullopt;
+        }
+
+        auto count = std::min({ std::max(std::size_t(size) / 2, std::size_t(1)), steal_batch_limit, out.size() });
+
+        [[maybe_unused]] auto guard = _items.enter_read();
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = _items.get_unchecked(t + i, std::memory_order_relaxed);
+        }
+        if (!_top.compare_exchange_strong(t, t + count, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return 0;
+        }
+        return count;
+    };
+    auto result = steal();
+    _batch_thieves.fetch_sub(1, std::memory_order_release); // pairs with the owner's load, top is up to date after it
+    return result;
+}
 } // namespace w::base
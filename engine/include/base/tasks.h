@@ -1,10 +1,145 @@
 #pragma once
 #include <base/await.h>
+#include <base/frame_allocator.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <format>
+#include <functional>
+#include <optional>
 #include <span>
+#include <stop_token>
+#include <tuple>
+#include <variant>
+#include <vector>
 
 namespace w {
+namespace detail {
+// Progress of a task or action, kept in a single atomic word.
+// Besides the constants below the word holds the address of the awaiting coroutine (continuation),
+// or the address of a sync_waiter tagged with the lowest bit, for a thread blocked in get().
+// Frame addresses are at least 8 byte aligned, so neither can collide with the constants.
+namespace coro_state {
+inline constexpr uintptr_t running = 0; // started, nobody is waiting yet
+inline constexpr uintptr_t done = 1;
+inline constexpr uintptr_t not_started = 2; // lazy task, the body runs once it is awaited
+inline constexpr uintptr_t sync_waiter_tag = 1;
+} // namespace coro_state
+
+// Lives on the stack of the thread blocked in get() or in the destructor,
+// so completing the coroutine never touches the frame after it was published as done
+struct alignas(8) sync_waiter {
+    std::atomic<bool> ready{ false };
+
+public:
+    void wait() const noexcept
+    {
+        ready.wait(false, std::memory_order::acquire);
+    }
+    void notify() noexcept
+    {
+        ready.store(true, std::memory_order::release);
+        ready.notify_one();
+    }
+};
+
+// Awaits the operand of co_await in place.
+// Handing out a plain reference from await_transform makes GCC copy the awaiter, which tasks do not allow.
+template<typename Awaiter>
+struct awaiter_ref {
+    Awaiter& awaiter;
+
+public:
+    bool await_ready() noexcept(noexcept(awaiter.await_ready()))
+    {
+        return awaiter.await_ready();
+    }
+    template<typename Promise>
+    decltype(auto) await_suspend(std::coroutine_handle<Promise> handle) noexcept(noexcept(awaiter.await_suspend(handle)))
+    {
+        return awaiter.await_suspend(handle);
+    }
+    decltype(auto) await_resume() noexcept(noexcept(awaiter.await_resume()))
+    {
+        return awaiter.await_resume();
+    }
+};
+
+// Cancellation token of a coroutine, taken from the first cancellation_token argument of the coroutine.
+// Awaited lazy tasks, combinators and pool hops without a token of their own inherit it,
+// so cancelling the source reaches everything the coroutine started after it was created.
+class cancellation_scope
+{
+public:
+    cancellation_scope() noexcept = default;
+    template<typename... Args>
+    explicit cancellation_scope(Args&... args) noexcept
+    {
+        (take_token(args), ...);
+    }
+
+public:
+    template<typename Awaitable>
+    decltype(auto) await_transform(Awaitable&& awaitable) noexcept
+    {
+        if constexpr (requires { awaitable.inherit_cancellation(token); }) {
+            if (token.can_be_cancelled()) {
+                awaitable.inherit_cancellation(token);
+            }
+        }
+        if constexpr (is_awaiter<Awaitable>) {
+            return awaiter_ref<std::remove_reference_t<Awaitable>>{ awaitable };
+        } else {
+            return std::forward<Awaitable>(awaitable); // has its own operator co_await
+        }
+    }
+    auto await_transform(get_cancellation_token_t) noexcept
+    {
+        struct awaitable {
+            bool await_ready() const noexcept
+            {
+                return true;
+            }
+            void await_suspend(std::coroutine_handle<>) const noexcept
+            {
+            }
+            cancellation_token await_resume() const noexcept
+            {
+                return token;
+            }
+            const cancellation_token& token;
+        };
+        return awaitable{ token };
+    }
+
+    // only before the coroutine starts, a token given explicitly wins
+    void inherit(const cancellation_token& parent) noexcept
+    {
+        if (!token.can_be_cancelled()) {
+            token = parent;
+        }
+    }
+    const cancellation_token& get_token() const noexcept
+    {
+        return token;
+    }
+
+private:
+    template<typename Arg>
+    void take_token(const Arg& arg) noexcept
+    {
+        if constexpr (std::is_same_v<Arg, cancellation_token>) {
+            inherit(arg);
+        }
+    }
+
+private:
+    cancellation_token token;
+};
+} // namespace detail
+
 template<typename PromiseType>
 struct [[nodiscard]] coro_type {
 public:
@@ -20,7 +155,6 @@ public:
     explicit coro_type(std::coroutine_handle<> coroutine) noexcept
         : coroutine(coroutine)
     {
-        //std::cout << std::format("Coroutine {} created\n", typeid(PromiseType).name());
     }
 
     coro_type(const coro_type&) = delete;
@@ -33,6 +167,7 @@ public:
     coro_type& operator=(coro_type&& other) noexcept
     {
         if (this != &other) {
+            wait_finish();
             coroutine = std::move(other.coroutine);
         }
         return *this;
@@ -40,27 +175,20 @@ public:
 
     ~coro_type() noexcept
     {
-        //std::cout << std::format("Coroutine {} destroyed\n", typeid(PromiseType).name());
-
-        if (await_ready())
-            return;
-
-        auto handle = coroutine.as<promise_type>();
-        handle.promise().wait_finish_internal();
+        wait_finish();
     }
 
 public:
     bool await_ready() const noexcept
     {
-        return !coroutine || coroutine.get().done();
+        return !coroutine || promise().is_done();
     }
 
+    // starts a lazy task through symmetric transfer, or attaches to a running action
     std::coroutine_handle<> await_suspend(
             std::coroutine_handle<> awaiting_coroutine) noexcept
     {
-        auto handle = coroutine.as<promise_type>();
-        handle.promise().set_continuation(awaiting_coroutine);
-        return coroutine.get();
+        return promise().set_continuation(coroutine.get(), awaiting_coroutine);
     }
 
     decltype(auto) await_resume() noexcept
@@ -68,37 +196,62 @@ public:
         if constexpr (std::is_void_v<return_type>) {
             return;
         } else {
-            auto handle = coroutine.as<promise_type>();
-            return handle.promise().get_result();
+            return promise().get_result();
         }
     }
 
+    /// @brief Blocks the calling thread until the coroutine finishes, a lazy task is started on this thread
     decltype(auto) get() noexcept
     {
-        auto handle = coroutine.as<promise_type>();
-        auto& promise = handle.promise();
-        promise.wait_finish_internal();
+        promise().wait_finish(coroutine.get());
         return await_resume();
     }
 
+    /// @brief Hands the token of the awaiting coroutine to a lazy task that has none
+    /// Running actions keep the token they were created with
+    void inherit_cancellation(const cancellation_token& token) noexcept
+    {
+        if (coroutine && promise().is_not_started()) {
+            promise().inherit(token);
+        }
+    }
+
+private:
+    promise_type& promise() const noexcept
+    {
+        return coroutine.template as<promise_type>().promise();
+    }
+    // a running coroutine has to finish before its frame is destroyed, a lazy one that never ran is just dropped
+    void wait_finish() noexcept
+    {
+        if (coroutine && !promise().is_done() && !promise().is_not_started()) {
+            promise().wait_finish(coroutine.get());
+        }
+    }
+
 protected:
     unique_coroutine_handle coroutine;
 };
 
 template<typename ResultType, typename CoroType, typename InitialSuspend = std::suspend_always>
     requires detail::is_awaiter<InitialSuspend>
-struct promise_base {
+struct promise_base : w::base::frame_allocated, detail::cancellation_scope {
 public:
     using storage_type = std::conditional_t<std::is_reference_v<ResultType>, std::remove_reference_t<ResultType>*, ResultType>;
     using result_type = std::conditional_t<std::is_void_v<storage_type>, decltype(std::ignore), storage_type>;
     static inline constexpr bool is_movable = !std::is_reference_v<ResultType> && !std::is_void_v<ResultType> && !std::is_arithmetic_v<ResultType> && !std::is_pointer_v<ResultType>;
+    static inline constexpr bool is_lazy = std::is_same_v<InitialSuspend, std::suspend_always>;
 
 public:
     promise_base() noexcept = default;
+    // sees the arguments of the coroutine, picks up a cancellation_token among them
+    template<typename... Args>
+    explicit promise_base(Args&... args) noexcept
+        : detail::cancellation_scope(args...)
+    {
+    }
     promise_base(const promise_base&) = delete;
-    promise_base(promise_base&&) = default;
     promise_base& operator=(const promise_base&) = delete;
-    promise_base& operator=(promise_base&&) = default;
 
 public:
     InitialSuspend initial_suspend() const noexcept
@@ -106,22 +259,29 @@ public:
         return {};
     }
 
-    continued_awaitable final_suspend() const noexcept
+    auto final_suspend() noexcept
     {
-        auto awaitable = continued_awaitable{ get_continuation() };
-        done.store(true, std::memory_order::release);
-        if (waited) {
-            done.notify_all(); // Probably expensive, is only done if someone is waiting
-        }
-        return awaitable;
+        struct awaitable {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            // the frame is suspended here, so whoever sees done may destroy it right away
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<>) const noexcept
+            {
+                return promise.complete();
+            }
+            void await_resume() const noexcept
+            {
+            }
+            promise_base& promise;
+        };
+        return awaitable{ *this };
     }
 
-    void unhandled_exception() const
+    void unhandled_exception() noexcept(false)
     {
-        done.store(true, std::memory_order::release);
-        if (waited) {
-            done.notify_all();
-        }
+        complete(); // the continuation is lost, but blocked threads are released
         throw;
     }
 
@@ -130,18 +290,23 @@ public:
         return CoroType{ std::coroutine_handle<promise_base>::from_promise(*this) };
     }
 
-    void set_continuation(std::coroutine_handle<> continuation) noexcept
-    {
-        this->continuation = continuation;
-    }
-
-    decltype(auto) get_continuation() const noexcept
+    // Registers the awaiting coroutine, returns the coroutine to run next
+    std::coroutine_handle<> set_continuation(std::coroutine_handle<> self, std::coroutine_handle<> continuation) noexcept
     {
-        return continuation;
+        auto value = reinterpret_cast<uintptr_t>(continuation.address());
+        if (state.load(std::memory_order::relaxed) == detail::coro_state::not_started) {
+            state.store(value, std::memory_order::relaxed); // nobody else can see a task that has not started
+            return self;
+        }
+        auto expected = detail::coro_state::running;
+        if (state.compare_exchange_strong(expected, value, std::memory_order::release, std::memory_order::acquire)) {
+            return std::noop_coroutine();
+        }
+        return continuation; // finished in the meantime
     }
 
     decltype(auto) get_result() noexcept
-        requires !std::is_void_v<ResultType>
+        requires(!std::is_void_v<ResultType>)
     {
         if constexpr (std::is_reference_v<ResultType>) {
             return *result;
@@ -152,18 +317,51 @@ public:
         }
     }
 
-    void wait_finish_internal() const noexcept
+    bool is_done() const noexcept
+    {
+        return state.load(std::memory_order::acquire) == detail::coro_state::done;
+    }
+    bool is_not_started() const noexcept
+    {
+        return state.load(std::memory_order::relaxed) == detail::coro_state::not_started;
+    }
+
+    // blocks until the coroutine finished, a lazy task that has not started runs on the calling thread
+    void wait_finish(std::coroutine_handle<> self) noexcept
+    {
+        if (state.load(std::memory_order::relaxed) == detail::coro_state::not_started) {
+            state.store(detail::coro_state::running, std::memory_order::relaxed);
+            self.resume();
+        }
+
+        detail::sync_waiter waiter;
+        auto expected = detail::coro_state::running;
+        auto value = reinterpret_cast<uintptr_t>(&waiter) | detail::coro_state::sync_waiter_tag;
+        if (state.compare_exchange_strong(expected, value, std::memory_order::release, std::memory_order::acquire)) {
+            waiter.wait();
+        }
+    }
+
+private:
+    // Publishes the result, the promise must not be touched after the exchange
+    std::coroutine_handle<> complete() noexcept
     {
-        waited = true;
-        done.wait(false, std::memory_order::acquire);
+        auto previous = state.exchange(detail::coro_state::done, std::memory_order::acq_rel);
+        if (previous == detail::coro_state::running) {
+            return std::noop_coroutine();
+        }
+        if (previous & detail::coro_state::sync_waiter_tag) {
+            reinterpret_cast<detail::sync_waiter*>(previous & ~detail::coro_state::sync_waiter_tag)->notify();
+            return std::noop_coroutine();
+        }
+        return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(previous));
     }
 
 protected:
-    std::coroutine_handle<> continuation = std::noop_coroutine();
     result_type result{};
 
-    mutable bool waited = false;
-    mutable std::atomic_bool done{ false };
+private:
+    std::atomic<uintptr_t> state{ is_lazy ? detail::coro_state::not_started : detail::coro_state::running };
 };
 
 template<typename ResultType, typename CoroType>
@@ -179,7 +377,7 @@ struct promise_value : PromiseBase {
     using storage_type = typename base_type::storage_type;
 
     template<typename U = storage_type>
-        requires !std::is_void_v<storage_type> && std::is_convertible_v<U&&, storage_type>
+        requires(!std::is_void_v<storage_type> && std::is_convertible_v<U &&, storage_type>)
     void return_value(U && value) noexcept
     {
         // Construct the value in place, avoids copy/move
@@ -202,49 +400,603 @@ template<typename T, typename CoroType>
 using action_promise = std::conditional_t<std::is_void_v<T>, promise_void<action_promise_base<void, CoroType>>, promise_value<action_promise_base<T, CoroType>>>;
 
 /// @brief Lazy task coroutine
+/// Starts when awaited, or on the calling thread in get()
 /// @tparam ReturnType Value type
 template<typename ReturnType>
 struct task : coro_type<task_promise<ReturnType, task<ReturnType>>> {
     using coro_type<task_promise<ReturnType, task<ReturnType>>>::coro_type;
 };
 
-/// @brief Eager action coroutine. Very fast but must be waited upon in order for it to be destroyed, otherwise it may deadlock.
+/// @brief Eager action coroutine. Very fast, destroying an unfinished action blocks until it finishes.
 /// @tparam ReturnType Value type
 template<typename ReturnType>
 struct action : coro_type<action_promise<ReturnType, action<ReturnType>>> {
-    using base = coro_type<action_promise<ReturnType, action<ReturnType>>>;
     using coro_type<action_promise<ReturnType, action<ReturnType>>>::coro_type;
+};
 
-    void await_suspend(
-            std::coroutine_handle<> awaiting_coroutine) noexcept
+namespace detail {
+template<typename Awaitable>
+using await_result_t = decltype(std::declval<Awaitable>().await_resume());
+
+// Result slot of a combinator child: void becomes std::monostate, lvalue references stay references
+template<typename R>
+using when_value_t = std::conditional_t<std::is_void_v<R>, std::monostate,
+                                        std::conditional_t<std::is_lvalue_reference_v<R>, std::reference_wrapper<std::remove_reference_t<R>>, std::remove_cvref_t<R>>>;
+
+template<typename T>
+inline constexpr bool is_lazy_task = false;
+template<typename T>
+inline constexpr bool is_lazy_task<task<T>> = true;
+
+template<typename Awaitable>
+inline constexpr bool is_lazy_awaitable = is_lazy_task<std::remove_cvref_t<Awaitable>>;
+
+// Counts finished children of when_all.
+// The awaiting coroutine holds one extra count while it starts the children,
+// so the parent is resumed exactly once, by whoever arrives last.
+class when_all_latch
+{
+public:
+    explicit when_all_latch(size_t children) noexcept
+        : count(children + 1)
+    {
+    }
+
+public:
+    void set_parent(std::coroutine_handle<> handle) noexcept
+    {
+        parent = handle;
+    }
+    // parent if this was the last arrival, noop otherwise
+    std::coroutine_handle<> arrive() noexcept
+    {
+        return count.fetch_sub(1, std::memory_order::acq_rel) == 1 ? parent : std::noop_coroutine();
+    }
+
+private:
+    std::atomic<size_t> count;
+    std::coroutine_handle<> parent;
+};
+
+// Starts lazy children on the pool with a single bulk submit, the last one continues on this thread.
+// Eager children are already running and have to be resumed by the caller before.
+inline std::coroutine_handle<> start_lazy(when_all_latch& latch, std::span<const std::coroutine_handle<>> lazy) noexcept
+{
+    if (lazy.empty()) {
+        return latch.arrive();
+    }
+    auto inline_child = lazy.back();
+    if (lazy.size() > 1) {
+        detail::resume_background(lazy.first(lazy.size() - 1));
+    }
+    latch.arrive(); // never the last one, inline_child has not run yet
+    return inline_child;
+}
+
+template<typename T>
+struct when_all_runner {
+    struct promise_type : w::base::frame_allocated, cancellation_scope {
+        when_all_runner get_return_object() noexcept
+        {
+            return when_all_runner{ unique_coroutine_handle{ std::coroutine_handle<promise_type>::from_promise(*this) } };
+        }
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+        auto final_suspend() const noexcept
+        {
+            struct awaitable {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+                {
+                    return handle.promise().latch->arrive();
+                }
+                void await_resume() const noexcept
+                {
+                }
+            };
+            return awaitable{};
+        }
+        template<typename U>
+        void return_value(U&& value) noexcept
+        {
+            result.emplace(std::forward<U>(value));
+        }
+        void unhandled_exception() const // throws exception
+        {
+            throw;
+        }
+
+        when_all_latch* latch = nullptr;
+        std::optional<T> result;
+    };
+
+public:
+    std::coroutine_handle<promise_type> get() const noexcept
+    {
+        return std::coroutine_handle<promise_type>::from_address(coroutine.get().address());
+    }
+    T take_result() noexcept
+    {
+        return std::move(*get().promise().result);
+    }
+
+    unique_coroutine_handle coroutine;
+};
+
+template<typename Awaitable>
+when_all_runner<when_value_t<await_result_t<Awaitable>>> make_when_all_runner(Awaitable awaitable)
+{
+    if constexpr (std::is_void_v<await_result_t<Awaitable>>) {
+        co_await awaitable;
+        co_return std::monostate{};
+    } else {
+        co_return co_await awaitable;
+    }
+}
+
+template<typename... Awaitables>
+class when_all_tuple_awaitable
+{
+public:
+    using result_type = std::tuple<when_value_t<await_result_t<Awaitables>>...>;
+
+public:
+    explicit when_all_tuple_awaitable(Awaitables&&... awaitables) noexcept
+        : latch(sizeof...(Awaitables))
+        , runners(make_when_all_runner<Awaitables>(std::forward<Awaitables>(awaitables))...)
+    {
+    }
+
+public:
+    bool await_ready() const noexcept
+    {
+        return sizeof...(Awaitables) == 0;
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept
+    {
+        latch.set_parent(parent);
+        std::array<std::coroutine_handle<>, sizeof...(Awaitables)> lazy;
+        size_t lazy_count = 0;
+        start(lazy, lazy_count, std::index_sequence_for<Awaitables...>{});
+        return start_lazy(latch, std::span{ lazy }.first(lazy_count));
+    }
+    result_type await_resume() noexcept
+    {
+        return std::apply([](auto&... runner) { return result_type{ runner.take_result()... }; }, runners);
+    }
+    // the runners pass the token on to the children that have none
+    void inherit_cancellation(const cancellation_token& token) noexcept
+    {
+        std::apply([&](auto&... runner) { (runner.get().promise().inherit(token), ...); }, runners);
+    }
+
+private:
+    template<size_t... I>
+    void start(auto& lazy, size_t& lazy_count, std::index_sequence<I...>) noexcept
+    {
+        auto start_one = [&]<size_t i>(std::integral_constant<size_t, i>) {
+            auto handle = std::get<i>(runners).get();
+            handle.promise().latch = &latch;
+            if constexpr (is_lazy_awaitable<std::tuple_element_t<i, std::tuple<Awaitables...>>>) {
+                lazy[lazy_count++] = handle;
+            } else {
+                handle.resume(); // eager child is running already, this only registers the continuation
+            }
+        };
+        (start_one(std::integral_constant<size_t, I>{}), ...);
+    }
+
+private:
+    when_all_latch latch;
+    std::tuple<when_all_runner<when_value_t<await_result_t<Awaitables>>>...> runners;
+};
+
+template<typename T>
+class when_all_range_awaitable
+{
+public:
+    using value_type = when_value_t<await_result_t<T&>>;
+
+public:
+    explicit when_all_range_awaitable(std::span<T> tasks)
+        : latch(tasks.size())
+    {
+        runners.reserve(tasks.size());
+        for (auto& task : tasks) {
+            runners.push_back(make_when_all_runner<T&>(task));
+        }
+    }
+
+public:
+    bool await_ready() const noexcept
+    {
+        return runners.empty();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent)
+    {
+        latch.set_parent(parent);
+        std::vector<std::coroutine_handle<>> lazy;
+        for (auto& runner : runners) {
+            auto handle = runner.get();
+            handle.promise().latch = &latch;
+            if constexpr (is_lazy_awaitable<T>) {
+                lazy.push_back(handle);
+            } else {
+                handle.resume(); // eager child is running already, this only registers the continuation
+            }
+        }
+        return start_lazy(latch, lazy);
+    }
+    // results in the order of the span, nothing for void tasks
+    auto await_resume()
+    {
+        if constexpr (std::is_void_v<await_result_t<T&>>) {
+            return;
+        } else {
+            std::vector<value_type> results;
+            results.reserve(runners.size());
+            for (auto& runner : runners) {
+                results.push_back(runner.take_result());
+            }
+            return results;
+        }
+    }
+    void inherit_cancellation(const cancellation_token& token) noexcept
+    {
+        for (auto& runner : runners) {
+            runner.get().promise().inherit(token);
+        }
+    }
+
+private:
+    when_all_latch latch;
+    std::vector<when_all_runner<value_type>> runners;
+};
+} // namespace detail
+
+/// @brief Waits for all awaitables to finish
+/// Lazy tasks are started on the thread pool in parallel, one of them continues on the current thread.
+/// Eager actions are already running and are only joined.
+/// The awaiting coroutine is resumed once, by the child that finishes last.
+/// @param args Tasks or actions, lvalues are awaited in place, rvalues are moved into the combinator
+/// @return Awaitable that yields a tuple of the results, void results are std::monostate
+template<typename... Args>
+    requires(sizeof...(Args) > 0 && (w::detail::is_awaiter<Args> && ...))
+[[nodiscard]] auto when_all(Args&&... args) noexcept
+{
+    return detail::when_all_tuple_awaitable<Args...>{ std::forward<Args>(args)... };
+}
+
+/// @brief Waits for all tasks in the range to finish, see when_all(Args&&...)
+/// @param tasks Tasks, have to stay alive until the combinator finishes
+/// @return Awaitable that yields a vector of the results in order, or nothing for void tasks
+template<typename T>
+[[nodiscard]] auto when_all(std::span<T> tasks)
+{
+    return detail::when_all_range_awaitable<T>{ tasks };
+}
+
+/// @brief Result of when_any
+/// @tparam T Result of the children, std::monostate for void
+template<typename T>
+struct when_any_result {
+    size_t index; // position of the child that finished first
+    T value;
+};
+
+namespace detail {
+// Shared between the awaiting coroutine and the children of when_any.
+// Losers keep running after the parent was resumed, so the state is reference counted
+// and every child releases it when it finishes.
+template<typename T>
+class when_any_state
+{
+public:
+    when_any_state(size_t children, std::stop_source cancel) noexcept
+        : refs(children + 1)
+        , cancel(std::move(cancel))
+    {
+    }
+
+public:
+    // true for the first child to finish only, requests stop for the others
+    template<typename U>
+    bool try_complete(size_t index, U&& value) noexcept
+    {
+        if (finished.exchange(true, std::memory_order::acq_rel)) {
+            return false;
+        }
+        result.emplace(index, std::forward<U>(value));
+        cancel.request_stop();
+        return true;
+    }
+    // the winner and the awaiting coroutine both arrive, the second one resumes the parent
+    std::coroutine_handle<> arrive() noexcept
+    {
+        return pending.fetch_sub(1, std::memory_order::acq_rel) == 1 ? parent : std::noop_coroutine();
+    }
+    void release(size_t count = 1) noexcept
+    {
+        if (refs.fetch_sub(count, std::memory_order::acq_rel) == count) {
+            delete this;
+        }
+    }
+
+public:
+    std::coroutine_handle<> parent;
+    std::optional<when_any_result<T>> result;
+
+private:
+    std::atomic<size_t> refs;
+    std::atomic<bool> finished{ false };
+    std::atomic<uint32_t> pending{ 2 };
+    std::stop_source cancel;
+};
+
+// Child of when_any, destroys itself when done
+template<typename T>
+struct when_any_runner {
+    struct promise_type : w::base::frame_allocated, cancellation_scope {
+        template<typename... Args>
+        promise_type(when_any_state<T>* state, Args&&...) noexcept
+            : state(state)
+        {
+        }
+
+        when_any_runner get_return_object() noexcept
+        {
+            return when_any_runner{ unique_coroutine_handle{ std::coroutine_handle<promise_type>::from_promise(*this) } };
+        }
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+        auto final_suspend() const noexcept
+        {
+            struct awaitable {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+                {
+                    auto* state = handle.promise().state;
+                    bool won = handle.promise().won;
+                    handle.destroy();
+
+                    auto next = won ? state->arrive() : std::noop_coroutine();
+                    state->release();
+                    return next;
+                }
+                void await_resume() const noexcept
+                {
+                }
+            };
+            return awaitable{};
+        }
+        void return_value(bool first) noexcept
+        {
+            won = first;
+        }
+        void unhandled_exception() const // throws exception
+        {
+            throw;
+        }
+
+        when_any_state<T>* state;
+        bool won = false;
+    };
+
+public:
+    unique_coroutine_handle coroutine;
+    bool lazy = false; // task that has to be started, actions are running already
+};
+
+template<typename T, typename Awaitable>
+when_any_runner<T> make_when_any_runner(when_any_state<T>* state, size_t index, Awaitable awaitable)
+{
+    if constexpr (std::is_void_v<await_result_t<Awaitable>>) {
+        co_await awaitable;
+        co_return state->try_complete(index, std::monostate{});
+    } else {
+        co_return state->try_complete(index, co_await awaitable);
+    }
+}
+
+template<typename T>
+class when_any_awaitable
+{
+public:
+    when_any_awaitable(when_any_state<T>* state, std::vector<when_any_runner<T>> runners) noexcept
+        : state(state)
+        , runners(std::move(runners))
+    {
+    }
+    when_any_awaitable(const when_any_awaitable&) = delete;
+    when_any_awaitable& operator=(const when_any_awaitable&) = delete;
+    ~when_any_awaitable() noexcept
+    {
+        // children that never started hold a reference too
+        state->release(started ? 1 : runners.size() + 1);
+    }
+
+public:
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent)
+    {
+        state->parent = parent;
+        started = true;
+
+        // children own themselves from here on
+        std::vector<std::coroutine_handle<>> lazy;
+        lazy.reserve(runners.size());
+        for (auto& runner : runners) {
+            if (runner.lazy) {
+                lazy.push_back(runner.coroutine.release());
+            } else {
+                runner.coroutine.release().resume(); // eager child is running already, this only registers the continuation
+            }
+        }
+        if (lazy.empty()) {
+            return state->arrive();
+        }
+
+        auto inline_child = lazy.back();
+        if (lazy.size() > 1) {
+            detail::resume_background(std::span{ lazy }.first(lazy.size() - 1));
+        }
+        // nothing below may touch this, a child may have resumed the parent already
+        if (state->arrive() == parent) {
+            detail::resume_background(inline_child);
+            return parent;
+        }
+        return inline_child;
+    }
+    when_any_result<T> await_resume() noexcept
     {
-        auto handle = this->coroutine.as<base::promise_type>();
-        handle.promise().set_continuation(awaiting_coroutine);
+        return std::move(*state->result);
     }
+    void inherit_cancellation(const cancellation_token& token) noexcept
+    {
+        for (auto& runner : runners) {
+            std::coroutine_handle<typename when_any_runner<T>::promise_type>::from_address(runner.coroutine.get().address()).promise().inherit(token);
+        }
+    }
+
+private:
+    when_any_state<T>* state;
+    std::vector<when_any_runner<T>> runners;
+    bool started = false;
 };
+} // namespace detail
+
+/// @brief Waits for the first awaitable to finish
+/// Children run in parallel like in when_all, the awaiting coroutine is resumed by the first one to finish.
+/// The others keep running until they finish on their own, cancel is stopped once the winner is known,
+/// so children holding its token can return early.
+/// @param cancel Stop source that is triggered for the losers
+/// @param args Tasks or actions of the same result type, moved into the combinator since they may outlive the await
+/// @return Awaitable that yields the index and the result of the winner
+template<typename... Args>
+    requires(sizeof...(Args) > 0 && (w::detail::is_awaiter<Args> && ...) && (!std::is_lvalue_reference_v<Args> && ...))
+[[nodiscard]] auto when_any(std::stop_source cancel, Args&&... args)
+{
+    using first_type = std::tuple_element_t<0, std::tuple<Args...>>;
+    using value_type = detail::when_value_t<detail::await_result_t<first_type>>;
+    static_assert((std::is_same_v<value_type, detail::when_value_t<detail::await_result_t<Args>>> && ...),
+                  "when_any requires children of the same result type");
+
+    auto* state = new detail::when_any_state<value_type>(sizeof...(Args), std::move(cancel));
+    std::vector<detail::when_any_runner<value_type>> runners;
+    runners.reserve(sizeof...(Args));
+    size_t index = 0;
+    auto add = [&]<typename A>(A&& awaitable) {
+        auto& runner = runners.emplace_back(detail::make_when_any_runner<value_type, A>(state, index++, std::move(awaitable)));
+        runner.lazy = detail::is_lazy_awaitable<A>;
+    };
+    (add(std::move(args)), ...);
+    return detail::when_any_awaitable<value_type>{ state, std::move(runners) };
+}
 
-/// @brief Wait for all tasks to finish. Evaluation is done from left to right.
-/// @param args Tasks
-/// @return Task that finishes when all tasks are done
+/// @brief Waits for the first awaitable to finish, losers are not cancelled
 template<typename... Args>
-    requires(w::detail::is_awaiter<Args> && ...)
-task<void> when_all(Args&&... args)
+    requires(sizeof...(Args) > 0 && (w::detail::is_awaiter<Args> && ...) && (!std::is_lvalue_reference_v<Args> && ...))
+[[nodiscard]] auto when_any(Args&&... args)
+{
+    return when_any(std::stop_source{ std::nostopstate }, std::forward<Args>(args)...);
+}
+
+/// @brief Waits for the first task in the range to finish, see when_any(std::stop_source, Args&&...)
+/// @param cancel Stop source that is triggered for the losers
+/// @param tasks Tasks, moved out of the range, must not be empty
+template<typename T>
+[[nodiscard]] auto when_any(std::stop_source cancel, std::span<T> tasks)
 {
-    if constexpr (sizeof...(args) == 1) {
-        static_assert(false, "when_all requires at least two arguments");
+    using value_type = detail::when_value_t<detail::await_result_t<T>>;
+
+    auto* state = new detail::when_any_state<value_type>(tasks.size(), std::move(cancel));
+    std::vector<detail::when_any_runner<value_type>> runners;
+    runners.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        auto& runner = runners.emplace_back(detail::make_when_any_runner<value_type, T>(state, i, std::move(tasks[i])));
+        runner.lazy = detail::is_lazy_awaitable<T>;
     }
-    (co_await std::forward<Args>(args), ...);
+    return detail::when_any_awaitable<value_type>{ state, std::move(runners) };
 }
 
-/// @brief Wait for all tasks to finish. Evaluation is done from left to right.
-/// @param args Tasks
-/// @return Task that finishes when all tasks are done
+/// @brief Waits for the first task in the range to finish, losers are not cancelled
 template<typename T>
-task<void> when_all(std::span<T> tasks)
+[[nodiscard]] auto when_any(std::span<T> tasks)
+{
+    return when_any(std::stop_source{ std::nostopstate }, tasks);
+}
+
+namespace detail {
+template<typename T, typename Awaitable>
+task<std::optional<T>> value_before_timeout(Awaitable awaitable)
 {
-    for (auto&& task : tasks) {
-        co_await task;
+    if constexpr (std::is_void_v<await_result_t<Awaitable>>) {
+        co_await awaitable;
+        co_return T{};
+    } else {
+        co_return T{ co_await awaitable };
     }
 }
 
+// the node belongs to with_timeout, so it can still cancel the timer once this frame waits in the wheel
+struct timeout_awaitable {
+    base::timer_node& timer;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> awaiting) const noexcept
+    {
+        timer.handle = awaiting;
+        detail::resume_at(&timer);
+    }
+    void await_resume() const noexcept
+    {
+        // the node may be gone already
+    }
+};
+
+// eager, the timer is in the wheel before with_timeout can cancel it
+template<typename T>
+action<std::optional<T>> timeout_on(base::timer_node& timer)
+{
+    co_await timeout_awaitable{ timer };
+    co_return std::nullopt;
+}
+} // namespace detail
+
+/// @brief Waits for the awaitable until the timeout
+/// Built on when_any: on timeout the awaitable keeps running until it finishes on its own,
+/// if it wins, the timer is cancelled and its frame finishes right away.
+/// @param awaitable Task or action, moved into the combinator
+/// @param timeout Longest time to wait
+/// @return Task that yields the result, std::monostate for void, or std::nullopt on timeout
+template<typename Awaitable>
+    requires w::detail::is_awaiter<Awaitable>
+[[nodiscard]] auto with_timeout(Awaitable awaitable, std::chrono::steady_clock::duration timeout)
+        -> task<std::optional<detail::when_value_t<detail::await_result_t<Awaitable>>>>
+{
+    using value_type = detail::when_value_t<detail::await_result_t<Awaitable>>;
+    base::timer_node timer{ .deadline = std::chrono::steady_clock::now() + timeout };
+    auto timeout_child = detail::timeout_on<value_type>(timer);
+    auto result = co_await when_any(detail::value_before_timeout<value_type, Awaitable>(std::move(awaitable)), std::move(timeout_child));
+    if (result.index == 0 && detail::cancel_timer(&timer)) {
+        timer.handle.resume(); // the timer child returns, its result is dropped
+    }
+    co_return std::move(result.value);
+}
 } // namespace w
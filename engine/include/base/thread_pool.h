@@ -3,12 +3,54 @@
 #include <base/atomic_queue.h>
 #include <base/xoshiro.h>
 #include <base/event_count.h>
+#include <base/idle_policy.h>
+#include <base/deadline_heap.h>
+#include <base/priority.h>
+#include <base/cpu_topology.h>
+#include <base/native_thread.h>
+#include <base/thread_pool_stats.h>
+#include <base/cancellation.h>
+#include <base/timer_wheel.h>
+#include <base/io_ring.h>
+#include <algorithm>
+#include <array>
 #include <coroutine>
+#include <limits>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 #include <immintrin.h>
 
 namespace w::base {
+struct thread_pool_config {
+    uint32_t worker_count = 0; // 0 is one worker per physical core
+    std::vector<uint32_t> affine_workers{ 0 }; // workers accepting submit_affine, e.g. UI, render or I/O threads
+    uint32_t deque_capacity = 256; // initial capacity of every priority lane, lanes grow on demand
+    uint32_t affine_queue_capacity = 32; // fixed, submit_affine waits while the queue is full
+    std::string thread_name = "w worker"; // workers are named "<thread_name> <index>"
+    size_t stack_size = 0; // 0 is the platform default
+    bool pin_threads = true;
+    idle_policy idle = idle_policy::latency();
+    std::optional<cpu_topology> topology{}; // detected if empty
+    trace_recorder* trace = nullptr; // optional, has to outlive the pool
+};
+
+// Where a worker runs and in which order it visits the other workers when stealing
+struct worker_placement {
+    static constexpr size_t tier_count = size_t(cpu_distance::count);
+
+    cpu_info cpu;
+    std::vector<uint32_t> victims; // other workers, nearest first
+    std::array<uint32_t, tier_count> tier_end{}; // end of each cpu_distance tier in victims
+};
+
+// Wrapper coroutine that resumes the handle, or destroys it if the token was cancelled while it was queued
+std::coroutine_handle<> make_cancellable(std::coroutine_handle<> handle, cancellation_token token) noexcept;
+
 struct thread_unit {
     static uint32_t generate_seed() noexcept
     {
@@ -17,14 +59,21 @@ struct thread_unit {
         return a;
     };
     thread_unit() noexcept = default;
-    thread_unit(auto thread_func, bool affinity = false) noexcept
-        : thread(thread_func)
+    thread_unit(const thread_pool_config& config, bool affinity, worker_placement placement) noexcept
+        : idle(config.idle)
+        , placement(std::move(placement))
         , rng(generate_seed())
-        , affine_tasks(affinity ? std::make_unique<w::base::atomic_queue<std::coroutine_handle<>, 32>>() : nullptr)
+        , queues(make_queues(config.deque_capacity, std::make_index_sequence<priority_count>{}))
+        , affine_tasks(affinity ? std::make_unique<affine_queue_type>(config.affine_queue_capacity) : nullptr)
     {
     }
 
 public:
+    // started separately, so all units exist before any thread can steal from them
+    bool start(std::function<void()> thread_func, size_t stack_size) noexcept
+    {
+        return thread.start(std::move(thread_func), stack_size);
+    }
     void request_stop() noexcept
     {
         thread.request_stop();
@@ -33,14 +82,15 @@ public:
     {
         return thread.get_stop_token().stop_requested();
     }
-    std::optional<std::coroutine_handle<>> steal_task() noexcept
+    std::optional<std::coroutine_handle<>> steal_task(priority lane = priority::normal) noexcept
     {
+        auto& queue = queues[size_t(lane)];
         do {
             auto val = queue.try_steal();
             if (val == std::nullopt) {
                 return std::nullopt;
             }
-            full.store(false, std::memory_order::relaxed);
+            release_full();
 
             if (val && val.value()) {
                 return val;
@@ -48,28 +98,84 @@ public:
             // else: try again
         } while (true);
     }
+    // pops from the highest non-empty lane
     std::optional<std::coroutine_handle<>> pop_task() noexcept
     {
+        for (auto& queue : queues) {
+            do {
+                auto val = queue.try_pop();
+                if (val == std::nullopt) {
+                    break;
+                }
+                release_full();
+                if (val && val.value()) {
+                    return val;
+                }
+                // else: try again
+            } while (true);
+        }
+        return std::nullopt;
+    }
+    std::optional<std::coroutine_handle<>> steal_tasks(thread_unit& thief, priority lane = priority::normal) noexcept
+    {
+        using deque = queue_type;
+        auto& queue = queues[size_t(lane)];
+        std::array<std::coroutine_handle<>, deque::steal_batch_limit> stolen;
         do {
-            auto val = queue.try_pop();
-            if (val == std::nullopt) {
+            auto count = queue.try_steal_half(stolen);
+            if (count == std::nullopt) {
                 return std::nullopt;
             }
-            full.store(false, std::memory_order::relaxed);
-            full.notify_one();
-            if (val && val.value()) {
-                return val;
+            if (count.value() == 0) {
+                continue; // lost the race, try again
             }
-            // else: try again
+            release_full();
+
+            // run the first one, the rest goes to the thief's deque where it can be stolen again
+            thief.push_tasks(std::span{ stolen }.subspan(1, count.value() - 1), lane);
+            return stolen[0];
         } while (true);
     }
-    void push_task(std::coroutine_handle<> handle) noexcept
+    void push_tasks(std::span<const std::coroutine_handle<>> handles, priority lane = priority::normal) noexcept
     {
-        while (!queue.try_push(handle)) {
+        if (handles.empty()) {
+            return;
+        }
+        while (!queues[size_t(lane)].try_push_bulk(handles)) {
+            stats.add(pool_counter::push_stalls);
+            full.store(true, std::memory_order::relaxed);
+            full.wait(true, std::memory_order::relaxed);
+        }
+    }
+    void push_task(std::coroutine_handle<> handle, priority lane = priority::normal) noexcept
+    {
+        // the queue grows on demand, so this only loops if the buffer could not be allocated
+        while (!queues[size_t(lane)].try_push(handle)) {
+            stats.add(pool_counter::push_stalls);
             full.store(true, std::memory_order::relaxed);
             full.wait(true, std::memory_order::relaxed); // wait until popped or stolen
         }
     }
+    // deadline lane is private to the worker, a full lane degrades to the high priority queue
+    void push_deadline_task(std::coroutine_handle<> handle, std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        if (!deadline_tasks.try_push(handle, deadline)) {
+            push_task(handle, priority::high);
+        }
+    }
+    // late tasks preempt the queue order, the clock is only read if the lane is not empty
+    std::optional<std::coroutine_handle<>> pop_due_task() noexcept
+    {
+        if (deadline_tasks.empty()) {
+            return std::nullopt;
+        }
+        return deadline_tasks.try_pop_due(std::chrono::steady_clock::now());
+    }
+    // earliest deadline first, used once the worker has nothing else to run
+    std::optional<std::coroutine_handle<>> pop_deadline_task() noexcept
+    {
+        return deadline_tasks.try_pop();
+    }
     bool push_affine_task(std::coroutine_handle<> handle) noexcept
     {
         if (!affine_tasks) {
@@ -96,9 +202,25 @@ public:
         full_affine.notify_one();
         return val;
     }
+    bool empty_queue(priority lane) const noexcept
+    {
+        return queues[size_t(lane)].size() == 0;
+    }
     bool empty_queue() const noexcept
     {
-        return queue.size() == 0;
+        return std::ranges::all_of(queues, [](auto& queue) { return queue.size() == 0; });
+    }
+    bool accepts_affine_tasks() const noexcept
+    {
+        return affine_tasks != nullptr;
+    }
+    bool has_affine_tasks() const noexcept
+    {
+        return affine_tasks && affine_tasks->size() != 0;
+    }
+    bool has_deadline_tasks() const noexcept
+    {
+        return !deadline_tasks.empty();
     }
 
     void join() noexcept
@@ -110,14 +232,110 @@ public:
     {
         return rng.next() % thread_count;
     }
+    // random worker from the given distance tier, nullopt if the tier is empty
+    std::optional<uint32_t> get_victim(cpu_distance tier) noexcept
+    {
+        auto t = size_t(tier);
+        uint32_t first = t == 0 ? 0 : placement.tier_end[t - 1];
+        uint32_t last = placement.tier_end[t];
+        if (first == last) {
+            return std::nullopt;
+        }
+        return placement.victims[first + rng.next() % (last - first)];
+    }
+    std::span<const uint32_t> victims_by_distance() const noexcept
+    {
+        return placement.victims;
+    }
+    const cpu_info& get_cpu() const noexcept
+    {
+        return placement.cpu;
+    }
+    void record_steal(cpu_distance tier) noexcept
+    {
+        auto& count = steals[size_t(tier)];
+        count.store(count.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+    }
+    std::array<size_t, worker_placement::tier_count> steals_by_distance() const noexcept
+    {
+        std::array<size_t, worker_placement::tier_count> result;
+        for (size_t t = 0; t < result.size(); ++t) {
+            result[t] = steals[t].load(std::memory_order::relaxed);
+        }
+        return result;
+    }
 
 private:
+    void release_full() noexcept
+    {
+        if (full.load(std::memory_order::relaxed)) {
+            full.store(false, std::memory_order::relaxed);
+            full.notify_one();
+        }
+    }
+
+public:
+    idle_state idle; // only touched by the owning thread
+    W_NO_UNIQUE_ADDRESS worker_stats stats; // written by the owning thread, empty without W_THREAD_POOL_STATS
+
+private:
+    worker_placement placement;
+    std::array<std::atomic<size_t>, worker_placement::tier_count> steals{}; // written by the owner only, any thread may read
+
+private:
+    using queue_type = w::base::growable_stealing_deque<std::coroutine_handle<>, 256>;
+    using affine_queue_type = w::base::runtime_atomic_queue<std::coroutine_handle<>>;
+
+    template<size_t... lanes>
+    static std::array<queue_type, priority_count> make_queues(size_t capacity, std::index_sequence<lanes...>) noexcept
+    {
+        return { ((void)lanes, queue_type{ capacity })... };
+    }
+
     xoroshiro rng{ 0 };
-    std::jthread thread;
-    w::base::stealing_deque<std::coroutine_handle<>, 256> queue;
-    std::unique_ptr<w::base::atomic_queue<std::coroutine_handle<>, 32>> affine_tasks;
+    std::array<queue_type, priority_count> queues; // indexed by priority, high first
+    w::base::deadline_heap<std::coroutine_handle<>, 64> deadline_tasks;
+    std::unique_ptr<affine_queue_type> affine_tasks;
     std::atomic<bool> full = false;
     std::atomic<bool> full_affine = false;
+    w::base::native_thread thread; // last, the thread may only start once the queues exist
+};
+
+// Work submitted from threads outside the pool.
+// A worker's deques only take pushes from their owner, so outsiders queue here and the next worker to look moves it over.
+class external_inbox
+{
+public:
+    void push(std::span<const std::coroutine_handle<>> handles, priority lane) noexcept
+    {
+        std::scoped_lock lock{ mutex };
+        auto& queue = lanes[size_t(lane)];
+        queue.insert(queue.end(), handles.begin(), handles.end());
+        pending.store(true, std::memory_order::seq_cst); // read by parking workers after prepare_wait
+    }
+    bool empty() const noexcept
+    {
+        return !pending.load(std::memory_order::seq_cst);
+    }
+    // calls take(handles, lane) for every lane and empties the inbox, returns the number of handles taken
+    template<typename Take>
+    size_t drain(Take&& take) noexcept
+    {
+        std::scoped_lock lock{ mutex };
+        size_t count = 0;
+        for (size_t lane = 0; lane < priority_count; ++lane) {
+            count += lanes[lane].size();
+            take(std::span<const std::coroutine_handle<>>{ lanes[lane] }, priority(lane));
+            lanes[lane].clear(); // keeps the capacity for the next burst
+        }
+        pending.store(false, std::memory_order::relaxed);
+        return count;
+    }
+
+private:
+    std::mutex mutex;
+    std::array<std::vector<std::coroutine_handle<>>, priority_count> lanes; // indexed by priority, high first
+    std::atomic<bool> pending = false;
 };
 
 class thread_pool
@@ -125,37 +343,185 @@ class thread_pool
     friend struct thread_pool_token;
 
 public:
-    thread_pool(uint32_t thread_count = std::thread::hardware_concurrency()) noexcept
+    explicit thread_pool(thread_pool_config config = {}) noexcept
+        : topology(config.topology ? std::move(config.topology.value()) : cpu_topology::detect())
+        , trace(config.trace)
     {
+        auto thread_count = config.worker_count ? config.worker_count : uint32_t(std::max<size_t>(topology.physical_core_count(), 1));
         units = std::make_unique<thread_unit[]>(thread_count);
         unit_count = thread_count;
 
+        notifier.set_external_wake(+[](void* pool) noexcept { static_cast<thread_pool*>(pool)->io.wake(); }, this);
+
+        auto placements = place_workers(topology, thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            bool affinity = std::ranges::find(config.affine_workers, uint32_t(i)) != config.affine_workers.end();
+            std::destroy_at(units.get() + i);
+            std::construct_at(units.get() + i, config, affinity, std::move(placements[i]));
+        }
         for (size_t i = 0; i < thread_count; ++i) {
-            std::construct_at(units.get() + i, [this, i]() {
+            auto thread_func = [this, i, name = config.thread_name + ' ' + std::to_string(i), pin = config.pin_threads]() {
                 index = i;
+                current_pool = this;
+                set_current_thread_name(name);
+                if (pin) {
+                    pin_current_thread(units[i].get_cpu().id);
+                }
                 thread_loop();
-                // printf("%zd thread stopped\n", i);
-            }, i == 0);
+            };
+            // the requested stack size may be refused, a worker with the default stack is better than none
+            if (!units[i].start(thread_func, config.stack_size)) {
+                units[i].start(thread_func, 0);
+            }
+        }
+    }
+    // joins the workers before the members they use are gone
+    ~thread_pool() noexcept
+    {
+        stop();
+        for (size_t i = 0; i < unit_count; ++i) {
+            units[i].join();
+        }
+    }
+
+    // Spreads workers over physical cores, then orders every worker's victims by cpu distance
+    static std::vector<worker_placement> place_workers(const cpu_topology& topology, size_t worker_count) noexcept
+    {
+        std::vector<worker_placement> placements(worker_count);
+        auto order = topology.placement_order();
+        if (order.empty()) {
+            order.push_back({});
+        }
+
+        for (size_t i = 0; i < worker_count; ++i) {
+            placements[i].cpu = order[i % order.size()];
         }
+        for (size_t i = 0; i < worker_count; ++i) {
+            auto& p = placements[i];
+            auto distance = [&](uint32_t worker) {
+                return cpu_topology::distance(p.cpu, placements[worker].cpu);
+            };
+            for (uint32_t v = 0; v < worker_count; ++v) {
+                if (v != i) {
+                    p.victims.push_back(v);
+                }
+            }
+            std::ranges::stable_sort(p.victims, {}, distance);
+            for (size_t t = 0; t < worker_placement::tier_count; ++t) {
+                p.tier_end[t] = uint32_t(std::ranges::count_if(p.victims, [&](uint32_t v) {
+                    return size_t(distance(v)) <= t;
+                }));
+            }
+        }
+        return placements;
     }
 
 public:
-    void submit(std::coroutine_handle<> handle) noexcept
+    void submit(std::coroutine_handle<> handle, priority lane = priority::normal) noexcept
     {
-        // always push to local queue
-        units[index].push_task(handle);
+        // workers push to their local queue, everyone else to the inbox
+        if (current_pool == this) {
+            units[index].push_task(handle, lane);
+        } else {
+            external.push({ &handle, 1 }, lane);
+        }
         notifier.notify_one();
     }
+    // For detached coroutines only, e.g. fire_and_forget: a cancelled one is destroyed without running.
+    // Awaited or joined coroutines have to check their token after resuming instead.
+    void submit(std::coroutine_handle<> handle, cancellation_token token, priority lane = priority::normal) noexcept
+    {
+        submit(make_cancellable(handle, std::move(token)), lane);
+    }
+    void submit_bulk(std::span<const std::coroutine_handle<>> handles, priority lane = priority::normal) noexcept
+    {
+        // one publication and one wakeup for the whole batch
+        if (current_pool == this) {
+            units[index].push_tasks(handles, lane);
+        } else {
+            external.push(handles, lane);
+        }
+        notifier.notify_many(std::min(handles.size(), unit_count));
+    }
+    // The task runs on this worker ahead of queued work once the deadline is reached,
+    // or earlier if the worker runs out of work.
+    // Outside the workers the deadline lane is out of reach, the task goes to the high priority lane instead.
+    void submit(std::coroutine_handle<> handle, std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        if (current_pool != this) {
+            submit(handle, priority::high);
+            return;
+        }
+        units[index].push_deadline_task(handle, deadline);
+    }
+    // The timer node has to stay alive until its handle is resumed.
+    // Timers are serviced by idle workers, one parked worker sleeps until the earliest deadline.
+    void schedule_timer(timer_node* timer) noexcept
+    {
+        auto deadline = timer->deadline.time_since_epoch().count(); // the node may be gone once scheduled
+        if (timers.schedule(timer) && deadline < keeper_deadline.load(std::memory_order::seq_cst)) {
+            notifier.notify_one(); // whoever wakes up takes over the earlier deadline
+        }
+    }
+    // false if the timer expired already, its handle runs on the pool then
+    bool cancel_timer(timer_node* timer) noexcept
+    {
+        return timers.cancel(timer);
+    }
+    // The request has to stay alive until its handle is resumed, the handle runs on the worker that reaped it
+    void submit_io(io_request* request) noexcept
+    {
+        io.submit(request);
+        if (current_pool != this) {
+            notifier.notify_one(); // only workers may queue what completed, a woken one reaps it or waits in the ring
+            return;
+        }
+        // reads served from the page cache often complete during the submission, they are queued here without a wakeup
+        if (auto task = reap_io()) {
+            units[index].push_task(task.value());
+        }
+        if (io.can_wait() && io.has_in_flight() && !io_keeper.load(std::memory_order::seq_cst)) {
+            notifier.notify_one(); // nobody waits in the ring, a parked worker has to start reaping
+        }
+    }
     size_t current_unit() const noexcept
     {
         return index;
     }
+    size_t size() const noexcept
+    {
+        return unit_count;
+    }
+    const cpu_topology& get_topology() const noexcept
+    {
+        return topology;
+    }
+    const thread_unit& get_unit(size_t i) const noexcept
+    {
+        return units[i];
+    }
+    worker_counters get_counters(size_t worker) const noexcept
+    {
+        return units[worker].stats.snapshot();
+    }
+    // sum over all workers
+    worker_counters get_counters() const noexcept
+    {
+        worker_counters total;
+        for (size_t i = 0; i < unit_count; ++i) {
+            total += units[i].stats.snapshot();
+        }
+        return total;
+    }
 
-    void submit_affine(std::coroutine_handle<> handle, size_t thread_idx) noexcept
+    // false if the worker was not configured as affine, the task is not queued then
+    bool submit_affine(std::coroutine_handle<> handle, size_t thread_idx) noexcept
     {
-        // always push to local queue
-        units[thread_idx].push_affine_task(handle);
+        if (thread_idx >= unit_count || !units[thread_idx].push_affine_task(handle)) {
+            return false;
+        }
         notifier.notify_all();
+        return true;
     }
     void stop() noexcept
     {
@@ -176,26 +542,73 @@ private:
     }
     std::optional<std::coroutine_handle<>> explore_task() noexcept
     {
-        size_t num_failed_steals = 0;
-        size_t num_yields = 0;
-
         auto& unit = units[index];
+        idle_state::episode episode{ unit.idle };
+        auto* tracer = active_trace();
+        auto begin = tracer ? trace_recorder::clock::now() : trace_recorder::clock::time_point{};
+        auto record_trace = [&]() {
+            if (tracer) {
+                tracer->record(index, trace_event_kind::explore, begin, trace_recorder::clock::now());
+            }
+        };
+
         while (!unit.stop_requested()) {
-            size_t victim = unit.get_victim(unit_count);
-            auto task = units[victim].steal_task();
+            auto task = steal_task(unit);
+            if (!task) {
+                task = unit.pop_affine_task(); // affine work should not wait for the spin budget to run out
+            }
+            if (!task) {
+                task = take_external();
+            }
 
             if (task) {
+                unit.idle.record(true);
+                record_trace();
                 return task;
             }
+            if (!episode.backoff()) {
+                break;
+            }
+        }
+        unit.idle.record(false);
+        record_trace();
+        return std::nullopt;
+    }
+    std::optional<std::coroutine_handle<>> steal_task(thread_unit& unit) noexcept
+    {
+        auto steal_from = [&](uint32_t victim, priority lane) {
+            unit.stats.add(pool_counter::steal_attempts);
+            auto task = units[victim].steal_tasks(unit, lane);
+            if (task) {
+                unit.stats.add(pool_counter::steals);
+                unit.record_steal(cpu_topology::distance(unit.get_cpu(), units[victim].get_cpu()));
+            } else {
+                unit.stats.add(pool_counter::failed_steals);
+            }
+            return task;
+        };
 
-            num_failed_steals++;
-            if (num_failed_steals > unit_count) {
-                std::this_thread::yield();
-                num_failed_steals = 0;
-                num_yields++;
-                if (num_yields > unit_count) {
-                    break;
-                }
+        // high priority work is searched on every worker before anything else is stolen, nearest first
+        for (auto victim : unit.victims_by_distance()) {
+            if (units[victim].empty_queue(priority::high)) {
+                continue;
+            }
+            if (auto task = steal_from(victim, priority::high)) {
+                return task;
+            }
+        }
+
+        // one random victim per tier, cache siblings first, then the same node, remote nodes last
+        for (size_t tier = 0; tier < worker_placement::tier_count; ++tier) {
+            auto victim = unit.get_victim(cpu_distance(tier));
+            if (!victim) {
+                continue;
+            }
+            if (auto task = steal_from(victim.value(), priority::normal)) {
+                return task;
+            }
+            if (auto task = steal_from(victim.value(), priority::low)) {
+                return task;
             }
         }
         return std::nullopt;
@@ -206,14 +619,31 @@ private:
             notifier.notify_one();
         }
 
+        auto& unit = units[index];
+        auto* tracer = active_trace();
+        auto burst_begin = thread_pool_stats_enabled ? worker_stats::clock::now() : worker_stats::clock::time_point{};
         do {
-            handle.resume();
-            if (auto p = units[index].pop_task()) {
+            if (tracer) {
+                auto begin = trace_recorder::clock::now();
+                handle.resume();
+                tracer->record(index, trace_event_kind::task, begin, trace_recorder::clock::now());
+            } else {
+                handle.resume();
+            }
+            unit.stats.add(pool_counter::tasks_executed);
+
+            if (auto d = unit.pop_due_task()) {
+                handle = d.value();
+            } else if (auto p = unit.pop_task()) {
                 handle = p.value();
             } else {
                 break;
             }
+            unit.stats.add(pool_counter::local_pops);
         } while (true);
+        if constexpr (thread_pool_stats_enabled) {
+            unit.stats.add(pool_counter::resume_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(worker_stats::clock::now() - burst_begin).count());
+        }
         active_threads.fetch_sub(1, std::memory_order::relaxed);
     }
     std::optional<std::coroutine_handle<>> wait_for_task() noexcept
@@ -224,6 +654,18 @@ private:
             if (auto task = unit.pop_affine_task()) {
                 return task;
             }
+            if (auto task = take_external()) {
+                return task;
+            }
+            if (auto task = unit.pop_deadline_task()) {
+                return task;
+            }
+            if (auto task = expire_timers()) {
+                return task;
+            }
+            if (auto task = reap_io()) {
+                return task;
+            }
 
             thief_threads.fetch_add(1, std::memory_order::relaxed);
         i_explore:
@@ -235,8 +677,9 @@ private:
             }
 
             if (!unit.empty_queue()) {
-                auto task = unit.steal_task();
+                auto task = unit.pop_task();
                 if (task) {
+                    unit.stats.add(pool_counter::local_pops);
                     if (thief_threads.fetch_sub(1, std::memory_order::relaxed) == 1) {
                         notifier.notify_one();
                     }
@@ -253,27 +696,180 @@ private:
 
             if (thief_threads.fetch_sub(1, std::memory_order::relaxed) != 1 || active_threads.load() <= 0) {
                 auto epoch = notifier.prepare_wait();
-                printf("%zd waiting\n", index);
-                notifier.wait(epoch);
-                printf("%zd woke up\n", index);
+                auto next_timer = timers.next_deadline();
+                if (has_pending_work() || io.has_completions() || next_timer <= timer_wheel::clock::now()) { // submitted before prepare_wait, the notification is already gone
+                    notifier.cancel_wait();
+                    continue;
+                }
+                unit.stats.add(pool_counter::parks);
+                auto* tracer = active_trace();
+                auto begin = tracer ? trace_recorder::clock::now() : trace_recorder::clock::time_point{};
+                if (!park_in_io(epoch, next_timer) && !park_until(epoch, next_timer)) {
+                    notifier.wait(epoch);
+                }
+                if (tracer) {
+                    tracer->record(index, trace_event_kind::park, begin, trace_recorder::clock::now());
+                }
+                unit.stats.add(pool_counter::wakeups);
             }
         } while (true);
     }
+    // Moves the work submitted from outside the pool onto this worker's deques, where the others can steal it
+    std::optional<std::coroutine_handle<>> take_external() noexcept
+    {
+        if (external.empty()) {
+            return std::nullopt;
+        }
+        auto& unit = units[index];
+        auto count = external.drain([&](std::span<const std::coroutine_handle<>> handles, priority lane) {
+            unit.push_tasks(handles, lane);
+        });
+        if (count > 1) {
+            notifier.notify_many(count - 1);
+        }
+        return unit.pop_task();
+    }
+    // Handles that became ready outside the queues: the first one is returned and the rest is queued on this worker.
+    // produce(add) calls add(handle) for each of them.
+    template<typename Produce>
+    std::optional<std::coroutine_handle<>> take_ready(pool_counter counter, Produce&& produce) noexcept
+    {
+        auto& unit = units[index];
+        std::optional<std::coroutine_handle<>> first;
+        std::array<std::coroutine_handle<>, 32> batch;
+        size_t count = 0;
+        auto flush = [&]() {
+            unit.push_tasks(std::span{ batch }.first(count));
+            notifier.notify_many(count);
+            count = 0;
+        };
+        auto add = [&](std::coroutine_handle<> handle) {
+            unit.stats.add(counter);
+            if (!first) {
+                first = handle;
+                return;
+            }
+            batch[count++] = handle;
+            if (count == batch.size()) {
+                flush();
+            }
+        };
+        produce(add);
+        if (count) {
+            flush();
+        }
+        return first;
+    }
+    // Runs the timers that are due
+    std::optional<std::coroutine_handle<>> expire_timers() noexcept
+    {
+        if (timers.empty()) {
+            return std::nullopt;
+        }
+        auto now = timer_wheel::clock::now();
+        if (timers.next_deadline() > now) {
+            return std::nullopt;
+        }
+        return take_ready(pool_counter::timers_expired, [&](auto& add) { timers.expire(now, add); });
+    }
+    // Resumes the coroutines whose reads completed
+    std::optional<std::coroutine_handle<>> reap_io() noexcept
+    {
+        if (!io.has_in_flight()) {
+            return std::nullopt;
+        }
+        auto* list = io.reap();
+        if (!list) {
+            return std::nullopt;
+        }
+        return take_ready(pool_counter::io_completions, [&](auto& add) {
+            while (list) {
+                auto* next = list->next; // the request is gone once the handle runs
+                add(list->handle);
+                list = next;
+            }
+        });
+    }
+    // While reads are in flight one parked worker waits inside the io ring, which also returns on notifications and the timer deadline.
+    // False if the ring cannot wait or another worker is already in it.
+    bool park_in_io(uint32_t epoch, timer_wheel::clock::time_point deadline) noexcept
+    {
+        if (!io.can_wait() || !io.has_in_flight() || io_keeper.exchange(true, std::memory_order::seq_cst)) {
+            return false;
+        }
+        notifier.wait_external(epoch, [&]() { io.wait(deadline); });
+        io_keeper.store(false, std::memory_order::seq_cst);
+        if (io.has_in_flight()) {
+            notifier.notify_one(); // this worker may get busy, hand the ring to a parked one
+        }
+        return true;
+    }
+    // The worker with the earliest timer sleeps until it instead of indefinitely,
+    // false if another worker is keeping an earlier or the same deadline
+    bool park_until(uint32_t epoch, timer_wheel::clock::time_point deadline) noexcept
+    {
+        if (deadline == timer_wheel::clock::time_point::max()) {
+            return false;
+        }
+        auto ticks = deadline.time_since_epoch().count();
+        auto current = keeper_deadline.load(std::memory_order::seq_cst);
+        do {
+            if (current <= ticks) {
+                return false;
+            }
+        } while (!keeper_deadline.compare_exchange_weak(current, ticks, std::memory_order::seq_cst));
+
+        notifier.wait_until(epoch, deadline);
+        keeper_deadline.compare_exchange_strong(ticks, no_keeper, std::memory_order::seq_cst); // unless an earlier timer took over
+        return true;
+    }
+    // nullptr unless a recorder is attached and recording
+    trace_recorder* active_trace() const noexcept
+    {
+        if constexpr (thread_pool_stats_enabled) {
+            return trace && trace->is_recording() ? trace : nullptr;
+        }
+        return nullptr;
+    }
+    bool has_pending_work() const noexcept
+    {
+        if (units[index].has_affine_tasks() || units[index].has_deadline_tasks() || !external.empty()) {
+            return true;
+        }
+        for (size_t i = 0; i < unit_count; ++i) {
+            if (!units[i].empty_queue()) {
+                return true;
+            }
+        }
+        return false;
+    }
 
 private:
-    thread_local static inline size_t index = 0;
+    thread_local static inline size_t index = 0; // of the worker in current_pool, only meaningful there
+    thread_local static inline const thread_pool* current_pool = nullptr; // set on the workers
+    cpu_topology topology;
+    trace_recorder* trace = nullptr;
     std::unique_ptr<thread_unit[]> units;
     size_t unit_count;
 
     alignas(std::hardware_destructive_interference_size) w::base::event_count notifier;
     alignas(std::hardware_destructive_interference_size) std::atomic<size_t> active_threads = 0;
     alignas(std::hardware_destructive_interference_size) std::atomic<size_t> thief_threads = 0;
+    alignas(std::hardware_destructive_interference_size) external_inbox external;
+
+    static constexpr timer_wheel::clock::rep no_keeper = std::numeric_limits<timer_wheel::clock::rep>::max();
+    timer_wheel timers;
+    std::atomic<timer_wheel::clock::rep> keeper_deadline = no_keeper; // steady clock ticks of the parked timekeeper
+
+    io_ring io{ +[](void* pool) noexcept { static_cast<thread_pool*>(pool)->notifier.notify_one(); }, this };
+    std::atomic<bool> io_keeper = false; // a parked worker waits in the io ring
 };
 
 struct global_thread_pool_token {
-    static global_thread_pool_token init_scoped() noexcept
+    // the config is only used by the first token, the pool lives until that token is destroyed
+    static global_thread_pool_token init_scoped(thread_pool_config config = {}) noexcept
     {
-        return global_thread_pool_token();
+        return global_thread_pool_token(std::move(config));
     }
     static thread_pool& get_pool() noexcept
     {
@@ -281,10 +877,10 @@ struct global_thread_pool_token {
     }
 
 private:
-    global_thread_pool_token() noexcept
+    explicit global_thread_pool_token(thread_pool_config config) noexcept
     {
         if (!pool) {
-            pool.emplace(4);
+            pool.emplace(std::move(config));
         }
     }
 
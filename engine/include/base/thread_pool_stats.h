@@ -0,0 +1,171 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+// Per worker counters and the trace recorder, 0 compiles every hook out of the pool
+#ifndef W_THREAD_POOL_STATS
+#define W_THREAD_POOL_STATS 1
+#endif
+
+// MSVC accepts the standard attribute but ignores it for ABI reasons, only its own spelling drops the storage
+#if defined(_MSC_VER)
+#define W_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define W_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+namespace w::base {
+inline constexpr bool thread_pool_stats_enabled = W_THREAD_POOL_STATS != 0;
+
+enum class pool_counter : uint8_t {
+    tasks_executed,
+    local_pops, // tasks taken from the worker's own lanes
+    steal_attempts,
+    steals, // successful steal attempts, a batch counts once
+    failed_steals, // victim was empty or the race was lost
+    parks,
+    wakeups,
+    resume_ns, // time spent running tasks
+    push_stalls, // push_task waited for a full queue
+    timers_expired, // timers this worker took off the wheel
+    io_completions, // reads this worker reaped from the io ring
+    count
+};
+
+// Plain snapshot of the counters
+struct worker_counters {
+    std::array<uint64_t, size_t(pool_counter::count)> values{};
+
+public:
+    uint64_t operator[](pool_counter counter) const noexcept
+    {
+        return values[size_t(counter)];
+    }
+    worker_counters& operator+=(const worker_counters& other) noexcept
+    {
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] += other.values[i];
+        }
+        return *this;
+    }
+};
+
+// Counters of a single worker, on their own cache lines.
+// Only the owner writes (load + store, no read-modify-write), any thread may take a snapshot.
+class alignas(std::hardware_destructive_interference_size) counting_worker_stats
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+public:
+    void add(pool_counter counter, uint64_t n = 1) noexcept
+    {
+        auto& value = values[size_t(counter)];
+        value.store(value.load(std::memory_order::relaxed) + n, std::memory_order::relaxed);
+    }
+    worker_counters snapshot() const noexcept
+    {
+        worker_counters result;
+        for (size_t i = 0; i < values.size(); ++i) {
+            result.values[i] = values[i].load(std::memory_order::relaxed);
+        }
+        return result;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, size_t(pool_counter::count)> values{};
+};
+
+// Stand-in without storage, held as W_NO_UNIQUE_ADDRESS it takes no space in the worker
+struct no_worker_stats {
+    using clock = std::chrono::steady_clock;
+
+    void add(pool_counter, uint64_t = 1) noexcept
+    {
+    }
+    worker_counters snapshot() const noexcept
+    {
+        return {};
+    }
+};
+
+using worker_stats = std::conditional_t<thread_pool_stats_enabled, counting_worker_stats, no_worker_stats>;
+
+enum class trace_event_kind : uint8_t {
+    task, // one handle.resume()
+    explore, // idle worker looking for work
+    park, // blocked on the notifier
+};
+
+// Records per worker spans for chrome://tracing and Perfetto.
+// Every worker appends to its own fixed buffer, events past the capacity are dropped.
+// Recording only happens between start() and stop(), the buffers are written after stop().
+class trace_recorder
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct event {
+        clock::time_point begin;
+        clock::time_point end;
+        trace_event_kind kind;
+    };
+
+public:
+    explicit trace_recorder(size_t worker_count, size_t events_per_worker = 1 << 16) noexcept;
+    trace_recorder(const trace_recorder&) = delete;
+    trace_recorder& operator=(const trace_recorder&) = delete;
+
+public:
+    // clears previous events
+    void start() noexcept;
+    void stop() noexcept
+    {
+        recording.store(false, std::memory_order::release);
+    }
+    bool is_recording() const noexcept
+    {
+        return recording.load(std::memory_order::relaxed);
+    }
+
+    // called by the worker that owns the lane
+    void record(size_t worker, trace_event_kind kind, clock::time_point begin, clock::time_point end) noexcept
+    {
+        if (worker >= worker_count) {
+            return;
+        }
+        auto& lane = lanes[worker];
+        auto n = lane.count.load(std::memory_order::relaxed);
+        if (n == capacity) {
+            lane.dropped.store(lane.dropped.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+            return;
+        }
+        lane.events[n] = { begin, end, kind };
+        lane.count.store(n + 1, std::memory_order::release);
+    }
+
+    size_t dropped_events() const noexcept;
+    // Chrome trace event format, one track per worker named "<thread_name> <index>"
+    void write_chrome_trace(std::ostream& out, const std::string& thread_name = "w worker") const;
+
+private:
+    struct alignas(std::hardware_destructive_interference_size) lane {
+        std::unique_ptr<event[]> events;
+        std::atomic<size_t> count{ 0 };
+        std::atomic<size_t> dropped{ 0 };
+    };
+
+    size_t worker_count;
+    size_t capacity;
+    std::unique_ptr<lane[]> lanes;
+    std::atomic<bool> recording{ false };
+    clock::time_point origin;
+};
+} // namespace w::base
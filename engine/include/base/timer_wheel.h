@@ -0,0 +1,262 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <thread>
+
+namespace w::base {
+// Intrusive timer, lives in the awaiter inside the suspended coroutine frame
+struct timer_node {
+    static constexpr uint8_t not_in_wheel = 0xFF;
+
+    std::chrono::steady_clock::time_point deadline;
+    std::coroutine_handle<> handle{}; // resumed once the deadline passed
+    timer_node* next = nullptr;
+    uint8_t level = not_in_wheel; // slot in the wheel, owned by the servicing thread
+    uint8_t slot = 0;
+};
+
+// Hierarchical timer wheel with 1ms ticks: 4 levels of 64 slots cover about 4.6 hours,
+// later timers wait in the last level and are placed again when it cascades.
+// Any thread may schedule, timers are pushed onto a lock-free stack and sorted into the wheel
+// by whichever thread services it next. Servicing is a try-lock, a busy wheel is skipped instead of waited on.
+// Cancelling takes the same lock and waits for it.
+class timer_wheel
+{
+public:
+    using clock = std::chrono::steady_clock;
+    static constexpr size_t slot_bits = 6;
+    static constexpr size_t slot_count = size_t(1) << slot_bits;
+    static constexpr size_t level_count = 4;
+    static constexpr int64_t never = INT64_MAX;
+
+public:
+    timer_wheel() noexcept
+        : origin(clock::now())
+    {
+    }
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+public:
+    // true if the timer is earlier than every timer known before, so a sleeping servicer has to wake up
+    bool schedule(timer_node* timer) noexcept
+    {
+        auto deadline = to_ns(timer->deadline); // the node may expire and be gone once published
+        auto* head = incoming.load(std::memory_order::relaxed);
+        do {
+            timer->next = head;
+        } while (!incoming.compare_exchange_weak(head, timer, std::memory_order::seq_cst, std::memory_order::relaxed));
+
+        auto next = next_deadline_ns.load(std::memory_order::seq_cst);
+        while (deadline < next) {
+            if (next_deadline_ns.compare_exchange_weak(next, deadline, std::memory_order::seq_cst)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    // time_point::max() if there are no timers
+    clock::time_point next_deadline() const noexcept
+    {
+        auto next = next_deadline_ns.load(std::memory_order::seq_cst);
+        return next == never ? clock::time_point::max() : origin + std::chrono::nanoseconds(next);
+    }
+    bool empty() const noexcept
+    {
+        return next_deadline_ns.load(std::memory_order::relaxed) == never;
+    }
+
+    // Calls on_expired(handle) for every timer due at now.
+    // Returns false without doing anything if another thread is servicing the wheel.
+    template<typename F>
+    bool expire(clock::time_point now, F&& on_expired) noexcept
+    {
+        if (servicing.test_and_set(std::memory_order::acquire)) {
+            return false;
+        }
+        auto now_ns = to_ns(now);
+        auto now_tick = tick_of(now_ns);
+        do {
+            place(incoming.exchange(nullptr, std::memory_order::seq_cst), now_ns, on_expired);
+            advance(now_ns, now_tick, on_expired);
+            next_deadline_ns.store(earliest(), std::memory_order::seq_cst);
+        } while (incoming.load(std::memory_order::seq_cst)); // scheduled meanwhile, its minimum may have been overwritten
+        servicing.clear(std::memory_order::release);
+        return true;
+    }
+    // Removes a timer that has not expired, its handle is never resumed then and the node may go away.
+    // False if it expired already, the handle was passed to on_expired.
+    bool cancel(timer_node* timer) noexcept
+    {
+        while (servicing.test_and_set(std::memory_order::acquire)) {
+            std::this_thread::yield(); // a servicing pass is short
+        }
+        bool found = false;
+        do {
+            // sorted in without expiring, due timers stay in the current tick for the next pass
+            auto* list = incoming.exchange(nullptr, std::memory_order::seq_cst);
+            while (list) {
+                auto* next = list->next;
+                if (list == timer) {
+                    found = true;
+                } else {
+                    insert(list, tick_of(to_ns(list->deadline)));
+                }
+                list = next;
+            }
+            if (!found && timer->level != timer_node::not_in_wheel) {
+                unlink(timer);
+                found = true;
+            }
+            next_deadline_ns.store(earliest(), std::memory_order::seq_cst);
+        } while (incoming.load(std::memory_order::seq_cst));
+        servicing.clear(std::memory_order::release);
+        return found;
+    }
+
+private:
+    int64_t to_ns(clock::time_point time) const noexcept
+    {
+        return std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time - origin).count(), 0);
+    }
+    static uint64_t tick_of(int64_t ns) noexcept
+    {
+        return uint64_t(ns) / 1'000'000;
+    }
+
+    template<typename F>
+    void place(timer_node* list, int64_t now_ns, F& on_expired) noexcept
+    {
+        while (list) {
+            auto* next = list->next;
+            auto deadline = to_ns(list->deadline);
+            if (deadline <= now_ns) {
+                on_expired(list->handle); // the node is gone once the handle runs
+            } else {
+                insert(list, tick_of(deadline));
+            }
+            list = next;
+        }
+    }
+    void insert(timer_node* timer, uint64_t tick) noexcept
+    {
+        tick = std::max(tick, current_tick); // serviced with a later now before, it expires on the next pass
+        auto delta = tick - current_tick;
+        size_t level = 0;
+        while (level + 1 < level_count && delta >= (uint64_t(1) << (slot_bits * (level + 1)))) {
+            ++level;
+        }
+        if (level == level_count - 1 && delta >= (uint64_t(1) << (slot_bits * level_count))) {
+            tick = current_tick + (uint64_t(1) << (slot_bits * level_count)) - 1; // placed again when the slot cascades
+        }
+        auto slot = (tick >> (slot_bits * level)) & (slot_count - 1);
+        timer->next = levels[level].slots[slot];
+        timer->level = uint8_t(level);
+        timer->slot = uint8_t(slot);
+        levels[level].slots[slot] = timer;
+        levels[level].occupied |= uint64_t(1) << slot;
+        ++count;
+    }
+    timer_node* take_slot(size_t level, size_t slot) noexcept
+    {
+        levels[level].occupied &= ~(uint64_t(1) << slot);
+        auto* list = levels[level].slots[slot];
+        levels[level].slots[slot] = nullptr;
+        for (auto* t = list; t; t = t->next) {
+            t->level = timer_node::not_in_wheel;
+            --count;
+        }
+        return list;
+    }
+    void unlink(timer_node* timer) noexcept
+    {
+        auto& l = levels[timer->level];
+        auto** link = &l.slots[timer->slot];
+        while (*link != timer) {
+            link = &(*link)->next;
+        }
+        *link = timer->next;
+        if (!l.slots[timer->slot]) {
+            l.occupied &= ~(uint64_t(1) << timer->slot);
+        }
+        timer->level = timer_node::not_in_wheel;
+        --count;
+    }
+
+    // Walks the ticks up to now, cascading higher levels on the way.
+    // The current tick stays open, its timers may be later than now within the same millisecond.
+    template<typename F>
+    void advance(int64_t now_ns, uint64_t now_tick, F& on_expired) noexcept
+    {
+        while (true) {
+            if (count == 0) {
+                current_tick = std::max(current_tick, now_tick);
+                return;
+            }
+            for (size_t level = level_count - 1; level > 0; --level) {
+                if ((current_tick & ((uint64_t(1) << (slot_bits * level)) - 1)) == 0) {
+                    auto* list = take_slot(level, (current_tick >> (slot_bits * level)) & (slot_count - 1));
+                    place(list, now_ns, on_expired);
+                }
+            }
+
+            auto slot = current_tick & (slot_count - 1);
+            auto* list = take_slot(0, slot);
+            while (list) {
+                auto* next = list->next;
+                if (to_ns(list->deadline) <= now_ns) {
+                    on_expired(list->handle);
+                } else {
+                    insert(list, current_tick); // later within the current tick
+                }
+                list = next;
+            }
+            if (current_tick >= now_tick) {
+                return;
+            }
+            ++current_tick;
+        }
+    }
+
+    // the first occupied slot of a level, in time order, holds the earliest timers of that level
+    int64_t earliest() const noexcept
+    {
+        int64_t result = never;
+        for (size_t level = 0; level < level_count; ++level) {
+            auto occupied = levels[level].occupied;
+            if (!occupied) {
+                continue;
+            }
+            // above level 0 the current slot only holds timers a full turn ahead
+            auto position = ((current_tick >> (slot_bits * level)) + (level ? 1 : 0)) & (slot_count - 1);
+            auto rotated = std::rotr(occupied, int(position));
+            auto slot = (position + std::countr_zero(rotated)) & (slot_count - 1);
+            for (auto* t = levels[level].slots[slot]; t; t = t->next) {
+                result = std::min(result, to_ns(t->deadline));
+            }
+        }
+        return result;
+    }
+
+private:
+    struct level {
+        std::array<timer_node*, slot_count> slots{};
+        uint64_t occupied = 0; // bit per non-empty slot
+    };
+
+    clock::time_point origin;
+    std::atomic<timer_node*> incoming{ nullptr };
+    std::atomic<int64_t> next_deadline_ns{ never };
+    std::atomic_flag servicing;
+
+    // owned by the servicing thread
+    std::array<level, level_count> levels{};
+    uint64_t current_tick = 0;
+    size_t count = 0;
+};
+} // namespace w::base
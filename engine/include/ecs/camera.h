@@ -1,19 +1,47 @@
 #pragma once
 #include <ecs/transform.h>
+#include <math/bounds.h>
 
 namespace w::ecs {
 struct camera : public transform {
 private:
     mutable math::float4x4a view;
+    mutable uint32_t view_generation = 0; // generation of the transform the view was built from
+    math::float4x4a projection = math::perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
 public:
+    // rebuilt only after the position or rotation changed
     math::matrix get_view() const noexcept
     {
-        if (dirty()) {
+        if (view_generation != get_generation()) {
             constexpr static math::vector forward = math::identity[2];
             auto look_vector = math::transform(get_rotation(), forward);
             view = math::look_to(get_position(), look_vector, math::identity[1]);
+            view_generation = get_generation();
         }
         return view;
     }
+    math::matrix get_projection() const noexcept
+    {
+        return projection;
+    }
+    void set_perspective(float fov_y, float aspect, float near_z, float far_z) noexcept
+    {
+        projection = math::perspective(fov_y, aspect, near_z, far_z);
+    }
+    void set_orthographic(float width, float height, float near_z, float far_z) noexcept
+    {
+        projection = math::orthographic(width, height, near_z, far_z);
+    }
+
+    math::matrix get_view_projection() const noexcept
+    {
+        return math::multiply(get_view(), get_projection());
+    }
+    // world space planes for culling, see math/culling.h
+    math::frustum get_frustum() const noexcept
+    {
+        return math::frustum(get_view_projection());
+    }
 };
-}
\ No newline at end of file
+}
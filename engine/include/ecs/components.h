@@ -0,0 +1,39 @@
+#pragma once
+#include <math/quantize.h>
+#include <math/vector.h>
+
+// Transform components of the registry, each in its own column.
+// Plain storage types, load them into math::vector for math.
+
+namespace w::ecs {
+struct position {
+    math::float3 value;
+};
+// quaternion, x y z w
+struct rotation {
+    math::float4 value{ 0.0f, 0.0f, 0.0f, 1.0f };
+};
+struct scale {
+    math::float3 value{ 1.0f, 1.0f, 1.0f };
+};
+
+// Position, scale and rotation in 16 bytes, 4 per cache line, for large static scenes and snapshots.
+// The position is relative to a cell known to the owner, see math/quantize.h for the error bounds.
+struct packed_transform {
+    math::packed_position position;
+    math::half3 scale;
+    math::packed_quat32 rotation;
+};
+static_assert(sizeof(packed_transform) == 16);
+
+inline packed_transform pack(const position& p, const rotation& r, const scale& s, const math::position_cell& cell) noexcept
+{
+    return { math::pack(p.value, cell), math::pack_half(s.value), math::pack32(math::quaternion(r.value)) };
+}
+inline void unpack(const packed_transform& packed, const math::position_cell& cell, position& p, rotation& r, scale& s) noexcept
+{
+    p.value = math::unpack(packed.position, cell);
+    r.value = math::unpack(packed.rotation);
+    s.value = math::unpack(packed.scale);
+}
+} // namespace w::ecs
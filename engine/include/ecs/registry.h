@@ -0,0 +1,336 @@
+#pragma once
+#include <base/tasks.h>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Archetype based entity storage.
+// Entities with the same set of components share an archetype, which keeps them in chunks of chunk_size bytes.
+// A chunk holds one column per component, structure of arrays, so a view touches only the columns it asks for.
+// Adding or removing a component moves the entity to another archetype, the last entity of the old one fills the gap.
+
+namespace w::ecs {
+// Index into the registry plus the generation of the slot, a destroyed entity never compares equal to a new one
+struct entity {
+    static constexpr uint32_t invalid_index = ~0u;
+
+    uint32_t index = invalid_index;
+    uint32_t generation = 0;
+
+    constexpr bool valid() const noexcept
+    {
+        return index != invalid_index;
+    }
+    friend constexpr bool operator==(entity, entity) noexcept = default;
+};
+
+inline constexpr size_t chunk_size = 16 * 1024;
+inline constexpr size_t max_components = 64;
+
+using component_id = uint32_t;
+using component_mask = uint64_t; // bit i set if component i is present
+
+// Components are plain data, they are moved between chunks with memcpy and never destroyed
+template<typename T>
+concept component = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T> && std::is_default_constructible_v<T> && !std::is_const_v<T>;
+
+struct component_info {
+    uint32_t size = 0;
+    uint32_t alignment = 0;
+};
+
+namespace detail {
+component_id register_component(component_info info) noexcept;
+} // namespace detail
+
+const component_info& get_component_info(component_id id) noexcept;
+
+// Id of the component type, assigned on first use and shared by all registries
+template<component T>
+component_id component_type_id() noexcept
+{
+    static const component_id id = detail::register_component({ sizeof(T), alignof(T) });
+    return id;
+}
+
+template<component... Ts>
+component_mask component_type_mask() noexcept
+{
+    return (component_mask(0) | ... | (component_mask(1) << component_type_id<Ts>()));
+}
+
+struct chunk_deleter {
+    void operator()(std::byte* memory) const noexcept
+    {
+        ::operator delete(memory, std::align_val_t{ 64 });
+    }
+};
+
+struct chunk {
+    std::unique_ptr<std::byte, chunk_deleter> memory; // chunk_size bytes, the entity column comes first
+    uint32_t count = 0;
+
+    std::span<const entity> entities() const noexcept
+    {
+        return { reinterpret_cast<const entity*>(memory.get()), count };
+    }
+};
+
+// Entities sharing one set of components
+class archetype
+{
+    friend class registry;
+    static constexpr uint16_t no_column = 0xffff;
+
+public:
+    explicit archetype(component_mask mask);
+
+public:
+    component_mask mask() const noexcept
+    {
+        return signature;
+    }
+    bool contains(component_mask components) const noexcept
+    {
+        return (signature & components) == components;
+    }
+    // entities per chunk
+    uint32_t chunk_capacity() const noexcept
+    {
+        return capacity;
+    }
+    size_t size() const noexcept
+    {
+        return entity_count;
+    }
+    // chunks past the last non empty one are kept for reuse
+    std::span<chunk> chunks() noexcept
+    {
+        return std::span{ chunk_list }.first(used_chunks);
+    }
+    std::span<const chunk> chunks() const noexcept
+    {
+        return std::span{ chunk_list }.first(used_chunks);
+    }
+
+    // column of the component in the chunk, the archetype has to contain it
+    void* column(const chunk& c, component_id id) const noexcept
+    {
+        assert(offsets[id] != no_column);
+        return c.memory.get() + offsets[id];
+    }
+    template<component T>
+    T* column(const chunk& c) const noexcept
+    {
+        return static_cast<T*>(column(c, component_type_id<T>()));
+    }
+
+private:
+    struct location {
+        uint32_t chunk;
+        uint32_t row;
+    };
+    // appends the entity and leaves its components uninitialized
+    location push(entity e);
+    // fills the row with the last entity, returns the entity that moved or an invalid one
+    entity erase(location at) noexcept;
+
+private:
+    component_mask signature;
+    uint32_t capacity = 0;
+    std::array<uint16_t, max_components> offsets; // byte offset of each column in a chunk
+    std::vector<component_id> components;
+    std::vector<chunk> chunk_list;
+    size_t used_chunks = 0;
+    size_t entity_count = 0;
+
+    // archetype with one component more or less, filled on first use
+    std::array<archetype*, max_components> add_edges{};
+    std::array<archetype*, max_components> remove_edges{};
+};
+
+template<typename... Ts>
+class view;
+
+class registry
+{
+public:
+    registry();
+    registry(const registry&) = delete;
+    registry& operator=(const registry&) = delete;
+    ~registry();
+
+public:
+    entity create();
+    template<component... Ts>
+    entity create(const Ts&... values)
+    {
+        entity e = create_in(component_type_mask<Ts...>());
+        (std::memcpy(get_component(e, component_type_id<Ts>()), &values, sizeof(Ts)), ...);
+        return e;
+    }
+    void destroy(entity e) noexcept;
+    bool alive(entity e) const noexcept
+    {
+        return e.index < records.size() && records[e.index].generation == e.generation && records[e.index].owner;
+    }
+    // live entities
+    size_t size() const noexcept
+    {
+        return records.size() - free_list.size();
+    }
+
+    // Sets the component, the entity moves to a new archetype if it did not have it yet
+    template<component T>
+    T& add(entity e, const T& value = {})
+    {
+        void* data = add_component(e, component_type_id<T>());
+        std::memcpy(data, &value, sizeof(T));
+        return *static_cast<T*>(data);
+    }
+    template<component T>
+    void remove(entity e)
+    {
+        remove_component(e, component_type_id<T>());
+    }
+    template<component T>
+    bool has(entity e) const noexcept
+    {
+        return alive(e) && records[e.index].owner->contains(component_type_mask<T>());
+    }
+    // nullptr if the entity does not have the component
+    template<component T>
+    T* get(entity e) noexcept
+    {
+        return has<T>(e) ? static_cast<T*>(get_component(e, component_type_id<T>())) : nullptr;
+    }
+
+    // Entities with all of the components, const components are read only.
+    // Structural changes invalidate the view.
+    template<typename... Ts>
+    ecs::view<Ts...> view()
+    {
+        return ecs::view<Ts...>{ matching(component_type_mask<std::remove_const_t<Ts>...>()) };
+    }
+    std::span<const std::unique_ptr<archetype>> archetypes() const noexcept
+    {
+        return archetype_list;
+    }
+
+    // Type erased access, for the templates above and for systems that do not know the type
+    void* add_component(entity e, component_id id);
+    void remove_component(entity e, component_id id);
+    void* get_component(entity e, component_id id) noexcept;
+
+private:
+    struct record {
+        archetype* owner = nullptr; // nullptr for free slots
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    entity create_in(component_mask mask);
+    archetype* find_or_create(component_mask mask);
+    void move_entity(entity e, archetype* target);
+    std::vector<archetype*> matching(component_mask mask) const;
+
+private:
+    std::vector<std::unique_ptr<archetype>> archetype_list;
+    std::unordered_map<component_mask, archetype*> archetype_lookup;
+    std::vector<record> records;
+    std::vector<uint32_t> free_list;
+};
+
+// Entities of every archetype that contains Ts..., iterated chunk by chunk
+template<typename... Ts>
+class view
+{
+    static_assert((component<std::remove_const_t<Ts>> && ...), "views are over components");
+
+public:
+    view() noexcept = default;
+    explicit view(std::vector<archetype*> archetypes) noexcept
+        : matches(std::move(archetypes))
+    {
+    }
+
+public:
+    size_t size() const noexcept
+    {
+        size_t count = 0;
+        for (const archetype* a : matches) {
+            count += a->size();
+        }
+        return count;
+    }
+    std::span<archetype* const> archetypes() const noexcept
+    {
+        return matches;
+    }
+
+    // f(std::span<const entity>, std::span<Ts>...) once per chunk
+    template<typename F>
+    void each_chunk(F&& f) const
+    {
+        for (archetype* a : matches) {
+            for (chunk& c : a->chunks()) {
+                call_chunk(f, *a, c);
+            }
+        }
+    }
+    // f(Ts&...) or f(entity, Ts&...) once per entity
+    template<typename F>
+    void each(F&& f) const
+    {
+        each_chunk([&f](std::span<const entity> entities, std::span<Ts>... columns) {
+            for (size_t i = 0; i < entities.size(); ++i) {
+                if constexpr (std::is_invocable_v<F&, entity, Ts&...>) {
+                    f(entities[i], columns[i]...);
+                } else {
+                    f(columns[i]...);
+                }
+            }
+        });
+    }
+
+    // Runs f(std::span<const entity>, std::span<Ts>...) on every chunk in parallel on the thread pool.
+    // The registry, the view and f have to stay alive and unchanged until the task finishes.
+    template<typename F>
+    w::task<void> each_chunk_parallel(F f) const
+    {
+        std::vector<w::task<void>> tasks;
+        for (archetype* a : matches) {
+            for (chunk& c : a->chunks()) {
+                tasks.push_back(run_chunk(f, *a, c));
+            }
+        }
+        if (!tasks.empty()) {
+            co_await w::when_all(std::span{ tasks });
+        }
+    }
+
+private:
+    template<typename F>
+    static void call_chunk(F& f, const archetype& a, const chunk& c)
+    {
+        f(c.entities(), std::span<Ts>{ a.template column<std::remove_const_t<Ts>>(c), c.count }...);
+    }
+    template<typename F>
+    static w::task<void> run_chunk(const F& f, const archetype& a, const chunk& c)
+    {
+        call_chunk(f, a, c);
+        co_return;
+    }
+
+private:
+    std::vector<archetype*> matches;
+};
+} // namespace w::ecs
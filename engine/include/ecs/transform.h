@@ -2,8 +2,68 @@
 #include <math/vector_math.h>
 #include <math/matrix_math.h>
 #include <math/quaternion_math.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
 namespace w::ecs {
+struct transform;
+
+// Transforms changed through their setters since the last take(), each listed once.
+// Lets a system visit what moved this frame in time proportional to the changes.
+class transform_changes
+{
+public:
+    // the list, clears it
+    static std::vector<transform*> take();
+    static size_t size() noexcept;
+
+    // Moves with the changes of any transform, independent of take().
+    // A cached matrix checked at the current epoch is still valid.
+    static uint64_t epoch() noexcept
+    {
+        return current_epoch() >> 1; // without the observed bit, reads do not move it
+    }
+
+private:
+    friend struct transform;
+    static void changed(transform& t);
+    static void forget(transform& t) noexcept;
+    static void hand_over(transform& from, transform& to) noexcept;
+    static void remove_at(uint32_t index) noexcept;
+
+    // raw word with the observed bit, what a cache remembers
+    static uint64_t current_epoch() noexcept
+    {
+        return change_epoch.load(std::memory_order::acquire);
+    }
+    // The low bit of the epoch is set once a cache remembered it, flag and epoch share one word
+    // so a change on another thread cannot clear the flag between the load and the store of a reader.
+    // The epoch a cache is about to remember, the next change has to move it.
+    static uint64_t observe_epoch() noexcept
+    {
+        auto epoch = change_epoch.load(std::memory_order::acquire);
+        if (!(epoch & observed)) {
+            epoch = change_epoch.fetch_or(observed, std::memory_order::acq_rel) | observed;
+        }
+        return epoch;
+    }
+    // only the first change after a cache remembered the epoch pays for the shared increment
+    static void next_epoch() noexcept
+    {
+        auto epoch = change_epoch.load(std::memory_order::relaxed);
+        while ((epoch & observed) && !change_epoch.compare_exchange_weak(epoch, epoch + 1, std::memory_order::release, std::memory_order::relaxed)) {
+        }
+    }
+
+    static constexpr uint64_t observed = 1;
+    static inline std::atomic<uint64_t> change_epoch{ 2 }; // above the checked_epoch of a new transform, not observed
+};
+
+// Position, rotation and scale under an optional parent.
+// Every change bumps the generation of the transform. The cached world matrix remembers the generation
+// and the parent world generation it was built from, so it is recomputed exactly once per change upstream.
+// A read is O(1) as long as no transform changed since the previous read of this one.
 struct transform {
 private:
     math::float3a position;
@@ -12,37 +72,95 @@ private:
 
     // Cached matrix
     mutable math::float4x4a matrix;
-    mutable bool _dirty = true; // Whether the matrix needs to be recalculated
     transform* parent = nullptr; // Parent transform
 
+    uint32_t generation = 1; // bumped by every setter
+    mutable uint32_t built_generation = 0; // generation the matrix was built from
+    mutable uint32_t built_parent_generation = 0; // world generation of the parent it was built from
+    mutable uint32_t world_generation = 0; // bumped whenever the matrix is rebuilt
+    mutable uint64_t checked_epoch = 0; // nothing changed since
+    std::atomic<uint32_t> queue_index{ not_queued }; // slot in transform_changes, written under its lock
+
+    static constexpr uint32_t not_queued = ~0u;
+    friend class transform_changes;
+
+public:
+    transform() noexcept = default;
+    // copies start with their own change history
+    transform(const transform& other) noexcept
+        : position(other.position), rotation(other.rotation), scale(other.scale), parent(other.parent)
+    {
+    }
+    // moves keep the history and take over the slot in transform_changes
+    transform(transform&& other) noexcept
+        : position(other.position), rotation(other.rotation), scale(other.scale), matrix(other.matrix), parent(other.parent)
+        , generation(other.generation), built_generation(other.built_generation), built_parent_generation(other.built_parent_generation)
+        , world_generation(other.world_generation), checked_epoch(other.checked_epoch)
+    {
+        if (other.queue_index.load(std::memory_order::relaxed) != not_queued) {
+            transform_changes::hand_over(other, *this);
+        }
+    }
+    transform& operator=(const transform& other)
+    {
+        position = other.position;
+        rotation = other.rotation;
+        scale = other.scale;
+        parent = other.parent;
+        changed();
+        return *this;
+    }
+    transform& operator=(transform&& other) noexcept
+    {
+        position = other.position;
+        rotation = other.rotation;
+        scale = other.scale;
+        parent = other.parent;
+        if (other.queue_index.load(std::memory_order::relaxed) != not_queued) {
+            transform_changes::hand_over(other, *this);
+        }
+        changed();
+        return *this;
+    }
+    ~transform()
+    {
+        if (queue_index.load(std::memory_order::relaxed) != not_queued) {
+            transform_changes::forget(*this);
+        }
+    }
+
 public:
+    // whether world_matrix() would rebuild the matrix
     bool dirty() const noexcept
     {
-        return _dirty || (parent && parent->dirty());
+        if (checked_epoch == transform_changes::current_epoch()) {
+            return false;
+        }
+        return built_generation != generation || (parent && (parent->dirty() || parent->world_generation != built_parent_generation));
     }
     void set_dirty() noexcept
     {
-        _dirty = true;
+        changed();
     }
     void set_position(math::vector pos) noexcept
     {
         position = pos;
-        _dirty = true;
+        changed();
     }
     void set_rotation(math::quaternion rot) noexcept
     {
         rotation = rot;
-        _dirty = true;
+        changed();
     }
     void set_scale(math::vector s) noexcept
     {
         scale = s;
-        _dirty = true;
+        changed();
     }
     void set_parent(transform* p) noexcept
     {
         parent = p;
-        _dirty = true;
+        changed();
     }
 
 public:
@@ -62,19 +180,54 @@ public:
     {
         return parent;
     }
+    // number of setter calls, for caches derived from the local values
+    uint32_t get_generation() const noexcept
+    {
+        return generation;
+    }
+    // number of world matrix rebuilds, for caches derived from the world matrix
+    uint32_t get_world_generation() const noexcept
+    {
+        world_matrix();
+        return world_generation;
+    }
 
     math::matrix local_matrix() const noexcept
     {
         auto qrotation = math::matrix(math::quaternion(rotation));
         return math::scale(scale) * qrotation * math::translate(position);
     }
+    // local * parent world, row vectors
     math::matrix world_matrix() const noexcept
     {
-        if (dirty()) {
-            matrix = parent ? parent->world_matrix() * local_matrix() : local_matrix();
-            _dirty = false;
+        uint64_t epoch = transform_changes::observe_epoch();
+        if (checked_epoch == epoch) {
+            return matrix;
+        }
+        uint32_t parent_generation = 0;
+        math::matrix parent_world;
+        if (parent) {
+            parent_world = parent->world_matrix();
+            parent_generation = parent->world_generation;
         }
+        if (built_generation != generation || built_parent_generation != parent_generation) {
+            matrix = parent ? math::multiply(local_matrix(), parent_world) : local_matrix();
+            built_generation = generation;
+            built_parent_generation = parent_generation;
+            ++world_generation;
+        }
+        checked_epoch = epoch;
         return matrix;
     }
+
+private:
+    void changed() noexcept
+    {
+        ++generation;
+        transform_changes::next_epoch();
+        if (queue_index.load(std::memory_order::relaxed) == not_queued) {
+            transform_changes::changed(*this); // checks again under the lock, take() may clear it meanwhile
+        }
+    }
 };
-} // namespace w::esc
\ No newline at end of file
+} // namespace w::ecs
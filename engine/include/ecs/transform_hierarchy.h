@@ -0,0 +1,81 @@
+#pragma once
+#include <base/tasks.h>
+#include <math/matrix.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace w::ecs {
+// Parent child relations of transforms, world = local * parent world with row vectors.
+// Nodes are kept in flat arrays sorted by depth, children of one parent next to each other,
+// so update() walks each level once and recomputes only the subtrees below changed nodes.
+// Structural changes are applied at the next update().
+class transform_hierarchy
+{
+public:
+    using node = uint32_t;
+    static constexpr node no_parent = ~0u;
+    static constexpr size_t parallel_grain = 4096; // nodes per pool task in update_parallel, a multiple of 64
+
+public:
+    node add(node parent = no_parent, const math::matrix& local = math::identity);
+    // the parent must not be a descendant of n
+    void set_parent(node n, node parent);
+    void set_local(node n, const math::matrix& local) noexcept
+    {
+        locals[slots[n]] = local;
+        mark_dirty(slots[n]);
+    }
+
+    node parent(node n) const noexcept
+    {
+        return parent_nodes[n];
+    }
+    math::matrix local(node n) const noexcept
+    {
+        return locals[slots[n]];
+    }
+    // as of the last update
+    math::matrix world(node n) const noexcept
+    {
+        return worlds[slots[n]];
+    }
+    size_t size() const noexcept
+    {
+        return parent_nodes.size();
+    }
+    // levels of the sorted arrays, 0 before the first update
+    size_t depth() const noexcept
+    {
+        return level_begin.empty() ? 0 : level_begin.size() - 1;
+    }
+
+    // Recomputes the world matrices of changed nodes and their descendants, returns how many were computed
+    size_t update();
+    // Same as update(), each level is split across the thread pool.
+    // The hierarchy must not be used until the task finishes.
+    w::task<size_t> update_parallel();
+
+private:
+    void mark_dirty(uint32_t slot) noexcept
+    {
+        dirty[slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+    void sort_by_depth();
+    size_t update_range(size_t begin, size_t end, bool parents_changed) noexcept;
+    static w::task<size_t> update_range_async(transform_hierarchy& self, size_t begin, size_t end, bool parents_changed);
+
+private:
+    // by node
+    std::vector<node> parent_nodes;
+    std::vector<uint32_t> slots; // position in the sorted arrays
+
+    // by slot
+    std::vector<uint32_t> parent_slots;
+    std::vector<math::float4x4a> locals;
+    std::vector<math::float4x4a> worlds;
+    std::vector<uint64_t> dirty; // set_local since the last update, then whole dirty subtrees during it
+    std::vector<uint32_t> level_begin; // first slot of each level, plus the end
+    bool structure_changed = false;
+};
+} // namespace w::ecs
@@ -0,0 +1,81 @@
+#pragma once
+#include <math/matrix.h>
+#include <array>
+#include <span>
+
+// Span based versions of multiply and transform for thousands of elements per call.
+// The kernels process 8 (AVX2) or 16 (AVX-512) elements per iteration,
+// without AVX2 they fall back to one element at a time.
+// See simd.h for how the instruction set is picked.
+// Results match the single element functions up to rounding.
+
+namespace w::math {
+// Structure of arrays views, every component holds the same number of elements
+struct float3_soa {
+    std::span<float> x, y, z;
+
+    size_t size() const noexcept
+    {
+        return x.size();
+    }
+};
+struct const_float3_soa {
+    const_float3_soa() noexcept = default;
+    const_float3_soa(std::span<const float> x, std::span<const float> y, std::span<const float> z) noexcept
+        : x(x), y(y), z(z)
+    {
+    }
+    const_float3_soa(float3_soa other) noexcept
+        : x(other.x), y(other.y), z(other.z)
+    {
+    }
+
+    size_t size() const noexcept
+    {
+        return x.size();
+    }
+
+    std::span<const float> x, y, z;
+};
+
+// one array per matrix element, m[row * 4 + column]
+struct float4x4_soa {
+    std::array<std::span<float>, 16> m;
+
+    size_t size() const noexcept
+    {
+        return m[0].size();
+    }
+};
+struct const_float4x4_soa {
+    const_float4x4_soa() noexcept = default;
+    const_float4x4_soa(const std::array<std::span<const float>, 16>& m) noexcept
+        : m(m)
+    {
+    }
+    const_float4x4_soa(const float4x4_soa& other) noexcept
+    {
+        for (size_t i = 0; i < 16; ++i) {
+            m[i] = other.m[i];
+        }
+    }
+
+    size_t size() const noexcept
+    {
+        return m[0].size();
+    }
+
+    std::array<std::span<const float>, 16> m;
+};
+
+// out[i] = a[i] * b[i] for the length of out, out may be the same span as a or b
+void multiply_batch(std::span<const float4x4a> a, std::span<const float4x4a> b, std::span<float4x4a> out) noexcept;
+// out[i] = a[i] * b, e.g. local transforms under a shared parent
+void multiply_batch(std::span<const float4x4a> a, const matrix& b, std::span<float4x4a> out) noexcept;
+// out may be the same arrays as a
+void multiply_batch(const const_float4x4_soa& a, const const_float4x4_soa& b, const float4x4_soa& out) noexcept;
+
+// out[i] = transform(m, points[i]) with w = 1, out may be the same span as points
+void transform_points(std::span<const float3> points, const matrix& m, std::span<float3> out) noexcept;
+void transform_points(const_float3_soa points, const matrix& m, float3_soa out) noexcept;
+} // namespace w::math
@@ -0,0 +1,113 @@
+#pragma once
+#include <math/matrix_math.h>
+
+// Bounding volumes and the view frustum. The tests are conservative:
+// false means outside for sure, volumes near the frustum corners may pass.
+// Span versions for whole scenes are in culling.h.
+
+namespace w::math {
+// axis aligned box as center and half extents
+struct aabb {
+    float3 center;
+    float3 extents;
+
+    static constexpr aabb from_min_max(vector min, vector max) noexcept
+    {
+        return { (min + max) * 0.5f, (max - min) * 0.5f };
+    }
+};
+struct bounding_sphere {
+    float3 center;
+    float radius = 0.0f;
+};
+
+// Planes as (normal, d), normals point inside and are normalized,
+// a point p is on the inner side if dot(normal, p) + d >= 0.
+struct frustum {
+    // near and far are macros on Windows
+    enum plane_index : uint8_t {
+        left_plane,
+        right_plane,
+        bottom_plane,
+        top_plane,
+        near_plane,
+        far_plane,
+        plane_count
+    };
+
+    constexpr frustum() noexcept = default;
+    // planes of v * view_projection, clip space x and y in [-w, w] and depth in [0, w] as from perspective
+    explicit constexpr frustum(const matrix& view_projection) noexcept
+    {
+        // clip = v * m, so each plane is a combination of the columns of m
+        matrix columns = transpose(view_projection);
+        vector unnormalized[plane_count] = {
+            columns[3] + columns[0],
+            columns[3] - columns[0],
+            columns[3] + columns[1],
+            columns[3] - columns[1],
+            columns[2],
+            columns[3] - columns[2],
+        };
+        for (size_t i = 0; i < plane_count; ++i) {
+            planes[i] = unnormalized[i] / length(unnormalized[i]);
+        }
+    }
+
+public:
+    float4a planes[plane_count];
+};
+
+namespace detail {
+constexpr inline vector point(float3 p) noexcept
+{
+    if (std::is_constant_evaluated()) {
+        return { p[0], p[1], p[2], 1.0f };
+    } else {
+        return _mm_blend_ps(vector(p), identity[3], 0b1000);
+    }
+}
+} // namespace detail
+
+inline bool intersects(const frustum& f, const aabb& box) noexcept
+{
+    constexpr vector sign_mask{ -0.0f, broadcast };
+    vector center = detail::point(box.center);
+    vector extents = box.extents;
+
+    // distance of the center plus the extents projected on the normal, smallest over the planes
+    vector nearest{ std::numeric_limits<float>::infinity(), broadcast };
+    for (const auto& plane : f.planes) {
+        vector p = plane;
+        vector distance = dot<4>(p, center) + dot<3>(_mm_andnot_ps(sign_mask, p), extents);
+        nearest = _mm_min_ps(nearest, distance);
+    }
+    return float(nearest) >= 0.0f;
+}
+inline bool intersects(const frustum& f, const bounding_sphere& sphere) noexcept
+{
+    vector center = detail::point(sphere.center);
+    vector nearest{ std::numeric_limits<float>::infinity(), broadcast };
+    for (const auto& plane : f.planes) {
+        nearest = _mm_min_ps(nearest, dot<4>(plane, center));
+    }
+    return float(nearest) >= -sphere.radius;
+}
+
+// box around the transformed box, row vectors like transform
+inline aabb transform(const matrix& m, const aabb& box) noexcept
+{
+    constexpr vector sign_mask{ -0.0f, broadcast };
+    vector e = box.extents;
+    vector extents = _mm_mul_ps(_mm_shuffle_ps(e, e, _MM_SHUFFLE(0, 0, 0, 0)), _mm_andnot_ps(sign_mask, m[0]));
+    extents = fmadd(vector(_mm_shuffle_ps(e, e, _MM_SHUFFLE(1, 1, 1, 1))), _mm_andnot_ps(sign_mask, m[1]), extents);
+    extents = fmadd(vector(_mm_shuffle_ps(e, e, _MM_SHUFFLE(2, 2, 2, 2))), _mm_andnot_ps(sign_mask, m[2]), extents);
+    return { transform(m, vector(box.center)), extents };
+}
+// the radius grows with the largest scale of m
+inline bounding_sphere transform(const matrix& m, const bounding_sphere& sphere) noexcept
+{
+    vector scale_sq = _mm_max_ps(_mm_max_ps(length_sq(m[0]), length_sq(m[1])), length_sq(m[2]));
+    return { transform(m, vector(sphere.center)), sphere.radius * float(vector(_mm_sqrt_ps(scale_sq))) };
+}
+} // namespace w::math
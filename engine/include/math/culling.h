@@ -0,0 +1,23 @@
+#pragma once
+#include <base/tasks.h>
+#include <math/bounds.h>
+#include <cstdint>
+#include <span>
+
+// Frustum tests for whole scenes, visible[i] is 1 if objects[i] may be visible and 0 if not.
+// The kernels test 8 objects per iteration with AVX2 and fall back to intersects() without it,
+// see simd.h. Results match intersects() up to rounding on the plane.
+
+namespace w::math {
+// objects are tested over the length of visible
+void cull(std::span<const aabb> boxes, const frustum& f, std::span<uint8_t> visible) noexcept;
+void cull(std::span<const bounding_sphere> spheres, const frustum& f, std::span<uint8_t> visible) noexcept;
+
+// objects per thread pool task in cull_parallel, smaller scenes run on the awaiting thread
+inline constexpr size_t cull_chunk_size = 16384;
+
+// Splits the scene into chunks culled in parallel on the thread pool.
+// The spans and the frustum have to stay alive until the task finishes.
+w::task<void> cull_parallel(std::span<const aabb> boxes, const frustum& f, std::span<uint8_t> visible);
+w::task<void> cull_parallel(std::span<const bounding_sphere> spheres, const frustum& f, std::span<uint8_t> visible);
+} // namespace w::math
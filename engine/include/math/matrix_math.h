@@ -1,8 +1,39 @@
 #pragma once
 #include <math/matrix.h>
+#include <math/simd.h>
+#include <math/transcendental.h>
 #include <math/vector_math.h>
 
 namespace w::math {
+namespace detail {
+// constexpr path of inverse and determinant, cofactors from the 2x2 minors
+// of the upper (s) and the lower (c) two rows
+struct matrix_minors {
+    float s[6];
+    float c[6];
+    float det;
+};
+constexpr matrix_minors minors(const matrix& m) noexcept
+{
+    matrix_minors r{};
+    r.s[0] = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+    r.s[1] = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+    r.s[2] = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+    r.s[3] = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    r.s[4] = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+    r.s[5] = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+    r.c[0] = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+    r.c[1] = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+    r.c[2] = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+    r.c[3] = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+    r.c[4] = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+    r.c[5] = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+
+    r.det = r.s[0] * r.c[5] - r.s[1] * r.c[4] + r.s[2] * r.c[3] + r.s[3] * r.c[2] - r.s[4] * r.c[1] + r.s[5] * r.c[0];
+    return r;
+}
+} // namespace detail
 
 constexpr matrix multiply(const matrix& a, const matrix& b) noexcept
 {
@@ -28,49 +59,7 @@ constexpr matrix multiply(const matrix& a, const matrix& b) noexcept
             eval_row(3)
         };
     } else {
-        __m256 t0 = _mm256_castps128_ps256(a.r[0]);
-        t0 = _mm256_insertf128_ps(t0, a.r[1], 1);
-        __m256 t1 = _mm256_castps128_ps256(a.r[2]);
-        t1 = _mm256_insertf128_ps(t1, a.r[3], 1);
-
-        __m256 u0 = _mm256_castps128_ps256(b.r[0]);
-        u0 = _mm256_insertf128_ps(u0, b.r[1], 1);
-        __m256 u1 = _mm256_castps128_ps256(b.r[2]);
-        u1 = _mm256_insertf128_ps(u1, b.r[3], 1);
-
-        __m256 a0 = _mm256_shuffle_ps(t0, t0, _MM_SHUFFLE(0, 0, 0, 0));
-        __m256 a1 = _mm256_shuffle_ps(t1, t1, _MM_SHUFFLE(0, 0, 0, 0));
-        __m256 b0 = _mm256_permute2f128_ps(u0, u0, 0x00);
-        __m256 c0 = _mm256_mul_ps(a0, b0);
-        __m256 c1 = _mm256_mul_ps(a1, b0);
-
-        a0 = _mm256_shuffle_ps(t0, t0, _MM_SHUFFLE(1, 1, 1, 1));
-        a1 = _mm256_shuffle_ps(t1, t1, _MM_SHUFFLE(1, 1, 1, 1));
-        b0 = _mm256_permute2f128_ps(u0, u0, 0x11);
-        __m256 c2 = _mm256_fmadd_ps(a0, b0, c0);
-        __m256 c3 = _mm256_fmadd_ps(a1, b0, c1);
-
-        a0 = _mm256_shuffle_ps(t0, t0, _MM_SHUFFLE(2, 2, 2, 2));
-        a1 = _mm256_shuffle_ps(t1, t1, _MM_SHUFFLE(2, 2, 2, 2));
-        __m256 b1 = _mm256_permute2f128_ps(u1, u1, 0x00);
-        __m256 c4 = _mm256_mul_ps(a0, b1);
-        __m256 c5 = _mm256_mul_ps(a1, b1);
-
-        a0 = _mm256_shuffle_ps(t0, t0, _MM_SHUFFLE(3, 3, 3, 3));
-        a1 = _mm256_shuffle_ps(t1, t1, _MM_SHUFFLE(3, 3, 3, 3));
-        b1 = _mm256_permute2f128_ps(u1, u1, 0x11);
-        __m256 c6 = _mm256_fmadd_ps(a0, b1, c4);
-        __m256 c7 = _mm256_fmadd_ps(a1, b1, c5);
-
-        t0 = _mm256_add_ps(c2, c6);
-        t1 = _mm256_add_ps(c3, c7);
-
-        return {
-            _mm256_castps256_ps128(t0),
-            _mm256_extractf128_ps(t0, 1),
-            _mm256_castps256_ps128(t1),
-            _mm256_extractf128_ps(t1, 1)
-        };
+        return detail::kernels().multiply(a, b);
     }
 }
 template<size_t Components = 3>
@@ -93,28 +82,7 @@ constexpr vector transform(const matrix& matr, vector v) noexcept
         }
         return result;
     } else {
-        constexpr auto last_component = Components - 1;
-        vector result = _mm_shuffle_ps(v, v, _MM_SHUFFLE(last_component, last_component, last_component, last_component)); // W
-
-        if constexpr (Components == 4)
-            result = _mm_mul_ps(result, matr[last_component]);
-        else
-            result = fmadd(result, matr[last_component], matr[3]);
-
-        auto a = [&]<size_t index> {
-            vector vTemp = _mm_shuffle_ps(v, v, _MM_SHUFFLE(index, index, index, index));
-            result = fmadd(vTemp, matr[index], result);
-        };
-
-        if constexpr (Components == 4) {
-            a.operator()<2>();
-        }
-        if constexpr (Components == 3) {
-            a.operator()<1>();
-        }
-        a.operator()<0>();
-        // use fold expression
-        return result;
+        return detail::kernels().transform[Components - 1](matr, v);
     }
 }
 
@@ -176,26 +144,7 @@ constexpr matrix transpose(const matrix& a) noexcept
             { a[0][3], a[1][3], a[2][3], a[3][3] }
         };
     } else {
-        __m256 t0 = _mm256_castps128_ps256(a[0]);
-        t0 = _mm256_insertf128_ps(t0, a[1], 1);
-        __m256 t1 = _mm256_castps128_ps256(a[2]);
-        t1 = _mm256_insertf128_ps(t1, a[3], 1);
-
-        __m256 vTemp = _mm256_unpacklo_ps(t0, t1);
-        __m256 vTemp2 = _mm256_unpackhi_ps(t0, t1);
-        __m256 vTemp3 = _mm256_permute2f128_ps(vTemp, vTemp2, 0x20);
-        __m256 vTemp4 = _mm256_permute2f128_ps(vTemp, vTemp2, 0x31);
-        vTemp = _mm256_unpacklo_ps(vTemp3, vTemp4);
-        vTemp2 = _mm256_unpackhi_ps(vTemp3, vTemp4);
-        t0 = _mm256_permute2f128_ps(vTemp, vTemp2, 0x20);
-        t1 = _mm256_permute2f128_ps(vTemp, vTemp2, 0x31);
-
-        return {
-            _mm256_castps256_ps128(t0),
-            _mm256_extractf128_ps(t0, 1),
-            _mm256_castps256_ps128(t1),
-            _mm256_extractf128_ps(t1, 1)
-        };
+        return detail::kernels().transpose(a);
     }
 }
 constexpr matrix look_to(vector eye, vector direction, vector up) noexcept
@@ -211,11 +160,155 @@ constexpr matrix look_to(vector eye, vector direction, vector up) noexcept
     vector d1 = dot(u, neg_eye);
     vector d2 = dot(f, neg_eye);
 
+    // the basis goes in the columns for row vectors, the translation in the last row
+    if (std::is_constant_evaluated()) {
+        return {
+            { r[0], u[0], f[0], 0.0f },
+            { r[1], u[1], f[1], 0.0f },
+            { r[2], u[2], f[2], 0.0f },
+            { d0[0], d1[0], d2[0], 1.0f }
+        };
+    } else {
+        return transpose(matrix{
+                _mm_blend_ps(r, d0, 0b1000),
+                _mm_blend_ps(u, d1, 0b1000),
+                _mm_blend_ps(f, d2, 0b1000),
+                identity[3] });
+    }
+}
+
+// |m| in all components
+constexpr vector determinant(const matrix& m) noexcept
+{
+    if (std::is_constant_evaluated()) {
+        return vector(detail::minors(m).det, broadcast);
+    } else {
+        return detail::kernels().determinant(m);
+    }
+}
+
+// General inverse, det receives |m| in all components if not null.
+// A singular matrix gives infinities or NaN, check det when that can happen.
+constexpr matrix inverse(const matrix& m, vector* det = nullptr) noexcept
+{
+    if (std::is_constant_evaluated()) {
+        auto [s, c, d] = detail::minors(m);
+        if (det) {
+            *det = vector(d, broadcast);
+        }
+        float r = 1.0f / d;
+        return {
+            { (m[1][1] * c[5] - m[1][2] * c[4] + m[1][3] * c[3]) * r,
+              (-m[0][1] * c[5] + m[0][2] * c[4] - m[0][3] * c[3]) * r,
+              (m[3][1] * s[5] - m[3][2] * s[4] + m[3][3] * s[3]) * r,
+              (-m[2][1] * s[5] + m[2][2] * s[4] - m[2][3] * s[3]) * r },
+            { (-m[1][0] * c[5] + m[1][2] * c[2] - m[1][3] * c[1]) * r,
+              (m[0][0] * c[5] - m[0][2] * c[2] + m[0][3] * c[1]) * r,
+              (-m[3][0] * s[5] + m[3][2] * s[2] - m[3][3] * s[1]) * r,
+              (m[2][0] * s[5] - m[2][2] * s[2] + m[2][3] * s[1]) * r },
+            { (m[1][0] * c[4] - m[1][1] * c[2] + m[1][3] * c[0]) * r,
+              (-m[0][0] * c[4] + m[0][1] * c[2] - m[0][3] * c[0]) * r,
+              (m[3][0] * s[4] - m[3][1] * s[2] + m[3][3] * s[0]) * r,
+              (-m[2][0] * s[4] + m[2][1] * s[2] - m[2][3] * s[0]) * r },
+            { (-m[1][0] * c[3] + m[1][1] * c[1] - m[1][2] * c[0]) * r,
+              (m[0][0] * c[3] - m[0][1] * c[1] + m[0][2] * c[0]) * r,
+              (-m[3][0] * s[3] + m[3][1] * s[1] - m[3][2] * s[0]) * r,
+              (m[2][0] * s[3] - m[2][1] * s[1] + m[2][2] * s[0]) * r }
+        };
+    } else {
+        return detail::kernels().inverse(m, det);
+    }
+}
+
+// Inverse of a matrix with 0, 0, 0, 1 in the last column, e.g. scale, rotation and translation.
+// The upper 3x3 is inverted with cross products, the translation follows as -t * A^-1.
+constexpr matrix inverse_affine(const matrix& m) noexcept
+{
+    if (std::is_constant_evaluated()) {
+        // columns of the inverse times |A|
+        vector c0 = { m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0], 0.0f };
+        vector c1 = { m[2][1] * m[0][2] - m[2][2] * m[0][1], m[2][2] * m[0][0] - m[2][0] * m[0][2], m[2][0] * m[0][1] - m[2][1] * m[0][0], 0.0f };
+        vector c2 = { m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0], 0.0f };
+        float r = 1.0f / (m[0][0] * c0[0] + m[0][1] * c0[1] + m[0][2] * c0[2]);
+
+        vector r0 = { c0[0] * r, c1[0] * r, c2[0] * r, 0.0f };
+        vector r1 = { c0[1] * r, c1[1] * r, c2[1] * r, 0.0f };
+        vector r2 = { c0[2] * r, c1[2] * r, c2[2] * r, 0.0f };
+        vector t = m[3];
+        return {
+            r0, r1, r2,
+            { -(t[0] * r0[0] + t[1] * r1[0] + t[2] * r2[0]),
+              -(t[0] * r0[1] + t[1] * r1[1] + t[2] * r2[1]),
+              -(t[0] * r0[2] + t[1] * r1[2] + t[2] * r2[2]),
+              1.0f }
+        };
+    } else {
+        __m128 r0 = cross(m[1], m[2]);
+        __m128 r1 = cross(m[2], m[0]);
+        __m128 r2 = cross(m[0], m[1]);
+        __m128 r3 = _mm_setzero_ps();
+        vector det = dot(m[0], r0);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3); // w stays 0, cross clears it
+
+        vector rdet = vector(1.0f, broadcast) / det;
+        vector x = r0 * rdet;
+        vector y = r1 * rdet;
+        vector z = r2 * rdet;
+        vector t = m[3];
+        vector translation = _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)), x);
+        translation = fmadd(vector(_mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))), y, translation);
+        translation = fmadd(vector(_mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2))), z, translation);
+        return { x, y, z, identity[3] - translation };
+    }
+}
+
+// Projections are left handed like look_to and map near_z to depth 0 and far_z to 1.
+// fov_y is the vertical field of view in radians, aspect is width / height.
+constexpr matrix perspective(float fov_y, float aspect, float near_z, float far_z) noexcept
+{
+    auto [s, c] = sincos(vector(0.5f * fov_y, broadcast));
+    float height = float(c) / float(s);
+    float width = height / aspect;
+    float range = far_z / (far_z - near_z);
+    return {
+        { width, 0.0f, 0.0f, 0.0f },
+        { 0.0f, height, 0.0f, 0.0f },
+        { 0.0f, 0.0f, range, 1.0f },
+        { 0.0f, 0.0f, -range * near_z, 0.0f }
+    };
+}
+// inverse(perspective(...)) without the general inverse
+constexpr matrix inverse_perspective(float fov_y, float aspect, float near_z, float far_z) noexcept
+{
+    auto [s, c] = sincos(vector(0.5f * fov_y, broadcast));
+    float height = float(c) / float(s);
+    float width = height / aspect;
+    float range = far_z / (far_z - near_z);
+    return {
+        { 1.0f / width, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f / height, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 0.0f, -1.0f / (range * near_z) },
+        { 0.0f, 0.0f, 1.0f, 1.0f / near_z }
+    };
+}
+// width and height of the view volume in view space units
+constexpr matrix orthographic(float width, float height, float near_z, float far_z) noexcept
+{
+    float range = 1.0f / (far_z - near_z);
+    return {
+        { 2.0f / width, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 2.0f / height, 0.0f, 0.0f },
+        { 0.0f, 0.0f, range, 0.0f },
+        { 0.0f, 0.0f, -range * near_z, 1.0f }
+    };
+}
+constexpr matrix inverse_orthographic(float width, float height, float near_z, float far_z) noexcept
+{
     return {
-        select<0b0001>(r, d0),
-        select<0b0001>(u, d1),
-        select<0b0001>(f, d2),
-        identity[3]
+        { 0.5f * width, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 0.5f * height, 0.0f, 0.0f },
+        { 0.0f, 0.0f, far_z - near_z, 0.0f },
+        { 0.0f, 0.0f, near_z, 1.0f }
     };
 }
-} // namespace w::math
\ No newline at end of file
+} // namespace w::math
@@ -0,0 +1,80 @@
+#pragma once
+#include <math/quaternion.h>
+#include <math/vector.h>
+#include <array>
+#include <cstdint>
+#include <numbers>
+#include <span>
+
+// Compact encodings of rotations, scales and positions for large static scenes and snapshots.
+// The batch kernels process 8 elements per iteration with AVX2 and F16C,
+// without them they fall back to one element at a time, see simd.h.
+// The error bounds below hold for every level.
+
+namespace w::math {
+// Smallest three: the index of the largest component in the top 2 bits, the other three
+// in [-1/sqrt2, 1/sqrt2] with 10 bits each. The largest is rebuilt from the unit length.
+struct packed_quat32 {
+    uint32_t bits;
+};
+// same with 15 bits per component, 47 of the 48 bits used
+struct packed_quat48 {
+    std::array<uint16_t, 3> bits;
+};
+// IEEE half precision per component, 3 significant decimal digits up to 65504
+struct half3 {
+    std::array<uint16_t, 3> bits;
+};
+// fixed point, a step of position_cell::step() per unit
+struct packed_position {
+    std::array<int16_t, 3> value;
+};
+
+// The cube packed positions are relative to, origin +- extent.
+// Positions outside are clamped to the cube.
+struct position_cell {
+    float3 origin;
+    float extent = 1.0f;
+
+    float step() const noexcept
+    {
+        return extent / 32767.0f;
+    }
+    // largest distance of a decoded position inside the cube per component, before the rounding of origin + offset
+    float max_error() const noexcept
+    {
+        return step() * 0.5f;
+    }
+};
+
+// Largest error per component of a decoded unit quaternion, up to the sign of the whole quaternion.
+// The three stored components are off by half a step at most, the rebuilt one by 3 times that.
+inline constexpr float packed_quat32_max_error = 3.2f * std::numbers::sqrt2_v<float> / 1023.0f * 0.5f;
+inline constexpr float packed_quat48_max_error = 3.2f * std::numbers::sqrt2_v<float> / 32767.0f * 0.5f;
+// of values in the normal range of half, 6.1e-5 to 65504
+inline constexpr float half_max_relative_error = 1.0f / 2048.0f;
+
+// rounds to nearest even, larger values become infinity like F16C does
+uint16_t to_half(float value) noexcept;
+float from_half(uint16_t bits) noexcept;
+
+// q must be normalized, x y z w
+packed_quat32 pack32(quaternion q) noexcept;
+packed_quat48 pack48(quaternion q) noexcept;
+quaternion unpack(packed_quat32 q) noexcept;
+quaternion unpack(packed_quat48 q) noexcept;
+half3 pack_half(vector v) noexcept;
+vector unpack(half3 v) noexcept;
+packed_position pack(vector position, const position_cell& cell) noexcept;
+vector unpack(packed_position position, const position_cell& cell) noexcept;
+
+// Batches, over the length of out. Quaternions are x y z w.
+void pack_batch(std::span<const float4> rotations, std::span<packed_quat32> out) noexcept;
+void pack_batch(std::span<const float4> rotations, std::span<packed_quat48> out) noexcept;
+void unpack_batch(std::span<const packed_quat32> rotations, std::span<float4> out) noexcept;
+void unpack_batch(std::span<const packed_quat48> rotations, std::span<float4> out) noexcept;
+void pack_batch(std::span<const float3> scales, std::span<half3> out) noexcept;
+void unpack_batch(std::span<const half3> scales, std::span<float3> out) noexcept;
+void pack_batch(std::span<const float3> positions, const position_cell& cell, std::span<packed_position> out) noexcept;
+void unpack_batch(std::span<const packed_position> positions, const position_cell& cell, std::span<float3> out) noexcept;
+} // namespace w::math
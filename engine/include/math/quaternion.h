@@ -1,6 +1,8 @@
 #pragma once
 #include <math/vector_math.h>
 #include <math/matrix.h>
+#include <math/simd.h>
+#include <math/transcendental.h>
 #include <numbers>
 #include <algorithm>
 
@@ -22,53 +24,19 @@ struct quaternion : vector {
                 identity[3]
             };
         } else {
-            using enum detail::swizzle_mask;
-            constexpr vector onex3{ 1, 1, 1, 0 };
-            vector _2q = q + q;
-            vector q2 = q * _2q; // 2 * q * q
-
-            vector v1 = _mm_shuffle_ps(q2, q2, detail::swizzle(y, x, x, w)); // 2yy, 2xx, 2xx
-            vector v2 = _mm_shuffle_ps(q2, q2, detail::swizzle(z, z, y, w)); // 2zz, 2zz, 2yy
-            vector sum1 = v1 + v2; // 2yy + 2zz, 2xx + 2zz, 2xx + 2yy
-            vector r1 = neg_identity_mask[3] & (onex3 - sum1); // 1 - 2yy - 2zz, 1 - 2xx - 2zz, 1 - 2xx - 2yy, 0
-
-            v1 = _mm_shuffle_ps(q, q, detail::swizzle(x, x, y, x));
-            v2 = _mm_shuffle_ps(_2q, _2q, detail::swizzle(z, y, z, z));
-            vector r2 = v1 * v2; // 2xz, 2xy, 2yz, 2xz
-
-            v1 = _mm_shuffle_ps(q, q, detail::swizzle(w, w, w, w));
-            v2 = _mm_shuffle_ps(_2q, _2q, detail::swizzle(y, z, x, y));
-            vector r3 = v1 * v2; // 2yw, 2zw, 2xw, 2yw
-
-            vector r4 = _mm_addsub_ps(r2, r3); // 2xz + 2yw, 2xy - 2zw, 2yz + 2xw, 2xz - 2yw
-            r3 = r3 ^ vector(-0.0f, -0.0f, -0.0f, -0.0f); // negate the last component
-            vector r5 = _mm_addsub_ps(r2, r3); // 2xz - 2yw, 2xy + 2zw, 2yz - 2xw, 2xz + 2yw
-
-            v1 = _mm_shuffle_ps(r1, r4, detail::swizzle(x, w, y, x)); // 1 - 2yy - 2zz, 0, 2xy - 2zw, 2xz + 2yw
-            v2 = _mm_shuffle_ps(r1, r5, detail::swizzle(y, w, z, y)); // 1 - 2xx - 2zz, 0, 2yz - 2xw, 2xy + 2zw
-            r1 = _mm_shuffle_ps(r1, r4, detail::swizzle(z, w, w, z)); // 1 - 2xx - 2yy, 0, 2xz - 2yw, 2yz + 2xw
-
-            return matrix(
-                    _mm_shuffle_ps(v1, v1, detail::swizzle(x, z, w, y)), // 1 - 2yy - 2zz, 2xy - 2zw, 2xz + 2yw, 0
-                    _mm_shuffle_ps(v2, v2, detail::swizzle(w, x, z, y)), // 2xy + 2zw, 1 - 2xx - 2zz, 2yz - 2xw, 0
-                    _mm_shuffle_ps(r1, r1, detail::swizzle(z, w, x, y)), // 2xz - 2yw, 2yz + 2xw, 1 - 2xx - 2yy, 0
-                    identity_mask[3]);
+            return detail::kernels().quaternion_to_matrix(q);
         }
     }
 
 public:
     // Creates a quaternion from an angle and an axis. The axis must be normalized.
-    // Unfortunatly, the compiler doesn't like the constexpr version of this function, since sin and cos are not constexpr.
+    // Not constexpr, since sin and cos are not.
     static inline quaternion from_angle_axis_normal(float angle, vector axis) noexcept
     {
-        constexpr vector select = vector(identity_mask[3]);
-        float half_angle = angle * 0.5f;
-        vector s = vector(std::sin(half_angle), broadcast);
-        vector c = vector(std::cos(half_angle), broadcast);
+        auto [s, c] = sincos(vector(angle * 0.5f, broadcast));
 
-        auto sel_ax = _mm_mul_ps(_mm_andnot_ps(select, axis), s);
-        auto sel_ang = _mm_and_ps(select, c);
-        return quaternion(sel_ax | sel_ang);
+        // blend rather than or, 0 * -sin in w would leave the sign bit set
+        return quaternion(_mm_blend_ps(_mm_mul_ps(axis, s), c, 0b1000));
     }
 
     // Creates a quaternion from an angle and an axis. The axis is not required to be normalized.
@@ -100,12 +68,11 @@ struct angle_axis : public T {
     explicit angle_axis(quaternion q) noexcept
     {
         // extract angle
-        float angle = std::acosf(_mm_cvtss_f32(_mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3))));
+        vector angle = acos(vector(_mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3))));
         // extract axis
         vector axis = _mm_andnot_ps(vector(identity_mask[3]), q);
         // divide by sin(angle) to normalize
-        vector sin_angle = vector(std::sinf(angle), broadcast);
-        static_cast<underlying_t&>(*this) = vector(_mm_div_ps(axis, sin_angle));
+        static_cast<underlying_t&>(*this) = vector(_mm_div_ps(axis, sin(angle)));
     }
 
 public:
@@ -120,7 +87,7 @@ public:
     }
 };
 
-template<typename T = float4a>
+template<typename T = float3a>
     requires(std::same_as<T, float3> || std::same_as<T, float3a>)
 struct spherical : public T {
     constexpr spherical() = default;
@@ -130,18 +97,17 @@ struct spherical : public T {
     }
     explicit spherical(vector coord3d) noexcept
     {
-        float radius = length(coord3d);
+        vector radius = length(coord3d);
 
-        auto xval = _mm_shuffle_ps(coord3d, coord3d, _MM_SHUFFLE(0, 0, 0, 0));
-        auto yval = _mm_shuffle_ps(coord3d, coord3d, _MM_SHUFFLE(1, 1, 1, 1));
-        auto zval = _mm_shuffle_ps(coord3d, coord3d, _MM_SHUFFLE(2, 2, 2, 2));
-        auto len2 = length<2>(coord3d);
+        vector xval = _mm_shuffle_ps(coord3d, coord3d, _MM_SHUFFLE(0, 0, 0, 0));
+        vector yval = _mm_shuffle_ps(coord3d, coord3d, _MM_SHUFFLE(1, 1, 1, 1));
+        vector zval = _mm_shuffle_ps(coord3d, coord3d, _MM_SHUFFLE(2, 2, 2, 2));
 
-        float phi = std::atanf(_mm_cvtss_f32(yval) / _mm_cvtss_f32(xval));
-        float theta = std::acosf(zval / radius);
-        this->data[0] = phi;
-        this->data[1] = theta;
-        this->data[2] = radius;
+        vector phi = atan2(yval, xval);
+        vector theta = acos(zval / radius);
+        this->data[0] = float(phi);
+        this->data[1] = float(theta);
+        this->data[2] = float(radius);
     }
     vector to_cartesian() const noexcept
     {
@@ -149,17 +115,18 @@ struct spherical : public T {
         float phi = this->data[0];
         float theta = this->data[1];
         float radius = this->data[2];
-        auto v1 = vector(float4a{ std::sinf(theta), std::cosf(theta), std::sinf(phi), std::cosf(phi) });
+        auto [s, c] = sincos(vector(theta, phi, 0.0f, 0.0f)); // sin(theta), sin(phi), 0, 0 and cos(theta), cos(phi), 1, 1
         auto vradius = vector(radius, broadcast);
 
-        auto shuf1 = _mm_shuffle_ps(v1, v1, detail::swizzle(x, x, y, w)); // sin(theta), sin(theta), cos(theta), ~
-        auto shuf2 = _mm_shuffle_ps(v1, identity[0], detail::swizzle(w, z, x, z)); // cos(phi), sin(phi), 1, ~
+        vector shuf1 = _mm_shuffle_ps(s, c, detail::swizzle(x, x, x, x)); // sin(theta), sin(theta), cos(theta), ~
+        vector shuf2 = _mm_shuffle_ps(c, s, detail::swizzle(y, z, y, y)); // cos(phi), 1, sin(phi), ~
+        shuf2 = _mm_shuffle_ps(shuf2, shuf2, detail::swizzle(x, z, y, y)); // cos(phi), sin(phi), 1, ~
         return vradius * shuf1 * shuf2;
     }
     void normalize() noexcept
     {
-        this->data[0] = std::clamp(this->data[0], 0, 2 * std::numbers::pi_v<float>);
-        this->data[1] = std::clamp(this->data[1], 0, 2 * std::numbers::pi_v<float>);
+        this->data[0] = std::clamp(this->data[0], 0.0f, 2 * std::numbers::pi_v<float>);
+        this->data[1] = std::clamp(this->data[1], 0.0f, 2 * std::numbers::pi_v<float>);
     }
 };
 
@@ -173,20 +140,22 @@ struct polar : public T {
     }
     explicit polar(vector coord2d) noexcept
     {
-        float radius = length(coord2d);
-        float angle = std::atan2f(coord2d[1], coord2d[0]);
-        this->data[0] = angle;
-        this->data[1] = radius;
+        vector radius = length<2>(coord2d);
+        vector angle = atan2(vector(_mm_shuffle_ps(coord2d, coord2d, _MM_SHUFFLE(1, 1, 1, 1))), coord2d);
+        this->data[0] = float(angle);
+        this->data[1] = float(radius);
     }
     vector to_cartesian() const noexcept
     {
         float angle = this->data[0];
         float radius = this->data[1];
-        return vector(radius * std::cosf(angle), radius * std::sinf(angle));
+        auto [s, c] = sincos(vector(angle, broadcast));
+        vector cos_sin = _mm_blend_ps(_mm_unpacklo_ps(c, s), _mm_setzero_ps(), 0b1100); // cos, sin, 0, 0
+        return vector(radius, broadcast) * cos_sin;
     }
     void normalize() noexcept
     {
-        this->data[0] = std::clamp(this->data[0], 0, 2 * std::numbers::pi_v<float>);
+        this->data[0] = std::clamp(this->data[0], 0.0f, 2 * std::numbers::pi_v<float>);
     }
 };
 
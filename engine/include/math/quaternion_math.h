@@ -29,19 +29,19 @@ constexpr quaternion dot(quaternion a, quaternion b) noexcept
 
 inline quaternion slerp(quaternion a, quaternion b, float t) noexcept
 {
-    quaternion q = dot(a, b);
-    float angle = std::acos(q[3]);
-    float s1 = std::sin((1.0f - t) * angle);
-    float s2 = std::sin(t * angle);
-    return quaternion((a * s1 + b * s2) / std::sin(angle));
+    vector angle = acos(vector(dot(a, b)));
+    vector s = sin(vector(1.0f - t, t, 1.0f, 1.0f) * angle); // sin((1 - t) * angle), sin(t * angle), sin(angle)
+    vector s1 = _mm_shuffle_ps(s, s, _MM_SHUFFLE(0, 0, 0, 0));
+    vector s2 = _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1));
+    vector s3 = _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 2, 2, 2));
+    return quaternion((a * s1 + b * s2) / s3);
 }
 inline quaternion pitch_yaw_roll(vector v) noexcept
 {
     using enum detail::swizzle_mask;
     v = v * 0.5f;
 
-    __m128 xcos{};
-    vector xsin = _mm_sincos_ps(&xcos, v); // warning, svml
+    auto [xsin, xcos] = sincos(v);
 
     //
     // cr *sp *cy + sr *cp *sy,
@@ -62,6 +62,6 @@ inline quaternion pitch_yaw_roll(vector v) noexcept
 
     constexpr vector xormask = { 0.0f, -0.0f, -0.0f, 0.0f };
     vector r1 = (rm1 * rm2 * rm3) ^ xormask;
-    return quaternion(_mm_fmadd_ps(m1 * m2, m3, r1));
+    return quaternion(fmadd(m1 * m2, m3, r1));
 }
 } // namespace w::math
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <math/matrix.h>
+#include <atomic>
+#include <cstdint>
+
+// Inline code in the math headers only needs SSE4.1, the heavier kernels
+// exist once per instruction set and are picked at runtime from CPUID.
+// Kernels for wider instruction sets are compiled per function,
+// the rest of a translation unit keeps the baseline target
+#if defined(_MSC_VER) && !defined(__clang__) // MSVC emits any intrinsic without flags
+#define WTARGET_AVX2
+#define WTARGET_AVX512
+#else
+#define WTARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#define WTARGET_AVX512 __attribute__((target("avx512f,avx2,fma,f16c")))
+#endif
+
+namespace w::math {
+// instruction sets with kernels of their own, in ascending order
+enum class simd_level : uint8_t {
+    sse41,
+    avx2, // AVX2, FMA3 and F16C
+    avx512, // AVX-512F
+};
+
+// highest level the cpu and the OS support, read with CPUID once
+simd_level supported_simd_level() noexcept;
+// level the dispatched kernels use, the supported one unless forced
+simd_level active_simd_level() noexcept;
+// for tests and benchmarks, clamped to the supported level
+void force_simd_level(simd_level level) noexcept;
+
+namespace detail {
+// single element kernels behind the non constexpr paths, one table per level
+struct simd_kernels {
+    matrix (*multiply)(const matrix& a, const matrix& b) noexcept;
+    matrix (*transpose)(const matrix& a) noexcept;
+    vector (*transform[4])(const matrix& m, vector v) noexcept; // by component count - 1
+    matrix (*quaternion_to_matrix)(vector q) noexcept;
+    matrix (*inverse)(const matrix& m, vector* det) noexcept;
+    vector (*determinant)(const matrix& m) noexcept;
+};
+
+extern const simd_kernels sse41_kernels;
+extern const simd_kernels avx2_kernels;
+extern const simd_kernels avx512_kernels;
+
+// SSE4.1 until static initialization picks the supported level
+extern std::atomic<const simd_kernels*> active_kernels;
+
+inline const simd_kernels& kernels() noexcept
+{
+    return *active_kernels.load(std::memory_order_relaxed);
+}
+} // namespace detail
+} // namespace w::math
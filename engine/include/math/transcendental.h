@@ -0,0 +1,248 @@
+#pragma once
+#include <math/vector_math.h>
+#include <limits>
+#include <span>
+
+// Polynomial sin, cos, acos, atan2, exp and log on all four lanes, SSE4.1 only.
+// Coefficients are the single precision minimax fits from Cephes.
+// Maximum error against double precision libm, in ulp of the float result
+// (checked by math_transcendental_test):
+//
+//   sin, cos, sincos  2 ulp for |x| <= 64, up to |x| = 8192 the same except for
+//                     results below 2^-12, which are within 2e-7 absolute;
+//                     there is no Payne-Hanek reduction for larger arguments
+//   acos              2 ulp on [-1, 1], NaN outside
+//   atan2             3 ulp, atan2(+-0, +-0) follows IEEE, infinities are not handled
+//   exp               2 ulp, 0 below -104 and infinity above 88.73, denormal results included
+//   log               2 ulp, -infinity for 0, NaN below 0, denormal inputs included
+//
+// sin, cos and sincos also evaluate at compile time, lane by lane with the same polynomials.
+// The span overloads at the bottom process 8 elements per iteration with AVX2
+// and fall back to these functions without it, see simd.h.
+
+namespace w::math {
+namespace detail {
+inline constexpr float two_over_pi = 0.636619772367581343f;
+// pi / 2 split for the Cody-Waite reduction, q * pi_2_hi is exact for |q| < 2^16
+inline constexpr float pi_2_hi = 1.5703125f;
+inline constexpr float pi_2_mid = 4.837512969970703125e-4f;
+inline constexpr float pi_2_lo = 7.54978995489188216e-8f;
+inline constexpr float half_pi = 1.57079632679489661923f;
+inline constexpr float quarter_pi = 0.785398163397448309616f;
+inline constexpr float pi = 3.14159265358979323846f;
+inline constexpr float tan_pi_8 = 0.414213562373095048802f;
+inline constexpr float log2e = 1.44269504088896341f;
+// ln 2 split, n * ln2_hi is exact for the whole exponent range
+inline constexpr float ln2_hi = 0.693359375f;
+inline constexpr float ln2_lo = -2.12194440e-4f;
+inline constexpr float exp_min = -104.0f; // exp(-104) rounds to 0
+inline constexpr float exp_max = 88.8f; // exp(88.8) overflows
+inline constexpr float sqrt_half = 0.707106781186547524f;
+
+// ((c0 * x + c1) * x + c2) ...
+template<typename... C>
+inline vector horner(vector x, float c0, C... c) noexcept
+{
+    vector result(c0, broadcast);
+    ((result = fmadd(result, x, vector(float(c), broadcast))), ...);
+    return result;
+}
+
+// r = x - q * pi / 2 with |r| <= pi / 4, q is returned as integers
+inline vector reduce_half_pi(vector x, __m128i& q) noexcept
+{
+    vector qf = _mm_round_ps(x * two_over_pi, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    q = _mm_cvtps_epi32(qf);
+    vector r = fmadd(qf, vector(-pi_2_hi, broadcast), x);
+    r = fmadd(qf, vector(-pi_2_mid, broadcast), r);
+    return fmadd(qf, vector(-pi_2_lo, broadcast), r);
+}
+// sin and cos of r on [-pi / 4, pi / 4], z = r * r
+inline vector sin_poly(vector r, vector z) noexcept
+{
+    return fmadd(r * z, horner(z, -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f), r);
+}
+inline vector cos_poly(vector z) noexcept
+{
+    vector c = fmadd(z * z, horner(z, 2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f), vector(1.0f, broadcast));
+    return fmadd(z, vector(-0.5f, broadcast), c);
+}
+// quadrant q: sin for even q, cos for odd q, negated in quadrants 2 and 3
+inline vector quadrant_select(vector s, vector c, __m128i q) noexcept
+{
+    vector odd = _mm_castsi128_ps(_mm_slli_epi32(q, 31)); // blendv reads the sign bit
+    vector sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    return vector(_mm_blendv_ps(s, c, odd)) ^ sign;
+}
+// asin on [0, 0.5], z = x * x
+inline vector asin_poly(vector x, vector z) noexcept
+{
+    return fmadd(x * z, horner(z, 4.2163199048e-2f, 2.4181311049e-2f, 4.5470025998e-2f, 7.4953002686e-2f, 1.6666752422e-1f), x);
+}
+// atan on [-tan(pi / 8), tan(pi / 8)]
+inline vector atan_poly(vector x) noexcept
+{
+    vector z = x * x;
+    return fmadd(x * z, horner(z, 8.05374449538e-2f, -1.38776856032e-1f, 1.99777106478e-1f, -3.33329491539e-1f), x);
+}
+} // namespace detail
+
+struct sincos_result {
+    vector sin;
+    vector cos;
+};
+
+namespace detail {
+// the reduction and polynomials above on one float, for constant evaluation
+constexpr inline void sincos_scalar(float x, float& s, float& c) noexcept
+{
+    float qf = float(int64_t(x * two_over_pi + (x < 0.0f ? -0.5f : 0.5f)));
+    float r = ((x - qf * pi_2_hi) - qf * pi_2_mid) - qf * pi_2_lo;
+    float z = r * r;
+    float sp = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+    float cp = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+    auto quadrant = [=](int64_t q) {
+        float v = q & 1 ? cp : sp;
+        return q & 2 ? -v : v;
+    };
+    s = quadrant(int64_t(qf));
+    c = quadrant(int64_t(qf) + 1);
+}
+} // namespace detail
+
+// both for the cost of one reduction
+constexpr inline sincos_result sincos(vector x) noexcept
+{
+    if (std::is_constant_evaluated()) {
+        sincos_result result;
+        for (size_t i = 0; i < 4; ++i) {
+            detail::sincos_scalar(x[i], result.sin.arrdata[i], result.cos.arrdata[i]);
+        }
+        return result;
+    } else {
+        __m128i q;
+        vector r = detail::reduce_half_pi(x, q);
+        vector z = r * r;
+        vector s = detail::sin_poly(r, z);
+        vector c = detail::cos_poly(z);
+        return { detail::quadrant_select(s, c, q), detail::quadrant_select(s, c, _mm_add_epi32(q, _mm_set1_epi32(1))) };
+    }
+}
+constexpr inline vector sin(vector x) noexcept
+{
+    if (std::is_constant_evaluated()) {
+        return sincos(x).sin;
+    } else {
+        __m128i q;
+        vector r = detail::reduce_half_pi(x, q);
+        vector z = r * r;
+        return detail::quadrant_select(detail::sin_poly(r, z), detail::cos_poly(z), q);
+    }
+}
+constexpr inline vector cos(vector x) noexcept
+{
+    if (std::is_constant_evaluated()) {
+        return sincos(x).cos;
+    } else {
+        __m128i q;
+        vector r = detail::reduce_half_pi(x, q);
+        vector z = r * r;
+        // cos(x) = sin(x + pi / 2)
+        return detail::quadrant_select(detail::sin_poly(r, z), detail::cos_poly(z), _mm_add_epi32(q, _mm_set1_epi32(1)));
+    }
+}
+inline vector acos(vector x) noexcept
+{
+    constexpr vector sign_mask{ -0.0f, broadcast };
+    vector sign = x & sign_mask;
+    vector a = _mm_andnot_ps(sign_mask, x);
+
+    // above 0.5 through asin(sqrt((1 - a) / 2)), which keeps the argument small
+    vector large = _mm_cmpgt_ps(a, vector(0.5f, broadcast));
+    vector z_large = (vector(1.0f, broadcast) - a) * 0.5f;
+    vector z = _mm_blendv_ps(a * a, z_large, large);
+    vector s = _mm_blendv_ps(a, _mm_sqrt_ps(z_large), large);
+    vector p = detail::asin_poly(s, z);
+
+    // small: pi / 2 - asin(x), large: 2 * asin(s) mirrored for negative x
+    vector small_result = vector(detail::half_pi, broadcast) - (p | sign);
+    vector large_result = _mm_blendv_ps(p + p, vector(detail::pi, broadcast) - (p + p), sign);
+    return _mm_blendv_ps(small_result, large_result, large);
+}
+
+inline vector atan2(vector y, vector x) noexcept
+{
+    constexpr vector sign_mask{ -0.0f, broadcast };
+    vector ax = _mm_andnot_ps(sign_mask, x);
+    vector ay = _mm_andnot_ps(sign_mask, y);
+
+    // atan of the ratio in [0, 1], 0 / 0 is 0
+    vector mx = _mm_max_ps(ax, ay);
+    vector ratio = _mm_and_ps(vector(_mm_min_ps(ax, ay)) / mx, _mm_cmpneq_ps(mx, _mm_setzero_ps()));
+    vector shifted = _mm_cmpgt_ps(ratio, vector(detail::tan_pi_8, broadcast));
+    vector t = _mm_blendv_ps(ratio, (ratio - vector(1.0f, broadcast)) / (ratio + vector(1.0f, broadcast)), shifted);
+    vector r = detail::atan_poly(t) + (vector(detail::quarter_pi, broadcast) & shifted);
+
+    // back to the octant of (x, y)
+    r = _mm_blendv_ps(r, vector(detail::half_pi, broadcast) - r, _mm_cmpgt_ps(ay, ax));
+    r = _mm_blendv_ps(r, vector(detail::pi, broadcast) - r, x);
+    return r | (y & sign_mask);
+}
+
+inline vector exp(vector x) noexcept
+{
+    // the min and max keep NaN
+    x = _mm_max_ps(vector(detail::exp_min, broadcast), _mm_min_ps(vector(detail::exp_max, broadcast), x));
+    vector n = _mm_round_ps(x * detail::log2e, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    vector r = fmadd(n, vector(-detail::ln2_hi, broadcast), x);
+    r = fmadd(n, vector(-detail::ln2_lo, broadcast), r);
+
+    vector p = detail::horner(r, 1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f);
+    p = fmadd(p, r * r, r) + vector(1.0f, broadcast);
+
+    // 2^n as two factors, each stays a normal float over the clamped range
+    __m128i ni = _mm_cvtps_epi32(n);
+    __m128i n1 = _mm_srai_epi32(ni, 1);
+    __m128i n2 = _mm_sub_epi32(ni, n1);
+    vector s1 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n1, _mm_set1_epi32(127)), 23));
+    vector s2 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n2, _mm_set1_epi32(127)), 23));
+    return p * s1 * s2;
+}
+
+inline vector log(vector x) noexcept
+{
+    // denormals are scaled into the normal range first
+    vector denormal = _mm_cmplt_ps(x, vector(std::numeric_limits<float>::min(), broadcast));
+    vector scaled = _mm_blendv_ps(x, x * 8388608.0f, denormal); // 2^23
+    __m128i bits = _mm_castps_si128(scaled);
+
+    // x = m * 2^e with m in [sqrt(0.5), sqrt(2))
+    __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126));
+    vector e = vector(_mm_cvtepi32_ps(exponent)) - (vector(23.0f, broadcast) & denormal);
+    vector m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));
+    vector small = _mm_cmplt_ps(m, vector(detail::sqrt_half, broadcast));
+    e = e - (vector(1.0f, broadcast) & small);
+    m = m + (m & small) - vector(1.0f, broadcast);
+
+    vector z = m * m;
+    vector y = m * z * detail::horner(m, 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f);
+    y = fmadd(e, vector(detail::ln2_lo, broadcast), y);
+    y = fmadd(z, vector(-0.5f, broadcast), y);
+    vector result = fmadd(e, vector(detail::ln2_hi, broadcast), m + y);
+
+    // log(0) = -inf, log(inf) = inf, NaN below 0 and for NaN
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+    result = _mm_blendv_ps(result, vector(-infinity, broadcast), _mm_cmpeq_ps(x, _mm_setzero_ps()));
+    result = _mm_blendv_ps(result, x, _mm_cmpeq_ps(x, vector(infinity, broadcast)));
+    return _mm_or_ps(result, _mm_cmpnge_ps(x, _mm_setzero_ps()));
+}
+
+// out[i] = f(in[i]) for the length of out, out may be the same span as in
+void sin(std::span<const float> in, std::span<float> out) noexcept;
+void cos(std::span<const float> in, std::span<float> out) noexcept;
+void sincos(std::span<const float> in, std::span<float> sin_out, std::span<float> cos_out) noexcept;
+void acos(std::span<const float> in, std::span<float> out) noexcept;
+void atan2(std::span<const float> y, std::span<const float> x, std::span<float> out) noexcept;
+void exp(std::span<const float> in, std::span<float> out) noexcept;
+void log(std::span<const float> in, std::span<float> out) noexcept;
+} // namespace w::math
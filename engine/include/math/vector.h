@@ -1,6 +1,6 @@
 #pragma once
 
-// the library supports AVX2 and FMA3 by default
+// the library requires SSE4.1, wider kernels are picked at runtime (see simd.h)
 // ARM and ARM64 are not supported
 
 #if defined(_MSC_VER) // MSVC only
@@ -9,9 +9,18 @@
 #define WVECTORCALL
 #endif
 
+// FMA3 in inline code only if the whole build targets it
+#if defined(__FMA__) || defined(__AVX2__)
+#define WMATH_INLINE_FMA 1
+#else
+#define WMATH_INLINE_FMA 0
+#endif
+
 #include <immintrin.h>
 #include <array>
+#include <bit>
 #include <cmath>
+#include <cstdint>
 #include <span>
 
 namespace w::math {
@@ -99,7 +108,7 @@ struct vector {
         if (std::is_constant_evaluated()) {
             arrdata = { x, x, x, x };
         } else {
-            data = _mm_broadcast_ss(&x);
+            data = _mm_set1_ps(x);
         }
     }
     constexpr explicit vector(float x) noexcept
@@ -147,7 +156,7 @@ public:
     };
 };
 
-// integer vectors
+// integer vectors, converted to and from vector bit for bit
 //-------------------------------------------------------------------------
 struct uint4 : detail::array_storage<unsigned, 4> {
     constexpr uint4() noexcept = default;
@@ -158,7 +167,7 @@ struct uint4 : detail::array_storage<unsigned, 4> {
     constexpr uint4(vector v) noexcept
     {
         if (std::is_constant_evaluated()) {
-            data = { static_cast<unsigned>(v[0]), static_cast<unsigned>(v[1]), static_cast<unsigned>(v[2]), static_cast<unsigned>(v[3]) };
+            data = { std::bit_cast<unsigned>(v[0]), std::bit_cast<unsigned>(v[1]), std::bit_cast<unsigned>(v[2]), std::bit_cast<unsigned>(v[3]) };
         } else {
             _mm_storeu_ps(reinterpret_cast<float*>(data.data()), v);
         }
@@ -166,7 +175,7 @@ struct uint4 : detail::array_storage<unsigned, 4> {
     constexpr operator vector() const noexcept
     {
         if (std::is_constant_evaluated()) {
-            return vector(static_cast<float>(x()), static_cast<float>(y()), static_cast<float>(z()), static_cast<float>(w()));
+            return vector(std::bit_cast<float>(x()), std::bit_cast<float>(y()), std::bit_cast<float>(z()), std::bit_cast<float>(w()));
         } else {
             return _mm_loadu_ps(reinterpret_cast<const float*>(data.data()));
         }
@@ -177,7 +186,7 @@ struct alignas(alignof(__m128)) uint4a : uint4 {
     constexpr uint4a(vector v) noexcept
     {
         if (std::is_constant_evaluated()) {
-            data = { static_cast<unsigned>(v[0]), static_cast<unsigned>(v[1]), static_cast<unsigned>(v[2]), static_cast<unsigned>(v[3]) };
+            data = { std::bit_cast<unsigned>(v[0]), std::bit_cast<unsigned>(v[1]), std::bit_cast<unsigned>(v[2]), std::bit_cast<unsigned>(v[3]) };
         } else {
             // aligned store
             _mm_store_ps(reinterpret_cast<float*>(data.data()), v);
@@ -186,7 +195,7 @@ struct alignas(alignof(__m128)) uint4a : uint4 {
     constexpr operator vector() const noexcept
     {
         if (std::is_constant_evaluated()) {
-            return vector(static_cast<float>(x()), static_cast<float>(y()), static_cast<float>(z()), static_cast<float>(w()));
+            return vector(std::bit_cast<float>(x()), std::bit_cast<float>(y()), std::bit_cast<float>(z()), std::bit_cast<float>(w()));
         } else {
             // aligned load
             return _mm_load_ps(reinterpret_cast<const float*>(data.data()));
@@ -126,10 +126,10 @@ constexpr inline vector dot(vector a, vector b) noexcept
 {
     if (std::is_constant_evaluated()) {
         // clang-format off
-        return { a[0] * b[0] 
-               + Components > 1 ? a[1] * b[1] : 0
-               + Components > 2 ? a[2] * b[2] : 0 
-               + Components > 3 ? a[3] * b[3] : 0
+        return { a[0] * b[0]
+               + (Components > 1 ? a[1] * b[1] : 0)
+               + (Components > 2 ? a[2] * b[2] : 0)
+               + (Components > 3 ? a[3] * b[3] : 0)
             , broadcast };
         // clang-format on
     } else {
@@ -143,7 +143,7 @@ constexpr inline vector cross(vector a, vector b) noexcept
     if (std::is_constant_evaluated()) {
         return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0], 0.0f };
     } else {
-        constexpr uint4 mask = { 0, 0, 0, 0xFFFFFFFF };
+        constexpr uint4 mask = { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0 }; // clears w
 
         vector t1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)); // y,z,x,w
         vector t2 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2)); // z,x,y,w
@@ -153,7 +153,11 @@ constexpr inline vector cross(vector a, vector b) noexcept
         vector t3 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)); // z,x,y,w
         vector t4 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1)); // y,z,x,w
 
+#if WMATH_INLINE_FMA
         result = _mm_fnmadd_ps(t3, t4, result); // y*z - z*y, z*x - x*z, x*y - y*x, w*w
+#else
+        result = _mm_sub_ps(result, _mm_mul_ps(t3, t4));
+#endif
 
         return _mm_and_ps(result, vector(mask));
     }
@@ -201,7 +205,11 @@ constexpr inline vector fmadd(vector a, vector b, vector c) noexcept
                  a[2] * b[2] + c[2],
                  a[3] * b[3] + c[3] };
     } else {
+#if WMATH_INLINE_FMA
         return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
     }
 }
 
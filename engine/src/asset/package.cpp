@@ -0,0 +1,135 @@
+#include <asset/package.h>
+#include <base/lz4.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+size_t chunk_count(const w::asset::package_entry& entry, uint32_t chunk_size) noexcept
+{
+    // no rounding addition, entry.size comes straight from the file
+    return std::max<size_t>(entry.size / chunk_size + (entry.size % chunk_size != 0), 1);
+}
+
+w::task<bool> decompress_async(const w::asset::package& package, const w::asset::package_entry& entry, size_t chunk, std::span<std::byte> out)
+{
+    co_return package.decompress_chunk(entry, chunk, out);
+}
+} // namespace
+
+w::result<w::asset::package> w::asset::package::open(const std::filesystem::path& path) noexcept
+{
+    auto mapped = base::mapped_file::open(path);
+    if (mapped) {
+        return { mapped.error.message, w::error };
+    }
+    auto bytes = mapped.value.bytes();
+
+    package result;
+    if (bytes.size() < sizeof(package_header)) {
+        return { "not a package", w::error };
+    }
+    std::memcpy(&result.header, bytes.data(), sizeof(package_header));
+    const auto& header = result.header;
+    if (header.magic != package_header::magic_value) {
+        return { "not a package", w::error };
+    }
+    if (header.version != package_header::current_version) {
+        return { "unsupported package version", w::error };
+    }
+    if (!std::has_single_bit(header.alignment) || header.chunk_size == 0) {
+        return { "corrupted package header", w::error };
+    }
+    if (header.toc_offset % alignof(package_entry) != 0 || header.toc_offset > bytes.size()
+        || (bytes.size() - header.toc_offset) / sizeof(package_entry) < header.entry_count) {
+        return { "corrupted table of contents", w::error };
+    }
+
+    // the mapping is page aligned, so the table can be used in place
+    result.toc = { reinterpret_cast<const package_entry*>(bytes.data() + header.toc_offset), header.entry_count };
+    for (size_t i = 0; i < result.toc.size(); ++i) {
+        const auto& entry = result.toc[i];
+        if (i > 0 && result.toc[i - 1].name_hash >= entry.name_hash) {
+            return { "table of contents is not sorted", w::error };
+        }
+        if (entry.offset > bytes.size() || entry.stored_size > bytes.size() - entry.offset) {
+            return { "asset lies outside the package", w::error };
+        }
+        bool valid_codec = entry.codec == compression::none ? entry.stored_size == entry.size : entry.codec == compression::lz4;
+        if (!valid_codec) {
+            return { "corrupted table of contents", w::error };
+        }
+        // the chunk table has to fit into the stored bytes, which bounds the decompressed size by the file size
+        if (entry.codec == compression::lz4 && chunk_count(entry, header.chunk_size) > entry.stored_size / sizeof(uint32_t)) {
+            return { "corrupted table of contents", w::error };
+        }
+    }
+    result.file = std::move(mapped.value);
+    return result;
+}
+
+const w::asset::package_entry* w::asset::package::find(uint64_t name_hash) const noexcept
+{
+    auto it = std::ranges::lower_bound(toc, name_hash, {}, &package_entry::name_hash);
+    return it != toc.end() && it->name_hash == name_hash ? &*it : nullptr;
+}
+
+bool w::asset::package::decompress_chunk(const package_entry& entry, size_t chunk, std::span<std::byte> out) const noexcept
+{
+    auto stored = stored_bytes(entry);
+    auto count = chunk_count(entry, header.chunk_size);
+    auto table_size = count * sizeof(uint32_t);
+    if (chunk >= count || stored.size() < table_size) {
+        return false;
+    }
+
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    if (chunk > 0) {
+        std::memcpy(&begin, stored.data() + (chunk - 1) * sizeof(uint32_t), sizeof(uint32_t));
+    }
+    std::memcpy(&end, stored.data() + chunk * sizeof(uint32_t), sizeof(uint32_t));
+    if (begin > end || end > stored.size() - table_size) {
+        return false;
+    }
+
+    auto data = stored.subspan(table_size + begin, end - begin);
+    if (data.size() == out.size()) {
+        std::memcpy(out.data(), data.data(), data.size()); // did not shrink, stored as is
+        return true;
+    }
+    return base::lz4::decompress(data, out);
+}
+
+w::task<w::result<w::asset::asset_data>> w::asset::package::load_async(const package_entry& entry) const
+{
+    if (entry.codec == compression::none) {
+        co_return asset_data{ nullptr, stored_bytes(entry) };
+    }
+
+    auto storage = std::make_unique_for_overwrite<std::byte[]>(entry.size);
+    std::span out{ storage.get(), size_t(entry.size) };
+    auto count = chunk_count(entry, header.chunk_size);
+    auto chunk_bytes = [&](size_t chunk) {
+        auto offset = chunk * header.chunk_size;
+        return out.subspan(offset, std::min<size_t>(header.chunk_size, out.size() - offset));
+    };
+
+    if (count == 1) {
+        if (!decompress_chunk(entry, 0, out)) {
+            co_return { "corrupted asset", w::error };
+        }
+        co_return asset_data{ std::move(storage), out };
+    }
+
+    std::vector<w::task<bool>> chunks;
+    chunks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        chunks.push_back(decompress_async(*this, entry, i, chunk_bytes(i)));
+    }
+    auto decompressed = co_await w::when_all(std::span{ chunks });
+    if (std::ranges::find(decompressed, false) != decompressed.end()) {
+        co_return { "corrupted asset", w::error };
+    }
+    co_return asset_data{ std::move(storage), out };
+}
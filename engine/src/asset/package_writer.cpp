@@ -0,0 +1,155 @@
+#include <asset/package_writer.h>
+#include <base/lz4.h>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace {
+bool read_whole(const std::filesystem::path& path, std::vector<std::byte>& out)
+{
+    std::ifstream file{ path, std::ios::binary | std::ios::ate };
+    if (!file) {
+        return false;
+    }
+    out.resize(size_t(file.tellg()));
+    file.seekg(0).read(reinterpret_cast<char*>(out.data()), std::streamsize(out.size()));
+    return bool(file);
+}
+
+// chunk end table followed by the chunks, empty if the asset did not shrink
+std::vector<std::byte> compress_chunks(std::span<const std::byte> data, uint32_t chunk_size)
+{
+    auto count = std::max<size_t>((data.size() + chunk_size - 1) / chunk_size, 1);
+    auto table_size = count * sizeof(uint32_t);
+    std::vector<std::byte> result(table_size + w::base::lz4::compress_bound(chunk_size) * count);
+
+    size_t end = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto chunk = data.subspan(i * chunk_size, std::min<size_t>(chunk_size, data.size() - i * chunk_size));
+        auto out = std::span{ result }.subspan(table_size + end);
+        auto compressed = w::base::lz4::compress(chunk, out);
+        if (compressed == 0 || compressed >= chunk.size()) {
+            std::ranges::copy(chunk, out.begin()); // a chunk that did not shrink is stored as is
+            compressed = chunk.size();
+        }
+        end += compressed;
+        if (end > UINT32_MAX) {
+            return {}; // the table cannot address it, stored uncompressed
+        }
+        auto end32 = uint32_t(end);
+        std::memcpy(result.data() + i * sizeof(uint32_t), &end32, sizeof(end32));
+    }
+    result.resize(table_size + end);
+    if (result.size() >= data.size()) {
+        return {};
+    }
+    return result;
+}
+} // namespace
+
+w::asset::package_writer::package_writer(uint32_t alignment, uint32_t chunk_size) noexcept
+    : alignment(std::bit_ceil(std::max<uint32_t>(alignment, alignof(package_entry))))
+    , chunk_size(std::max<uint32_t>(chunk_size, 1))
+{
+}
+
+w::error_message w::asset::package_writer::add(std::string_view name, std::span<const std::byte> data, compression codec)
+{
+    return add({ hash_name(name), { data.begin(), data.end() }, {}, codec });
+}
+
+w::error_message w::asset::package_writer::add_file(std::string_view name, std::filesystem::path source, compression codec)
+{
+    return add({ hash_name(name), {}, std::move(source), codec });
+}
+
+w::error_message w::asset::package_writer::add_directory(const std::filesystem::path& directory, compression codec)
+{
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator{ directory, error }; !error && it != std::filesystem::recursive_directory_iterator{}; it.increment(error)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        auto name = std::filesystem::relative(it->path(), directory).generic_string();
+        if (auto result = add_file(name, it->path(), codec); !result) {
+            return result;
+        }
+    }
+    if (error) {
+        return { "could not list the directory" };
+    }
+    return {};
+}
+
+w::error_message w::asset::package_writer::add(pending_asset asset)
+{
+    if (std::ranges::find(pending, asset.name_hash, &pending_asset::name_hash) != pending.end()) {
+        return { "two assets share a name hash" };
+    }
+    pending.push_back(std::move(asset));
+    return {};
+}
+
+w::error_message w::asset::package_writer::write(const std::filesystem::path& path) const
+{
+    std::vector<const pending_asset*> order;
+    for (auto& asset : pending) {
+        order.push_back(&asset);
+    }
+    std::ranges::sort(order, {}, [](auto* asset) { return asset->name_hash; });
+
+    std::ofstream out{ path, std::ios::binary | std::ios::trunc };
+    if (!out) {
+        return { "could not create the package" };
+    }
+
+    package_header header;
+    header.entry_count = uint32_t(order.size());
+    header.alignment = alignment;
+    header.chunk_size = chunk_size;
+    header.toc_offset = sizeof(package_header);
+    std::vector<package_entry> toc(order.size());
+
+    auto align = [&](uint64_t offset) { return (offset + alignment - 1) & ~uint64_t(alignment - 1); };
+    uint64_t offset = align(header.toc_offset + toc.size() * sizeof(package_entry));
+    std::vector<std::byte> loaded;
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto& asset = *order[i];
+        std::span<const std::byte> data = asset.data;
+        if (!asset.source.empty()) {
+            if (!read_whole(asset.source, loaded)) {
+                return { "could not read an asset" };
+            }
+            data = loaded;
+        }
+
+        auto& entry = toc[i];
+        entry.name_hash = asset.name_hash;
+        entry.size = data.size();
+        std::vector<std::byte> compressed;
+        if (asset.codec == compression::lz4 && !data.empty()) {
+            compressed = compress_chunks(data, chunk_size);
+        }
+        std::span<const std::byte> stored = compressed.empty() ? data : std::span<const std::byte>{ compressed };
+        entry.codec = compressed.empty() ? compression::none : compression::lz4;
+        entry.stored_size = stored.size();
+        if (stored.empty()) {
+            continue; // offset 0, may lie past the end of the file otherwise
+        }
+        entry.offset = offset;
+
+        out.seekp(std::streamoff(offset));
+        out.write(reinterpret_cast<const char*>(stored.data()), std::streamsize(stored.size()));
+        offset = align(offset + stored.size());
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(toc.data()), std::streamsize(toc.size() * sizeof(package_entry)));
+    out.close();
+    if (!out) {
+        return { "could not write the package" };
+    }
+    return {};
+}
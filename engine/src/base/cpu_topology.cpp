@@ -0,0 +1,357 @@
+#include <base/cpu_topology.h>
+#include <algorithm>
+#include <cstddef>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__)
+#include <filesystem>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+#if defined(__linux__)
+std::string read_line(const std::filesystem::path& path)
+{
+    std::ifstream file{ path };
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// parses cpulist format: "0-3,8,10-11"
+std::vector<uint32_t> parse_cpu_list(std::string_view list)
+{
+    std::vector<uint32_t> result;
+    while (!list.empty()) {
+        auto comma = list.find(',');
+        auto range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+        uint32_t first = 0;
+        uint32_t last = 0;
+        auto dash = range.find('-');
+        if (std::from_chars(range.data(), range.data() + range.size(), first).ec != std::errc{}) {
+            continue;
+        }
+        last = first;
+        if (dash != std::string_view::npos) {
+            std::from_chars(range.data() + dash + 1, range.data() + range.size(), last);
+        }
+        for (uint32_t cpu = first; cpu <= last; ++cpu) {
+            result.push_back(cpu);
+        }
+    }
+    return result;
+}
+
+uint32_t lowest_cpu(const std::filesystem::path& list_path, uint32_t fallback)
+{
+    auto list = parse_cpu_list(read_line(list_path));
+    return list.empty() ? fallback : *std::ranges::min_element(list);
+}
+
+// the cpus the process may run on, e.g. limited by taskset or a container cpuset, empty if unknown
+std::vector<uint32_t> allowed_cpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return {};
+    }
+    std::vector<uint32_t> result;
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            result.push_back(cpu);
+        }
+    }
+    return result;
+}
+#elif defined(_WIN32)
+// logical cpus in a group mask, numbered group * 64 + bit
+std::vector<uint32_t> group_cpus(const GROUP_AFFINITY& affinity)
+{
+    constexpr uint32_t group_size = sizeof(KAFFINITY) * 8;
+    std::vector<uint32_t> result;
+    for (uint32_t bit = 0; bit < group_size; ++bit) {
+        if (affinity.Mask & (KAFFINITY(1) << bit)) {
+            result.push_back(uint32_t(affinity.Group) * group_size + bit);
+        }
+    }
+    return result;
+}
+
+// sets the field of every listed cpu to the lowest cpu of the mask
+void assign_lowest(std::vector<w::base::cpu_info>& cpus, const GROUP_AFFINITY& affinity, uint32_t w::base::cpu_info::* field)
+{
+    auto ids = group_cpus(affinity);
+    if (ids.empty()) {
+        return;
+    }
+    auto lowest = *std::ranges::min_element(ids);
+    for (auto id : ids) {
+        auto it = std::ranges::find(cpus, id, &w::base::cpu_info::id);
+        if (it != cpus.end()) {
+            (*it).*field = lowest;
+        }
+    }
+}
+#endif
+} // namespace
+
+w::base::cpu_topology w::base::cpu_topology::detect() noexcept
+{
+#if defined(__linux__)
+    try {
+        namespace fs = std::filesystem;
+        const fs::path cpu_root = "/sys/devices/system/cpu";
+        const fs::path node_root = "/sys/devices/system/node";
+
+        auto allowed = allowed_cpus();
+        auto online = parse_cpu_list(read_line(cpu_root / "online"));
+        if (online.empty()) {
+            online = allowed;
+        } else if (!allowed.empty()) {
+            std::erase_if(online, [&](uint32_t id) { return !std::ranges::binary_search(allowed, id); });
+        }
+        if (online.empty()) {
+            return flat(std::max(std::thread::hardware_concurrency(), 1u));
+        }
+
+        std::vector<cpu_info> cpus;
+        cpus.reserve(online.size());
+        for (auto id : online) {
+            auto dir = cpu_root / ("cpu" + std::to_string(id));
+            cpu_info info{ .id = id };
+            info.core = lowest_cpu(dir / "topology" / "thread_siblings_list", id);
+            info.l2 = info.core;
+            info.l3 = info.core;
+
+            std::error_code ec;
+            for (auto& index : fs::directory_iterator(dir / "cache", ec)) {
+                if (!index.path().filename().string().starts_with("index")) {
+                    continue;
+                }
+                auto type = read_line(index.path() / "type");
+                if (type == "Instruction") {
+                    continue;
+                }
+                auto level = read_line(index.path() / "level");
+                if (level == "2") {
+                    info.l2 = lowest_cpu(index.path() / "shared_cpu_list", info.core);
+                } else if (level == "3") {
+                    info.l3 = lowest_cpu(index.path() / "shared_cpu_list", info.core);
+                }
+            }
+            cpus.push_back(info);
+        }
+
+        std::error_code ec;
+        for (auto& node : fs::directory_iterator(node_root, ec)) {
+            auto name = node.path().filename().string();
+            uint32_t node_id = 0;
+            if (!name.starts_with("node") || std::from_chars(name.data() + 4, name.data() + name.size(), node_id).ec != std::errc{}) {
+                continue;
+            }
+            for (auto id : parse_cpu_list(read_line(node.path() / "cpulist"))) {
+                auto it = std::ranges::find(cpus, id, &cpu_info::id);
+                if (it != cpus.end()) {
+                    it->node = node_id;
+                }
+            }
+        }
+        return cpu_topology{ std::move(cpus) };
+    } catch (...) {
+        return flat(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+#elif defined(_WIN32)
+    try {
+        DWORD length = 0;
+        ::GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+        if (::GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+            return flat(std::max(std::thread::hardware_concurrency(), 1u));
+        }
+        std::vector<std::byte> buffer(length);
+        if (!::GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) {
+            return flat(std::max(std::thread::hardware_concurrency(), 1u));
+        }
+        // entries have variable size, every one records its own
+        auto for_each_relation = [&](LOGICAL_PROCESSOR_RELATIONSHIP relation, auto&& f) {
+            for (DWORD offset = 0; offset < length;) {
+                auto& info = *reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+                if (info.Relationship == relation) {
+                    f(info);
+                }
+                offset += info.Size;
+            }
+        };
+
+        // cores first, caches and nodes refer to the cpus they created
+        std::vector<cpu_info> cpus;
+        for_each_relation(RelationProcessorCore, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+            std::vector<uint32_t> ids;
+            for (WORD group = 0; group < info.Processor.GroupCount; ++group) {
+                auto group_ids = group_cpus(info.Processor.GroupMask[group]);
+                ids.insert(ids.end(), group_ids.begin(), group_ids.end());
+            }
+            if (ids.empty()) {
+                return;
+            }
+            auto core = *std::ranges::min_element(ids);
+            for (auto id : ids) {
+                cpus.push_back({ .id = id, .core = core, .l2 = core, .l3 = core });
+            }
+        });
+        for_each_relation(RelationCache, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+            if (info.Cache.Type == CacheInstruction) {
+                return;
+            }
+            if (info.Cache.Level == 2) {
+                assign_lowest(cpus, info.Cache.GroupMask, &cpu_info::l2);
+            } else if (info.Cache.Level == 3) {
+                assign_lowest(cpus, info.Cache.GroupMask, &cpu_info::l3);
+            }
+        });
+        for_each_relation(RelationNumaNode, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+            for (auto id : group_cpus(info.NumaNode.GroupMask)) {
+                auto it = std::ranges::find(cpus, id, &cpu_info::id);
+                if (it != cpus.end()) {
+                    it->node = info.NumaNode.NodeNumber;
+                }
+            }
+        });
+
+        // the process affinity only covers the primary group, which is also all pin_current_thread can pin to
+        DWORD_PTR process_mask = 0;
+        DWORD_PTR system_mask = 0;
+        if (::GetProcessAffinityMask(::GetCurrentProcess(), &process_mask, &system_mask)) {
+            std::erase_if(cpus, [&](const cpu_info& cpu) {
+                return cpu.id >= sizeof(DWORD_PTR) * 8 || !(process_mask & (DWORD_PTR(1) << cpu.id));
+            });
+        }
+        if (cpus.empty()) {
+            return flat(std::max(std::thread::hardware_concurrency(), 1u));
+        }
+        std::ranges::sort(cpus, {}, &cpu_info::id);
+        return cpu_topology{ std::move(cpus) };
+    } catch (...) {
+        return flat(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+#else
+    return flat(std::max(std::thread::hardware_concurrency(), 1u));
+#endif
+}
+
+w::base::cpu_topology w::base::cpu_topology::flat(uint32_t cpu_count) noexcept
+{
+    std::vector<cpu_info> cpus(cpu_count);
+    for (uint32_t i = 0; i < cpu_count; ++i) {
+        cpus[i] = { .id = i, .core = i, .l2 = i, .l3 = 0, .node = 0 };
+    }
+    return cpu_topology{ std::move(cpus) };
+}
+
+w::base::cpu_topology w::base::cpu_topology::simulated(uint32_t nodes, uint32_t l3_per_node, uint32_t cores_per_l3, uint32_t threads_per_core) noexcept
+{
+    std::vector<cpu_info> cpus;
+    cpus.reserve(nodes * l3_per_node * cores_per_l3 * threads_per_core);
+
+    // Linux numbering: first thread of every core, then the SMT siblings
+    uint32_t core_count = nodes * l3_per_node * cores_per_l3;
+    for (uint32_t thread = 0; thread < threads_per_core; ++thread) {
+        for (uint32_t core = 0; core < core_count; ++core) {
+            uint32_t l3 = core / cores_per_l3;
+            cpus.push_back({
+                    .id = thread * core_count + core,
+                    .core = core,
+                    .l2 = core, // private L2 per core
+                    .l3 = l3 * cores_per_l3,
+                    .node = l3 / l3_per_node,
+            });
+        }
+    }
+    return cpu_topology{ std::move(cpus) };
+}
+
+size_t w::base::cpu_topology::physical_core_count() const noexcept
+{
+    std::vector<uint32_t> cores;
+    cores.reserve(cpus.size());
+    for (auto& cpu : cpus) {
+        cores.push_back(cpu.core);
+    }
+    std::ranges::sort(cores);
+    return std::ranges::distance(cores.begin(), std::unique(cores.begin(), cores.end()));
+}
+
+size_t w::base::cpu_topology::node_count() const noexcept
+{
+    uint32_t max_node = 0;
+    for (auto& cpu : cpus) {
+        max_node = std::max(max_node, cpu.node);
+    }
+    return cpus.empty() ? 0 : max_node + 1;
+}
+
+std::vector<w::base::cpu_info> w::base::cpu_topology::placement_order() const noexcept
+{
+    auto order = cpus;
+
+    // rank of the cpu inside its core, 0 for the first hardware thread
+    std::vector<uint32_t> smt_rank(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            smt_rank[i] += order[j].core == order[i].core;
+        }
+    }
+    std::vector<size_t> indices(order.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = i;
+    }
+    std::ranges::stable_sort(indices, {}, [&](size_t i) {
+        auto& cpu = order[i];
+        return std::tuple{ smt_rank[i], cpu.node, cpu.l3, cpu.l2, cpu.core };
+    });
+
+    std::vector<cpu_info> result;
+    result.reserve(order.size());
+    for (auto i : indices) {
+        result.push_back(order[i]);
+    }
+    return result;
+}
+
+bool w::base::pin_current_thread(uint32_t cpu) noexcept
+{
+#if defined(_WIN32)
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (cpu >= sizeof(DWORD_PTR) * 8 || !::GetProcessAffinityMask(::GetCurrentProcess(), &process_mask, &system_mask)
+        || !(process_mask & (DWORD_PTR(1) << cpu))) {
+        return false;
+    }
+    return ::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    // the thread still has the affinity it inherited, a cpu outside of it is not ours to use
+    if (::pthread_getaffinity_np(::pthread_self(), sizeof(set), &set) != 0 || !CPU_ISSET(cpu, &set)) {
+        return false;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,68 @@
+#include <base/event_count.h>
+#include <algorithm>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+#endif
+
+namespace {
+// std::atomic::wait has no timeout, so the timed wait goes to the OS directly
+void wait_on_address(std::atomic<uint32_t>& word, uint32_t old_value, std::chrono::steady_clock::time_point deadline) noexcept
+{
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero()) {
+        return;
+    }
+#if defined(_WIN32)
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+    WaitOnAddress(&word, &old_value, sizeof(old_value), DWORD(std::min<long long>(ms, INFINITE - 1)));
+#elif defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC, the absolute deadline survives spurious wakeups without drift
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    timespec ts{ .tv_sec = time_t(since_epoch / 1'000'000'000), .tv_nsec = long(since_epoch % 1'000'000'000) };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_BITSET_PRIVATE, old_value, &ts, nullptr, FUTEX_BITSET_MATCH_ANY);
+#else
+    (void)word;
+    (void)old_value;
+    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(remaining, std::chrono::milliseconds(1)));
+#endif
+}
+} // namespace
+
+bool w::base::event_count::wait_until(uint32_t old_epoch, std::chrono::steady_clock::time_point deadline) noexcept
+{
+    timed_waiters.fetch_add(1, std::memory_order::seq_cst);
+    bool notified = true;
+    while (true) {
+        auto timed = timed_epoch.load(std::memory_order::seq_cst);
+        if (epoch.load(std::memory_order::seq_cst) != old_epoch) {
+            break;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            notified = false;
+            break;
+        }
+        wait_on_address(timed_epoch, timed, deadline);
+    }
+    timed_waiters.fetch_sub(1, std::memory_order::relaxed);
+    wcount.fetch_sub(1, std::memory_order::seq_cst);
+    return notified;
+}
+
+void w::base::event_count::wake_timed_waiters() noexcept
+{
+    timed_epoch.fetch_add(1, std::memory_order::seq_cst);
+#if defined(_WIN32)
+    WakeByAddressAll(&timed_epoch);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&timed_epoch), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
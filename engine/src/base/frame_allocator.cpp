@@ -0,0 +1,206 @@
+#include <base/frame_allocator.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+using w::base::frame_allocator;
+
+enum class frame_kind : uint16_t {
+    pooled,
+    global,
+    resource,
+};
+
+struct alignas(frame_allocator::header_size) frame_header {
+    void* source; // owning frame_cache or memory_resource
+    uint32_t size; // requested size, without the header
+    frame_kind kind;
+    uint16_t size_class;
+};
+static_assert(sizeof(frame_header) == frame_allocator::header_size);
+
+struct free_block {
+    free_block* next;
+};
+
+frame_header* header_of(void* frame) noexcept
+{
+    return static_cast<frame_header*>(frame) - 1;
+}
+free_block* block_of(frame_header* header) noexcept
+{
+    return reinterpret_cast<free_block*>(header + 1);
+}
+frame_header* header_of(free_block* block) noexcept
+{
+    return reinterpret_cast<frame_header*>(block) - 1;
+}
+
+// Free lists of a single thread.
+// Caches are never destroyed: a finished thread abandons its cache and the next new thread adopts it,
+// so frames still alive on other threads can always be returned.
+class frame_cache
+{
+public:
+    free_block* pop(size_t cls) noexcept
+    {
+        auto* block = lists[cls];
+        if (!block) {
+            drain_remote();
+            block = lists[cls];
+            if (!block) {
+                return nullptr;
+            }
+        }
+        lists[cls] = block->next;
+        counts[cls]--;
+        return block;
+    }
+    void push(free_block* block, size_t cls) noexcept
+    {
+        if (counts[cls] >= frame_allocator::max_cached_blocks) {
+            ::operator delete(header_of(block));
+            return;
+        }
+        block->next = lists[cls];
+        lists[cls] = block;
+        counts[cls]++;
+    }
+    // any thread
+    void push_remote(free_block* block) noexcept
+    {
+        auto* head = remote.load(std::memory_order::relaxed);
+        do {
+            block->next = head;
+        } while (!remote.compare_exchange_weak(head, block, std::memory_order::release, std::memory_order::relaxed));
+    }
+    // owner only, takes the whole stack at once so there is no ABA
+    void drain_remote() noexcept
+    {
+        auto* block = remote.exchange(nullptr, std::memory_order::acquire);
+        while (block) {
+            auto* next = block->next;
+            push(block, header_of(block)->size_class);
+            block = next;
+        }
+    }
+    void release_all() noexcept
+    {
+        for (size_t cls = 0; cls < frame_allocator::class_count; ++cls) {
+            while (auto* block = lists[cls]) {
+                lists[cls] = block->next;
+                ::operator delete(header_of(block));
+            }
+            counts[cls] = 0;
+        }
+    }
+
+private:
+    std::array<free_block*, frame_allocator::class_count> lists{};
+    std::array<uint32_t, frame_allocator::class_count> counts{};
+    alignas(std::hardware_destructive_interference_size) std::atomic<free_block*> remote{ nullptr };
+};
+
+struct cache_registry {
+    std::mutex mutex;
+    std::vector<frame_cache*> abandoned;
+
+public:
+    static cache_registry& get() noexcept
+    {
+        static auto* registry = new cache_registry; // leaked, threads may exit after static destruction
+        return *registry;
+    }
+    frame_cache* adopt()
+    {
+        std::scoped_lock lock{ mutex };
+        if (abandoned.empty()) {
+            return new frame_cache;
+        }
+        auto* cache = abandoned.back();
+        abandoned.pop_back();
+        return cache;
+    }
+    void abandon(frame_cache* cache) noexcept
+    {
+        cache->release_all();
+        std::scoped_lock lock{ mutex };
+        abandoned.push_back(cache);
+    }
+};
+
+struct thread_cache {
+    frame_cache* cache = cache_registry::get().adopt();
+
+public:
+    ~thread_cache() noexcept
+    {
+        cache_registry::get().abandon(cache);
+    }
+};
+
+frame_cache* local_cache()
+{
+    thread_local thread_cache local;
+    return local.cache;
+}
+
+void* init_header(void* memory, void* source, size_t size, frame_kind kind, size_t cls) noexcept
+{
+    auto* header = ::new (memory) frame_header{ source, uint32_t(size), kind, uint16_t(cls) };
+    return header + 1;
+}
+} // namespace
+
+void* w::base::frame_allocator::allocate(size_t size)
+{
+    auto total = size + header_size;
+    if (total > max_class_size) {
+        return init_header(::operator new(total), nullptr, size, frame_kind::global, 0);
+    }
+
+    auto cls = size_class(total);
+    auto* cache = local_cache();
+    if (auto* block = cache->pop(cls)) {
+        header_of(block)->size = uint32_t(size); // source and size class are already set
+        return block;
+    }
+    return init_header(::operator new(min_class_size << cls), cache, size, frame_kind::pooled, cls);
+}
+
+void* w::base::frame_allocator::allocate(size_t size, std::pmr::memory_resource* resource)
+{
+    if (!resource) {
+        return allocate(size);
+    }
+    return init_header(resource->allocate(size + header_size, header_size), resource, size, frame_kind::resource, 0);
+}
+
+void w::base::frame_allocator::deallocate(void* frame) noexcept
+{
+    if (!frame) {
+        return;
+    }
+    auto* header = header_of(frame);
+    switch (header->kind) {
+    case frame_kind::global:
+        ::operator delete(header);
+        return;
+    case frame_kind::resource:
+        static_cast<std::pmr::memory_resource*>(header->source)->deallocate(header, header->size + header_size, header_size);
+        return;
+    case frame_kind::pooled:
+        break;
+    }
+
+    auto* owner = static_cast<frame_cache*>(header->source);
+    auto* block = block_of(header);
+    if (owner == local_cache()) {
+        owner->push(block, header->size_class);
+    } else {
+        owner->push_remote(block);
+    }
+}
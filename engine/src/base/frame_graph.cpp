@@ -0,0 +1,203 @@
+#include <base/frame_graph.h>
+#include <base/frame_allocator.h>
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+// One coroutine per system and frame, destroys itself when done
+// and continues with a dependent that became ready, the others are submitted to the pool
+struct w::base::frame_graph::system_runner {
+    struct promise_type : w::base::frame_allocated {
+        promise_type(frame_graph& graph, system s) noexcept
+            : graph(graph), s(s)
+        {
+        }
+
+        system_runner get_return_object() noexcept
+        {
+            return { std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+        auto final_suspend() const noexcept
+        {
+            struct awaitable {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+                {
+                    frame_graph& graph = handle.promise().graph;
+                    system s = handle.promise().s;
+                    handle.destroy();
+                    return graph.finish(s);
+                }
+                void await_resume() const noexcept
+                {
+                }
+            };
+            return awaitable{};
+        }
+        void return_void() const noexcept
+        {
+        }
+        void unhandled_exception() const noexcept
+        {
+            std::terminate(); // the frame would never finish
+        }
+
+        frame_graph& graph;
+        system s;
+    };
+
+    std::coroutine_handle<> handle;
+};
+
+struct w::base::frame_graph::start_awaitable {
+    frame_graph& graph;
+
+    bool await_ready() const noexcept
+    {
+        return graph.systems.empty();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept
+    {
+        return graph.start(awaiting);
+    }
+    void await_resume() const noexcept
+    {
+    }
+};
+
+w::base::frame_graph::system w::base::frame_graph::add_system(system_data data)
+{
+    for (resource r : data.reads) {
+        assert(r < resource_count && "unknown resource");
+    }
+    for (resource r : data.writes) {
+        assert(r < resource_count && "unknown resource");
+    }
+    systems.push_back(std::move(data));
+    compiled = false;
+    return system(systems.size() - 1);
+}
+
+void w::base::frame_graph::compile()
+{
+    constexpr system none = ~0u;
+    size_t count = systems.size();
+    std::vector<system> last_writer(resource_count, none);
+    std::vector<std::vector<system>> readers(resource_count);
+
+    // edges from earlier to later systems, duplicates removed below
+    std::vector<std::pair<system, system>> edges;
+    for (system s = 0; s < count; ++s) {
+        auto depend = [&](system before) {
+            if (before != none && before != s) {
+                edges.emplace_back(before, s);
+            }
+        };
+        for (resource r : systems[s].reads) {
+            depend(last_writer[r]);
+        }
+        for (resource r : systems[s].writes) {
+            depend(last_writer[r]);
+            for (system reader : readers[r]) {
+                depend(reader);
+            }
+        }
+        for (resource r : systems[s].reads) {
+            readers[r].push_back(s);
+        }
+        for (resource r : systems[s].writes) {
+            last_writer[r] = s;
+            readers[r].clear();
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    dependent_begin.assign(count + 1, 0);
+    dependency_count.assign(count, 0);
+    dependent_list.resize(edges.size());
+    for (auto [before, after] : edges) {
+        ++dependent_begin[before + 1];
+        ++dependency_count[after];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        dependent_begin[i + 1] += dependent_begin[i];
+    }
+    for (size_t i = 0; i < edges.size(); ++i) {
+        dependent_list[i] = edges[i].second; // sorted by the first system, so already in place
+    }
+
+    roots.clear();
+    for (system s = 0; s < count; ++s) {
+        if (dependency_count[s] == 0) {
+            roots.push_back(s);
+        }
+    }
+    pending = std::make_unique<std::atomic<uint32_t>[]>(count);
+    ready.resize(edges.size());
+    ready_roots.resize(roots.size());
+    compiled = true;
+}
+
+w::task<void> w::base::frame_graph::run()
+{
+    assert(compiled && "compile() after adding systems");
+    co_await start_awaitable{ *this };
+}
+
+w::base::frame_graph::system_runner w::base::frame_graph::run_system(frame_graph& graph, system s)
+{
+    auto& data = graph.systems[s];
+    if (data.run_async) {
+        co_await data.run_async();
+    } else {
+        data.run();
+    }
+}
+
+// The roots go to the pool with a single bulk submit, none of them runs on the awaiting thread,
+// which may not even be a worker. Every system may be done before the submit returns.
+std::coroutine_handle<> w::base::frame_graph::start(std::coroutine_handle<> awaiting) noexcept
+{
+    continuation = awaiting;
+    remaining.store(systems.size() + 1, std::memory_order::relaxed);
+    for (size_t s = 0; s < systems.size(); ++s) {
+        pending[s].store(dependency_count[s], std::memory_order::relaxed);
+    }
+    for (size_t i = 0; i < roots.size(); ++i) {
+        ready_roots[i] = run_system(*this, roots[i]).handle;
+    }
+    w::detail::resume_background(std::span{ ready_roots });
+    if (remaining.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+        return continuation;
+    }
+    return std::noop_coroutine();
+}
+
+// Releases the dependents of s. Once the last system finished the awaiting coroutine continues,
+// the graph may be gone after that.
+std::coroutine_handle<> w::base::frame_graph::finish(system s) noexcept
+{
+    auto* slots = ready.data() + dependent_begin[s];
+    size_t count = 0;
+    for (system d : dependents(s)) {
+        if (pending[d].fetch_sub(1, std::memory_order::acq_rel) == 1) {
+            slots[count++] = run_system(*this, d).handle;
+        }
+    }
+    if (count > 1) {
+        w::detail::resume_background(std::span{ slots, count - 1 });
+    }
+    std::coroutine_handle<> next = count > 0 ? slots[count - 1] : std::noop_coroutine();
+    if (remaining.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+        return continuation; // nothing became ready, the others are done
+    }
+    return next;
+}
@@ -0,0 +1,125 @@
+#include <base/io.h>
+#include <base/thread_pool.h>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// reads until the buffer is full or the file ends, the count is short only at the end
+w::task<w::result<size_t>> read_fully(const w::io::file& file, std::span<std::byte> buffer, uint64_t offset)
+{
+    size_t total = 0;
+    while (total < buffer.size()) {
+        auto read = co_await w::io::read_at_async(file, buffer.subspan(total), offset + total);
+        if (read) {
+            co_return read;
+        }
+        if (read.value == 0) {
+            break;
+        }
+        total += read.value;
+    }
+    co_return total;
+}
+} // namespace
+
+w::result<w::io::file> w::io::file::open(const std::filesystem::path& path) noexcept
+{
+#if defined(_WIN32)
+    auto handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return { "could not open the file", w::error };
+    }
+    return file{ reinterpret_cast<intptr_t>(handle) };
+#else
+    int fd;
+    do {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        return { "could not open the file", w::error };
+    }
+    return file{ intptr_t(fd) };
+#endif
+}
+
+uint64_t w::io::file::size() const noexcept
+{
+    if (!is_open()) {
+        return 0;
+    }
+#if defined(_WIN32)
+    LARGE_INTEGER size;
+    return GetFileSizeEx(reinterpret_cast<HANDLE>(handle), &size) ? uint64_t(size.QuadPart) : 0;
+#else
+    struct stat info;
+    return fstat(int(handle), &info) == 0 ? uint64_t(info.st_size) : 0;
+#endif
+}
+
+void w::io::file::close() noexcept
+{
+    if (!is_open()) {
+        return;
+    }
+#if defined(_WIN32)
+    CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+    ::close(int(handle));
+#endif
+    handle = invalid_handle;
+}
+
+void w::io::detail::submit_read(w::base::io_request* request) noexcept
+{
+    w::base::global_thread_pool_token::get_pool().submit_io(request);
+}
+
+w::task<w::result<w::io::file_contents>> w::io::read_file_async(std::filesystem::path path, size_t chunk_size)
+{
+    auto opened = file::open(path);
+    if (opened) {
+        co_return { opened.error.message, w::error };
+    }
+    const auto& source = opened.value;
+    auto size = size_t(source.size());
+    file_contents contents{ std::make_unique_for_overwrite<std::byte[]>(size), size };
+    std::span buffer{ contents.data.get(), size };
+
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    if (size <= chunk_size) {
+        auto read = co_await read_fully(source, buffer, 0);
+        if (read) {
+            co_return { read.error.message, w::error };
+        }
+        contents.size = read.value; // shrunk since the size was taken
+        co_return std::move(contents);
+    }
+
+    std::vector<w::task<w::result<size_t>>> chunks;
+    chunks.reserve((size + chunk_size - 1) / chunk_size);
+    for (size_t offset = 0; offset < size; offset += chunk_size) {
+        chunks.push_back(read_fully(source, buffer.subspan(offset, std::min(chunk_size, size - offset)), offset));
+    }
+    auto reads = co_await w::when_all(std::span{ chunks });
+
+    size_t total = 0;
+    for (size_t i = 0; i < reads.size(); ++i) {
+        if (reads[i]) {
+            co_return { reads[i].error.message, w::error };
+        }
+        if (reads[i].value != chunk_size && i + 1 != reads.size()) {
+            co_return { "file shrunk while reading", w::error }; // a gap in the middle
+        }
+        total += reads[i].value;
+    }
+    contents.size = total;
+    co_return std::move(contents);
+}
@@ -0,0 +1,375 @@
+#include <base/io_ring.h>
+#include <base/native_thread.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <cstring>
+#endif
+
+namespace {
+int64_t read_blocking(intptr_t file, void* buffer, uint32_t size, uint64_t offset) noexcept
+{
+#if defined(_WIN32)
+    OVERLAPPED overlapped{};
+    overlapped.Offset = DWORD(offset);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+    DWORD read = 0;
+    if (!ReadFile(reinterpret_cast<HANDLE>(file), buffer, size, &read, &overlapped)) {
+        auto error = GetLastError();
+        return error == ERROR_HANDLE_EOF ? 0 : -int64_t(error);
+    }
+    return read;
+#else
+    ssize_t read;
+    do {
+        read = pread(int(file), buffer, size, off_t(offset));
+    } while (read < 0 && errno == EINTR);
+    return read < 0 ? -int64_t(errno) : int64_t(read);
+#endif
+}
+} // namespace
+
+#if defined(__linux__)
+struct w::base::io_ring::uring {
+    int fd = -1;
+    void* sq_map = MAP_FAILED;
+    size_t sq_map_size = 0;
+    void* cq_map = MAP_FAILED;
+    size_t cq_map_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    uint32_t* sq_head = nullptr;
+    uint32_t* sq_tail = nullptr;
+    uint32_t* sq_array = nullptr;
+    uint32_t sq_mask = 0;
+    uint32_t sq_entries = 0;
+    uint32_t* cq_head = nullptr;
+    uint32_t* cq_tail = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    uint32_t cq_mask = 0;
+
+    std::atomic_flag submitting; // any thread fills the SQ, one at a time
+    std::atomic<bool> wake_pending{ false }; // a wake nop is submitted and not reaped yet
+    std::atomic<uint32_t> waiters{ 0 }; // threads inside wait()
+
+public:
+    ~uring() noexcept
+    {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_map != MAP_FAILED && cq_map != sq_map) {
+            munmap(cq_map, cq_map_size);
+        }
+        if (sq_map != MAP_FAILED) {
+            munmap(sq_map, sq_map_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // nullptr if the kernel has no io_uring, or one without timed waits (before 5.11)
+    static std::unique_ptr<uring> create(uint32_t entries) noexcept
+    {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CLAMP;
+        auto ring = std::make_unique<uring>();
+        ring->fd = int(syscall(SYS_io_uring_setup, entries, &params));
+        if (ring->fd < 0 || !(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+            return nullptr;
+        }
+
+        ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_map = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_map) {
+            ring->sq_map_size = ring->cq_map_size = std::max(ring->sq_map_size, ring->cq_map_size);
+        }
+        ring->sq_map = mmap(nullptr, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+        if (ring->sq_map == MAP_FAILED) {
+            return nullptr;
+        }
+        ring->cq_map = single_map ? ring->sq_map : mmap(nullptr, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) {
+            return nullptr;
+        }
+        ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES));
+        if (ring->sqes == MAP_FAILED) {
+            return nullptr;
+        }
+
+        auto* sq = static_cast<char*>(ring->sq_map);
+        auto* cq = static_cast<char*>(ring->cq_map);
+        ring->sq_head = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+        ring->sq_tail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+        ring->sq_array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+        ring->sq_mask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+        ring->sq_entries = params.sq_entries;
+        ring->cq_head = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+        ring->cq_tail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        ring->cq_mask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+        return ring;
+    }
+
+public:
+    int enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags, void* arg = nullptr, size_t arg_size = 0) noexcept
+    {
+        return int(syscall(SYS_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    // False if the kernel refused the entry, it is taken back then and never completes.
+    // Without SQPOLL the kernel only consumes entries inside enter, which is serialized by the lock.
+    bool push(uint8_t opcode, const io_request* request) noexcept
+    {
+        while (submitting.test_and_set(std::memory_order::acquire)) {
+            std::this_thread::yield();
+        }
+        auto tail = *sq_tail; // only written under the lock
+        while (tail - std::atomic_ref{ *sq_head }.load(std::memory_order::acquire) >= sq_entries) {
+            std::this_thread::yield(); // not consumed yet, only happens if a previous enter failed
+        }
+        auto index = tail & sq_mask;
+        auto& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = -1;
+        if (request) {
+            sqe.fd = int(request->file);
+            sqe.addr = reinterpret_cast<uint64_t>(request->buffer);
+            sqe.len = request->size;
+            sqe.off = request->offset;
+        }
+        sqe.user_data = reinterpret_cast<uint64_t>(request);
+        sq_array[index] = index;
+        std::atomic_ref{ *sq_tail }.store(tail + 1, std::memory_order::release);
+
+        int result;
+        do {
+            auto unconsumed = tail + 1 - std::atomic_ref{ *sq_head }.load(std::memory_order::acquire);
+            result = enter(unconsumed, 0, 0);
+        } while (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+        bool consumed = int32_t(std::atomic_ref{ *sq_head }.load(std::memory_order::acquire) - (tail + 1)) >= 0; // head is past the entry
+        if (result < 0 && !consumed) {
+            std::atomic_ref{ *sq_tail }.store(tail, std::memory_order::release); // the caller reports the error, no completion may follow
+        }
+        submitting.clear(std::memory_order::release);
+        return result >= 0 || consumed;
+    }
+
+    bool has_completions() const noexcept
+    {
+        return std::atomic_ref{ *cq_head }.load(std::memory_order::relaxed) != std::atomic_ref{ *cq_tail }.load(std::memory_order::acquire);
+    }
+
+    // true if a wake nop was among the completions
+    template<typename F>
+    bool reap(F&& on_complete) noexcept
+    {
+        bool woken = false;
+        auto head = *cq_head; // only written by the reaping thread
+        auto tail = std::atomic_ref{ *cq_tail }.load(std::memory_order::acquire);
+        for (; head != tail; ++head) {
+            auto& cqe = cqes[head & cq_mask];
+            if (cqe.user_data) {
+                on_complete(reinterpret_cast<io_request*>(cqe.user_data), cqe.res);
+            } else {
+                woken = true; // wake() submits empty nops
+            }
+        }
+        if (woken) {
+            wake_pending.store(false, std::memory_order::seq_cst);
+        }
+        std::atomic_ref{ *cq_head }.store(head, std::memory_order::release);
+        return woken;
+    }
+};
+#else
+struct w::base::io_ring::uring {
+};
+#endif
+
+struct w::base::io_ring::fallback {
+    std::mutex mutex;
+    std::condition_variable ready;
+    io_request* head = nullptr;
+    io_request** tail = &head;
+    bool stop = false;
+    native_thread thread;
+};
+
+w::base::io_ring::io_ring(wake_callback wake_workers, void* context, uint32_t entries) noexcept
+    : wake_workers(wake_workers)
+    , context(context)
+{
+#if defined(__linux__)
+    ring = uring::create(entries);
+    if (ring) {
+        return;
+    }
+#else
+    (void)entries;
+#endif
+
+    thread = std::make_unique<fallback>();
+    thread->thread.start([this]() {
+        set_current_thread_name("w io fallback");
+        auto& queue = *thread;
+        while (true) {
+            io_request* request;
+            {
+                std::unique_lock lock{ queue.mutex };
+                queue.ready.wait(lock, [&] { return queue.stop || queue.head; });
+                if (!queue.head) {
+                    return;
+                }
+                request = queue.head;
+                queue.head = request->next;
+                if (!queue.head) {
+                    queue.tail = &queue.head;
+                }
+            }
+            request->result = read_blocking(request->file, request->buffer, request->size, request->offset);
+            push_completed(request);
+        }
+    });
+}
+
+w::base::io_ring::~io_ring() noexcept
+{
+    if (thread) {
+        {
+            std::lock_guard lock{ thread->mutex };
+            thread->stop = true;
+        }
+        thread->ready.notify_one();
+        thread->thread.join();
+    }
+}
+
+void w::base::io_ring::submit(io_request* request) noexcept
+{
+    in_flight.fetch_add(1, std::memory_order::seq_cst);
+#if defined(__linux__)
+    if (ring) {
+        if (!ring->push(IORING_OP_READ, request)) {
+            request->result = -int64_t(errno);
+            push_completed(request);
+        }
+        return;
+    }
+#endif
+    {
+        std::lock_guard lock{ thread->mutex };
+        request->next = nullptr;
+        *thread->tail = request;
+        thread->tail = &request->next;
+    }
+    thread->ready.notify_one();
+}
+
+bool w::base::io_ring::has_completions() const noexcept
+{
+    if (completed.load(std::memory_order::relaxed)) {
+        return true;
+    }
+#if defined(__linux__)
+    return ring && ring->has_completions();
+#else
+    return false;
+#endif
+}
+
+w::base::io_request* w::base::io_ring::reap() noexcept
+{
+    if (reaping.test_and_set(std::memory_order::acquire)) {
+        return nullptr;
+    }
+    auto* list = completed.exchange(nullptr, std::memory_order::acquire);
+    size_t count = 0;
+    for (auto* r = list; r; r = r->next) {
+        ++count;
+    }
+    bool took_wake = false;
+#if defined(__linux__)
+    if (ring) {
+        took_wake = ring->reap([&](io_request* request, int32_t result) {
+            request->result = result;
+            request->next = list;
+            list = request;
+            ++count;
+        });
+    }
+#endif
+    reaping.clear(std::memory_order::release);
+#if defined(__linux__)
+    if (took_wake && ring->waiters.load(std::memory_order::seq_cst) != 0) {
+        wake(); // the nop may have been meant for the thread waiting in the ring
+    }
+#else
+    (void)took_wake;
+#endif
+    if (count) {
+        in_flight.fetch_sub(count, std::memory_order::relaxed);
+    }
+    return list;
+}
+
+void w::base::io_ring::wait(clock::time_point deadline) noexcept
+{
+#if defined(__linux__)
+    if (!ring) {
+        return;
+    }
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg arg{};
+    if (deadline != clock::time_point::max()) {
+        auto remaining = std::max(deadline - clock::now(), clock::duration::zero());
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        timeout.tv_sec = ns / 1'000'000'000;
+        timeout.tv_nsec = ns % 1'000'000'000;
+        arg.ts = reinterpret_cast<uint64_t>(&timeout);
+    }
+    ring->waiters.fetch_add(1, std::memory_order::seq_cst);
+    ring->enter(0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    ring->waiters.fetch_sub(1, std::memory_order::relaxed);
+#else
+    (void)deadline;
+#endif
+}
+
+void w::base::io_ring::wake() noexcept
+{
+#if defined(__linux__)
+    if (ring && !ring->wake_pending.exchange(true, std::memory_order::seq_cst)) {
+        if (!ring->push(IORING_OP_NOP, nullptr)) { // its completion ends the wait
+            ring->wake_pending.store(false, std::memory_order::relaxed);
+        }
+    }
+#endif
+}
+
+void w::base::io_ring::push_completed(io_request* request) noexcept
+{
+    auto* head = completed.load(std::memory_order::relaxed);
+    do {
+        request->next = head;
+    } while (!completed.compare_exchange_weak(head, request, std::memory_order::release, std::memory_order::relaxed));
+    wake_workers(context);
+}
@@ -0,0 +1,190 @@
+#include <base/lz4.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace {
+constexpr size_t min_match = 4;
+constexpr size_t last_literals = 5; // the block always ends with literals
+constexpr size_t match_limit = 12; // no match may start in the last bytes
+constexpr size_t max_offset = 65535;
+constexpr size_t hash_bits = 12;
+
+uint32_t read32(const uint8_t* p) noexcept
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+uint32_t hash(uint32_t sequence) noexcept
+{
+    return (sequence * 2654435761u) >> (32 - hash_bits);
+}
+
+// length beyond the 15 stored in the token, as a run of 255 bytes
+uint8_t* write_length(uint8_t* op, size_t length) noexcept
+{
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = uint8_t(length);
+    return op;
+}
+
+// nullptr if the sequence does not fit
+uint8_t* write_sequence(uint8_t* op, const uint8_t* oend, const uint8_t* literals, size_t literal_count, size_t offset, size_t match_length) noexcept
+{
+    size_t needed = 1 + literal_count / 255 + 1 + literal_count + (match_length ? 2 + match_length / 255 + 1 : 0);
+    if (needed > size_t(oend - op)) {
+        return nullptr;
+    }
+    auto* token = op++;
+    *token = uint8_t(std::min<size_t>(literal_count, 15) << 4);
+    if (literal_count >= 15) {
+        op = write_length(op, literal_count - 15);
+    }
+    std::memcpy(op, literals, literal_count);
+    op += literal_count;
+    if (!match_length) {
+        return op; // last sequence, literals only
+    }
+
+    *op++ = uint8_t(offset);
+    *op++ = uint8_t(offset >> 8);
+    auto stored = match_length - min_match;
+    *token |= uint8_t(std::min<size_t>(stored, 15));
+    if (stored >= 15) {
+        op = write_length(op, stored - 15);
+    }
+    return op;
+}
+
+// false if the length runs past the input
+bool read_length(const uint8_t*& ip, const uint8_t* iend, size_t& length) noexcept
+{
+    uint8_t byte;
+    do {
+        if (ip == iend) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+} // namespace
+
+size_t w::base::lz4::compress(std::span<const std::byte> src, std::span<std::byte> dst) noexcept
+{
+    if (src.size() > max_input_size) {
+        return 0;
+    }
+    const auto* in = reinterpret_cast<const uint8_t*>(src.data());
+    auto* op = reinterpret_cast<uint8_t*>(dst.data());
+    const auto* oend = op + dst.size();
+    size_t n = src.size();
+    size_t anchor = 0;
+
+    if (n > match_limit) {
+        auto table = std::make_unique<std::array<uint32_t, size_t(1) << hash_bits>>(); // positions, 0 is checked like any other
+        size_t limit = n - match_limit;
+        size_t ip = 1;
+        size_t misses = 0;
+        while (ip < limit) {
+            auto sequence = read32(in + ip);
+            auto& slot = (*table)[hash(sequence)];
+            size_t ref = slot;
+            slot = uint32_t(ip);
+            if (ip - ref > max_offset || read32(in + ref) != sequence) {
+                ip += 1 + (misses++ >> 6); // skips ahead faster through incompressible data
+                continue;
+            }
+            misses = 0;
+
+            // extend backwards into the pending literals, then forwards
+            while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+                --ip;
+                --ref;
+            }
+            size_t length = min_match;
+            while (ip + length < n - last_literals && in[ip + length] == in[ref + length]) {
+                ++length;
+            }
+            op = write_sequence(op, oend, in + anchor, ip - anchor, ip - ref, length);
+            if (!op) {
+                return 0;
+            }
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    op = write_sequence(op, oend, in + anchor, n - anchor, 0, 0);
+    return op ? size_t(op - reinterpret_cast<uint8_t*>(dst.data())) : 0;
+}
+
+bool w::base::lz4::decompress(std::span<const std::byte> src, std::span<std::byte> dst) noexcept
+{
+    const auto* ip = reinterpret_cast<const uint8_t*>(src.data());
+    const auto* iend = ip + src.size();
+    auto* const obegin = reinterpret_cast<uint8_t*>(dst.data());
+    auto* op = obegin;
+    const auto* oend = op + dst.size();
+
+    while (ip != iend) {
+        auto token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(ip, iend, literals)) {
+            return false;
+        }
+        if (literals > size_t(iend - ip) || literals > size_t(oend - op)) {
+            return false;
+        }
+        if (literals <= 16 && iend - ip >= 16 && oend - op >= 16) {
+            std::memcpy(op, ip, 16); // fixed size copy, the bytes past the literals are overwritten later
+        } else {
+            std::memcpy(op, ip, literals);
+        }
+        ip += literals;
+        op += literals;
+        if (ip == iend) {
+            break; // the last sequence has no match
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+        ip += 2;
+        if (offset == 0 || offset > size_t(op - obegin)) {
+            return false;
+        }
+        size_t length = token & 15;
+        if (length == 15 && !read_length(ip, iend, length)) {
+            return false;
+        }
+        length += min_match;
+        if (length > size_t(oend - op)) {
+            return false;
+        }
+        const auto* match = op - offset;
+        if (offset >= 8 && size_t(oend - op) >= length + 8) {
+            // 8 byte steps, each one only reads bytes written before, also for overlapping matches
+            for (size_t i = 0; i < length; i += 8) {
+                std::memcpy(op + i, match + i, 8);
+            }
+            op += length;
+        } else if (offset >= length) {
+            std::memcpy(op, match, length);
+            op += length;
+        } else {
+            for (size_t i = 0; i < length; ++i) { // overlapping, repeats the last offset bytes
+                *op++ = match[i];
+            }
+        }
+    }
+    return op == oend;
+}
@@ -0,0 +1,86 @@
+#include <base/mapped_file.h>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// a zero length file cannot be mapped, it gets a dummy address so it still counts as open
+const std::byte empty_file{};
+} // namespace
+
+w::result<w::base::mapped_file> w::base::mapped_file::open(const std::filesystem::path& path) noexcept
+{
+#if defined(_WIN32)
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return { "could not open the file", w::error };
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return { "could not query the file size", w::error };
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        return mapped_file{ &empty_file, 0 };
+    }
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // the mapping keeps the file open
+    if (!mapping) {
+        return { "could not map the file", w::error };
+    }
+    auto* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping alive
+    if (!view) {
+        return { "could not map the file", w::error };
+    }
+    return mapped_file{ static_cast<const std::byte*>(view), size_t(size.QuadPart) };
+#else
+    int fd;
+    do {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        return { "could not open the file", w::error };
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return { "could not query the file size", w::error };
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        return mapped_file{ &empty_file, 0 };
+    }
+    auto size = size_t(info.st_size);
+    auto* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (view == MAP_FAILED) {
+        return { "could not map the file", w::error };
+    }
+    return mapped_file{ static_cast<const std::byte*>(view), size };
+#endif
+}
+
+void w::base::mapped_file::unmap() noexcept
+{
+    if (!data || data == &empty_file) {
+        data = nullptr;
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<std::byte*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,87 @@
+#include <base/native_thread.h>
+#include <string>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace {
+#if defined(_WIN32)
+DWORD WINAPI thread_entry(void* arg)
+{
+    (*static_cast<std::function<void()>*>(arg))();
+    return 0;
+}
+#else
+void* thread_entry(void* arg)
+{
+    (*static_cast<std::function<void()>*>(arg))();
+    return nullptr;
+}
+#endif
+} // namespace
+
+bool w::base::native_thread::start(std::function<void()> thread_func, size_t stack_size) noexcept
+{
+    if (joinable()) {
+        return false;
+    }
+    func = std::move(thread_func);
+
+#if defined(_WIN32)
+    auto h = CreateThread(nullptr, stack_size, thread_entry, &func, stack_size ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0, nullptr);
+    if (!h) {
+        return false;
+    }
+    handle = reinterpret_cast<uintptr_t>(h);
+#else
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0) {
+        return false;
+    }
+    if (stack_size && pthread_attr_setstacksize(&attr, stack_size) != 0) {
+        pthread_attr_destroy(&attr);
+        return false;
+    }
+    pthread_t t;
+    auto result = pthread_create(&t, &attr, thread_entry, &func);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        return false;
+    }
+    handle = uintptr_t(t);
+#endif
+    return true;
+}
+
+void w::base::native_thread::join() noexcept
+{
+    if (!joinable()) {
+        return;
+    }
+#if defined(_WIN32)
+    auto h = reinterpret_cast<HANDLE>(handle);
+    WaitForSingleObject(h, INFINITE);
+    CloseHandle(h);
+#else
+    pthread_join(pthread_t(handle), nullptr);
+#endif
+    handle = 0;
+}
+
+void w::base::set_current_thread_name(std::string_view name) noexcept
+{
+#if defined(_WIN32)
+    std::wstring wide(name.begin(), name.end());
+    SetThreadDescription(GetCurrentThread(), wide.c_str());
+#elif defined(__linux__)
+    std::string truncated{ name.substr(0, 15) };
+    pthread_setname_np(pthread_self(), truncated.c_str());
+#elif defined(__APPLE__)
+    std::string truncated{ name };
+    pthread_setname_np(truncated.c_str());
+#endif
+}
@@ -1,14 +1,78 @@
 #include <base/await.h>
 #include <base/thread_pool.h>
+#include <base/frame_allocator.h>
 
-void w::detail::resume_background(std::coroutine_handle<> handle) noexcept
+namespace {
+struct cancellable_resume {
+    struct promise_type : w::base::frame_allocated {
+        cancellable_resume get_return_object() noexcept
+        {
+            return { std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+        void return_void() const noexcept
+        {
+        }
+        void unhandled_exception() const // throws exception
+        {
+            throw;
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+cancellable_resume resume_unless_cancelled(std::coroutine_handle<> handle, w::cancellation_token token)
+{
+    if (token.is_cancelled()) {
+        handle.destroy();
+    } else {
+        handle.resume();
+    }
+    co_return;
+}
+} // namespace
+
+std::coroutine_handle<> w::base::make_cancellable(std::coroutine_handle<> handle, cancellation_token token) noexcept
+{
+    return resume_unless_cancelled(handle, std::move(token)).handle;
+}
+
+void w::detail::resume_background(std::coroutine_handle<> handle, priority lane) noexcept
+{
+    w::base::global_thread_pool_token::get_pool().submit(handle, lane);
+}
+
+void w::detail::resume_background(std::coroutine_handle<> handle, std::chrono::steady_clock::time_point deadline) noexcept
+{
+    w::base::global_thread_pool_token::get_pool().submit(handle, deadline);
+}
+
+void w::detail::resume_background(std::span<const std::coroutine_handle<>> handles, priority lane) noexcept
+{
+    w::base::global_thread_pool_token::get_pool().submit_bulk(handles, lane);
+}
+
+bool w::detail::resume_affine(std::coroutine_handle<> handle, size_t thread_index) noexcept
+{
+    return w::base::global_thread_pool_token::get_pool().submit_affine(handle, thread_index);
+}
+
+void w::detail::resume_at(w::base::timer_node* timer) noexcept
 {
-    w::base::global_thread_pool_token::get_pool().submit(handle);
+    w::base::global_thread_pool_token::get_pool().schedule_timer(timer);
 }
 
-void w::detail::resume_affine(std::coroutine_handle<> handle, size_t thread_index) noexcept
+bool w::detail::cancel_timer(w::base::timer_node* timer) noexcept
 {
-    w::base::global_thread_pool_token::get_pool().submit_affine(handle, thread_index);
+    return w::base::global_thread_pool_token::get_pool().cancel_timer(timer);
 }
 
 size_t w::detail::current() noexcept
@@ -0,0 +1,106 @@
+#include <base/thread_pool_stats.h>
+#include <iomanip>
+#include <ostream>
+#include <string_view>
+
+namespace {
+// JSON string contents, quotes, backslashes and control characters escaped
+void write_json_escaped(std::ostream& out, std::string_view text)
+{
+    constexpr char hex[] = "0123456789abcdef";
+    for (char c : text) {
+        switch (c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        case '\r':
+            out << "\\r";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+            } else {
+                out << c;
+            }
+        }
+    }
+}
+} // namespace
+
+w::base::trace_recorder::trace_recorder(size_t worker_count, size_t events_per_worker) noexcept
+    : worker_count(worker_count)
+    , capacity(events_per_worker)
+    , lanes(std::make_unique<lane[]>(worker_count))
+    , origin(clock::now())
+{
+    for (size_t i = 0; i < worker_count; ++i) {
+        lanes[i].events = std::make_unique<event[]>(events_per_worker);
+    }
+}
+
+// workers check is_recording before recording, so the lanes are not touched once the flag is published
+void w::base::trace_recorder::start() noexcept
+{
+    for (size_t i = 0; i < worker_count; ++i) {
+        lanes[i].count.store(0, std::memory_order::relaxed);
+        lanes[i].dropped.store(0, std::memory_order::relaxed);
+    }
+    origin = clock::now();
+    recording.store(true, std::memory_order::release);
+}
+
+size_t w::base::trace_recorder::dropped_events() const noexcept
+{
+    size_t dropped = 0;
+    for (size_t i = 0; i < worker_count; ++i) {
+        dropped += lanes[i].dropped.load(std::memory_order::relaxed);
+    }
+    return dropped;
+}
+
+void w::base::trace_recorder::write_chrome_trace(std::ostream& out, const std::string& thread_name) const
+{
+    constexpr const char* names[] = { "task", "explore", "park" };
+    auto micros = [this](clock::time_point t) {
+        return std::chrono::duration<double, std::micro>(t - origin).count();
+    };
+
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() -> std::ostream& {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        return out;
+    };
+
+    for (size_t worker = 0; worker < worker_count; ++worker) {
+        separator() << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << worker << R"(,"args":{"name":")";
+        write_json_escaped(out, thread_name); // comes from thread_pool_config, may hold anything
+        out << ' ' << worker << "\"}}";
+
+        auto& lane = lanes[worker];
+        auto count = lane.count.load(std::memory_order::acquire);
+        for (size_t i = 0; i < count; ++i) {
+            auto& e = lane.events[i];
+            separator() << R"({"name":")" << names[size_t(e.kind)] << R"(","ph":"X","pid":1,"tid":)" << worker
+                        << ",\"ts\":" << micros(e.begin) << ",\"dur\":" << micros(e.end) - micros(e.begin) << '}';
+        }
+    }
+    out << "\n]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,243 @@
+#include <ecs/registry.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <exception>
+#include <new>
+
+namespace {
+std::array<w::ecs::component_info, w::ecs::max_components> component_infos;
+std::atomic<w::ecs::component_id> next_component_id{ 0 };
+
+// columns start at least 16 byte aligned, so float4a and friends can be loaded directly
+size_t column_alignment(const w::ecs::component_info& info) noexcept
+{
+    return std::max<size_t>(info.alignment, 16);
+}
+size_t align_up(size_t value, size_t alignment) noexcept
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+w::ecs::component_id w::ecs::detail::register_component(component_info info) noexcept
+{
+    component_id id = next_component_id.fetch_add(1, std::memory_order::relaxed);
+    if (id >= max_components) {
+        std::terminate(); // component masks have one bit per type
+    }
+    component_infos[id] = info;
+    return id;
+}
+
+const w::ecs::component_info& w::ecs::get_component_info(component_id id) noexcept
+{
+    return component_infos[id];
+}
+
+// archetype
+//-------------------------------------------------------------------------
+w::ecs::archetype::archetype(component_mask mask)
+    : signature(mask)
+{
+    offsets.fill(no_column);
+    size_t entity_bytes = sizeof(entity);
+    for (component_mask rest = mask; rest; rest &= rest - 1) {
+        component_id id = component_id(std::countr_zero(rest));
+        components.push_back(id);
+        entity_bytes += get_component_info(id).size;
+    }
+
+    // largest count whose columns fit the chunk once aligned
+    auto layout = [this](size_t count, bool store) {
+        size_t end = sizeof(entity) * count;
+        for (component_id id : components) {
+            const auto& info = get_component_info(id);
+            end = align_up(end, column_alignment(info));
+            if (store) {
+                offsets[id] = uint16_t(end);
+            }
+            end += info.size * count;
+        }
+        return end;
+    };
+    capacity = uint32_t(chunk_size / entity_bytes);
+    while (capacity > 1 && layout(capacity, false) > chunk_size) {
+        --capacity;
+    }
+    assert(capacity > 0 && layout(capacity, false) <= chunk_size && "components do not fit a chunk");
+    layout(capacity, true);
+}
+
+w::ecs::archetype::location w::ecs::archetype::push(entity e)
+{
+    if (used_chunks == 0 || chunk_list[used_chunks - 1].count == capacity) {
+        if (used_chunks == chunk_list.size()) {
+            chunk_list.push_back({ std::unique_ptr<std::byte, chunk_deleter>{ static_cast<std::byte*>(::operator new(chunk_size, std::align_val_t{ 64 })) } });
+        }
+        ++used_chunks;
+    }
+    chunk& c = chunk_list[used_chunks - 1];
+    uint32_t row = c.count++;
+    std::memcpy(c.memory.get() + row * sizeof(entity), &e, sizeof(entity));
+    ++entity_count;
+    return { uint32_t(used_chunks - 1), row };
+}
+
+w::ecs::entity w::ecs::archetype::erase(location at) noexcept
+{
+    chunk& last = chunk_list[used_chunks - 1];
+    uint32_t last_row = last.count - 1;
+
+    entity moved{};
+    if (at.chunk != used_chunks - 1 || at.row != last_row) {
+        chunk& target = chunk_list[at.chunk];
+        moved = last.entities()[last_row];
+        std::memcpy(target.memory.get() + at.row * sizeof(entity), &moved, sizeof(entity));
+        for (component_id id : components) {
+            size_t size = get_component_info(id).size;
+            std::memcpy(static_cast<std::byte*>(column(target, id)) + at.row * size, static_cast<std::byte*>(column(last, id)) + last_row * size, size);
+        }
+    }
+
+    --last.count;
+    --entity_count;
+    if (last.count == 0) {
+        --used_chunks;
+        // one empty chunk stays around, so an entity going back and forth does not allocate every time
+        if (chunk_list.size() > used_chunks + 1) {
+            chunk_list.pop_back();
+        }
+    }
+    return moved;
+}
+
+// registry
+//-------------------------------------------------------------------------
+w::ecs::registry::registry()
+{
+    find_or_create(0);
+}
+w::ecs::registry::~registry() = default;
+
+w::ecs::entity w::ecs::registry::create()
+{
+    return create_in(0);
+}
+
+w::ecs::entity w::ecs::registry::create_in(component_mask mask)
+{
+    uint32_t index;
+    if (free_list.empty()) {
+        index = uint32_t(records.size());
+        records.emplace_back();
+    } else {
+        index = free_list.back();
+        free_list.pop_back();
+    }
+
+    record& r = records[index];
+    entity e{ index, r.generation };
+    r.owner = find_or_create(mask);
+    auto [chunk, row] = r.owner->push(e);
+    r.chunk = chunk;
+    r.row = row;
+    return e;
+}
+
+void w::ecs::registry::destroy(entity e) noexcept
+{
+    if (!alive(e)) {
+        return;
+    }
+    record& r = records[e.index];
+    entity moved = r.owner->erase({ r.chunk, r.row });
+    if (moved.valid()) {
+        records[moved.index].chunk = r.chunk;
+        records[moved.index].row = r.row;
+    }
+    r.owner = nullptr;
+    ++r.generation;
+    free_list.push_back(e.index);
+}
+
+void* w::ecs::registry::add_component(entity e, component_id id)
+{
+    assert(alive(e));
+    archetype* source = records[e.index].owner;
+    if (!source->contains(component_mask(1) << id)) {
+        archetype*& target = source->add_edges[id];
+        if (!target) {
+            target = find_or_create(source->mask() | (component_mask(1) << id));
+            target->remove_edges[id] = source;
+        }
+        move_entity(e, target);
+    }
+    return get_component(e, id);
+}
+
+void w::ecs::registry::remove_component(entity e, component_id id)
+{
+    assert(alive(e));
+    archetype* source = records[e.index].owner;
+    if (source->contains(component_mask(1) << id)) {
+        archetype*& target = source->remove_edges[id];
+        if (!target) {
+            target = find_or_create(source->mask() & ~(component_mask(1) << id));
+            target->add_edges[id] = source;
+        }
+        move_entity(e, target);
+    }
+}
+
+void* w::ecs::registry::get_component(entity e, component_id id) noexcept
+{
+    const record& r = records[e.index];
+    return static_cast<std::byte*>(r.owner->column(r.owner->chunk_list[r.chunk], id)) + r.row * get_component_info(id).size;
+}
+
+void w::ecs::registry::move_entity(entity e, archetype* target)
+{
+    record& r = records[e.index];
+    archetype* source = r.owner;
+    auto [chunk, row] = target->push(e);
+
+    // shared components keep their values, added ones are set by the caller
+    const auto& from = source->chunk_list[r.chunk];
+    const auto& to = target->chunk_list[chunk];
+    for (component_id id : source->components) {
+        if (target->contains(component_mask(1) << id)) {
+            size_t size = get_component_info(id).size;
+            std::memcpy(static_cast<std::byte*>(target->column(to, id)) + row * size, static_cast<std::byte*>(source->column(from, id)) + r.row * size, size);
+        }
+    }
+
+    entity moved = source->erase({ r.chunk, r.row });
+    if (moved.valid()) {
+        records[moved.index].chunk = r.chunk;
+        records[moved.index].row = r.row;
+    }
+    r.owner = target;
+    r.chunk = chunk;
+    r.row = row;
+}
+
+w::ecs::archetype* w::ecs::registry::find_or_create(component_mask mask)
+{
+    auto [it, inserted] = archetype_lookup.try_emplace(mask, nullptr);
+    if (inserted) {
+        it->second = archetype_list.emplace_back(std::make_unique<archetype>(mask)).get();
+    }
+    return it->second;
+}
+
+std::vector<w::ecs::archetype*> w::ecs::registry::matching(component_mask mask) const
+{
+    std::vector<archetype*> result;
+    for (const auto& a : archetype_list) {
+        if (a->contains(mask)) {
+            result.push_back(a.get());
+        }
+    }
+    return result;
+}
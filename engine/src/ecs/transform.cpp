@@ -0,0 +1,68 @@
+#include <ecs/transform.h>
+#include <mutex>
+
+namespace {
+std::mutex changes_mutex;
+std::vector<w::ecs::transform*> changed_transforms;
+} // namespace
+
+std::vector<w::ecs::transform*> w::ecs::transform_changes::take()
+{
+    std::vector<transform*> result;
+    std::lock_guard lock(changes_mutex);
+    result.swap(changed_transforms);
+    for (transform* t : result) {
+        t->queue_index.store(transform::not_queued, std::memory_order::relaxed);
+    }
+    return result;
+}
+
+size_t w::ecs::transform_changes::size() noexcept
+{
+    std::lock_guard lock(changes_mutex);
+    return changed_transforms.size();
+}
+
+void w::ecs::transform_changes::changed(transform& t)
+{
+    std::lock_guard lock(changes_mutex);
+    if (t.queue_index.load(std::memory_order::relaxed) != transform::not_queued) {
+        return; // listed by a concurrent change
+    }
+    t.queue_index.store(uint32_t(changed_transforms.size()), std::memory_order::relaxed);
+    changed_transforms.push_back(&t);
+}
+
+void w::ecs::transform_changes::forget(transform& t) noexcept
+{
+    std::lock_guard lock(changes_mutex);
+    if (auto index = t.queue_index.load(std::memory_order::relaxed); index != transform::not_queued) {
+        remove_at(index);
+        t.queue_index.store(transform::not_queued, std::memory_order::relaxed);
+    }
+}
+
+void w::ecs::transform_changes::hand_over(transform& from, transform& to) noexcept
+{
+    std::lock_guard lock(changes_mutex);
+    auto index = from.queue_index.load(std::memory_order::relaxed);
+    if (index == transform::not_queued) {
+        return; // taken meanwhile
+    }
+    if (to.queue_index.load(std::memory_order::relaxed) == transform::not_queued) {
+        changed_transforms[index] = &to;
+        to.queue_index.store(index, std::memory_order::relaxed);
+    } else {
+        remove_at(index);
+    }
+    from.queue_index.store(transform::not_queued, std::memory_order::relaxed);
+}
+
+// swap with the last one, the caller holds the lock
+void w::ecs::transform_changes::remove_at(uint32_t index) noexcept
+{
+    transform* last = changed_transforms.back();
+    changed_transforms[index] = last;
+    last->queue_index.store(index, std::memory_order::relaxed);
+    changed_transforms.pop_back();
+}
@@ -0,0 +1,207 @@
+#include <ecs/transform_hierarchy.h>
+#include <math/batch.h>
+#include <math/matrix_math.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <span>
+
+w::ecs::transform_hierarchy::node w::ecs::transform_hierarchy::add(node parent, const math::matrix& local)
+{
+    assert(parent == no_parent || parent < size());
+    node n = node(size());
+    uint32_t slot = uint32_t(locals.size());
+    parent_nodes.push_back(parent);
+    slots.push_back(slot);
+    parent_slots.push_back(parent == no_parent ? no_parent : slots[parent]);
+    locals.push_back(local);
+    worlds.push_back(local);
+    dirty.resize((locals.size() + 63) / 64);
+    mark_dirty(slot);
+    structure_changed = true;
+    return n;
+}
+
+void w::ecs::transform_hierarchy::set_parent(node n, node parent)
+{
+    for (node p = parent; p != no_parent; p = parent_nodes[p]) {
+        assert(p != n && "the parent is a descendant");
+    }
+    parent_nodes[n] = parent;
+    mark_dirty(slots[n]);
+    structure_changed = true;
+}
+
+// breadth first from the roots, children ordered like their parents
+void w::ecs::transform_hierarchy::sort_by_depth()
+{
+    size_t count = size();
+    std::vector<uint32_t> child_begin(count + 1, 0);
+    for (node p : parent_nodes) {
+        if (p != no_parent) {
+            ++child_begin[p + 1];
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        child_begin[i + 1] += child_begin[i];
+    }
+    std::vector<node> children(child_begin[count]);
+    std::vector<uint32_t> fill(child_begin.begin(), child_begin.end() - 1);
+    std::vector<node> order;
+    order.reserve(count);
+    for (node n = 0; n < count; ++n) {
+        if (parent_nodes[n] == no_parent) {
+            order.push_back(n);
+        } else {
+            children[fill[parent_nodes[n]]++] = n;
+        }
+    }
+
+    level_begin.assign(1, 0);
+    for (size_t level = 0; level_begin.back() < order.size(); ++level) {
+        size_t end = order.size();
+        level_begin.push_back(uint32_t(end));
+        for (size_t i = level_begin[level]; i < end; ++i) {
+            node n = order[i];
+            order.insert(order.end(), children.begin() + child_begin[n], children.begin() + child_begin[n + 1]);
+        }
+    }
+
+    std::vector<uint32_t> new_parents(count);
+    std::vector<math::float4x4a> new_locals(count), new_worlds(count);
+    std::vector<uint64_t> new_dirty(dirty.size());
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        node n = order[slot];
+        uint32_t old = slots[n];
+        new_locals[slot] = locals[old];
+        new_worlds[slot] = worlds[old];
+        new_dirty[slot / 64] |= ((dirty[old / 64] >> (old % 64)) & 1) << (slot % 64);
+    }
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        slots[order[slot]] = slot;
+    }
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        node p = parent_nodes[order[slot]];
+        new_parents[slot] = p == no_parent ? no_parent : slots[p];
+    }
+    parent_slots = std::move(new_parents);
+    locals = std::move(new_locals);
+    worlds = std::move(new_worlds);
+    dirty = std::move(new_dirty);
+    structure_changed = false;
+}
+
+// Slots of one level. Parents are one level up and final, so only the range is written.
+// Ranges of one level may share a word of the dirty bits with the level above, hence the atomic access.
+// Without recomputed parents only the nodes changed themselves are dirty.
+size_t w::ecs::transform_hierarchy::update_range(size_t begin, size_t end, bool parents_changed) noexcept
+{
+    auto test = [this](uint32_t slot) {
+        return (std::atomic_ref(dirty[slot / 64]).load(std::memory_order::relaxed) >> (slot % 64)) & 1;
+    };
+
+    size_t computed = 0;
+    alignas(64) math::float4x4a parents[64];
+    for (size_t word = begin / 64; word * 64 < end; ++word) {
+        size_t first = std::max(begin, word * 64);
+        size_t last = std::min(end, word * 64 + 64);
+        uint64_t range = (last - first == 64 ? ~uint64_t(0) : ((uint64_t(1) << (last - first)) - 1)) << (first % 64);
+
+        // a node is dirty if it changed itself or its parent was recomputed, siblings share the lookup
+        std::atomic_ref bits_ref(dirty[word]);
+        uint64_t own = bits_ref.load(std::memory_order::relaxed) & range;
+        uint64_t bits = own;
+        uint32_t last_parent = no_parent;
+        bool last_parent_dirty = false;
+        for (uint64_t rest = parents_changed ? range & ~own : 0; rest; rest &= rest - 1) {
+            size_t slot = word * 64 + std::countr_zero(rest);
+            uint32_t p = parent_slots[slot];
+            if (p != last_parent) {
+                last_parent = p;
+                last_parent_dirty = p != no_parent && test(p);
+            }
+            if (last_parent_dirty) {
+                bits |= rest & -rest;
+            }
+        }
+        if (bits == 0) {
+            continue;
+        }
+        if (bits != own) {
+            bits_ref.fetch_or(bits, std::memory_order::relaxed);
+        }
+        computed += std::popcount(bits);
+
+        if (parent_slots[first] == no_parent) {
+            for (uint64_t rest = bits; rest; rest &= rest - 1) {
+                size_t slot = word * 64 + std::countr_zero(rest);
+                worlds[slot] = locals[slot];
+            }
+        } else if (bits == range) {
+            // the whole range, parents gathered for the batch multiply
+            size_t n = last - first;
+            for (size_t i = 0; i < n; ++i) {
+                parents[i] = worlds[parent_slots[first + i]];
+            }
+            math::multiply_batch(std::span{ locals }.subspan(first, n), std::span{ parents, n }, std::span{ worlds }.subspan(first, n));
+        } else {
+            for (uint64_t rest = bits; rest; rest &= rest - 1) {
+                size_t slot = word * 64 + std::countr_zero(rest);
+                worlds[slot] = math::multiply(locals[slot], worlds[parent_slots[slot]]);
+            }
+        }
+    }
+    return computed;
+}
+
+size_t w::ecs::transform_hierarchy::update()
+{
+    if (structure_changed) {
+        sort_by_depth();
+    }
+    size_t computed = 0, computed_level = 0;
+    for (size_t level = 0; level + 1 < level_begin.size(); ++level) {
+        computed_level = update_range(level_begin[level], level_begin[level + 1], computed_level > 0);
+        computed += computed_level;
+    }
+    std::fill(dirty.begin(), dirty.end(), 0);
+    return computed;
+}
+
+w::task<size_t> w::ecs::transform_hierarchy::update_range_async(transform_hierarchy& self, size_t begin, size_t end, bool parents_changed)
+{
+    co_return self.update_range(begin, end, parents_changed);
+}
+
+w::task<size_t> w::ecs::transform_hierarchy::update_parallel()
+{
+    if (structure_changed) {
+        sort_by_depth();
+    }
+    size_t computed = 0, computed_level = 0;
+    std::vector<w::task<size_t>> tasks;
+    for (size_t level = 0; level + 1 < level_begin.size(); ++level) {
+        size_t begin = level_begin[level], end = level_begin[level + 1];
+        bool parents_changed = computed_level > 0;
+        if (end - begin <= parallel_grain) {
+            computed_level = update_range(begin, end, parents_changed);
+            computed += computed_level;
+            continue;
+        }
+        // split at multiples of the grain, so two tasks never write the same word
+        tasks.clear();
+        for (size_t first = begin; first < end;) {
+            size_t last = std::min(end, (first / parallel_grain + 1) * parallel_grain);
+            tasks.push_back(update_range_async(*this, first, last, parents_changed));
+            first = last;
+        }
+        computed_level = 0;
+        for (size_t n : co_await w::when_all(std::span{ tasks })) {
+            computed_level += n;
+        }
+        computed += computed_level;
+    }
+    std::fill(dirty.begin(), dirty.end(), 0);
+    co_return computed;
+}
@@ -0,0 +1,466 @@
+#include <math/batch.h>
+#include <math/simd.h>
+#include <algorithm>
+
+namespace {
+using w::math::float3;
+using w::math::float4x4;
+using w::math::float4x4a;
+
+const float* row_data(const float4x4a& m, size_t row) noexcept
+{
+    return m.r[row].data.data();
+}
+float* row_data(float4x4a& m, size_t row) noexcept
+{
+    return m.r[row].data.data();
+}
+
+// tails shorter than a full register
+void transform_points_scalar(std::span<const float3> points, const float4x4& m, std::span<float3> out, size_t first) noexcept
+{
+    for (size_t i = first; i < out.size(); ++i) {
+        float3 p = points[i];
+        for (size_t c = 0; c < 3; ++c) {
+            out[i][c] = p[0] * m.r[0][c] + p[1] * m.r[1][c] + p[2] * m.r[2][c] + m.r[3][c];
+        }
+    }
+}
+void transform_points_scalar(w::math::const_float3_soa points, const float4x4& m, w::math::float3_soa out, size_t first) noexcept
+{
+    for (size_t i = first; i < out.size(); ++i) {
+        float x = points.x[i], y = points.y[i], z = points.z[i];
+        out.x[i] = x * m.r[0][0] + y * m.r[1][0] + z * m.r[2][0] + m.r[3][0];
+        out.y[i] = x * m.r[0][1] + y * m.r[1][1] + z * m.r[2][1] + m.r[3][1];
+        out.z[i] = x * m.r[0][2] + y * m.r[1][2] + z * m.r[2][2] + m.r[3][2];
+    }
+}
+void multiply_soa_scalar(const w::math::const_float4x4_soa& a, const w::math::const_float4x4_soa& b, const w::math::float4x4_soa& out, size_t first) noexcept
+{
+    for (size_t i = first; i < out.size(); ++i) {
+        for (size_t r = 0; r < 4; ++r) {
+            float a0 = a.m[r * 4][i], a1 = a.m[r * 4 + 1][i], a2 = a.m[r * 4 + 2][i], a3 = a.m[r * 4 + 3][i];
+            for (size_t c = 0; c < 4; ++c) {
+                out.m[r * 4 + c][i] = a0 * b.m[c][i] + a1 * b.m[4 + c][i] + a2 * b.m[8 + c][i] + a3 * b.m[12 + c][i];
+            }
+        }
+    }
+}
+
+// AVX2, two rows or 8 elements per register
+//-------------------------------------------------------------------------
+// rows * b for the two rows in the register, b rows are broadcast to both halves
+WTARGET_AVX2 __m256 combine_rows_avx2(__m256 rows, const __m256 (&b)[4]) noexcept
+{
+    __m256 result = _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b[0]);
+    result = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0x55), b[1], result);
+    result = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xaa), b[2], result);
+    return _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xff), b[3], result);
+}
+
+WTARGET_AVX2 void multiply_avx2(std::span<const float4x4a> a, std::span<const float4x4a> b, std::span<float4x4a> out) noexcept
+{
+    for (size_t i = 0; i < out.size(); ++i) {
+        auto* b_rows = reinterpret_cast<const __m128*>(row_data(b[i], 0));
+        const __m256 rows[4] = { _mm256_broadcast_ps(b_rows), _mm256_broadcast_ps(b_rows + 1), _mm256_broadcast_ps(b_rows + 2), _mm256_broadcast_ps(b_rows + 3) };
+        __m256 a01 = _mm256_loadu_ps(row_data(a[i], 0));
+        __m256 a23 = _mm256_loadu_ps(row_data(a[i], 2));
+        _mm256_storeu_ps(row_data(out[i], 0), combine_rows_avx2(a01, rows));
+        _mm256_storeu_ps(row_data(out[i], 2), combine_rows_avx2(a23, rows));
+    }
+}
+
+WTARGET_AVX2 void multiply_avx2(std::span<const float4x4a> a, const w::math::matrix& b, std::span<float4x4a> out) noexcept
+{
+    __m256 rows[4];
+    for (size_t r = 0; r < 4; ++r) {
+        rows[r] = _mm256_broadcast_ps(&b.r[r].data);
+    }
+    for (size_t i = 0; i < out.size(); ++i) {
+        __m256 a01 = _mm256_loadu_ps(row_data(a[i], 0));
+        __m256 a23 = _mm256_loadu_ps(row_data(a[i], 2));
+        _mm256_storeu_ps(row_data(out[i], 0), combine_rows_avx2(a01, rows));
+        _mm256_storeu_ps(row_data(out[i], 2), combine_rows_avx2(a23, rows));
+    }
+}
+
+WTARGET_AVX2 void multiply_avx2(const w::math::const_float4x4_soa& a, const w::math::const_float4x4_soa& b, const w::math::float4x4_soa& out) noexcept
+{
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        for (size_t r = 0; r < 4; ++r) {
+            __m256 a0 = _mm256_loadu_ps(&a.m[r * 4][i]);
+            __m256 a1 = _mm256_loadu_ps(&a.m[r * 4 + 1][i]);
+            __m256 a2 = _mm256_loadu_ps(&a.m[r * 4 + 2][i]);
+            __m256 a3 = _mm256_loadu_ps(&a.m[r * 4 + 3][i]);
+            for (size_t c = 0; c < 4; ++c) {
+                __m256 result = _mm256_mul_ps(a0, _mm256_loadu_ps(&b.m[c][i]));
+                result = _mm256_fmadd_ps(a1, _mm256_loadu_ps(&b.m[4 + c][i]), result);
+                result = _mm256_fmadd_ps(a2, _mm256_loadu_ps(&b.m[8 + c][i]), result);
+                result = _mm256_fmadd_ps(a3, _mm256_loadu_ps(&b.m[12 + c][i]), result);
+                _mm256_storeu_ps(&out.m[r * 4 + c][i], result);
+            }
+        }
+    }
+    multiply_soa_scalar(a, b, out, i);
+}
+
+// x, y and z for 8 points, the same order as transform<3>
+struct lanes_avx2 {
+    __m256 x, y, z;
+};
+struct rows_avx2 {
+    __m256 m[4][3];
+};
+
+WTARGET_AVX2 rows_avx2 broadcast_rows_avx2(const float4x4& m) noexcept
+{
+    rows_avx2 result;
+    for (size_t r = 0; r < 4; ++r) {
+        for (size_t c = 0; c < 3; ++c) {
+            result.m[r][c] = _mm256_set1_ps(m.r[r][c]);
+        }
+    }
+    return result;
+}
+
+WTARGET_AVX2 lanes_avx2 transform_avx2(lanes_avx2 p, const rows_avx2& m) noexcept
+{
+    lanes_avx2 result;
+    __m256* out[3] = { &result.x, &result.y, &result.z };
+    for (size_t c = 0; c < 3; ++c) {
+        __m256 value = _mm256_fmadd_ps(p.z, m.m[2][c], m.m[3][c]);
+        value = _mm256_fmadd_ps(p.y, m.m[1][c], value);
+        *out[c] = _mm256_fmadd_ps(p.x, m.m[0][c], value);
+    }
+    return result;
+}
+
+WTARGET_AVX2 __m256 load_halves_avx2(const float* low, const float* high) noexcept
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+WTARGET_AVX2 void transform_avx2(std::span<const float3> points, const float4x4& matrix, std::span<float3> out) noexcept
+{
+    auto m = broadcast_rows_avx2(matrix);
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        // 8 packed xyz triples, each half of a register holds 4 of them
+        const float* in = points[i].data.data();
+        __m256 m03 = load_halves_avx2(in, in + 12); // x0 y0 z0 x1
+        __m256 m14 = load_halves_avx2(in + 4, in + 16); // y1 z1 x2 y2
+        __m256 m25 = load_halves_avx2(in + 8, in + 20); // z2 x3 y3 z3
+        __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2)); // x2 y2 x3 y3
+        __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1)); // y0 z0 y1 z1
+        lanes_avx2 p = {
+            _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0)),
+            _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)),
+            _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1)),
+        };
+
+        p = transform_avx2(p, m);
+
+        __m256 rxy = _mm256_shuffle_ps(p.x, p.y, _MM_SHUFFLE(2, 0, 2, 0)); // x0 x2 y0 y2
+        __m256 ryz = _mm256_shuffle_ps(p.y, p.z, _MM_SHUFFLE(3, 1, 3, 1)); // y1 y3 z1 z3
+        __m256 rzx = _mm256_shuffle_ps(p.z, p.x, _MM_SHUFFLE(3, 1, 2, 0)); // z0 z2 x1 x3
+        m03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+        m14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+        m25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+        float* result = out[i].data.data();
+        _mm_storeu_ps(result, _mm256_castps256_ps128(m03));
+        _mm_storeu_ps(result + 4, _mm256_castps256_ps128(m14));
+        _mm_storeu_ps(result + 8, _mm256_castps256_ps128(m25));
+        _mm_storeu_ps(result + 12, _mm256_extractf128_ps(m03, 1));
+        _mm_storeu_ps(result + 16, _mm256_extractf128_ps(m14, 1));
+        _mm_storeu_ps(result + 20, _mm256_extractf128_ps(m25, 1));
+    }
+    transform_points_scalar(points, matrix, out, i);
+}
+
+WTARGET_AVX2 void transform_avx2(w::math::const_float3_soa points, const float4x4& matrix, w::math::float3_soa out) noexcept
+{
+    auto m = broadcast_rows_avx2(matrix);
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        auto p = transform_avx2({ _mm256_loadu_ps(&points.x[i]), _mm256_loadu_ps(&points.y[i]), _mm256_loadu_ps(&points.z[i]) }, m);
+        _mm256_storeu_ps(&out.x[i], p.x);
+        _mm256_storeu_ps(&out.y[i], p.y);
+        _mm256_storeu_ps(&out.z[i], p.z);
+    }
+    transform_points_scalar(points, matrix, out, i);
+}
+
+// AVX-512, a whole matrix or 16 elements per register
+//-------------------------------------------------------------------------
+WTARGET_AVX512 __m512 combine_rows_avx512(__m512 rows, const __m512 (&b)[4]) noexcept
+{
+    __m512 result = _mm512_mul_ps(_mm512_permute_ps(rows, 0x00), b[0]);
+    result = _mm512_fmadd_ps(_mm512_permute_ps(rows, 0x55), b[1], result);
+    result = _mm512_fmadd_ps(_mm512_permute_ps(rows, 0xaa), b[2], result);
+    return _mm512_fmadd_ps(_mm512_permute_ps(rows, 0xff), b[3], result);
+}
+
+WTARGET_AVX512 void multiply_avx512(std::span<const float4x4a> a, std::span<const float4x4a> b, std::span<float4x4a> out) noexcept
+{
+    for (size_t i = 0; i < out.size(); ++i) {
+        auto* b_rows = reinterpret_cast<const __m128*>(row_data(b[i], 0));
+        const __m512 rows[4] = { _mm512_broadcast_f32x4(b_rows[0]), _mm512_broadcast_f32x4(b_rows[1]), _mm512_broadcast_f32x4(b_rows[2]), _mm512_broadcast_f32x4(b_rows[3]) };
+        _mm512_storeu_ps(row_data(out[i], 0), combine_rows_avx512(_mm512_loadu_ps(row_data(a[i], 0)), rows));
+    }
+}
+
+WTARGET_AVX512 void multiply_avx512(std::span<const float4x4a> a, const w::math::matrix& b, std::span<float4x4a> out) noexcept
+{
+    __m512 rows[4];
+    for (size_t r = 0; r < 4; ++r) {
+        rows[r] = _mm512_broadcast_f32x4(b.r[r]);
+    }
+    for (size_t i = 0; i < out.size(); ++i) {
+        _mm512_storeu_ps(row_data(out[i], 0), combine_rows_avx512(_mm512_loadu_ps(row_data(a[i], 0)), rows));
+    }
+}
+
+WTARGET_AVX512 void multiply_avx512(const w::math::const_float4x4_soa& a, const w::math::const_float4x4_soa& b, const w::math::float4x4_soa& out) noexcept
+{
+    size_t i = 0;
+    for (; i + 16 <= out.size(); i += 16) {
+        // 32 registers hold all of b, the AVX2 version reloads it per row instead
+        __m512 bv[16];
+        for (size_t e = 0; e < 16; ++e) {
+            bv[e] = _mm512_loadu_ps(&b.m[e][i]);
+        }
+        for (size_t r = 0; r < 4; ++r) {
+            __m512 a0 = _mm512_loadu_ps(&a.m[r * 4][i]);
+            __m512 a1 = _mm512_loadu_ps(&a.m[r * 4 + 1][i]);
+            __m512 a2 = _mm512_loadu_ps(&a.m[r * 4 + 2][i]);
+            __m512 a3 = _mm512_loadu_ps(&a.m[r * 4 + 3][i]);
+            for (size_t c = 0; c < 4; ++c) {
+                __m512 result = _mm512_mul_ps(a0, bv[c]);
+                result = _mm512_fmadd_ps(a1, bv[4 + c], result);
+                result = _mm512_fmadd_ps(a2, bv[8 + c], result);
+                result = _mm512_fmadd_ps(a3, bv[12 + c], result);
+                _mm512_storeu_ps(&out.m[r * 4 + c][i], result);
+            }
+        }
+    }
+    multiply_soa_scalar(a, b, out, i);
+}
+
+struct lanes_avx512 {
+    __m512 x, y, z;
+};
+struct rows_avx512 {
+    __m512 m[4][3];
+};
+
+WTARGET_AVX512 rows_avx512 broadcast_rows_avx512(const float4x4& m) noexcept
+{
+    rows_avx512 result;
+    for (size_t r = 0; r < 4; ++r) {
+        for (size_t c = 0; c < 3; ++c) {
+            result.m[r][c] = _mm512_set1_ps(m.r[r][c]);
+        }
+    }
+    return result;
+}
+
+WTARGET_AVX512 lanes_avx512 transform_avx512(lanes_avx512 p, const rows_avx512& m) noexcept
+{
+    lanes_avx512 result;
+    __m512* out[3] = { &result.x, &result.y, &result.z };
+    for (size_t c = 0; c < 3; ++c) {
+        __m512 value = _mm512_fmadd_ps(p.z, m.m[2][c], m.m[3][c]);
+        value = _mm512_fmadd_ps(p.y, m.m[1][c], value);
+        *out[c] = _mm512_fmadd_ps(p.x, m.m[0][c], value);
+    }
+    return result;
+}
+
+// 16 xyz triples span three registers, element g of them is component g % 3 of point g / 3.
+// A component is gathered from the first two with one two source permute,
+// the lanes coming from the third are merged in with a masked permute.
+struct triple_shuffle {
+    std::array<int32_t, 16> pair_index{};
+    std::array<int32_t, 16> third_index{};
+    uint16_t third_mask = 0;
+};
+
+constexpr triple_shuffle deinterleave_shuffle(int component) noexcept
+{
+    triple_shuffle result;
+    for (int p = 0; p < 16; ++p) {
+        int g = p * 3 + component;
+        if (g < 32) {
+            result.pair_index[p] = g;
+        } else {
+            result.third_index[p] = g - 32;
+            result.third_mask |= uint16_t(1u << p);
+        }
+    }
+    return result;
+}
+
+// register 0, 1 or 2 from the x, y and z registers, the reverse of the above
+constexpr triple_shuffle interleave_shuffle(int reg) noexcept
+{
+    triple_shuffle result;
+    for (int j = 0; j < 16; ++j) {
+        int g = reg * 16 + j;
+        int point = g / 3;
+        switch (g % 3) {
+        case 0:
+            result.pair_index[j] = point;
+            break;
+        case 1:
+            result.pair_index[j] = point + 16;
+            break;
+        default:
+            result.third_index[j] = point;
+            result.third_mask |= uint16_t(1u << j);
+            break;
+        }
+    }
+    return result;
+}
+
+constexpr triple_shuffle deinterleave_shuffles[3] = { deinterleave_shuffle(0), deinterleave_shuffle(1), deinterleave_shuffle(2) };
+constexpr triple_shuffle interleave_shuffles[3] = { interleave_shuffle(0), interleave_shuffle(1), interleave_shuffle(2) };
+
+struct triple_shuffle_avx512 {
+    __m512i pair_index;
+    __m512i third_index;
+    __mmask16 third_mask;
+};
+
+WTARGET_AVX512 triple_shuffle_avx512 load_shuffle_avx512(const triple_shuffle& shuffle) noexcept
+{
+    return { _mm512_loadu_si512(shuffle.pair_index.data()), _mm512_loadu_si512(shuffle.third_index.data()), shuffle.third_mask };
+}
+
+WTARGET_AVX512 __m512 apply_shuffle_avx512(const triple_shuffle_avx512& shuffle, __m512 first, __m512 second, __m512 third) noexcept
+{
+    __m512 pair = _mm512_permutex2var_ps(first, shuffle.pair_index, second);
+    return _mm512_mask_permutexvar_ps(pair, shuffle.third_mask, shuffle.third_index, third);
+}
+
+WTARGET_AVX512 void transform_avx512(std::span<const float3> points, const float4x4& matrix, std::span<float3> out) noexcept
+{
+    auto m = broadcast_rows_avx512(matrix);
+    triple_shuffle_avx512 split[3], merge[3];
+    for (int i = 0; i < 3; ++i) {
+        split[i] = load_shuffle_avx512(deinterleave_shuffles[i]);
+        merge[i] = load_shuffle_avx512(interleave_shuffles[i]);
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= out.size(); i += 16) {
+        const float* in = points[i].data.data();
+        __m512 v0 = _mm512_loadu_ps(in);
+        __m512 v1 = _mm512_loadu_ps(in + 16);
+        __m512 v2 = _mm512_loadu_ps(in + 32);
+        lanes_avx512 p = {
+            apply_shuffle_avx512(split[0], v0, v1, v2),
+            apply_shuffle_avx512(split[1], v0, v1, v2),
+            apply_shuffle_avx512(split[2], v0, v1, v2),
+        };
+
+        p = transform_avx512(p, m);
+
+        float* result = out[i].data.data();
+        _mm512_storeu_ps(result, apply_shuffle_avx512(merge[0], p.x, p.y, p.z));
+        _mm512_storeu_ps(result + 16, apply_shuffle_avx512(merge[1], p.x, p.y, p.z));
+        _mm512_storeu_ps(result + 32, apply_shuffle_avx512(merge[2], p.x, p.y, p.z));
+    }
+    transform_points_scalar(points, matrix, out, i);
+}
+
+WTARGET_AVX512 void transform_avx512(w::math::const_float3_soa points, const float4x4& matrix, w::math::float3_soa out) noexcept
+{
+    auto m = broadcast_rows_avx512(matrix);
+    size_t i = 0;
+    for (; i + 16 <= out.size(); i += 16) {
+        auto p = transform_avx512({ _mm512_loadu_ps(&points.x[i]), _mm512_loadu_ps(&points.y[i]), _mm512_loadu_ps(&points.z[i]) }, m);
+        _mm512_storeu_ps(&out.x[i], p.x);
+        _mm512_storeu_ps(&out.y[i], p.y);
+        _mm512_storeu_ps(&out.z[i], p.z);
+    }
+    transform_points_scalar(points, matrix, out, i);
+}
+
+// SSE4.1, one element at a time
+//-------------------------------------------------------------------------
+void multiply_sse41(std::span<const float4x4a> a, std::span<const float4x4a> b, std::span<float4x4a> out) noexcept
+{
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = w::math::detail::sse41_kernels.multiply(a[i], b[i]);
+    }
+}
+
+void multiply_sse41(std::span<const float4x4a> a, const w::math::matrix& b, std::span<float4x4a> out) noexcept
+{
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = w::math::detail::sse41_kernels.multiply(a[i], b);
+    }
+}
+} // namespace
+
+void w::math::multiply_batch(std::span<const float4x4a> a, std::span<const float4x4a> b, std::span<float4x4a> out) noexcept
+{
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+        return multiply_avx512(a, b, out);
+    case simd_level::avx2:
+        return multiply_avx2(a, b, out);
+    default:
+        return multiply_sse41(a, b, out);
+    }
+}
+
+void w::math::multiply_batch(std::span<const float4x4a> a, const matrix& b, std::span<float4x4a> out) noexcept
+{
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+        return multiply_avx512(a, b, out);
+    case simd_level::avx2:
+        return multiply_avx2(a, b, out);
+    default:
+        return multiply_sse41(a, b, out);
+    }
+}
+
+void w::math::multiply_batch(const const_float4x4_soa& a, const const_float4x4_soa& b, const float4x4_soa& out) noexcept
+{
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+        return multiply_avx512(a, b, out);
+    case simd_level::avx2:
+        return multiply_avx2(a, b, out);
+    default:
+        return multiply_soa_scalar(a, b, out, 0);
+    }
+}
+
+void w::math::transform_points(std::span<const float3> points, const matrix& m, std::span<float3> out) noexcept
+{
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+        return transform_avx512(points, m, out);
+    case simd_level::avx2:
+        return transform_avx2(points, m, out);
+    default:
+        return transform_points_scalar(points, m, out, 0);
+    }
+}
+
+void w::math::transform_points(const_float3_soa points, const matrix& m, float3_soa out) noexcept
+{
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+        return transform_avx512(points, m, out);
+    case simd_level::avx2:
+        return transform_avx2(points, m, out);
+    default:
+        return transform_points_scalar(points, m, out, 0);
+    }
+}
@@ -0,0 +1,156 @@
+#include <math/culling.h>
+#include <math/simd.h>
+#include <vector>
+
+namespace {
+using w::math::aabb;
+using w::math::bounding_sphere;
+using w::math::frustum;
+
+static_assert(sizeof(aabb) == 6 * sizeof(float), "the kernels gather boxes with a stride of 6 floats");
+static_assert(sizeof(bounding_sphere) == 4 * sizeof(float), "the kernels load one sphere per 128 bits");
+
+template<typename T>
+void cull_scalar(std::span<const T> objects, const frustum& f, std::span<uint8_t> visible, size_t first) noexcept
+{
+    for (size_t i = first; i < visible.size(); ++i) {
+        visible[i] = w::math::intersects(f, objects[i]);
+    }
+}
+
+// AVX2, 8 objects per iteration
+//-------------------------------------------------------------------------
+// 0 or 1 per lane of the comparison, 8 bytes
+WTARGET_AVX2 void store_visible(__m256 inside, uint8_t* out) noexcept
+{
+    __m256i ones = _mm256_and_si256(_mm256_castps_si256(inside), _mm256_set1_epi32(1));
+    __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(ones), _mm256_extracti128_si256(ones, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(words, words));
+}
+
+WTARGET_AVX2 void cull_avx2(std::span<const aabb> boxes, const frustum& f, std::span<uint8_t> visible) noexcept
+{
+    // plane components and their absolute values, broadcast from here in the loop
+    alignas(32) float planes[frustum::plane_count][7];
+    for (size_t p = 0; p < frustum::plane_count; ++p) {
+        for (size_t c = 0; c < 4; ++c) {
+            planes[p][c] = f.planes[p][c];
+        }
+        for (size_t c = 0; c < 3; ++c) {
+            planes[p][4 + c] = std::abs(f.planes[p][c]);
+        }
+    }
+
+    const __m256i stride = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    size_t i = 0;
+    for (; i + 8 <= visible.size(); i += 8) {
+        const float* base = boxes[i].center.data.data();
+        __m256 cx = _mm256_i32gather_ps(base, stride, 4);
+        __m256 cy = _mm256_i32gather_ps(base + 1, stride, 4);
+        __m256 cz = _mm256_i32gather_ps(base + 2, stride, 4);
+        __m256 ex = _mm256_i32gather_ps(base + 3, stride, 4);
+        __m256 ey = _mm256_i32gather_ps(base + 4, stride, 4);
+        __m256 ez = _mm256_i32gather_ps(base + 5, stride, 4);
+
+        // dot(n, c) + d + dot(|n|, e), smallest over the planes
+        __m256 nearest = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        for (const auto& p : planes) {
+            __m256 distance = _mm256_fmadd_ps(cx, _mm256_broadcast_ss(&p[0]), _mm256_broadcast_ss(&p[3]));
+            distance = _mm256_fmadd_ps(cy, _mm256_broadcast_ss(&p[1]), distance);
+            distance = _mm256_fmadd_ps(cz, _mm256_broadcast_ss(&p[2]), distance);
+            distance = _mm256_fmadd_ps(ex, _mm256_broadcast_ss(&p[4]), distance);
+            distance = _mm256_fmadd_ps(ey, _mm256_broadcast_ss(&p[5]), distance);
+            distance = _mm256_fmadd_ps(ez, _mm256_broadcast_ss(&p[6]), distance);
+            nearest = _mm256_min_ps(nearest, distance);
+        }
+        store_visible(_mm256_cmp_ps(nearest, _mm256_setzero_ps(), _CMP_GE_OQ), visible.data() + i);
+    }
+    cull_scalar(boxes, f, visible, i);
+}
+
+WTARGET_AVX2 void cull_avx2(std::span<const bounding_sphere> spheres, const frustum& f, std::span<uint8_t> visible) noexcept
+{
+    size_t i = 0;
+    for (; i + 8 <= visible.size(); i += 8) {
+        // spheres i and i + 4 share a register, the transpose keeps the order
+        const float* base = spheres[i].center.data.data();
+        __m256 s0 = _mm256_loadu2_m128(base + 16, base);
+        __m256 s1 = _mm256_loadu2_m128(base + 20, base + 4);
+        __m256 s2 = _mm256_loadu2_m128(base + 24, base + 8);
+        __m256 s3 = _mm256_loadu2_m128(base + 28, base + 12);
+        __m256 t0 = _mm256_unpacklo_ps(s0, s1);
+        __m256 t1 = _mm256_unpacklo_ps(s2, s3);
+        __m256 t2 = _mm256_unpackhi_ps(s0, s1);
+        __m256 t3 = _mm256_unpackhi_ps(s2, s3);
+        __m256 cx = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 cy = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 cz = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 radius = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+        __m256 nearest = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        for (const auto& plane : f.planes) {
+            const float* p = plane.data.data();
+            __m256 distance = _mm256_fmadd_ps(cx, _mm256_broadcast_ss(&p[0]), _mm256_broadcast_ss(&p[3]));
+            distance = _mm256_fmadd_ps(cy, _mm256_broadcast_ss(&p[1]), distance);
+            distance = _mm256_fmadd_ps(cz, _mm256_broadcast_ss(&p[2]), distance);
+            nearest = _mm256_min_ps(nearest, distance);
+        }
+        __m256 inside = _mm256_cmp_ps(_mm256_add_ps(nearest, radius), _mm256_setzero_ps(), _CMP_GE_OQ);
+        store_visible(inside, visible.data() + i);
+    }
+    cull_scalar(spheres, f, visible, i);
+}
+
+// the AVX-512 level keeps the AVX2 kernels, the loops are bound by loading the objects
+template<typename T>
+void cull_dispatch(std::span<const T> objects, const frustum& f, std::span<uint8_t> visible) noexcept
+{
+    if (w::math::active_simd_level() >= w::math::simd_level::avx2) {
+        cull_avx2(objects, f, visible);
+    } else {
+        cull_scalar(objects, f, visible, 0);
+    }
+}
+
+template<typename T>
+w::task<void> cull_chunk(std::span<const T> objects, const frustum& f, std::span<uint8_t> visible)
+{
+    cull_dispatch(objects, f, visible);
+    co_return;
+}
+
+template<typename T>
+w::task<void> cull_chunks(std::span<const T> objects, const frustum& f, std::span<uint8_t> visible)
+{
+    if (visible.size() <= w::math::cull_chunk_size) {
+        cull_dispatch(objects, f, visible);
+        co_return;
+    }
+
+    std::vector<w::task<void>> chunks;
+    chunks.reserve((visible.size() + w::math::cull_chunk_size - 1) / w::math::cull_chunk_size);
+    for (size_t first = 0; first < visible.size(); first += w::math::cull_chunk_size) {
+        size_t count = std::min(w::math::cull_chunk_size, visible.size() - first);
+        chunks.push_back(cull_chunk(objects.subspan(first, count), f, visible.subspan(first, count)));
+    }
+    co_await w::when_all(std::span{ chunks });
+}
+} // namespace
+
+void w::math::cull(std::span<const aabb> boxes, const frustum& f, std::span<uint8_t> visible) noexcept
+{
+    cull_dispatch(boxes, f, visible);
+}
+void w::math::cull(std::span<const bounding_sphere> spheres, const frustum& f, std::span<uint8_t> visible) noexcept
+{
+    cull_dispatch(spheres, f, visible);
+}
+
+w::task<void> w::math::cull_parallel(std::span<const aabb> boxes, const frustum& f, std::span<uint8_t> visible)
+{
+    return cull_chunks(boxes, f, visible);
+}
+w::task<void> w::math::cull_parallel(std::span<const bounding_sphere> spheres, const frustum& f, std::span<uint8_t> visible)
+{
+    return cull_chunks(spheres, f, visible);
+}
@@ -0,0 +1,345 @@
+#include <math/simd.h>
+
+// Single element kernels dispatched through simd.h.
+// Transform and quaternion to matrix gain nothing from 512 bit registers,
+// the AVX-512 table shares the AVX2 versions. Inverse and determinant are
+// bound by shuffles, every table uses the SSE4.1 versions.
+
+namespace {
+using w::math::matrix;
+using w::math::vector;
+
+template<int Index>
+__m128 splat(__m128 v) noexcept
+{
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(Index, Index, Index, Index));
+}
+
+// SSE4.1
+//-------------------------------------------------------------------------
+__m128 combine_rows_sse41(__m128 row, const matrix& b) noexcept
+{
+    __m128 result = _mm_mul_ps(splat<0>(row), b.r[0]);
+    result = _mm_add_ps(_mm_mul_ps(splat<1>(row), b.r[1]), result);
+    result = _mm_add_ps(_mm_mul_ps(splat<2>(row), b.r[2]), result);
+    return _mm_add_ps(_mm_mul_ps(splat<3>(row), b.r[3]), result);
+}
+
+matrix multiply_sse41(const matrix& a, const matrix& b) noexcept
+{
+    return {
+        combine_rows_sse41(a.r[0], b),
+        combine_rows_sse41(a.r[1], b),
+        combine_rows_sse41(a.r[2], b),
+        combine_rows_sse41(a.r[3], b)
+    };
+}
+
+matrix transpose_sse41(const matrix& a) noexcept
+{
+    __m128 r0 = a.r[0], r1 = a.r[1], r2 = a.r[2], r3 = a.r[3];
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    return { r0, r1, r2, r3 };
+}
+
+// starts with the last component, like the constexpr path
+template<size_t Components>
+vector transform_sse41(const matrix& m, vector v) noexcept
+{
+    constexpr int last = Components - 1;
+    __m128 result = _mm_mul_ps(splat<last>(v), m.r[last]);
+    if constexpr (Components < 4) {
+        result = _mm_add_ps(result, m.r[3]);
+    }
+    if constexpr (Components > 3) {
+        result = _mm_add_ps(_mm_mul_ps(splat<2>(v), m.r[2]), result);
+    }
+    if constexpr (Components > 2) {
+        result = _mm_add_ps(_mm_mul_ps(splat<1>(v), m.r[1]), result);
+    }
+    if constexpr (Components > 1) {
+        result = _mm_add_ps(_mm_mul_ps(splat<0>(v), m.r[0]), result);
+    }
+    return result;
+}
+
+matrix quaternion_to_matrix_sse41(vector q) noexcept
+{
+    using enum w::math::detail::swizzle_mask;
+    using w::math::detail::swizzle;
+    const __m128 onex3 = _mm_setr_ps(1, 1, 1, 0);
+    __m128 _2q = _mm_add_ps(q, q);
+    __m128 q2 = _mm_mul_ps(q, _2q); // 2 * q * q
+
+    __m128 v1 = _mm_shuffle_ps(q2, q2, swizzle(y, x, x, w)); // 2yy, 2xx, 2xx
+    __m128 v2 = _mm_shuffle_ps(q2, q2, swizzle(z, z, y, w)); // 2zz, 2zz, 2yy
+    __m128 sum1 = _mm_add_ps(v1, v2); // 2yy + 2zz, 2xx + 2zz, 2xx + 2yy
+    __m128 r1 = _mm_and_ps(w::math::neg_identity_mask[3], _mm_sub_ps(onex3, sum1)); // 1 - 2yy - 2zz, 1 - 2xx - 2zz, 1 - 2xx - 2yy, 0
+
+    v1 = _mm_shuffle_ps(q, q, swizzle(x, x, y, x));
+    v2 = _mm_shuffle_ps(_2q, _2q, swizzle(z, y, z, z));
+    __m128 r2 = _mm_mul_ps(v1, v2); // 2xz, 2xy, 2yz, 2xz
+
+    v1 = _mm_shuffle_ps(q, q, swizzle(w, w, w, w));
+    v2 = _mm_shuffle_ps(_2q, _2q, swizzle(y, z, x, y));
+    __m128 r3 = _mm_mul_ps(v1, v2); // 2yw, 2zw, 2xw, 2yw
+
+    __m128 r4 = _mm_addsub_ps(r2, r3); // 2xz - 2yw, 2xy + 2zw, 2yz - 2xw, 2xz + 2yw
+    r3 = _mm_xor_ps(r3, _mm_set1_ps(-0.0f));
+    __m128 r5 = _mm_addsub_ps(r2, r3); // 2xz + 2yw, 2xy - 2zw, 2yz + 2xw, 2xz - 2yw
+
+    v1 = _mm_shuffle_ps(r1, r4, swizzle(x, w, y, x));
+    v2 = _mm_shuffle_ps(r1, r5, swizzle(y, w, z, y));
+    r1 = _mm_shuffle_ps(r1, r4, swizzle(z, w, w, z));
+
+    return matrix(
+            _mm_shuffle_ps(v1, v1, swizzle(x, z, w, y)),
+            _mm_shuffle_ps(v2, v2, swizzle(w, x, z, y)),
+            _mm_shuffle_ps(r1, r1, swizzle(z, w, x, y)),
+            w::math::identity[3]);
+}
+
+// inverse by 2x2 blocks, M = | A B |, each block is stored row major in one register
+//                            | C D |
+// a# is the adjugate of a, for 2x2 blocks |a| a^-1
+template<int X, int Y, int Z, int W>
+__m128 shuffle(__m128 a, __m128 b) noexcept
+{
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+}
+// a * b
+__m128 mat2_mul(__m128 a, __m128 b) noexcept
+{
+    return _mm_add_ps(_mm_mul_ps(a, shuffle<0, 3, 0, 3>(b, b)), _mm_mul_ps(shuffle<1, 0, 3, 2>(a, a), shuffle<2, 1, 2, 1>(b, b)));
+}
+// a# * b
+__m128 mat2_adj_mul(__m128 a, __m128 b) noexcept
+{
+    return _mm_sub_ps(_mm_mul_ps(shuffle<3, 3, 0, 0>(a, a), b), _mm_mul_ps(shuffle<1, 1, 2, 2>(a, a), shuffle<2, 3, 0, 1>(b, b)));
+}
+// a * b#
+__m128 mat2_mul_adj(__m128 a, __m128 b) noexcept
+{
+    return _mm_sub_ps(_mm_mul_ps(a, shuffle<3, 0, 3, 0>(b, b)), _mm_mul_ps(shuffle<1, 0, 3, 2>(a, a), shuffle<2, 1, 2, 1>(b, b)));
+}
+
+struct blocks {
+    __m128 a, b, c, d;
+    __m128 dets; // |A| |B| |C| |D|
+    __m128 a_b; // A# * B
+    __m128 d_c; // D# * C
+    __m128 det; // |M| in all lanes
+};
+blocks block_determinant(const matrix& m) noexcept
+{
+    blocks r;
+    r.a = _mm_movelh_ps(m.r[0], m.r[1]);
+    r.b = _mm_movehl_ps(m.r[1], m.r[0]);
+    r.c = _mm_movelh_ps(m.r[2], m.r[3]);
+    r.d = _mm_movehl_ps(m.r[3], m.r[2]);
+    r.dets = _mm_sub_ps(_mm_mul_ps(shuffle<0, 2, 0, 2>(m.r[0], m.r[2]), shuffle<1, 3, 1, 3>(m.r[1], m.r[3])),
+                        _mm_mul_ps(shuffle<1, 3, 1, 3>(m.r[0], m.r[2]), shuffle<0, 2, 0, 2>(m.r[1], m.r[3])));
+    r.a_b = mat2_adj_mul(r.a, r.b);
+    r.d_c = mat2_adj_mul(r.d, r.c);
+
+    // |M| = |A| |D| + |B| |C| - tr((A# B) (D# C))
+    __m128 trace = _mm_mul_ps(r.a_b, shuffle<0, 2, 1, 3>(r.d_c, r.d_c));
+    trace = _mm_hadd_ps(trace, trace);
+    trace = _mm_hadd_ps(trace, trace);
+    __m128 det = _mm_add_ps(_mm_mul_ps(splat<0>(r.dets), splat<3>(r.dets)), _mm_mul_ps(splat<1>(r.dets), splat<2>(r.dets)));
+    r.det = _mm_sub_ps(det, trace);
+    return r;
+}
+
+vector determinant_sse41(const matrix& m) noexcept
+{
+    return block_determinant(m).det;
+}
+
+matrix inverse_sse41(const matrix& m, vector* det) noexcept
+{
+    blocks k = block_determinant(m);
+    if (det) {
+        *det = k.det;
+    }
+
+    // M^-1 = 1 / |M| * | X Y |, with X# = |D| A - B (D# C), Y# = |B| C - D (A# B)#
+    //                  | Z W |       Z# = |C| B - A (D# C)#, W# = |A| D - C (A# B)
+    __m128 x = _mm_sub_ps(_mm_mul_ps(splat<3>(k.dets), k.a), mat2_mul(k.b, k.d_c));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(splat<1>(k.dets), k.c), mat2_mul_adj(k.d, k.a_b));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(splat<2>(k.dets), k.b), mat2_mul_adj(k.a, k.d_c));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(splat<0>(k.dets), k.d), mat2_mul(k.c, k.a_b));
+
+    // the signs of the adjugate, the shuffles below undo it and place the blocks
+    __m128 rdet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), k.det);
+    x = _mm_mul_ps(x, rdet);
+    y = _mm_mul_ps(y, rdet);
+    z = _mm_mul_ps(z, rdet);
+    w = _mm_mul_ps(w, rdet);
+    return {
+        shuffle<3, 1, 3, 1>(x, y),
+        shuffle<2, 0, 2, 0>(x, y),
+        shuffle<3, 1, 3, 1>(z, w),
+        shuffle<2, 0, 2, 0>(z, w)
+    };
+}
+
+// AVX2 and FMA3
+//-------------------------------------------------------------------------
+// a pair of a rows times b, the b rows are in both halves
+WTARGET_AVX2 __m256 combine_rows_avx2(__m256 rows, __m256 b0, __m256 b1, __m256 b2, __m256 b3) noexcept
+{
+    __m256 result = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+    result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(1, 1, 1, 1)), b1, result);
+    result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(2, 2, 2, 2)), b2, result);
+    return _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(3, 3, 3, 3)), b3, result);
+}
+
+WTARGET_AVX2 matrix multiply_avx2(const matrix& a, const matrix& b) noexcept
+{
+    __m256 t0 = _mm256_insertf128_ps(_mm256_castps128_ps256(a.r[0]), a.r[1], 1);
+    __m256 t1 = _mm256_insertf128_ps(_mm256_castps128_ps256(a.r[2]), a.r[3], 1);
+    __m256 b0 = _mm256_broadcast_ps(&b.r[0].data);
+    __m256 b1 = _mm256_broadcast_ps(&b.r[1].data);
+    __m256 b2 = _mm256_broadcast_ps(&b.r[2].data);
+    __m256 b3 = _mm256_broadcast_ps(&b.r[3].data);
+    t0 = combine_rows_avx2(t0, b0, b1, b2, b3);
+    t1 = combine_rows_avx2(t1, b0, b1, b2, b3);
+    return {
+        _mm256_castps256_ps128(t0),
+        _mm256_extractf128_ps(t0, 1),
+        _mm256_castps256_ps128(t1),
+        _mm256_extractf128_ps(t1, 1)
+    };
+}
+
+WTARGET_AVX2 matrix transpose_avx2(const matrix& a) noexcept
+{
+    __m256 t0 = _mm256_insertf128_ps(_mm256_castps128_ps256(a.r[0]), a.r[1], 1);
+    __m256 t1 = _mm256_insertf128_ps(_mm256_castps128_ps256(a.r[2]), a.r[3], 1);
+
+    __m256 lo = _mm256_unpacklo_ps(t0, t1);
+    __m256 hi = _mm256_unpackhi_ps(t0, t1);
+    __m256 u0 = _mm256_permute2f128_ps(lo, hi, 0x20);
+    __m256 u1 = _mm256_permute2f128_ps(lo, hi, 0x31);
+    lo = _mm256_unpacklo_ps(u0, u1);
+    hi = _mm256_unpackhi_ps(u0, u1);
+    t0 = _mm256_permute2f128_ps(lo, hi, 0x20);
+    t1 = _mm256_permute2f128_ps(lo, hi, 0x31);
+
+    return {
+        _mm256_castps256_ps128(t0),
+        _mm256_extractf128_ps(t0, 1),
+        _mm256_castps256_ps128(t1),
+        _mm256_extractf128_ps(t1, 1)
+    };
+}
+
+template<size_t Components>
+WTARGET_AVX2 vector transform_avx2(const matrix& m, vector v) noexcept
+{
+    constexpr int last = Components - 1;
+    __m128 result;
+    if constexpr (Components < 4) {
+        result = _mm_fmadd_ps(splat<last>(v), m.r[last], m.r[3]);
+    } else {
+        result = _mm_mul_ps(splat<last>(v), m.r[last]);
+    }
+    if constexpr (Components > 3) {
+        result = _mm_fmadd_ps(splat<2>(v), m.r[2], result);
+    }
+    if constexpr (Components > 2) {
+        result = _mm_fmadd_ps(splat<1>(v), m.r[1], result);
+    }
+    if constexpr (Components > 1) {
+        result = _mm_fmadd_ps(splat<0>(v), m.r[0], result);
+    }
+    return result;
+}
+
+// the same as the SSE4.1 version, the add/subtract pairs become FMAs with sign flipped factors
+WTARGET_AVX2 matrix quaternion_to_matrix_avx2(vector q) noexcept
+{
+    using enum w::math::detail::swizzle_mask;
+    using w::math::detail::swizzle;
+    const __m128 onex3 = _mm_setr_ps(1, 1, 1, 0);
+    const __m128 negate_even = _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+    const __m128 negate_odd = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+    __m128 _2q = _mm_add_ps(q, q);
+    __m128 q2 = _mm_mul_ps(q, _2q);
+
+    __m128 v1 = _mm_shuffle_ps(q2, q2, swizzle(y, x, x, w));
+    __m128 v2 = _mm_shuffle_ps(q2, q2, swizzle(z, z, y, w));
+    __m128 r1 = _mm_and_ps(w::math::neg_identity_mask[3], _mm_sub_ps(onex3, _mm_add_ps(v1, v2)));
+
+    v1 = _mm_shuffle_ps(q, q, swizzle(x, x, y, x));
+    v2 = _mm_shuffle_ps(_2q, _2q, swizzle(z, y, z, z));
+    __m128 r2 = _mm_mul_ps(v1, v2); // 2xz, 2xy, 2yz, 2xz
+
+    __m128 qw = _mm_shuffle_ps(q, q, swizzle(w, w, w, w));
+    __m128 r3 = _mm_shuffle_ps(_2q, _2q, swizzle(y, z, x, y)); // times w: 2yw, 2zw, 2xw, 2yw
+    __m128 r4 = _mm_fmadd_ps(qw, _mm_xor_ps(r3, negate_even), r2); // 2xz - 2yw, 2xy + 2zw, 2yz - 2xw, 2xz + 2yw
+    __m128 r5 = _mm_fmadd_ps(qw, _mm_xor_ps(r3, negate_odd), r2); // 2xz + 2yw, 2xy - 2zw, 2yz + 2xw, 2xz - 2yw
+
+    v1 = _mm_shuffle_ps(r1, r4, swizzle(x, w, y, x));
+    v2 = _mm_shuffle_ps(r1, r5, swizzle(y, w, z, y));
+    r1 = _mm_shuffle_ps(r1, r4, swizzle(z, w, w, z));
+
+    return matrix(
+            _mm_shuffle_ps(v1, v1, swizzle(x, z, w, y)),
+            _mm_shuffle_ps(v2, v2, swizzle(w, x, z, y)),
+            _mm_shuffle_ps(r1, r1, swizzle(z, w, x, y)),
+            w::math::identity[3]);
+}
+
+// AVX-512, the whole matrix in one register
+//-------------------------------------------------------------------------
+WTARGET_AVX512 matrix store_matrix(__m512 rows) noexcept
+{
+    matrix result;
+    _mm512_storeu_ps(&result.r[0].data, rows);
+    return result;
+}
+
+WTARGET_AVX512 matrix multiply_avx512(const matrix& a, const matrix& b) noexcept
+{
+    __m512 rows = _mm512_loadu_ps(&a.r[0].data);
+    __m512 result = _mm512_mul_ps(_mm512_permute_ps(rows, 0x00), _mm512_broadcast_f32x4(b.r[0]));
+    result = _mm512_fmadd_ps(_mm512_permute_ps(rows, 0x55), _mm512_broadcast_f32x4(b.r[1]), result);
+    result = _mm512_fmadd_ps(_mm512_permute_ps(rows, 0xaa), _mm512_broadcast_f32x4(b.r[2]), result);
+    result = _mm512_fmadd_ps(_mm512_permute_ps(rows, 0xff), _mm512_broadcast_f32x4(b.r[3]), result);
+    return store_matrix(result);
+}
+
+WTARGET_AVX512 matrix transpose_avx512(const matrix& a) noexcept
+{
+    const __m512i columns = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    return store_matrix(_mm512_permutexvar_ps(columns, _mm512_loadu_ps(&a.r[0].data)));
+}
+
+} // namespace
+
+constexpr w::math::detail::simd_kernels w::math::detail::sse41_kernels{
+    multiply_sse41,
+    transpose_sse41,
+    { transform_sse41<1>, transform_sse41<2>, transform_sse41<3>, transform_sse41<4> },
+    quaternion_to_matrix_sse41,
+    inverse_sse41,
+    determinant_sse41
+};
+constexpr w::math::detail::simd_kernels w::math::detail::avx2_kernels{
+    multiply_avx2,
+    transpose_avx2,
+    { transform_avx2<1>, transform_avx2<2>, transform_avx2<3>, transform_avx2<4> },
+    quaternion_to_matrix_avx2,
+    inverse_sse41,
+    determinant_sse41
+};
+constexpr w::math::detail::simd_kernels w::math::detail::avx512_kernels{
+    multiply_avx512,
+    transpose_avx512,
+    { transform_avx2<1>, transform_avx2<2>, transform_avx2<3>, transform_avx2<4> },
+    quaternion_to_matrix_avx2,
+    inverse_sse41,
+    determinant_sse41
+};
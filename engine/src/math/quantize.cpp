@@ -0,0 +1,506 @@
+#include <math/quantize.h>
+#include <math/simd.h>
+#include <algorithm>
+#include <bit>
+#include <concepts>
+
+namespace {
+using w::math::float3;
+using w::math::float4;
+using w::math::half3;
+using w::math::packed_position;
+using w::math::packed_quat32;
+using w::math::packed_quat48;
+using w::math::position_cell;
+
+static_assert(sizeof(float3) == 3 * sizeof(float), "the kernels treat float3 spans as flat float arrays");
+static_assert(sizeof(float4) == 4 * sizeof(float), "the kernels load one quaternion per 128 bits");
+static_assert(sizeof(half3) == 6 && sizeof(packed_position) == 6 && sizeof(packed_quat48) == 6, "the kernels treat packed spans as flat arrays");
+
+// code = v * scale + offset, v = code * step - 1 / sqrt2
+template<uint32_t Bits>
+struct smallest_three {
+    static constexpr uint32_t mask = (1u << Bits) - 1;
+    static constexpr float max_code = float(mask);
+    static constexpr float scale = max_code / std::numbers::sqrt2_v<float>;
+    static constexpr float offset = max_code * 0.5f;
+    static constexpr float step = std::numbers::sqrt2_v<float> / max_code;
+    static constexpr float min_value = 1.0f / std::numbers::sqrt2_v<float>;
+};
+
+struct smallest_three_codes {
+    uint32_t largest;
+    uint32_t codes[3];
+};
+
+// the largest component, the first one on ties, is left out and made positive
+template<uint32_t Bits>
+smallest_three_codes encode(w::math::quaternion q) noexcept
+{
+    using format = smallest_three<Bits>;
+    float c[4] = { q[0], q[1], q[2], q[3] };
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i) {
+        if (std::abs(c[i]) > std::abs(c[largest])) {
+            largest = i;
+        }
+    }
+    float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+    smallest_three_codes result{ largest, {} };
+    for (uint32_t i = 0, k = 0; i < 4; ++i) {
+        if (i != largest) {
+            float code = c[i] * sign * format::scale + format::offset;
+            result.codes[k++] = uint32_t(std::lrint(std::clamp(code, 0.0f, format::max_code)));
+        }
+    }
+    return result;
+}
+
+template<uint32_t Bits>
+w::math::quaternion decode(const smallest_three_codes& codes) noexcept
+{
+    using format = smallest_three<Bits>;
+    float c[4];
+    float sum = 0.0f;
+    for (uint32_t i = 0, k = 0; i < 4; ++i) {
+        if (i != codes.largest) {
+            c[i] = float(codes.codes[k++]) * format::step - format::min_value;
+            sum += c[i] * c[i];
+        }
+    }
+    c[codes.largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return w::math::quaternion(w::math::vector(c[0], c[1], c[2], c[3]));
+}
+
+smallest_three_codes split(packed_quat32 q) noexcept
+{
+    return { q.bits >> 30, { (q.bits >> 20) & 1023, (q.bits >> 10) & 1023, q.bits & 1023 } };
+}
+smallest_three_codes split(packed_quat48 q) noexcept
+{
+    uint64_t bits = uint64_t(q.bits[0]) | uint64_t(q.bits[1]) << 16 | uint64_t(q.bits[2]) << 32;
+    constexpr uint64_t mask = smallest_three<15>::mask;
+    return { uint32_t(bits >> 45), { uint32_t((bits >> 30) & mask), uint32_t((bits >> 15) & mask), uint32_t(bits & mask) } };
+}
+
+// the offsets of a packed position in steps of the cell, clamped to the cube
+float cell_scale(const position_cell& cell) noexcept
+{
+    return 32767.0f / cell.extent;
+}
+int16_t pack_offset(float position, float origin, float scale) noexcept
+{
+    return int16_t(std::lrint(std::clamp((position - origin) * scale, -32767.0f, 32767.0f)));
+}
+
+// Scalar, from the element first on
+//-------------------------------------------------------------------------
+template<typename Packed>
+void pack_quat_scalar(std::span<const float4> rotations, std::span<Packed> out, size_t first) noexcept
+{
+    for (size_t i = first; i < out.size(); ++i) {
+        if constexpr (std::same_as<Packed, packed_quat32>) {
+            out[i] = w::math::pack32(w::math::quaternion(rotations[i]));
+        } else {
+            out[i] = w::math::pack48(w::math::quaternion(rotations[i]));
+        }
+    }
+}
+template<typename Packed>
+void unpack_quat_scalar(std::span<const Packed> rotations, std::span<float4> out, size_t first) noexcept
+{
+    for (size_t i = first; i < out.size(); ++i) {
+        out[i] = w::math::unpack(rotations[i]);
+    }
+}
+
+// flat arrays of floats and halves
+void pack_half_scalar(const float* in, uint16_t* out, size_t first, size_t count) noexcept
+{
+    for (size_t i = first; i < count; ++i) {
+        out[i] = w::math::to_half(in[i]);
+    }
+}
+void unpack_half_scalar(const uint16_t* in, float* out, size_t first, size_t count) noexcept
+{
+    for (size_t i = first; i < count; ++i) {
+        out[i] = w::math::from_half(in[i]);
+    }
+}
+
+// flat arrays, component i % 3
+void pack_position_scalar(const float* in, const position_cell& cell, int16_t* out, size_t first, size_t count) noexcept
+{
+    float scale = cell_scale(cell);
+    for (size_t i = first; i < count; ++i) {
+        out[i] = pack_offset(in[i], cell.origin[i % 3], scale);
+    }
+}
+void unpack_position_scalar(const int16_t* in, const position_cell& cell, float* out, size_t first, size_t count) noexcept
+{
+    float step = cell.step();
+    for (size_t i = first; i < count; ++i) {
+        out[i] = cell.origin[i % 3] + float(in[i]) * step;
+    }
+}
+
+// AVX2, 8 elements per iteration
+//-------------------------------------------------------------------------
+struct quat_lanes {
+    __m256 c[4]; // x y z w of 8 quaternions
+};
+
+// quaternions i and i + 4 share a register, the transpose keeps the order
+WTARGET_AVX2 quat_lanes load_quats(const float4* q) noexcept
+{
+    auto* base = reinterpret_cast<const float*>(q);
+    __m256 s0 = _mm256_loadu2_m128(base + 16, base);
+    __m256 s1 = _mm256_loadu2_m128(base + 20, base + 4);
+    __m256 s2 = _mm256_loadu2_m128(base + 24, base + 8);
+    __m256 s3 = _mm256_loadu2_m128(base + 28, base + 12);
+    __m256 t0 = _mm256_unpacklo_ps(s0, s1);
+    __m256 t1 = _mm256_unpacklo_ps(s2, s3);
+    __m256 t2 = _mm256_unpackhi_ps(s0, s1);
+    __m256 t3 = _mm256_unpackhi_ps(s2, s3);
+    return { {
+            _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)),
+            _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)),
+            _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+            _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+    } };
+}
+WTARGET_AVX2 void store_quats(const quat_lanes& q, float4* out) noexcept
+{
+    auto* base = reinterpret_cast<float*>(out);
+    __m256 t0 = _mm256_unpacklo_ps(q.c[0], q.c[1]);
+    __m256 t1 = _mm256_unpackhi_ps(q.c[0], q.c[1]);
+    __m256 t2 = _mm256_unpacklo_ps(q.c[2], q.c[3]);
+    __m256 t3 = _mm256_unpackhi_ps(q.c[2], q.c[3]);
+    _mm256_storeu2_m128(base + 16, base, _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)));
+    _mm256_storeu2_m128(base + 20, base + 4, _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)));
+    _mm256_storeu2_m128(base + 24, base + 8, _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)));
+    _mm256_storeu2_m128(base + 28, base + 12, _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)));
+}
+
+struct code_lanes {
+    __m256i largest;
+    __m256i codes[3];
+};
+
+template<uint32_t Bits>
+WTARGET_AVX2 code_lanes encode_avx2(const float4* in) noexcept
+{
+    using format = smallest_three<Bits>;
+    quat_lanes q = load_quats(in);
+    __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    __m256 largest_abs = _mm256_and_ps(q.c[0], abs_mask);
+    __m256 largest_value = q.c[0];
+    __m256i largest = _mm256_setzero_si256();
+    for (int i = 1; i < 4; ++i) {
+        __m256 a = _mm256_and_ps(q.c[i], abs_mask);
+        __m256 greater = _mm256_cmp_ps(a, largest_abs, _CMP_GT_OQ);
+        largest_abs = _mm256_blendv_ps(largest_abs, a, greater);
+        largest_value = _mm256_blendv_ps(largest_value, q.c[i], greater);
+        largest = _mm256_blendv_epi8(largest, _mm256_set1_epi32(i), _mm256_castps_si256(greater));
+    }
+
+    // the others in order, x or y, y or z, z or w
+    __m256 first = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_setzero_si256()));
+    __m256 below_2 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(2), largest));
+    __m256 below_3 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(3), largest));
+    __m256 others[3] = {
+        _mm256_blendv_ps(q.c[0], q.c[1], first),
+        _mm256_blendv_ps(q.c[1], q.c[2], below_2),
+        _mm256_blendv_ps(q.c[2], q.c[3], below_3),
+    };
+
+    __m256 sign = _mm256_andnot_ps(abs_mask, largest_value);
+    code_lanes result{ largest, {} };
+    for (int k = 0; k < 3; ++k) {
+        __m256 code = _mm256_fmadd_ps(_mm256_xor_ps(others[k], sign), _mm256_set1_ps(format::scale), _mm256_set1_ps(format::offset));
+        code = _mm256_min_ps(_mm256_max_ps(code, _mm256_setzero_ps()), _mm256_set1_ps(format::max_code));
+        result.codes[k] = _mm256_cvtps_epi32(code);
+    }
+    return result;
+}
+
+template<uint32_t Bits>
+WTARGET_AVX2 void decode_avx2(const code_lanes& codes, float4* out) noexcept
+{
+    using format = smallest_three<Bits>;
+    __m256 v[3];
+    __m256 sum = _mm256_setzero_ps();
+    for (int k = 0; k < 3; ++k) {
+        v[k] = _mm256_fmsub_ps(_mm256_cvtepi32_ps(codes.codes[k]), _mm256_set1_ps(format::step), _mm256_set1_ps(format::min_value));
+        sum = _mm256_fmadd_ps(v[k], v[k], sum);
+    }
+    __m256 rebuilt = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), sum), _mm256_setzero_ps()));
+
+    __m256 is[4];
+    for (int i = 0; i < 4; ++i) {
+        is[i] = _mm256_castsi256_ps(_mm256_cmpeq_epi32(codes.largest, _mm256_set1_epi32(i)));
+    }
+    __m256 below_2 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(2), codes.largest));
+    quat_lanes q{ {
+            _mm256_blendv_ps(v[0], rebuilt, is[0]),
+            _mm256_blendv_ps(_mm256_blendv_ps(v[1], rebuilt, is[1]), v[0], is[0]),
+            _mm256_blendv_ps(_mm256_blendv_ps(v[2], rebuilt, is[2]), v[1], below_2),
+            _mm256_blendv_ps(v[2], rebuilt, is[3]),
+    } };
+    store_quats(q, out);
+}
+
+WTARGET_AVX2 void pack_avx2(std::span<const float4> rotations, std::span<packed_quat32> out) noexcept
+{
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        code_lanes c = encode_avx2<10>(rotations.data() + i);
+        __m256i bits = _mm256_or_si256(_mm256_slli_epi32(c.largest, 30), _mm256_slli_epi32(c.codes[0], 20));
+        bits = _mm256_or_si256(bits, _mm256_or_si256(_mm256_slli_epi32(c.codes[1], 10), c.codes[2]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.data() + i), bits);
+    }
+    pack_quat_scalar(rotations, out, i);
+}
+
+// 6 bytes per element, the 16 byte stores overlap the next ones and write 4 bytes past the 8 elements,
+// so the last 8 elements are left to the scalar loop
+WTARGET_AVX2 void pack_avx2(std::span<const float4> rotations, std::span<packed_quat48> out) noexcept
+{
+    const __m256i compact = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1,
+            0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 9 <= out.size(); i += 8) {
+        code_lanes c = encode_avx2<15>(rotations.data() + i);
+        // bits 0 to 31 and 32 to 47 of largest << 45 | a << 30 | b << 15 | c
+        __m256i low = _mm256_or_si256(_mm256_or_si256(c.codes[2], _mm256_slli_epi32(c.codes[1], 15)), _mm256_slli_epi32(c.codes[0], 30));
+        __m256i high = _mm256_or_si256(_mm256_srli_epi32(c.codes[0], 2), _mm256_slli_epi32(c.largest, 13));
+        __m256i even = _mm256_shuffle_epi8(_mm256_unpacklo_epi32(low, high), compact); // elements 0 1 | 4 5
+        __m256i odd = _mm256_shuffle_epi8(_mm256_unpackhi_epi32(low, high), compact); // elements 2 3 | 6 7
+        auto* bytes = reinterpret_cast<uint8_t*>(out.data() + i);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), _mm256_castsi256_si128(even));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + 12), _mm256_castsi256_si128(odd));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + 24), _mm256_extracti128_si256(even, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + 36), _mm256_extracti128_si256(odd, 1));
+    }
+    pack_quat_scalar(rotations, out, i);
+}
+
+WTARGET_AVX2 void unpack_avx2(std::span<const packed_quat32> rotations, std::span<float4> out) noexcept
+{
+    const __m256i mask = _mm256_set1_epi32(1023);
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rotations.data() + i));
+        code_lanes c{ _mm256_srli_epi32(bits, 30), {
+                _mm256_and_si256(_mm256_srli_epi32(bits, 20), mask),
+                _mm256_and_si256(_mm256_srli_epi32(bits, 10), mask),
+                _mm256_and_si256(bits, mask),
+        } };
+        decode_avx2<10>(c, out.data() + i);
+    }
+    unpack_quat_scalar(rotations, out, i);
+}
+
+// the gathers read 2 bytes past the 8 elements, the last 8 are left to the scalar loop
+WTARGET_AVX2 void unpack_avx2(std::span<const packed_quat48> rotations, std::span<float4> out) noexcept
+{
+    const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    const __m256i mask = _mm256_set1_epi32(smallest_three<15>::mask);
+    size_t i = 0;
+    for (; i + 9 <= out.size(); i += 8) {
+        auto* bytes = reinterpret_cast<const int*>(rotations.data() + i);
+        __m256i low = _mm256_i32gather_epi32(bytes, offsets, 1);
+        __m256i high = _mm256_and_si256(_mm256_i32gather_epi32(bytes + 1, offsets, 1), _mm256_set1_epi32(0xffff));
+        code_lanes c{ _mm256_srli_epi32(high, 13), {
+                _mm256_or_si256(_mm256_srli_epi32(low, 30), _mm256_slli_epi32(_mm256_and_si256(high, _mm256_set1_epi32(0x1fff)), 2)),
+                _mm256_and_si256(_mm256_srli_epi32(low, 15), mask),
+                _mm256_and_si256(low, mask),
+        } };
+        decode_avx2<15>(c, out.data() + i);
+    }
+    unpack_quat_scalar(rotations, out, i);
+}
+
+WTARGET_AVX2 void pack_half_avx2(const float* in, uint16_t* out, size_t count) noexcept
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+    pack_half_scalar(in, out, i, count);
+}
+WTARGET_AVX2 void unpack_half_avx2(const uint16_t* in, float* out, size_t count) noexcept
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+    }
+    unpack_half_scalar(in, out, i, count);
+}
+
+// the origin for 8 flat components starting at component 0, 1 or 2
+WTARGET_AVX2 void origin_phases(const position_cell& cell, __m256 (&phases)[3]) noexcept
+{
+    for (size_t phase = 0; phase < 3; ++phase) {
+        alignas(32) float lanes[8];
+        for (size_t l = 0; l < 8; ++l) {
+            lanes[l] = cell.origin[(phase + l) % 3];
+        }
+        phases[phase] = _mm256_load_ps(lanes);
+    }
+}
+
+WTARGET_AVX2 void pack_position_avx2(const float* in, const position_cell& cell, int16_t* out, size_t count) noexcept
+{
+    __m256 origins[3];
+    origin_phases(cell, origins);
+    __m256 scale = _mm256_set1_ps(cell_scale(cell));
+    __m256 limit = _mm256_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 offset = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(in + i), origins[i % 3]), scale);
+        offset = _mm256_min_ps(_mm256_max_ps(offset, _mm256_sub_ps(_mm256_setzero_ps(), limit)), limit);
+        __m256i codes = _mm256_cvtps_epi32(offset);
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(codes), _mm256_extracti128_si256(codes, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    pack_position_scalar(in, cell, out, i, count);
+}
+WTARGET_AVX2 void unpack_position_avx2(const int16_t* in, const position_cell& cell, float* out, size_t count) noexcept
+{
+    __m256 origins[3];
+    origin_phases(cell, origins);
+    __m256 step = _mm256_set1_ps(cell.step());
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i codes = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(codes), step, origins[i % 3]));
+    }
+    unpack_position_scalar(in, cell, out, i, count);
+}
+
+// the AVX-512 level keeps the AVX2 kernels, the loops are bound by memory
+bool use_avx2() noexcept
+{
+    return w::math::active_simd_level() >= w::math::simd_level::avx2;
+}
+} // namespace
+
+uint16_t w::math::to_half(float value) noexcept
+{
+    uint32_t x = std::bit_cast<uint32_t>(value);
+    uint16_t sign = uint16_t((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+    if (x >= 0x47800000) { // 65536 and above, infinity and NaN, quiet NaN keeps the top of the payload
+        return sign | (x > 0x7f800000 ? uint16_t(0x7e00 | ((x >> 13) & 0x3ff)) : uint16_t(0x7c00));
+    }
+    if (x < 0x38800000) { // below the smallest normal half, the addition of 0.5 rounds to the denormal
+        float denormal = std::bit_cast<float>(x) + 0.5f;
+        return sign | uint16_t(std::bit_cast<uint32_t>(denormal) - 0x3f000000);
+    }
+    // rebias the exponent and round the mantissa to nearest even, a carry moves into the exponent
+    uint32_t odd = (x >> 13) & 1;
+    x += (uint32_t(15 - 127) << 23) + 0xfff + odd;
+    return sign | uint16_t(x >> 13);
+}
+
+float w::math::from_half(uint16_t bits) noexcept
+{
+    uint32_t sign = uint32_t(bits & 0x8000) << 16;
+    uint32_t x = uint32_t(bits & 0x7fff) << 13;
+    uint32_t exponent = x & 0x0f800000;
+    x += uint32_t(127 - 15) << 23;
+    if (exponent == 0x0f800000) { // infinity and NaN
+        x += uint32_t(128 - 16) << 23;
+    } else if (exponent == 0) { // denormal, renormalized by the float subtraction
+        x = std::bit_cast<uint32_t>(std::bit_cast<float>(x + (1u << 23)) - std::bit_cast<float>(113u << 23));
+    }
+    return std::bit_cast<float>(x | sign);
+}
+
+w::math::packed_quat32 w::math::pack32(quaternion q) noexcept
+{
+    auto c = encode<10>(q);
+    return { c.largest << 30 | c.codes[0] << 20 | c.codes[1] << 10 | c.codes[2] };
+}
+w::math::packed_quat48 w::math::pack48(quaternion q) noexcept
+{
+    auto c = encode<15>(q);
+    uint64_t bits = uint64_t(c.largest) << 45 | uint64_t(c.codes[0]) << 30 | uint64_t(c.codes[1]) << 15 | c.codes[2];
+    return { { uint16_t(bits), uint16_t(bits >> 16), uint16_t(bits >> 32) } };
+}
+w::math::quaternion w::math::unpack(packed_quat32 q) noexcept
+{
+    return decode<10>(split(q));
+}
+w::math::quaternion w::math::unpack(packed_quat48 q) noexcept
+{
+    return decode<15>(split(q));
+}
+
+w::math::half3 w::math::pack_half(vector v) noexcept
+{
+    return { { to_half(v[0]), to_half(v[1]), to_half(v[2]) } };
+}
+w::math::vector w::math::unpack(half3 v) noexcept
+{
+    return vector(from_half(v.bits[0]), from_half(v.bits[1]), from_half(v.bits[2]), 0.0f);
+}
+
+w::math::packed_position w::math::pack(vector position, const position_cell& cell) noexcept
+{
+    float scale = cell_scale(cell);
+    return { { pack_offset(position[0], cell.origin[0], scale), pack_offset(position[1], cell.origin[1], scale), pack_offset(position[2], cell.origin[2], scale) } };
+}
+w::math::vector w::math::unpack(packed_position position, const position_cell& cell) noexcept
+{
+    float step = cell.step();
+    return vector(cell.origin[0] + float(position.value[0]) * step,
+            cell.origin[1] + float(position.value[1]) * step,
+            cell.origin[2] + float(position.value[2]) * step,
+            0.0f);
+}
+
+void w::math::pack_batch(std::span<const float4> rotations, std::span<packed_quat32> out) noexcept
+{
+    use_avx2() ? pack_avx2(rotations, out) : pack_quat_scalar(rotations, out, 0);
+}
+void w::math::pack_batch(std::span<const float4> rotations, std::span<packed_quat48> out) noexcept
+{
+    use_avx2() ? pack_avx2(rotations, out) : pack_quat_scalar(rotations, out, 0);
+}
+void w::math::unpack_batch(std::span<const packed_quat32> rotations, std::span<float4> out) noexcept
+{
+    use_avx2() ? unpack_avx2(rotations, out) : unpack_quat_scalar(rotations, out, 0);
+}
+void w::math::unpack_batch(std::span<const packed_quat48> rotations, std::span<float4> out) noexcept
+{
+    use_avx2() ? unpack_avx2(rotations, out) : unpack_quat_scalar(rotations, out, 0);
+}
+
+void w::math::pack_batch(std::span<const float3> scales, std::span<half3> out) noexcept
+{
+    auto* in = reinterpret_cast<const float*>(scales.data());
+    auto* halves = reinterpret_cast<uint16_t*>(out.data());
+    use_avx2() ? pack_half_avx2(in, halves, out.size() * 3) : pack_half_scalar(in, halves, 0, out.size() * 3);
+}
+void w::math::unpack_batch(std::span<const half3> scales, std::span<float3> out) noexcept
+{
+    auto* halves = reinterpret_cast<const uint16_t*>(scales.data());
+    auto* floats = reinterpret_cast<float*>(out.data());
+    use_avx2() ? unpack_half_avx2(halves, floats, out.size() * 3) : unpack_half_scalar(halves, floats, 0, out.size() * 3);
+}
+
+void w::math::pack_batch(std::span<const float3> positions, const position_cell& cell, std::span<packed_position> out) noexcept
+{
+    auto* in = reinterpret_cast<const float*>(positions.data());
+    auto* codes = reinterpret_cast<int16_t*>(out.data());
+    use_avx2() ? pack_position_avx2(in, cell, codes, out.size() * 3) : pack_position_scalar(in, cell, codes, 0, out.size() * 3);
+}
+void w::math::unpack_batch(std::span<const packed_position> positions, const position_cell& cell, std::span<float3> out) noexcept
+{
+    auto* codes = reinterpret_cast<const int16_t*>(positions.data());
+    auto* floats = reinterpret_cast<float*>(out.data());
+    use_avx2() ? unpack_position_avx2(codes, cell, floats, out.size() * 3) : unpack_position_scalar(codes, cell, floats, 0, out.size() * 3);
+}
@@ -0,0 +1,107 @@
+#include <math/simd.h>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace {
+struct cpuid_registers {
+    uint32_t eax, ebx, ecx, edx;
+};
+
+cpuid_registers cpuid(uint32_t leaf, uint32_t subleaf) noexcept
+{
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, int(leaf), int(subleaf));
+    return { uint32_t(out[0]), uint32_t(out[1]), uint32_t(out[2]), uint32_t(out[3]) };
+#else
+    cpuid_registers out{};
+    __cpuid_count(leaf, subleaf, out.eax, out.ebx, out.ecx, out.edx);
+    return out;
+#endif
+}
+
+// register state the OS saves on context switches
+uint64_t enabled_xsave_state() noexcept
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t low, high;
+    __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return uint64_t(high) << 32 | low;
+#endif
+}
+
+bool bit(uint32_t value, int index) noexcept
+{
+    return (value >> index) & 1;
+}
+
+w::math::simd_level detect() noexcept
+{
+    using enum w::math::simd_level;
+    auto basic = cpuid(1, 0);
+    if (!bit(basic.ecx, 27) || !bit(basic.ecx, 28) || !bit(basic.ecx, 12) || !bit(basic.ecx, 29)) { // OSXSAVE, AVX, FMA, F16C
+        return sse41; // the baseline, required by the inline code
+    }
+    auto xsave = enabled_xsave_state();
+    auto extended = cpuid(0, 0).eax >= 7 ? cpuid(7, 0) : cpuid_registers{};
+    constexpr uint64_t avx_state = 0x6; // xmm and ymm
+    constexpr uint64_t avx512_state = 0xe6; // and opmask and both zmm halves
+    if ((xsave & avx_state) != avx_state || !bit(extended.ebx, 5)) {
+        return sse41;
+    }
+    if (bit(extended.ebx, 16) && (xsave & avx512_state) == avx512_state) {
+        return avx512;
+    }
+    return avx2;
+}
+
+const w::math::detail::simd_kernels& kernels_for(w::math::simd_level level) noexcept
+{
+    switch (level) {
+    case w::math::simd_level::avx512:
+        return w::math::detail::avx512_kernels;
+    case w::math::simd_level::avx2:
+        return w::math::detail::avx2_kernels;
+    default:
+        return w::math::detail::sse41_kernels;
+    }
+}
+} // namespace
+
+constinit std::atomic<const w::math::detail::simd_kernels*> w::math::detail::active_kernels{ &sse41_kernels };
+
+namespace {
+// switches to the supported level before main, earlier calls run the SSE4.1 kernels
+struct select_kernels {
+    select_kernels() noexcept
+    {
+        w::math::force_simd_level(w::math::supported_simd_level());
+    }
+} const kernels_selected;
+} // namespace
+
+w::math::simd_level w::math::supported_simd_level() noexcept
+{
+    static const simd_level level = detect();
+    return level;
+}
+
+w::math::simd_level w::math::active_simd_level() noexcept
+{
+    auto* active = detail::active_kernels.load(std::memory_order_relaxed);
+    return active == &detail::avx512_kernels ? simd_level::avx512
+            : active == &detail::avx2_kernels ? simd_level::avx2
+                                              : simd_level::sse41;
+}
+
+void w::math::force_simd_level(simd_level level) noexcept
+{
+    detail::active_kernels.store(&kernels_for(std::min(level, supported_simd_level())), std::memory_order_relaxed);
+}
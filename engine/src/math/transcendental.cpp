@@ -0,0 +1,286 @@
+#include <math/transcendental.h>
+#include <math/simd.h>
+#include <algorithm>
+
+namespace {
+using w::math::vector;
+namespace detail = w::math::detail;
+
+// AVX2, the functions of transcendental.h on 8 elements
+//-------------------------------------------------------------------------
+WTARGET_AVX2 __m256 set8(float x) noexcept
+{
+    return _mm256_set1_ps(x);
+}
+template<typename... C>
+WTARGET_AVX2 __m256 horner_avx2(__m256 x, float c0, C... c) noexcept
+{
+    __m256 result = _mm256_set1_ps(c0);
+    ((result = _mm256_fmadd_ps(result, x, _mm256_set1_ps(float(c)))), ...);
+    return result;
+}
+
+WTARGET_AVX2 __m256 reduce_half_pi_avx2(__m256 x, __m256i& q) noexcept
+{
+    __m256 qf = _mm256_round_ps(_mm256_mul_ps(x, set8(detail::two_over_pi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    q = _mm256_cvtps_epi32(qf);
+    __m256 r = _mm256_fnmadd_ps(qf, set8(detail::pi_2_hi), x);
+    r = _mm256_fnmadd_ps(qf, set8(detail::pi_2_mid), r);
+    return _mm256_fnmadd_ps(qf, set8(detail::pi_2_lo), r);
+}
+WTARGET_AVX2 __m256 sin_poly_avx2(__m256 r, __m256 z) noexcept
+{
+    return _mm256_fmadd_ps(_mm256_mul_ps(r, z), horner_avx2(z, -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f), r);
+}
+WTARGET_AVX2 __m256 cos_poly_avx2(__m256 z) noexcept
+{
+    __m256 c = _mm256_fmadd_ps(_mm256_mul_ps(z, z), horner_avx2(z, 2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f), set8(1.0f));
+    return _mm256_fmadd_ps(z, set8(-0.5f), c);
+}
+WTARGET_AVX2 __m256 quadrant_select_avx2(__m256 s, __m256 c, __m256i q) noexcept
+{
+    __m256 odd = _mm256_castsi256_ps(_mm256_slli_epi32(q, 31));
+    __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    return _mm256_xor_ps(_mm256_blendv_ps(s, c, odd), sign);
+}
+
+WTARGET_AVX2 __m256 sin_avx2(__m256 x) noexcept
+{
+    __m256i q;
+    __m256 r = reduce_half_pi_avx2(x, q);
+    __m256 z = _mm256_mul_ps(r, r);
+    return quadrant_select_avx2(sin_poly_avx2(r, z), cos_poly_avx2(z), q);
+}
+WTARGET_AVX2 __m256 cos_avx2(__m256 x) noexcept
+{
+    __m256i q;
+    __m256 r = reduce_half_pi_avx2(x, q);
+    __m256 z = _mm256_mul_ps(r, r);
+    return quadrant_select_avx2(sin_poly_avx2(r, z), cos_poly_avx2(z), _mm256_add_epi32(q, _mm256_set1_epi32(1)));
+}
+WTARGET_AVX2 void sincos_avx2(__m256 x, __m256& s, __m256& c) noexcept
+{
+    __m256i q;
+    __m256 r = reduce_half_pi_avx2(x, q);
+    __m256 z = _mm256_mul_ps(r, r);
+    __m256 sp = sin_poly_avx2(r, z);
+    __m256 cp = cos_poly_avx2(z);
+    s = quadrant_select_avx2(sp, cp, q);
+    c = quadrant_select_avx2(sp, cp, _mm256_add_epi32(q, _mm256_set1_epi32(1)));
+}
+
+WTARGET_AVX2 __m256 acos_avx2(__m256 x) noexcept
+{
+    __m256 sign = _mm256_and_ps(x, set8(-0.0f));
+    __m256 a = _mm256_andnot_ps(set8(-0.0f), x);
+
+    __m256 large = _mm256_cmp_ps(a, set8(0.5f), _CMP_GT_OQ);
+    __m256 z_large = _mm256_mul_ps(_mm256_sub_ps(set8(1.0f), a), set8(0.5f));
+    __m256 z = _mm256_blendv_ps(_mm256_mul_ps(a, a), z_large, large);
+    __m256 s = _mm256_blendv_ps(a, _mm256_sqrt_ps(z_large), large);
+    __m256 p = _mm256_fmadd_ps(_mm256_mul_ps(s, z), horner_avx2(z, 4.2163199048e-2f, 2.4181311049e-2f, 4.5470025998e-2f, 7.4953002686e-2f, 1.6666752422e-1f), s);
+
+    __m256 small_result = _mm256_sub_ps(set8(detail::half_pi), _mm256_or_ps(p, sign));
+    __m256 p2 = _mm256_add_ps(p, p);
+    __m256 large_result = _mm256_blendv_ps(p2, _mm256_sub_ps(set8(detail::pi), p2), sign);
+    return _mm256_blendv_ps(small_result, large_result, large);
+}
+
+WTARGET_AVX2 __m256 atan2_avx2(__m256 y, __m256 x) noexcept
+{
+    __m256 ax = _mm256_andnot_ps(set8(-0.0f), x);
+    __m256 ay = _mm256_andnot_ps(set8(-0.0f), y);
+
+    __m256 mx = _mm256_max_ps(ax, ay);
+    __m256 ratio = _mm256_and_ps(_mm256_div_ps(_mm256_min_ps(ax, ay), mx), _mm256_cmp_ps(mx, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+    __m256 shifted = _mm256_cmp_ps(ratio, set8(detail::tan_pi_8), _CMP_GT_OQ);
+    __m256 t = _mm256_blendv_ps(ratio, _mm256_div_ps(_mm256_sub_ps(ratio, set8(1.0f)), _mm256_add_ps(ratio, set8(1.0f))), shifted);
+    __m256 z = _mm256_mul_ps(t, t);
+    __m256 r = _mm256_fmadd_ps(_mm256_mul_ps(t, z), horner_avx2(z, 8.05374449538e-2f, -1.38776856032e-1f, 1.99777106478e-1f, -3.33329491539e-1f), t);
+    r = _mm256_add_ps(r, _mm256_and_ps(set8(detail::quarter_pi), shifted));
+
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(set8(detail::half_pi), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(set8(detail::pi), r), x);
+    return _mm256_or_ps(r, _mm256_and_ps(y, set8(-0.0f)));
+}
+
+WTARGET_AVX2 __m256 exp_avx2(__m256 x) noexcept
+{
+    x = _mm256_max_ps(set8(detail::exp_min), _mm256_min_ps(set8(detail::exp_max), x));
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, set8(detail::log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, set8(detail::ln2_hi), x);
+    r = _mm256_fnmadd_ps(n, set8(detail::ln2_lo), r);
+
+    __m256 p = horner_avx2(r, 1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f);
+    p = _mm256_add_ps(_mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r), set8(1.0f));
+
+    __m256i ni = _mm256_cvtps_epi32(n);
+    __m256i n1 = _mm256_srai_epi32(ni, 1);
+    __m256i n2 = _mm256_sub_epi32(ni, n1);
+    __m256 s1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, _mm256_set1_epi32(127)), 23));
+    __m256 s2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n2, _mm256_set1_epi32(127)), 23));
+    return _mm256_mul_ps(_mm256_mul_ps(p, s1), s2);
+}
+
+WTARGET_AVX2 __m256 log_avx2(__m256 x) noexcept
+{
+    __m256 denormal = _mm256_cmp_ps(x, set8(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+    __m256 scaled = _mm256_blendv_ps(x, _mm256_mul_ps(x, set8(8388608.0f)), denormal);
+    __m256i bits = _mm256_castps_si256(scaled);
+
+    __m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126));
+    __m256 e = _mm256_sub_ps(_mm256_cvtepi32_ps(exponent), _mm256_and_ps(set8(23.0f), denormal));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+    __m256 small = _mm256_cmp_ps(m, set8(detail::sqrt_half), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(set8(1.0f), small));
+    m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(m, small)), set8(1.0f));
+
+    __m256 z = _mm256_mul_ps(m, m);
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(m, z), horner_avx2(m, 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f));
+    y = _mm256_fmadd_ps(e, set8(detail::ln2_lo), y);
+    y = _mm256_fmadd_ps(z, set8(-0.5f), y);
+    __m256 result = _mm256_fmadd_ps(e, set8(detail::ln2_hi), _mm256_add_ps(m, y));
+
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+    result = _mm256_blendv_ps(result, set8(-infinity), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+    result = _mm256_blendv_ps(result, x, _mm256_cmp_ps(x, set8(infinity), _CMP_EQ_OQ));
+    return _mm256_or_ps(result, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_NGE_UQ));
+}
+
+// span loops, the tail goes through a zero padded register
+template<__m256 (*F)(__m256)>
+WTARGET_AVX2 void apply_avx2(std::span<const float> in, std::span<float> out) noexcept
+{
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        _mm256_storeu_ps(out.data() + i, F(_mm256_loadu_ps(in.data() + i)));
+    }
+    if (i < out.size()) {
+        alignas(32) float buffer[8]{};
+        std::copy(in.begin() + i, in.begin() + out.size(), buffer);
+        _mm256_store_ps(buffer, F(_mm256_load_ps(buffer)));
+        std::copy(buffer, buffer + (out.size() - i), out.begin() + i);
+    }
+}
+WTARGET_AVX2 void sincos_avx2(std::span<const float> in, std::span<float> sin_out, std::span<float> cos_out) noexcept
+{
+    size_t size = sin_out.size();
+    size_t i = 0;
+    __m256 s, c;
+    for (; i + 8 <= size; i += 8) {
+        sincos_avx2(_mm256_loadu_ps(in.data() + i), s, c);
+        _mm256_storeu_ps(sin_out.data() + i, s);
+        _mm256_storeu_ps(cos_out.data() + i, c);
+    }
+    if (i < size) {
+        alignas(32) float buffer[8]{};
+        std::copy(in.begin() + i, in.begin() + size, buffer);
+        sincos_avx2(_mm256_load_ps(buffer), s, c);
+        _mm256_store_ps(buffer, s);
+        std::copy(buffer, buffer + (size - i), sin_out.begin() + i);
+        _mm256_store_ps(buffer, c);
+        std::copy(buffer, buffer + (size - i), cos_out.begin() + i);
+    }
+}
+WTARGET_AVX2 void atan2_avx2(std::span<const float> y, std::span<const float> x, std::span<float> out) noexcept
+{
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        _mm256_storeu_ps(out.data() + i, atan2_avx2(_mm256_loadu_ps(y.data() + i), _mm256_loadu_ps(x.data() + i)));
+    }
+    if (i < out.size()) {
+        alignas(32) float y_buffer[8]{};
+        alignas(32) float x_buffer[8]{};
+        std::copy(y.begin() + i, y.begin() + out.size(), y_buffer);
+        std::copy(x.begin() + i, x.begin() + out.size(), x_buffer);
+        _mm256_store_ps(y_buffer, atan2_avx2(_mm256_load_ps(y_buffer), _mm256_load_ps(x_buffer)));
+        std::copy(y_buffer, y_buffer + (out.size() - i), out.begin() + i);
+    }
+}
+
+// SSE4.1, the inline functions 4 elements at a time
+//-------------------------------------------------------------------------
+template<vector (*F)(vector)>
+void apply_sse41(std::span<const float> in, std::span<float> out) noexcept
+{
+    size_t i = 0;
+    for (; i + 4 <= out.size(); i += 4) {
+        _mm_storeu_ps(out.data() + i, F(_mm_loadu_ps(in.data() + i)));
+    }
+    if (i < out.size()) {
+        alignas(16) float buffer[4]{};
+        std::copy(in.begin() + i, in.begin() + out.size(), buffer);
+        _mm_store_ps(buffer, F(_mm_load_ps(buffer)));
+        std::copy(buffer, buffer + (out.size() - i), out.begin() + i);
+    }
+}
+void sincos_sse41(std::span<const float> in, std::span<float> sin_out, std::span<float> cos_out) noexcept
+{
+    size_t size = sin_out.size();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        auto [s, c] = w::math::sincos(_mm_loadu_ps(in.data() + i));
+        _mm_storeu_ps(sin_out.data() + i, s);
+        _mm_storeu_ps(cos_out.data() + i, c);
+    }
+    if (i < size) {
+        alignas(16) float buffer[4]{};
+        std::copy(in.begin() + i, in.begin() + size, buffer);
+        auto [s, c] = w::math::sincos(_mm_load_ps(buffer));
+        _mm_store_ps(buffer, s);
+        std::copy(buffer, buffer + (size - i), sin_out.begin() + i);
+        _mm_store_ps(buffer, c);
+        std::copy(buffer, buffer + (size - i), cos_out.begin() + i);
+    }
+}
+void atan2_sse41(std::span<const float> y, std::span<const float> x, std::span<float> out) noexcept
+{
+    size_t i = 0;
+    for (; i + 4 <= out.size(); i += 4) {
+        _mm_storeu_ps(out.data() + i, w::math::atan2(_mm_loadu_ps(y.data() + i), _mm_loadu_ps(x.data() + i)));
+    }
+    if (i < out.size()) {
+        alignas(16) float y_buffer[4]{};
+        alignas(16) float x_buffer[4]{};
+        std::copy(y.begin() + i, y.begin() + out.size(), y_buffer);
+        std::copy(x.begin() + i, x.begin() + out.size(), x_buffer);
+        _mm_store_ps(y_buffer, w::math::atan2(_mm_load_ps(y_buffer), _mm_load_ps(x_buffer)));
+        std::copy(y_buffer, y_buffer + (out.size() - i), out.begin() + i);
+    }
+}
+
+// the AVX-512 level keeps the AVX2 kernels, the polynomials are latency bound
+bool use_avx2() noexcept
+{
+    return w::math::active_simd_level() >= w::math::simd_level::avx2;
+}
+} // namespace
+
+void w::math::sin(std::span<const float> in, std::span<float> out) noexcept
+{
+    return use_avx2() ? apply_avx2<sin_avx2>(in, out) : apply_sse41<sin>(in, out);
+}
+void w::math::cos(std::span<const float> in, std::span<float> out) noexcept
+{
+    return use_avx2() ? apply_avx2<cos_avx2>(in, out) : apply_sse41<cos>(in, out);
+}
+void w::math::sincos(std::span<const float> in, std::span<float> sin_out, std::span<float> cos_out) noexcept
+{
+    return use_avx2() ? sincos_avx2(in, sin_out, cos_out) : sincos_sse41(in, sin_out, cos_out);
+}
+void w::math::acos(std::span<const float> in, std::span<float> out) noexcept
+{
+    return use_avx2() ? apply_avx2<acos_avx2>(in, out) : apply_sse41<acos>(in, out);
+}
+void w::math::atan2(std::span<const float> y, std::span<const float> x, std::span<float> out) noexcept
+{
+    return use_avx2() ? atan2_avx2(y, x, out) : atan2_sse41(y, x, out);
+}
+void w::math::exp(std::span<const float> in, std::span<float> out) noexcept
+{
+    return use_avx2() ? apply_avx2<exp_avx2>(in, out) : apply_sse41<exp>(in, out);
+}
+void w::math::log(std::span<const float> in, std::span<float> out) noexcept
+{
+    return use_avx2() ? apply_avx2<log_avx2>(in, out) : apply_sse41<log>(in, out);
+}
@@ -14,7 +14,7 @@ public:
     w::action<void> init_async(uint32_t w, uint32_t height, bool fullscreen);
     w::action<int> run_async();
     w::action<bool> process_events_async(); // true if quit event was received
-    w::action<void> on_resize_async(int width, int height);
+    w::action<void> on_resize_async(int width, int height, w::cancellation_token cancel);
 
 private:
     bool process_events(); // true if quit event was received
@@ -22,6 +22,7 @@ private:
 
 private:
     size_t ui_thread;
+    w::cancellation_source resize_cancel; // cancels the pending resize once a newer one arrives
 
     ut::window wnd;
     w::graphics gfx;
@@ -69,7 +69,9 @@ w::action<bool> ut::app::process_events_async()
             co_return true; // Quit the application
         case w::window_event::Resize:
             auto [w, h] = wnd.pixel_size();
-            tasks.emplace_back(on_resize_async(w, h));
+            resize_cancel.cancel(); // only the latest size matters
+            resize_cancel = {};
+            tasks.emplace_back(on_resize_async(w, h, resize_cancel.get_token()));
             break;
         }
     } while (event != w::window_event::NoEvent);
@@ -96,9 +98,11 @@ bool ut::app::process_events()
     } while (event != w::window_event::NoEvent);
     return false;
 }
-w::action<void> ut::app::on_resize_async(int width, int height)
+w::action<void> ut::app::on_resize_async(int width, int height, w::cancellation_token cancel)
 {
-    co_await w::resume_background();
+    if (!co_await w::resume_background()) {
+        co_return; // superseded by a newer resize
+    }
     auto e = swapchain.resize(uint32_t(width), uint32_t(height)); // Costly operation
     if (!bool(e)) {
         ; // log error
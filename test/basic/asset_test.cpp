@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+#include <asset/package.h>
+#include <asset/package_writer.h>
+#include <base/lz4.h>
+#include <base/thread_pool.h>
+#include "test_pool.h"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <string>
+#include <vector>
+
+namespace {
+// compressible, but not trivially: words from a small vocabulary with varying numbers
+std::vector<std::byte> text_like(size_t size)
+{
+    constexpr std::string_view words[] = { "mesh ", "texture ", "stone ", "vertex ", "normal " };
+    std::vector<std::byte> result;
+    uint32_t state = 12345;
+    while (result.size() < size) {
+        state = state * 1664525u + 1013904223u;
+        auto word = words[(state >> 16) % std::size(words)];
+        auto number = std::to_string(state % 1000);
+        for (char c : std::string(word) + number + ' ') {
+            result.push_back(std::byte(c));
+        }
+    }
+    result.resize(size);
+    return result;
+}
+
+std::vector<std::byte> noise(size_t size)
+{
+    std::vector<std::byte> result(size);
+    uint32_t state = 777;
+    for (auto& b : result) {
+        state = state * 1664525u + 1013904223u;
+        b = std::byte(state >> 24);
+    }
+    return result;
+}
+
+bool round_trips(std::span<const std::byte> data)
+{
+    std::vector<std::byte> compressed(w::base::lz4::compress_bound(data.size()));
+    auto size = w::base::lz4::compress(data, compressed);
+    if (size == 0) {
+        return false;
+    }
+    std::vector<std::byte> decompressed(data.size());
+    return w::base::lz4::decompress(std::span{ compressed }.first(size), decompressed)
+            && std::memcmp(decompressed.data(), data.data(), data.size()) == 0;
+}
+
+w::fire_and_forget load(const w::asset::package& package, const w::asset::package_entry& entry, w::result<w::asset::asset_data>& out, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    out = co_await package.load_async(entry);
+    done.count_down();
+}
+
+bool same(std::span<const std::byte> a, std::span<const std::byte> b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+} // namespace
+
+TEST_CASE("lz4_round_trip")
+{
+    REQUIRE(round_trips({}));
+    REQUIRE(round_trips(text_like(7)));
+    REQUIRE(round_trips(text_like(100'000)));
+    REQUIRE(round_trips(noise(100'000)));
+    std::vector<std::byte> zeros(70'000); // long matches with overlapping copies
+    REQUIRE(round_trips(zeros));
+
+    auto data = text_like(10'000);
+    std::vector<std::byte> compressed(w::base::lz4::compress_bound(data.size()));
+    auto size = w::base::lz4::compress(data, compressed);
+    REQUIRE(size < data.size() / 2);
+    std::vector<std::byte> out(data.size());
+    REQUIRE(!w::base::lz4::decompress(std::span{ compressed }.first(size - 1), out)); // truncated
+    REQUIRE(!w::base::lz4::decompress(std::span{ compressed }.first(size), std::span{ out }.first(data.size() - 1)));
+}
+
+TEST_CASE("package_round_trip")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+    auto path = std::filesystem::temp_directory_path() / "w_package_test.wpak";
+
+    auto text = text_like(1'000'000);
+    auto random = noise(3'000);
+    {
+        w::asset::package_writer writer{ 256, 64 << 10 };
+        REQUIRE(writer.add("levels/text.bin", text, w::asset::compression::lz4));
+        REQUIRE(writer.add("textures/noise.bin", random, w::asset::compression::lz4));
+        REQUIRE(writer.add("empty.bin", {}));
+        REQUIRE(!writer.add("empty.bin", random)); // same name hash
+        REQUIRE(writer.write(path));
+    }
+
+    auto opened = w::asset::package::open(path);
+    REQUIRE(!opened);
+    auto& package = opened.value;
+    REQUIRE(package.entries().size() == 3);
+    REQUIRE(package.find("missing") == nullptr);
+
+    // incompressible data stays in place
+    auto* noise_entry = package.find("textures/noise.bin");
+    REQUIRE(noise_entry);
+    REQUIRE(noise_entry->codec == w::asset::compression::none);
+    REQUIRE(noise_entry->offset % 256 == 0);
+    REQUIRE(same(package.view(*noise_entry), random));
+
+    auto* text_entry = package.find(w::asset::hash_name("levels/text.bin"));
+    REQUIRE(text_entry);
+    REQUIRE(text_entry->codec == w::asset::compression::lz4);
+    REQUIRE(text_entry->stored_size < text.size() / 2);
+    REQUIRE(package.view(*text_entry).empty());
+    {
+        w::result<w::asset::asset_data> loaded;
+        std::latch done{ 1 };
+        load(package, *text_entry, loaded, done);
+        done.wait();
+        REQUIRE(!loaded);
+        REQUIRE(loaded.value.storage);
+        REQUIRE(same(loaded.value.bytes, text));
+    }
+
+    auto* empty_entry = package.find("empty.bin");
+    REQUIRE(empty_entry);
+    REQUIRE(package.view(*empty_entry).empty());
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("package_rejects_garbage")
+{
+    auto path = std::filesystem::temp_directory_path() / "w_package_garbage.wpak";
+    {
+        auto bytes = noise(4096);
+        std::ofstream{ path, std::ios::binary }.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+    }
+    REQUIRE(w::asset::package::open(path));
+    REQUIRE(w::asset::package::open(path.string() + ".missing"));
+
+    // a compressed entry claiming far more bytes than its chunk table covers
+    {
+        w::asset::package_writer writer{ 256, 64 << 10 };
+        REQUIRE(writer.add("levels/text.bin", text_like(100'000), w::asset::compression::lz4));
+        REQUIRE(writer.write(path));
+    }
+    REQUIRE(!w::asset::package::open(path));
+    {
+        std::fstream file{ path, std::ios::binary | std::ios::in | std::ios::out };
+        w::asset::package_header header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        uint64_t size = uint64_t(1) << 60;
+        file.seekp(std::streamoff(header.toc_offset + offsetof(w::asset::package_entry, size)));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    auto corrupted = w::asset::package::open(path);
+    REQUIRE(corrupted);
+    REQUIRE(corrupted.error.message == "corrupted table of contents");
+    std::filesystem::remove(path);
+}
@@ -4,6 +4,8 @@
 #include <vector>
 #include <set>
 #include <mutex>
+#include <atomic>
+#include <array>
 
 class Test
 {
@@ -193,4 +195,138 @@ TEST_CASE("smoke_madness")
 
     REQUIRE(storage.size() == storage2.size());
     REQUIRE(storage == storage2);
-}
\ No newline at end of file
+}
+
+TEST_CASE("growable_stealing")
+{
+    constexpr int count = 100000;
+    w::base::growable_stealing_deque<int, 16> queue;
+    std::vector<std::atomic<int>> seen(count + 1);
+    std::atomic<bool> stop{ false };
+
+    // without thieves or pops the 17th push has to grow the buffer
+    for (int i = 0; i < 17; ++i) {
+        REQUIRE(queue.try_push(0));
+    }
+    REQUIRE(queue.capacity() > 16);
+    while (queue.try_pop()) {
+    }
+
+    std::vector<std::jthread> thieves;
+    for (size_t i = 0; i < 3; ++i) {
+        thieves.emplace_back([&] {
+            while (true) {
+                auto item = queue.try_steal();
+                if (item) {
+                    if (item.value() != 0) {
+                        seen[item.value()].fetch_add(1, std::memory_order::relaxed);
+                    }
+                } else if (stop.load(std::memory_order::acquire)) {
+                    break;
+                }
+            }
+        });
+    }
+
+    // owner never fails to push, the buffer grows past the initial 16 entries
+    for (int i = 1; i <= count; ++i) {
+        REQUIRE(queue.try_push(i));
+        if (i % 3 == 0) {
+            auto item = queue.try_pop();
+            if (item && item.value() != 0) {
+                seen[item.value()].fetch_add(1, std::memory_order::relaxed);
+            }
+        }
+    }
+    while (auto item = queue.try_pop()) {
+        if (item.value() != 0) {
+            seen[item.value()].fetch_add(1, std::memory_order::relaxed);
+        }
+    }
+    stop.store(true, std::memory_order::release);
+    thieves.clear();
+
+    REQUIRE(queue.capacity() > 16);
+    for (int i = 1; i <= count; ++i) {
+        REQUIRE(seen[i].load() == 1);
+    }
+}
+
+TEST_CASE("steal_half")
+{
+    w::base::stealing_deque<int, 128> queue;
+    std::array<int, 10> items{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    REQUIRE(queue.try_push_bulk(items));
+    REQUIRE(queue.size() == 10);
+
+    std::array<int, 64> stolen{};
+    auto count = queue.try_steal_half(stolen);
+    REQUIRE(count == 5u);
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(stolen[i] == i + 1); // thieves take the oldest items
+    }
+    REQUIRE(queue.size() == 5);
+
+    // the owner keeps popping the newest item
+    std::vector<int> rest;
+    while (auto item = queue.try_pop()) {
+        rest.push_back(item.value());
+    }
+    REQUIRE(rest == std::vector<int>{ 10, 9, 8, 7, 6 });
+    REQUIRE(queue.try_steal_half(stolen) == std::nullopt);
+}
+
+TEST_CASE("steal_half_races_owner")
+{
+    constexpr int count = 200000;
+    w::base::stealing_deque<int, 1024> queue;
+    std::vector<std::atomic<int>> seen(count + 1);
+    std::atomic<bool> stop{ false };
+    auto see = [&](int item) {
+        if (item != 0) {
+            seen[item].fetch_add(1, std::memory_order::relaxed);
+        }
+    };
+
+    std::vector<std::jthread> thieves;
+    for (size_t i = 0; i < 3; ++i) {
+        thieves.emplace_back([&] {
+            std::array<int, 64> stolen;
+            while (true) {
+                auto taken = queue.try_steal_half(stolen);
+                if (taken) {
+                    for (size_t j = 0; j < taken.value(); ++j) {
+                        see(stolen[j]);
+                    }
+                } else if (stop.load(std::memory_order::acquire)) {
+                    break;
+                }
+            }
+        });
+    }
+
+    // short bursts keep the owner close to top, where it races the batches
+    for (int i = 1; i <= count;) {
+        for (int burst = 0; burst < 8 && i <= count; ++burst, ++i) {
+            while (!queue.try_push(i)) {
+                if (auto item = queue.try_pop()) {
+                    see(item.value());
+                }
+            }
+        }
+        for (int pop = 0; pop < 6; ++pop) {
+            if (auto item = queue.try_pop()) {
+                see(item.value());
+            }
+        }
+    }
+    while (auto item = queue.try_pop()) {
+        see(item.value());
+    }
+    stop.store(true, std::memory_order::release);
+    thieves.clear();
+
+    for (int i = 1; i <= count; ++i) {
+        REQUIRE(seen[i].load() == 1);
+    }
+}
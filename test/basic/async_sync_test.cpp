@@ -0,0 +1,170 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/async_sync.h>
+#include <base/tasks.h>
+#include <base/thread_pool.h>
+#include "test_pool.h"
+#include <atomic>
+#include <latch>
+#include <thread>
+
+namespace {
+// the counter is not atomic on purpose, the mutex has to order the increments
+w::fire_and_forget locked_increments(w::async_mutex& mutex, int& counter, int rounds, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    for (int i = 0; i < rounds; ++i) {
+        co_await w::resume_background(); // spread over the workers
+        auto guard = co_await mutex.scoped_lock();
+        ++counter;
+    }
+    done.count_down();
+}
+
+w::fire_and_forget throttled(w::async_semaphore& semaphore, std::atomic<int>& inside, std::atomic<int>& peak, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    for (int i = 0; i < 100; ++i) {
+        co_await semaphore.acquire();
+        auto now = inside.fetch_add(1) + 1;
+        auto seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+        co_await w::resume_background();
+        inside.fetch_sub(1);
+        semaphore.release();
+    }
+    done.count_down();
+}
+
+w::fire_and_forget acquire_once(w::async_semaphore& semaphore, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    co_await semaphore.acquire();
+    done.count_down();
+}
+
+template<typename Event>
+w::fire_and_forget wait_for(Event& event, std::atomic<int>& woken, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    co_await event.wait();
+    woken.fetch_add(1);
+    done.count_down();
+}
+
+w::fire_and_forget arrive(w::async_latch& latch)
+{
+    co_await w::resume_affine(0);
+    co_await w::resume_background();
+    latch.count_down();
+}
+
+w::fire_and_forget signal_from_worker(auto& event)
+{
+    co_await w::resume_affine(0);
+    event.set();
+}
+} // namespace
+
+TEST_CASE("async_mutex_excludes")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    constexpr int coroutines = 16;
+    constexpr int rounds = 500;
+    w::async_mutex mutex;
+    int counter = 0;
+    std::latch done{ coroutines };
+    for (int i = 0; i < coroutines; ++i) {
+        locked_increments(mutex, counter, rounds, done);
+    }
+    done.wait();
+
+    REQUIRE(counter == coroutines * rounds);
+    REQUIRE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST_CASE("async_semaphore_limits_concurrency")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    w::async_semaphore semaphore{ 2 };
+    std::atomic<int> inside{ 0 };
+    std::atomic<int> peak{ 0 };
+    std::latch done{ 8 };
+    for (int i = 0; i < 8; ++i) {
+        throttled(semaphore, inside, peak, done);
+    }
+    done.wait();
+
+    REQUIRE(peak.load() <= 2);
+    REQUIRE(semaphore.available() == 2);
+}
+
+TEST_CASE("async_semaphore_release_resumes_waiter")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    // the count goes negative while the coroutine waits, the release has to hand it the permit
+    w::async_semaphore semaphore{ 0 };
+    std::latch done{ 1 };
+    acquire_once(semaphore, done);
+    while (semaphore.available() >= 0) {
+        std::this_thread::yield();
+    }
+    semaphore.release();
+    done.wait();
+    REQUIRE(semaphore.available() == 0);
+}
+
+TEST_CASE("async_events_and_latch")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    // manual reset releases everybody
+    {
+        w::async_event event;
+        std::atomic<int> woken{ 0 };
+        std::latch done{ 3 };
+        for (int i = 0; i < 3; ++i) {
+            wait_for(event, woken, done);
+        }
+        signal_from_worker(event);
+        done.wait();
+        REQUIRE(woken.load() == 3);
+        REQUIRE(event.is_set());
+    }
+
+    // auto reset releases one waiter per set
+    {
+        w::async_auto_reset_event event;
+        std::atomic<int> woken{ 0 };
+        std::latch first{ 1 };
+        wait_for(event, woken, first);
+        signal_from_worker(event);
+        first.wait();
+        REQUIRE(!event.is_set());
+
+        event.set();
+        event.set(); // collapses with the first one
+        REQUIRE(event.is_set());
+        std::latch second{ 1 };
+        wait_for(event, woken, second);
+        second.wait();
+        REQUIRE(!event.is_set());
+        REQUIRE(woken.load() == 2);
+    }
+
+    {
+        w::async_latch latch{ 4 };
+        std::atomic<int> woken{ 0 };
+        std::latch done{ 1 };
+        wait_for(latch, woken, done);
+        for (int i = 0; i < 4; ++i) {
+            arrive(latch);
+        }
+        done.wait();
+        REQUIRE(latch.try_wait());
+    }
+}
@@ -1,2 +1,428 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/async_sync.h>
 #include <base/tasks.h>
+#include <base/thread_pool.h>
+#include "test_pool.h"
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <memory_resource>
+#include <string>
+#include <thread>
 
+using namespace std::chrono_literals;
+
+namespace {
+w::task<int> square(int value)
+{
+    co_return value * value;
+}
+
+w::task<std::string> name()
+{
+    co_return "two";
+}
+
+w::task<void> nothing()
+{
+    co_return;
+}
+
+w::fire_and_forget collect_tuple(std::tuple<int, std::string, std::monostate>& out, std::latch& done)
+{
+    co_await w::resume_background();
+    out = co_await w::when_all(square(3), name(), nothing());
+    done.count_down();
+}
+
+w::fire_and_forget collect_range(std::vector<int>& out, std::latch& done)
+{
+    co_await w::resume_background();
+    std::vector<w::task<int>> tasks;
+    for (int i = 0; i < 64; ++i) {
+        tasks.push_back(square(i));
+    }
+    out = co_await w::when_all(std::span{ tasks });
+    done.count_down();
+}
+
+// every child waits for all of them to start, only possible if they run at the same time
+w::task<bool> rendezvous(std::atomic<int>& started, int expected)
+{
+    started.fetch_add(1);
+    auto give_up = std::chrono::steady_clock::now() + 2s;
+    while (started.load() < expected) {
+        if (std::chrono::steady_clock::now() > give_up) {
+            co_return false;
+        }
+        std::this_thread::yield();
+    }
+    co_return true;
+}
+
+w::fire_and_forget parallel_root(std::atomic<int>& started, std::tuple<bool, bool, bool, bool>& out, std::latch& done)
+{
+    co_await w::resume_background();
+    out = co_await w::when_all(rendezvous(started, 4), rendezvous(started, 4), rendezvous(started, 4), rendezvous(started, 4));
+    done.count_down();
+}
+
+w::task<int> fast(int value)
+{
+    co_return value;
+}
+
+w::task<int> until_cancelled(std::stop_token token, std::atomic<int>& cancelled, std::latch& losers)
+{
+    auto give_up = std::chrono::steady_clock::now() + 2s;
+    while (!token.stop_requested() && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::yield();
+    }
+    if (token.stop_requested()) {
+        cancelled.fetch_add(1);
+    }
+    losers.count_down();
+    co_return -1;
+}
+
+w::fire_and_forget race(w::when_any_result<int>& out, std::atomic<int>& cancelled, std::latch& losers, std::latch& done)
+{
+    co_await w::resume_background();
+    std::stop_source cancel;
+    out = co_await w::when_any(cancel,
+                               until_cancelled(cancel.get_token(), cancelled, losers),
+                               fast(42),
+                               until_cancelled(cancel.get_token(), cancelled, losers),
+                               until_cancelled(cancel.get_token(), cancelled, losers));
+    done.count_down();
+}
+
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+    int allocations = 0;
+    int deallocations = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+w::task<int> in_arena(std::allocator_arg_t, std::pmr::memory_resource*, int value)
+{
+    co_return value + 1;
+}
+
+w::fire_and_forget arena_root(counting_resource& resource, int& out, std::latch& done)
+{
+    out = co_await in_arena(std::allocator_arg, &resource, 41);
+    done.count_down();
+}
+
+// finishes on another worker while the parent is attaching to it
+w::action<int> hop(int value)
+{
+    co_await w::resume_background();
+    co_return value;
+}
+
+w::action<int> parent_of_hop(int value)
+{
+    auto child = hop(value);
+    co_return co_await child + 1;
+}
+
+w::fire_and_forget stress_root(std::atomic<int>& sum, std::latch& done, int value)
+{
+    co_await w::resume_affine(0);
+    sum.fetch_add(co_await parent_of_hop(value), std::memory_order::relaxed);
+    done.count_down();
+}
+
+w::action<int> affine_hop(int value)
+{
+    co_await w::resume_affine(0);
+    co_await w::resume_background();
+    co_return value;
+}
+w::task<bool> sees_cancellation()
+{
+    auto token = co_await w::get_cancellation_token();
+    co_return token.is_cancelled();
+}
+
+w::task<bool> hops_unless_cancelled()
+{
+    co_return co_await w::resume_background();
+}
+
+// the token is only read by the promise constructor, the body never touches it
+w::action<int> cancellable_parent([[maybe_unused]] w::cancellation_token cancel)
+{
+    co_await w::resume_affine(0);
+    int observed = 0;
+    observed += co_await sees_cancellation(); // inherited by the lazy child
+    observed += !co_await w::resume_background(); // does not suspend at all
+    auto [a, b] = co_await w::when_all(hops_unless_cancelled(), hops_unless_cancelled());
+    observed += !a + !b;
+    co_return observed;
+}
+
+// parks the coroutine, so it can be queued by hand
+struct park {
+    std::coroutine_handle<>& handle;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> h) const noexcept
+    {
+        handle = h;
+    }
+    void await_resume() const noexcept
+    {
+    }
+};
+
+struct count_on_exit {
+    std::latch& exited;
+    ~count_on_exit()
+    {
+        exited.count_down();
+    }
+};
+
+w::fire_and_forget parked(std::coroutine_handle<>& handle, std::atomic<int>& ran, std::latch& exited)
+{
+    count_on_exit guard{ exited };
+    co_await park{ handle };
+    ran.fetch_add(1, std::memory_order::relaxed);
+}
+
+w::fire_and_forget submit_from_worker(std::coroutine_handle<> handle, w::cancellation_token cancel)
+{
+    co_await w::resume_affine(0);
+    w::base::global_thread_pool_token::get_pool().submit(handle, std::move(cancel));
+}
+// only the cancellation ends the sleep in time
+w::action<bool> cancelled_sleep([[maybe_unused]] w::cancellation_token cancel)
+{
+    co_await w::resume_affine(0);
+    co_return co_await w::sleep_for(1h);
+}
+
+w::task<int> slow_square(int value, std::chrono::milliseconds delay)
+{
+    co_await w::sleep_for(delay);
+    co_return value * value;
+}
+
+// late until the gate opens
+w::task<int> gated_square(int value, w::async_event& gate, std::latch& exited)
+{
+    count_on_exit guard{ exited };
+    co_await gate.wait();
+    co_return value * value;
+}
+
+w::fire_and_forget timed(std::optional<int>& fast, std::optional<int>& slow, w::async_event& gate, std::latch& exited, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    fast = co_await w::with_timeout(slow_square(3, 1ms), 1h); // the timer is cancelled, not waited for
+    slow = co_await w::with_timeout(gated_square(4, gate, exited), 5ms);
+    done.count_down();
+}
+} // namespace
+
+TEST_CASE("when_all_collects_results")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    std::tuple<int, std::string, std::monostate> out;
+    std::latch done{ 1 };
+    collect_tuple(out, done);
+    done.wait();
+
+    REQUIRE(std::get<0>(out) == 9);
+    REQUIRE(std::get<1>(out) == "two");
+}
+
+TEST_CASE("when_all_range_keeps_order")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    std::vector<int> out;
+    std::latch done{ 1 };
+    collect_range(out, done);
+    done.wait();
+
+    REQUIRE(out.size() == 64);
+    for (int i = 0; i < 64; ++i) {
+        REQUIRE(out[i] == i * i);
+    }
+}
+
+TEST_CASE("when_all_runs_children_in_parallel")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    std::atomic<int> started{ 0 };
+    std::tuple<bool, bool, bool, bool> out;
+    std::latch done{ 1 };
+    parallel_root(started, out, done);
+    done.wait();
+
+    REQUIRE(out == std::tuple{ true, true, true, true });
+}
+
+TEST_CASE("when_any_cancels_losers")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    w::when_any_result<int> out{ size_t(-1), 0 };
+    std::atomic<int> cancelled{ 0 };
+    std::latch losers{ 3 };
+    std::latch done{ 1 };
+    race(out, cancelled, losers, done);
+    done.wait();
+    losers.wait();
+
+    REQUIRE(out.index == 1);
+    REQUIRE(out.value == 42);
+    REQUIRE(cancelled.load() == 3);
+}
+
+TEST_CASE("frame_allocator_reuses_blocks")
+{
+    using w::base::frame_allocator;
+
+    auto* a = frame_allocator::allocate(200);
+    frame_allocator::deallocate(a);
+    auto* b = frame_allocator::allocate(180); // same size class
+    REQUIRE(a == b);
+
+    // freed on another thread, returned through the remote stack
+    std::thread{ [b] { frame_allocator::deallocate(b); } }.join();
+    auto* c = frame_allocator::allocate(200);
+    REQUIRE(c == b);
+    frame_allocator::deallocate(c);
+
+    auto* large = frame_allocator::allocate(frame_allocator::max_class_size * 2);
+    REQUIRE(large != nullptr);
+    frame_allocator::deallocate(large);
+}
+
+TEST_CASE("frame_in_memory_resource")
+{
+    counting_resource resource;
+    int out = 0;
+    std::latch done{ 1 };
+    arena_root(resource, out, done);
+    done.wait();
+
+    REQUIRE(out == 42);
+    REQUIRE(resource.allocations == 1);
+    REQUIRE(resource.deallocations == 1);
+}
+
+TEST_CASE("action_continuation_stress")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    constexpr int count = 20'000;
+    std::atomic<int> sum{ 0 };
+    std::latch done{ count };
+    for (int i = 0; i < count; ++i) {
+        stress_root(sum, done, i);
+    }
+    done.wait();
+    REQUIRE(sum.load() == count * (count - 1) / 2 + count);
+
+    // blocking get() while the action finishes on a worker
+    for (int i = 0; i < 1000; ++i) {
+        auto action = affine_hop(i);
+        REQUIRE(action.get() == i);
+    }
+}
+
+TEST_CASE("lazy_task_get_and_drop")
+{
+    REQUIRE(square(5).get() == 25); // runs on this thread
+
+    auto never_awaited = square(6); // destroyed without running
+    (void)never_awaited;
+}
+
+TEST_CASE("cancellation_reaches_children")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    w::cancellation_source source;
+    source.cancel();
+    REQUIRE(cancellable_parent(source.get_token()).get() == 4);
+
+    w::cancellation_source live;
+    REQUIRE(cancellable_parent(live.get_token()).get() == 0);
+    REQUIRE(cancellable_parent({}).get() == 0);
+}
+
+TEST_CASE("pool_drops_cancelled_submissions")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    std::coroutine_handle<> dropped, kept;
+    std::atomic<int> ran{ 0 };
+    std::latch exited{ 2 };
+    parked(dropped, ran, exited);
+    parked(kept, ran, exited);
+
+    w::cancellation_source source;
+    source.cancel();
+    submit_from_worker(dropped, source.get_token());
+    submit_from_worker(kept, w::cancellation_source{}.get_token());
+    exited.wait();
+
+    REQUIRE(ran.load() == 1); // the dropped frame was destroyed, its locals still unwound
+}
+
+TEST_CASE("cancel_ends_sleep_early")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    auto start = std::chrono::steady_clock::now();
+    w::cancellation_source source;
+    auto sleeping = cancelled_sleep(source.get_token());
+    std::this_thread::sleep_for(10ms); // in the wheel by now, most likely
+    source.cancel();
+    REQUIRE(!sleeping.get());
+    REQUIRE(std::chrono::steady_clock::now() - start < 10s);
+}
+
+TEST_CASE("with_timeout_yields_nullopt_when_late")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+
+    std::optional<int> fast, slow{ -1 };
+    w::async_event gate;
+    std::latch exited{ 1 }, done{ 1 };
+    timed(fast, slow, gate, exited, done);
+    done.wait();
+
+    REQUIRE(fast == 9);
+    REQUIRE(!slow.has_value());
+    gate.set(); // the late child still finishes before the pool goes away
+    exited.wait();
+}
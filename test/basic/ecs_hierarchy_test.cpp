@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/thread_pool.h>
+#include <ecs/transform_hierarchy.h>
+#include <math/matrix_math.h>
+#include <math/quaternion.h>
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+using namespace w::math;
+using w::ecs::transform_hierarchy;
+
+namespace {
+bool near(const matrix& a, const matrix& b)
+{
+    for (size_t r = 0; r < 4; ++r) {
+        for (size_t c = 0; c < 4; ++c) {
+            if (!(std::abs(a[r][c] - b[r][c]) <= 1e-3f * std::max(1.0f, std::abs(b[r][c])))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+matrix test_local(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f), angle(-3.0f, 3.0f);
+    matrix rotation = quaternion::from_angle_axis_normal(angle(rng), identity[2]);
+    return multiply(rotation, translate(vector(offset(rng), offset(rng), offset(rng), 0.0f)));
+}
+
+// the recursive definition the hierarchy replaces
+matrix reference_world(const transform_hierarchy& h, transform_hierarchy::node n)
+{
+    auto p = h.parent(n);
+    return p == transform_hierarchy::no_parent ? h.local(n) : multiply(h.local(n), reference_world(h, p));
+}
+
+// random tree, each node's parent comes before it
+transform_hierarchy random_tree(size_t count, std::mt19937& rng)
+{
+    transform_hierarchy h;
+    for (size_t i = 0; i < count; ++i) {
+        auto parent = i < 3 ? transform_hierarchy::no_parent : transform_hierarchy::node(std::uniform_int_distribution<size_t>(i / 2, i - 1)(rng));
+        h.add(parent, test_local(rng));
+    }
+    return h;
+}
+
+// nodes with one of the roots as ancestor or self
+size_t subtree_size(const transform_hierarchy& h, std::initializer_list<transform_hierarchy::node> roots)
+{
+    size_t count = 0;
+    for (transform_hierarchy::node n = 0; n < h.size(); ++n) {
+        for (auto p = n; p != transform_hierarchy::no_parent; p = h.parent(p)) {
+            if (std::find(roots.begin(), roots.end(), p) != roots.end()) {
+                ++count;
+                break;
+            }
+        }
+    }
+    return count;
+}
+} // namespace
+
+TEST_CASE("hierarchy_matches_recursion")
+{
+    std::mt19937 rng(3);
+    transform_hierarchy h = random_tree(2000, rng);
+    REQUIRE(h.update() == 2000);
+    REQUIRE(h.depth() > 3);
+    for (transform_hierarchy::node n = 0; n < h.size(); ++n) {
+        REQUIRE(near(h.world(n), reference_world(h, n)));
+    }
+
+    // nothing changed, nothing computed
+    REQUIRE(h.update() == 0);
+
+    // exactly the changed subtrees
+    for (auto n : { 10, 500, 1999 }) {
+        h.set_local(n, test_local(rng));
+    }
+    REQUIRE(h.update() == subtree_size(h, { 10, 500, 1999 }));
+    for (transform_hierarchy::node n = 0; n < h.size(); ++n) {
+        REQUIRE(near(h.world(n), reference_world(h, n)));
+    }
+
+    // reparenting and new nodes
+    h.set_parent(1500, 2);
+    h.set_parent(40, transform_hierarchy::no_parent);
+    auto added = h.add(1500, test_local(rng));
+    REQUIRE(h.update() == subtree_size(h, { 1500, 40 }));
+    REQUIRE(h.parent(added) == 1500);
+    for (transform_hierarchy::node n = 0; n < h.size(); ++n) {
+        REQUIRE(near(h.world(n), reference_world(h, n)));
+    }
+}
+
+TEST_CASE("hierarchy_parallel_matches_serial")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 4, .pin_threads = false });
+
+    // wide levels, so every level is split across tasks
+    std::mt19937 rng(5);
+    transform_hierarchy serial = random_tree(60000, rng);
+    rng.seed(5);
+    transform_hierarchy parallel = random_tree(60000, rng);
+    REQUIRE(serial.update() == 60000);
+    REQUIRE(parallel.update_parallel().get() == 60000);
+    for (transform_hierarchy::node n = 0; n < serial.size(); n += 7) {
+        REQUIRE(near(parallel.world(n), serial.world(n)));
+    }
+
+    for (transform_hierarchy::node n = 0; n < serial.size(); n += 97) {
+        matrix local = test_local(rng);
+        serial.set_local(n, local);
+        parallel.set_local(n, local);
+    }
+    size_t computed = serial.update();
+    REQUIRE(parallel.update_parallel().get() == computed);
+    for (transform_hierarchy::node n = 0; n < serial.size(); ++n) {
+        REQUIRE(near(parallel.world(n), serial.world(n)));
+    }
+}
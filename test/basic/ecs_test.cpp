@@ -0,0 +1,186 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/thread_pool.h>
+#include <ecs/components.h>
+#include <ecs/registry.h>
+#include <atomic>
+#include <vector>
+
+using namespace w::ecs;
+
+namespace {
+struct velocity {
+    float x = 0, y = 0, z = 0;
+};
+struct health {
+    int value = 100;
+};
+struct large {
+    float data[4000]{};
+};
+} // namespace
+
+TEST_CASE("ecs_entities")
+{
+    registry reg;
+    entity a = reg.create();
+    entity b = reg.create(position{ { 1, 2, 3 } }, health{ 5 });
+    REQUIRE(reg.size() == 2);
+    REQUIRE(reg.alive(a));
+    REQUIRE(reg.has<position>(b));
+    REQUIRE(!reg.has<position>(a));
+    REQUIRE(reg.get<health>(b)->value == 5);
+    REQUIRE(reg.get<health>(a) == nullptr);
+
+    // the slot is reused with a new generation
+    reg.destroy(a);
+    REQUIRE(!reg.alive(a));
+    REQUIRE(!reg.has<position>(a));
+    entity c = reg.create();
+    REQUIRE(c.index == a.index);
+    REQUIRE(c != a);
+    REQUIRE(!reg.alive(a));
+    REQUIRE(reg.alive(c));
+    reg.destroy(a); // stale handles are ignored
+    REQUIRE(reg.alive(c));
+    REQUIRE(reg.size() == 2);
+}
+
+TEST_CASE("ecs_add_remove_moves_archetypes")
+{
+    registry reg;
+    std::vector<entity> entities;
+    for (int i = 0; i < 5000; ++i) {
+        entity e = reg.create(position{ { float(i), 0, 0 } });
+        if (i % 2) {
+            reg.add(e, velocity{ float(i), 1, 0 });
+        }
+        if (i % 3 == 0) {
+            reg.add(e, health{ i });
+        }
+        entities.push_back(e);
+    }
+    // removes from the middle of several chunks, the last entities fill the gaps
+    for (int i = 0; i < 5000; i += 7) {
+        reg.remove<velocity>(entities[i]);
+    }
+    for (int i = 0; i < 5000; i += 11) {
+        reg.destroy(entities[i]);
+    }
+
+    for (int i = 0; i < 5000; ++i) {
+        entity e = entities[i];
+        if (i % 11 == 0) {
+            REQUIRE(!reg.alive(e));
+            continue;
+        }
+        REQUIRE(reg.get<position>(e)->value[0] == float(i));
+        REQUIRE(reg.has<velocity>(e) == (i % 2 && i % 7));
+        if (reg.has<velocity>(e)) {
+            REQUIRE(reg.get<velocity>(e)->x == float(i));
+        }
+        REQUIRE(reg.has<health>(e) == (i % 3 == 0));
+        if (reg.has<health>(e)) {
+            REQUIRE(reg.get<health>(e)->value == i);
+        }
+    }
+
+    // adding an existing component assigns it
+    entity e = entities[1];
+    reg.add(e, velocity{ 7, 7, 7 });
+    REQUIRE(reg.get<velocity>(e)->x == 7);
+    REQUIRE(reg.get<position>(e)->value[0] == 1);
+}
+
+TEST_CASE("ecs_chunk_layout")
+{
+    registry reg;
+    entity e = reg.create(position{}, rotation{}, scale{});
+    for (const auto& a : reg.archetypes()) {
+        if (a->size() == 0) {
+            continue;
+        }
+        REQUIRE(a->mask() == component_type_mask<position, rotation, scale>());
+        // 8 byte entity + 12 + 16 + 12 bytes of components, minus the column padding
+        REQUIRE(a->chunk_capacity() > 0);
+        REQUIRE(a->chunk_capacity() <= chunk_size / (8 + 12 + 16 + 12));
+        REQUIRE(a->chunk_capacity() >= chunk_size / (8 + 12 + 16 + 12) - 2);
+        const chunk& c = a->chunks()[0];
+        for (void* column : { a->column(c, component_type_id<position>()), a->column(c, component_type_id<rotation>()), a->column(c, component_type_id<scale>()) }) {
+            REQUIRE(reinterpret_cast<uintptr_t>(column) % 16 == 0);
+            REQUIRE(static_cast<std::byte*>(column) < c.memory.get() + chunk_size);
+        }
+    }
+    REQUIRE(reg.get<rotation>(e)->value[3] == 1.0f);
+
+    // close to the chunk size, one entity per chunk
+    entity big = reg.create(large{});
+    reg.get<large>(big)->data[3999] = 3;
+    REQUIRE(reg.get<large>(big)->data[3999] == 3);
+}
+
+TEST_CASE("ecs_views")
+{
+    registry reg;
+    for (int i = 0; i < 3000; ++i) {
+        entity e = reg.create(position{ { float(i), 0, 0 } }, velocity{ 1, 2, 3 });
+        if (i % 4 == 0) {
+            reg.add(e, health{});
+        }
+    }
+    reg.create(position{}); // no velocity
+
+    auto moving = reg.view<position, const velocity>();
+    REQUIRE(moving.size() == 3000);
+    REQUIRE(moving.archetypes().size() == 2);
+    REQUIRE(reg.view<position>().size() == 3001);
+    REQUIRE(reg.view<health, velocity>().size() == 750);
+
+    moving.each([](position& p, const velocity& v) {
+        p.value[0] += v.x;
+        p.value[1] += v.y;
+    });
+    size_t count = 0;
+    reg.view<const position>().each([&](entity e, const position& p) {
+        REQUIRE(reg.get<position>(e) == &p);
+        count += p.value[1] == 2.0f;
+    });
+    REQUIRE(count == 3000);
+
+    size_t chunks = 0, entities = 0;
+    moving.each_chunk([&](std::span<const entity> ids, std::span<position> p, std::span<const velocity> v) {
+        REQUIRE(ids.size() == p.size());
+        REQUIRE(ids.size() == v.size());
+        ++chunks;
+        entities += ids.size();
+    });
+    REQUIRE(entities == 3000);
+    REQUIRE(chunks > 2);
+}
+
+TEST_CASE("ecs_parallel_chunks")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 4, .pin_threads = false });
+
+    registry reg;
+    for (int i = 0; i < 20000; ++i) {
+        reg.create(position{ { float(i), 0, 0 } }, velocity{ 1, 0, 0 });
+    }
+    std::atomic<size_t> visited{ 0 };
+    auto moving = reg.view<position, const velocity>();
+    moving.each_chunk_parallel([&](std::span<const entity> ids, std::span<position> p, std::span<const velocity> v) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            p[i].value[0] += v[i].x;
+        }
+        visited.fetch_add(ids.size(), std::memory_order::relaxed);
+    }).get();
+    REQUIRE(visited == 20000);
+
+    bool moved = true;
+    reg.view<const position>().each([&](entity e, const position& p) {
+        moved = moved && p.value[0] == float(e.index + 1);
+    });
+    REQUIRE(moved);
+
+    // an empty view finishes right away
+    reg.view<health>().each_chunk_parallel([](std::span<const entity>, std::span<health>) {}).get();
+}
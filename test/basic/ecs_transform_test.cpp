@@ -0,0 +1,221 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ecs/camera.h>
+#include <ecs/transform.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <thread>
+#include <vector>
+
+using namespace w::math;
+namespace ecs = w::ecs;
+using w::ecs::transform_changes;
+
+namespace {
+bool near(vector a, vector b)
+{
+    for (size_t i = 0; i < 3; ++i) {
+        if (!(std::abs(a[i] - b[i]) <= 1e-5f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void reset(ecs::transform& t, vector position)
+{
+    t.set_position(position);
+    t.set_rotation(quaternion(identity[3]));
+    t.set_scale(vector(1.0f, 1.0f, 1.0f, 0.0f));
+}
+} // namespace
+
+TEST_CASE("transform_recomputes_once_per_change")
+{
+    // root <- middle <- leaf, root <- sibling
+    ecs::transform root, middle, leaf, sibling;
+    reset(root, vector(1.0f, 0.0f, 0.0f, 0.0f));
+    reset(middle, vector(0.0f, 2.0f, 0.0f, 0.0f));
+    reset(leaf, vector(0.0f, 0.0f, 3.0f, 0.0f));
+    reset(sibling, vector(0.0f, 0.0f, 0.0f, 0.0f));
+    middle.set_parent(&root);
+    leaf.set_parent(&middle);
+    sibling.set_parent(&root);
+
+    REQUIRE(near(leaf.world_matrix()[3], vector(1.0f, 2.0f, 3.0f, 1.0f)));
+    REQUIRE(root.get_world_generation() == 1);
+    REQUIRE(middle.get_world_generation() == 1);
+    REQUIRE(leaf.get_world_generation() == 1);
+
+    // reads without changes compute nothing
+    for (int i = 0; i < 3; ++i) {
+        leaf.world_matrix();
+        sibling.world_matrix();
+    }
+    REQUIRE(!leaf.dirty());
+    REQUIRE(root.get_world_generation() == 1);
+    REQUIRE(leaf.get_world_generation() == 1);
+    REQUIRE(sibling.get_world_generation() == 1);
+
+    // a change of the root reaches every descendant exactly once
+    root.set_position(vector(5.0f, 0.0f, 0.0f, 0.0f));
+    REQUIRE(leaf.dirty());
+    REQUIRE(near(leaf.world_matrix()[3], vector(5.0f, 2.0f, 3.0f, 1.0f)));
+    REQUIRE(near(sibling.world_matrix()[3], vector(5.0f, 0.0f, 0.0f, 1.0f)));
+    REQUIRE(root.get_world_generation() == 2);
+    REQUIRE(middle.get_world_generation() == 2);
+    REQUIRE(leaf.get_world_generation() == 2);
+    REQUIRE(sibling.get_world_generation() == 2);
+
+    // a change of the leaf stays there
+    leaf.set_position(vector(0.0f, 0.0f, 4.0f, 0.0f));
+    REQUIRE(!middle.dirty());
+    REQUIRE(near(leaf.world_matrix()[3], vector(5.0f, 2.0f, 4.0f, 1.0f)));
+    REQUIRE(root.get_world_generation() == 2);
+    REQUIRE(middle.get_world_generation() == 2);
+    REQUIRE(leaf.get_world_generation() == 3);
+    REQUIRE(sibling.get_world_generation() == 2);
+
+    // several changes before a read are one rebuild
+    middle.set_position(vector(0.0f, 1.0f, 0.0f, 0.0f));
+    middle.set_position(vector(0.0f, 7.0f, 0.0f, 0.0f));
+    REQUIRE(near(leaf.world_matrix()[3], vector(5.0f, 7.0f, 4.0f, 1.0f)));
+    REQUIRE(middle.get_world_generation() == 3);
+    REQUIRE(leaf.get_world_generation() == 4);
+    REQUIRE(sibling.get_world_generation() == 2);
+
+    // the parent rotation applies to the child offset, world = local * parent
+    root.set_rotation(quaternion::from_angle_axis_normal(std::numbers::pi_v<float> / 2, identity[2]));
+    vector rotated = transform(root.world_matrix(), vector(1.0f, 0.0f, 0.0f, 0.0f)) - root.world_matrix()[3];
+    REQUIRE(near(sibling.world_matrix()[3], root.world_matrix()[3]));
+    REQUIRE(near(transform(middle.world_matrix(), vector(0.0f, 0.0f, 0.0f, 0.0f)), transform(root.world_matrix(), vector(0.0f, 7.0f, 0.0f, 0.0f))));
+    REQUIRE(std::abs(std::abs(rotated[1]) - 1.0f) < 1e-5f);
+
+    // reparenting rebuilds the moved subtree only
+    leaf.set_parent(&sibling);
+    uint32_t middle_generation = middle.get_world_generation();
+    leaf.world_matrix();
+    REQUIRE(middle.get_world_generation() == middle_generation);
+    REQUIRE(near(leaf.world_matrix()[3], transform(sibling.world_matrix(), vector(0.0f, 0.0f, 4.0f, 0.0f))));
+}
+
+TEST_CASE("transform_changes_list")
+{
+    transform_changes::take();
+
+    std::vector<std::unique_ptr<ecs::transform>> objects;
+    for (int i = 0; i < 10; ++i) {
+        objects.push_back(std::make_unique<ecs::transform>());
+    }
+    REQUIRE(transform_changes::size() == 0);
+
+    objects[2]->set_position(vector(1.0f, 0.0f, 0.0f, 0.0f));
+    objects[5]->set_scale(vector(2.0f, 2.0f, 2.0f, 0.0f));
+    objects[2]->set_rotation(quaternion(identity[3]));
+    objects[7]->set_parent(objects[5].get());
+    objects[9]->set_position(vector(1.0f, 0.0f, 0.0f, 0.0f));
+    objects[9].reset(); // destroyed transforms leave the list
+
+    auto changed = transform_changes::take();
+    REQUIRE(changed.size() == 3);
+    for (int i : { 2, 5, 7 }) {
+        REQUIRE(std::find(changed.begin(), changed.end(), objects[i].get()) != changed.end());
+    }
+    REQUIRE(transform_changes::take().empty());
+
+    // reading does not list anything, the next change does again
+    objects[7]->world_matrix();
+    REQUIRE(transform_changes::size() == 0);
+    objects[2]->set_position(vector(2.0f, 0.0f, 0.0f, 0.0f));
+    REQUIRE(transform_changes::take() == std::vector<ecs::transform*>{ objects[2].get() });
+}
+
+TEST_CASE("transform_changes_moves_and_epoch")
+{
+    transform_changes::take();
+
+    // moved transforms keep their slot, a growing vector moves instead of copying
+    std::vector<ecs::transform> objects(4);
+    objects[1].set_position(vector(1.0f, 0.0f, 0.0f, 0.0f));
+    objects[3].set_position(vector(3.0f, 0.0f, 0.0f, 0.0f));
+    objects.resize(1000);
+    REQUIRE(transform_changes::size() == 2);
+    auto changed = transform_changes::take();
+    std::sort(changed.begin(), changed.end());
+    REQUIRE(changed == std::vector<ecs::transform*>{ &objects[1], &objects[3] });
+    REQUIRE(near(objects[3].world_matrix()[3], vector(3.0f, 0.0f, 0.0f, 1.0f)));
+
+    // a move assignment lists the target instead of the source
+    objects[5].set_position(vector(5.0f, 0.0f, 0.0f, 0.0f));
+    objects[6] = std::move(objects[5]);
+    REQUIRE(transform_changes::take() == std::vector<ecs::transform*>{ &objects[6] });
+
+    // changes move the epoch, take() does not, so nobody has to take() for reads to stay O(1)
+    objects[7].set_parent(&objects[6]);
+    REQUIRE(near(objects[7].world_matrix()[3], vector(5.0f, 0.0f, 0.0f, 1.0f)));
+    uint64_t epoch = transform_changes::epoch();
+    objects[6].set_position(vector(6.0f, 0.0f, 0.0f, 0.0f));
+    objects[6].set_scale(vector(1.0f, 1.0f, 1.0f, 0.0f)); // nothing cached in between, the epoch moves once
+    REQUIRE(transform_changes::epoch() == epoch + 1);
+    REQUIRE(objects[7].dirty());
+    REQUIRE(near(objects[7].world_matrix()[3], vector(6.0f, 0.0f, 0.0f, 1.0f)));
+    REQUIRE(!objects[7].dirty());
+    transform_changes::take();
+    REQUIRE(transform_changes::epoch() == epoch + 1);
+    REQUIRE(!objects[7].dirty());
+
+    // destroying queued transforms empties the list
+    for (auto& t : objects) {
+        t.set_scale(vector(2.0f, 2.0f, 2.0f, 0.0f));
+    }
+    REQUIRE(transform_changes::size() == objects.size());
+    objects.erase(objects.begin(), objects.begin() + 500);
+    objects.clear();
+    REQUIRE(transform_changes::size() == 0);
+}
+
+TEST_CASE("transform_epoch_concurrent_changes")
+{
+    // another thread changing and reading an unrelated transform must not hide a change of this chain
+    ecs::transform other;
+    reset(other, vector(0.0f, 0.0f, 0.0f, 0.0f));
+    std::atomic<bool> stop{ false };
+    std::thread writer{ [&] {
+        for (int i = 0; !stop.load(std::memory_order::relaxed); ++i) {
+            other.set_position(vector(float(i & 0xff), 0.0f, 0.0f, 0.0f));
+            other.world_matrix();
+        }
+    } };
+
+    ecs::transform parent;
+    ecs::transform child;
+    reset(parent, vector(0.0f, 0.0f, 0.0f, 0.0f));
+    reset(child, vector(0.0f, 1.0f, 0.0f, 0.0f));
+    child.set_parent(&parent);
+    bool fresh = true;
+    for (int i = 0; i < 100000 && fresh; ++i) {
+        child.world_matrix();
+        parent.set_position(vector(float(i & 0xff), 0.0f, 0.0f, 0.0f));
+        fresh = near(child.world_matrix()[3], vector(float(i & 0xff), 1.0f, 0.0f, 1.0f));
+    }
+    stop.store(true, std::memory_order::relaxed);
+    writer.join();
+    transform_changes::take();
+    REQUIRE(fresh);
+}
+
+TEST_CASE("camera_view_cache")
+{
+    w::ecs::camera camera;
+    camera.set_position(vector(0.0f, 0.0f, -5.0f, 0.0f));
+    camera.set_rotation(quaternion(identity[3]));
+    matrix view = camera.get_view();
+    REQUIRE(near(transform(view, vector(0.0f, 0.0f, 0.0f, 0.0f)), vector(0.0f, 0.0f, 5.0f, 1.0f)));
+
+    // the view follows a change even after something else read the world matrix
+    camera.set_position(vector(0.0f, 0.0f, -2.0f, 0.0f));
+    camera.world_matrix();
+    REQUIRE(near(transform(camera.get_view(), vector(0.0f, 0.0f, 0.0f, 0.0f)), vector(0.0f, 0.0f, 2.0f, 1.0f)));
+}
@@ -0,0 +1,159 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/frame_graph.h>
+#include <base/thread_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using w::base::frame_graph;
+
+namespace {
+// start and finish of each system in one sequence
+struct run_log {
+    explicit run_log(size_t systems)
+        : started(systems), finished(systems)
+    {
+    }
+
+    void record(frame_graph::system s)
+    {
+        started[s] = sequence.fetch_add(1, std::memory_order::relaxed);
+        std::this_thread::yield(); // give the others a chance to overtake
+        finished[s] = sequence.fetch_add(1, std::memory_order::relaxed);
+    }
+
+    std::atomic<uint32_t> sequence = 0;
+    std::vector<uint32_t> started, finished;
+};
+
+bool contains(std::span<const frame_graph::system> systems, frame_graph::system s)
+{
+    return std::find(systems.begin(), systems.end(), s) != systems.end();
+}
+} // namespace
+
+TEST_CASE("frame_graph_orders_conflicts")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 4, .pin_threads = false });
+
+    frame_graph graph;
+    auto transforms = graph.add_resource();
+    auto visible = graph.add_resource();
+    auto commands = graph.add_resource();
+    auto audio = graph.add_resource();
+
+    run_log log(7);
+    auto system = [&log](frame_graph::system s) {
+        return [&log, s] { log.record(s); };
+    };
+    auto simulate = graph.add_system(system(0), {}, { transforms });
+    auto cull = graph.add_system(system(1), { transforms }, { visible });
+    auto animate_ui = graph.add_system(system(2), { transforms }, {});
+    auto record = graph.add_system(system(3), { visible }, { commands });
+    auto mix = graph.add_system(system(4), {}, { audio });
+    auto next_simulate = graph.add_system(system(5), {}, { transforms }); // after the readers of this frame
+    auto submit = graph.add_system([&log]() -> w::task<void> {
+        log.record(6);
+        co_return;
+    },
+            { commands, audio });
+    graph.compile();
+
+    // read after write, write after read, write after write
+    REQUIRE(contains(graph.dependents(simulate), cull));
+    REQUIRE(contains(graph.dependents(simulate), animate_ui));
+    REQUIRE(contains(graph.dependents(cull), next_simulate));
+    REQUIRE(contains(graph.dependents(animate_ui), next_simulate));
+    REQUIRE(contains(graph.dependents(cull), record));
+    REQUIRE(contains(graph.dependents(record), submit));
+    REQUIRE(contains(graph.dependents(mix), submit));
+    // no conflict, no order
+    REQUIRE(!contains(graph.dependents(cull), animate_ui));
+    REQUIRE(graph.dependents(mix).size() == 1);
+    REQUIRE(graph.dependents(submit).empty());
+
+    std::vector<std::pair<frame_graph::system, frame_graph::system>> edges;
+    for (frame_graph::system s = 0; s < graph.size(); ++s) {
+        for (auto d : graph.dependents(s)) {
+            edges.emplace_back(s, d);
+        }
+    }
+    // the same graph every frame
+    for (int frame = 0; frame < 200; ++frame) {
+        log.sequence = 0;
+        graph.run().get();
+        REQUIRE(log.sequence == 14); // every system once
+        for (auto [before, after] : edges) {
+            REQUIRE(log.finished[before] < log.started[after]);
+        }
+    }
+}
+
+TEST_CASE("frame_graph_overlaps_independent_systems")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 4, .pin_threads = false });
+
+    frame_graph graph;
+    auto a = graph.add_resource();
+    auto b = graph.add_resource();
+
+    // both wait for each other, which only finishes if they run at the same time
+    std::atomic<int> arrived = 0;
+    std::atomic<bool> overlapped = true;
+    auto meet = [&] {
+        arrived.fetch_add(1);
+        auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (arrived.load() < 2) {
+            if (std::chrono::steady_clock::now() > end) {
+                overlapped = false;
+                return;
+            }
+            std::this_thread::yield();
+        }
+    };
+    graph.add_system(meet, { a }, {});
+    graph.add_system(meet, { b }, {});
+
+    // a system splitting its own work across the pool
+    std::atomic<int> parts = 0;
+    graph.add_system([&]() -> w::task<void> {
+        std::vector<w::task<void>> tasks;
+        for (int i = 0; i < 8; ++i) {
+            tasks.push_back([](std::atomic<int>& parts) -> w::task<void> {
+                parts.fetch_add(1);
+                co_return;
+            }(parts));
+        }
+        co_await w::when_all(std::span{ tasks });
+    },
+            { a, b }, {});
+    graph.compile();
+
+    for (int frame = 0; frame < 10; ++frame) {
+        arrived = 0;
+        graph.run().get();
+        REQUIRE(overlapped);
+        REQUIRE(parts == 8 * (frame + 1));
+    }
+
+    // systems run on the pool, not on the thread waiting for the frame
+    frame_graph chain;
+    auto link = chain.add_resource();
+    auto caller = std::this_thread::get_id();
+    std::atomic<int> on_caller = 0;
+    for (int i = 0; i < 3; ++i) {
+        chain.add_system([&] { on_caller += std::this_thread::get_id() == caller; }, {}, { link });
+    }
+    chain.compile();
+    for (int frame = 0; frame < 10; ++frame) {
+        chain.run().get();
+    }
+    REQUIRE(on_caller == 0);
+
+    // nothing to run
+    frame_graph empty;
+    empty.compile();
+    empty.run().get();
+}
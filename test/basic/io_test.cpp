@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/io.h>
+#include <base/tasks.h>
+#include <base/thread_pool.h>
+#include "test_pool.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// removed again when the test ends
+struct temp_file {
+    explicit temp_file(size_t size)
+        : path(std::filesystem::temp_directory_path() / ("w_io_test_" + std::to_string(size)))
+    {
+        contents.resize(size);
+        for (size_t i = 0; i < size; ++i) {
+            contents[i] = char(i * 31 + i / 4093); // no period that lines up with a chunk
+        }
+        std::ofstream{ path, std::ios::binary }.write(contents.data(), std::streamsize(size));
+    }
+    ~temp_file()
+    {
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+    }
+
+    std::filesystem::path path;
+    std::string contents;
+};
+
+w::fire_and_forget read_whole(std::filesystem::path path, size_t chunk_size, w::result<w::io::file_contents>& out, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    out = co_await w::io::read_file_async(std::move(path), chunk_size);
+    done.count_down();
+}
+
+w::fire_and_forget read_tail(const w::io::file& file, uint64_t offset, std::vector<std::byte>& buffer, w::result<size_t>& out, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    out = co_await w::io::read_at_async(file, buffer, offset);
+    done.count_down();
+}
+
+// started and suspended on the calling thread, resumed by the worker that reaped the read
+w::fire_and_forget read_here(const w::io::file& file, uint64_t offset, std::vector<std::byte>& buffer, w::result<size_t>& out, std::latch& done)
+{
+    out = co_await w::io::read_at_async(file, buffer, offset);
+    done.count_down();
+}
+
+bool same(const w::io::file_contents& read, const std::string& expected)
+{
+    return read.size == expected.size() && std::memcmp(read.data.get(), expected.data(), expected.size()) == 0;
+}
+} // namespace
+
+TEST_CASE("read_file_async_reads_in_chunks")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+    temp_file file{ 1'000'003 };
+
+    for (size_t chunk_size : { size_t(1) << 20, size_t(65536), size_t(4096) }) {
+        w::result<w::io::file_contents> read;
+        std::latch done{ 1 };
+        read_whole(file.path, chunk_size, read, done);
+        done.wait();
+        REQUIRE(!read);
+        REQUIRE(same(read.value, file.contents));
+    }
+
+    w::result<w::io::file_contents> missing;
+    std::latch done{ 1 };
+    read_whole(file.path.string() + ".missing", 4096, missing, done);
+    done.wait();
+    REQUIRE(missing);
+}
+
+TEST_CASE("read_at_async_stops_at_the_end")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped(w::test::test_pool_config());
+    temp_file source{ 10'000 };
+    auto opened = w::io::file::open(source.path);
+    REQUIRE(!opened);
+    REQUIRE(opened.value.size() == 10'000);
+
+    std::vector<std::byte> buffer(4096);
+    w::result<size_t> read;
+    std::latch done{ 1 };
+    read_tail(opened.value, 9'000, buffer, read, done);
+    done.wait();
+    REQUIRE(!read);
+    REQUIRE(read.value == 1'000);
+    REQUIRE(std::memcmp(buffer.data(), source.contents.data() + 9'000, 1'000) == 0);
+
+    std::latch past_end{ 1 };
+    read_tail(opened.value, 10'000, buffer, read, past_end);
+    past_end.wait();
+    REQUIRE(!read);
+    REQUIRE(read.value == 0);
+
+    // submitted from threads outside the pool
+    constexpr size_t readers = 4;
+    std::vector<std::vector<std::byte>> buffers(readers, std::vector<std::byte>(1000));
+    std::vector<w::result<size_t>> reads(readers);
+    std::latch outside{ readers };
+    {
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < readers; ++i) {
+            threads.emplace_back([&, i] { read_here(opened.value, i * 1000, buffers[i], reads[i], outside); });
+        }
+    }
+    outside.wait();
+    for (size_t i = 0; i < readers; ++i) {
+        REQUIRE(!reads[i]);
+        REQUIRE(reads[i].value == 1000);
+        REQUIRE(std::memcmp(buffers[i].data(), source.contents.data() + i * 1000, 1000) == 0);
+    }
+}
+
+TEST_CASE("io_ring_wakes_again_after_a_reap")
+{
+    w::base::io_ring ring{ +[](void*) noexcept {}, nullptr };
+    if (!ring.can_wait()) {
+        return; // the fallback thread has nothing to wake
+    }
+    // the wake nop may be reaped by any worker, not only the one waiting in the ring
+    for (int i = 0; i < 3; ++i) {
+        ring.wake();
+        REQUIRE(ring.has_completions());
+        REQUIRE(ring.reap() == nullptr);
+        REQUIRE(!ring.has_completions());
+    }
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+#include <math/batch.h>
+#include <math/matrix_math.h>
+#include <math/simd.h>
+#include <cmath>
+#include <vector>
+
+using namespace w::math;
+
+namespace {
+// deterministic values in [-2, 2)
+struct value_source {
+    uint32_t state = 1234;
+    float next() noexcept
+    {
+        state = state * 1664525u + 1013904223u;
+        return float(state >> 8) / float(1 << 22) - 2.0f;
+    }
+    float4x4a next_matrix() noexcept
+    {
+        float4x4a result;
+        for (auto& row : result.r) {
+            for (auto& v : row) {
+                v = next();
+            }
+        }
+        return result;
+    }
+};
+
+bool near(float a, float b) noexcept
+{
+    return std::abs(a - b) <= 1e-5f * std::max(1.0f, std::abs(b));
+}
+
+bool near(const float4x4a& a, const float4x4a& b) noexcept
+{
+    for (size_t r = 0; r < 4; ++r) {
+        for (size_t c = 0; c < 4; ++c) {
+            if (!near(a.r[r][c], b.r[r][c])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// every level the cpu supports, the batch functions have to agree on all of them
+std::vector<simd_level> levels()
+{
+    std::vector<simd_level> result;
+    for (auto level : { simd_level::sse41, simd_level::avx2, simd_level::avx512 }) {
+        if (level <= supported_simd_level()) {
+            result.push_back(level);
+        }
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("multiply_batch_matches_multiply")
+{
+    value_source values;
+    constexpr size_t count = 37; // not a multiple of 8 or 16
+    std::vector<float4x4a> a(count), b(count), expected(count), expected_parent(count);
+    for (size_t i = 0; i < count; ++i) {
+        a[i] = values.next_matrix();
+        b[i] = values.next_matrix();
+    }
+    float4x4a parent = values.next_matrix();
+    for (size_t i = 0; i < count; ++i) {
+        expected[i] = multiply(a[i], b[i]);
+        expected_parent[i] = multiply(a[i], parent);
+    }
+
+    for (auto level : levels()) {
+        force_simd_level(level);
+        std::vector<float4x4a> out(count);
+        multiply_batch(a, b, out);
+        for (size_t i = 0; i < count; ++i) {
+            REQUIRE(near(out[i], expected[i]));
+        }
+        multiply_batch(a, parent, out);
+        for (size_t i = 0; i < count; ++i) {
+            REQUIRE(near(out[i], expected_parent[i]));
+        }
+
+        // the same data as structure of arrays, in place
+        std::vector<float> a_soa(16 * count), b_soa(16 * count);
+        float4x4_soa a_view, b_view;
+        for (size_t e = 0; e < 16; ++e) {
+            a_view.m[e] = std::span{ a_soa }.subspan(e * count, count);
+            b_view.m[e] = std::span{ b_soa }.subspan(e * count, count);
+            for (size_t i = 0; i < count; ++i) {
+                a_view.m[e][i] = a[i].r[e / 4][e % 4];
+                b_view.m[e][i] = b[i].r[e / 4][e % 4];
+            }
+        }
+        multiply_batch(a_view, b_view, a_view);
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t e = 0; e < 16; ++e) {
+                REQUIRE(near(a_view.m[e][i], expected[i].r[e / 4][e % 4]));
+            }
+        }
+    }
+    force_simd_level(supported_simd_level());
+}
+
+TEST_CASE("transform_points_matches_transform")
+{
+    value_source values;
+    constexpr size_t count = 53;
+    matrix m = values.next_matrix();
+    std::vector<float3> points(count), expected(count);
+    for (size_t i = 0; i < count; ++i) {
+        points[i] = { values.next(), values.next(), values.next() };
+        expected[i] = transform(m, vector(points[i]));
+    }
+
+    for (auto level : levels()) {
+        force_simd_level(level);
+        std::vector<float3> out(count);
+        transform_points(points, m, out);
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t c = 0; c < 3; ++c) {
+                REQUIRE(near(out[i][c], expected[i][c]));
+            }
+        }
+
+        std::vector<float> x(count), y(count), z(count);
+        for (size_t i = 0; i < count; ++i) {
+            x[i] = points[i][0];
+            y[i] = points[i][1];
+            z[i] = points[i][2];
+        }
+        float3_soa soa{ x, y, z };
+        transform_points(soa, m, soa);
+        for (size_t i = 0; i < count; ++i) {
+            REQUIRE(near(x[i], expected[i][0]));
+            REQUIRE(near(y[i], expected[i][1]));
+            REQUIRE(near(z[i], expected[i][2]));
+        }
+    }
+    force_simd_level(supported_simd_level());
+}
@@ -0,0 +1,181 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/thread_pool.h>
+#include <ecs/camera.h>
+#include <math/culling.h>
+#include <math/simd.h>
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+using namespace w::math;
+
+namespace {
+bool near(vector a, vector b, float tolerance = 1e-5f)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        if (!(std::abs(a[i] - b[i]) <= tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// camera at the origin looking down +z, 90 degrees wide, depth from 1 to 100
+frustum test_frustum()
+{
+    matrix view = look_to(vector(0.0f, 0.0f, 0.0f, 0.0f), identity[2], identity[1]);
+    return frustum(multiply(view, perspective(std::numbers::pi_v<float> / 2, 1.0f, 1.0f, 100.0f)));
+}
+
+// smallest signed distance to the planes in double, the batches may round differently close to 0
+double margin(const frustum& f, const aabb& box)
+{
+    double nearest = INFINITY;
+    for (const auto& p : f.planes) {
+        double distance = p[3];
+        for (size_t i = 0; i < 3; ++i) {
+            distance += double(p[i]) * box.center[i] + std::abs(double(p[i])) * box.extents[i];
+        }
+        nearest = std::min(nearest, distance);
+    }
+    return nearest;
+}
+double margin(const frustum& f, const bounding_sphere& sphere)
+{
+    return margin(f, aabb{ sphere.center, {} }) + sphere.radius;
+}
+
+struct scene {
+    std::vector<aabb> boxes;
+    std::vector<bounding_sphere> spheres;
+};
+scene random_scene(size_t count)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-150.0f, 150.0f), size(0.1f, 10.0f);
+    scene s;
+    for (size_t i = 0; i < count; ++i) {
+        float3 center{ position(rng), position(rng), position(rng) };
+        s.boxes.push_back({ center, { size(rng), size(rng), size(rng) } });
+        s.spheres.push_back({ center, size(rng) });
+    }
+    return s;
+}
+
+template<typename T>
+void check_matches_intersects(const frustum& f, const std::vector<T>& objects, const std::vector<uint8_t>& visible)
+{
+    for (size_t i = 0; i < objects.size(); ++i) {
+        if (std::abs(margin(f, objects[i])) > 1e-3) {
+            REQUIRE(visible[i] == uint8_t(intersects(f, objects[i])));
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("frustum_planes")
+{
+    // the view moves eye + direction onto the z axis
+    vector eye(1.0f, 2.0f, 3.0f, 0.0f);
+    matrix view = look_to(eye, identity[0], identity[1]);
+    REQUIRE(near(transform(view, eye + identity[0] * 5.0f), vector(0.0f, 0.0f, 5.0f, 1.0f)));
+    REQUIRE(near(transform(view, eye + identity[1]), vector(0.0f, 1.0f, 0.0f, 1.0f)));
+
+    frustum f = test_frustum();
+    REQUIRE(near(f.planes[frustum::near_plane], vector(0.0f, 0.0f, 1.0f, -1.0f)));
+    REQUIRE(near(f.planes[frustum::far_plane], vector(0.0f, 0.0f, -1.0f, 100.0f), 1e-3f));
+    float d = std::sqrt(0.5f);
+    REQUIRE(near(f.planes[frustum::left_plane], vector(d, 0.0f, d, 0.0f)));
+    REQUIRE(near(f.planes[frustum::top_plane], vector(0.0f, -d, d, 0.0f)));
+
+    auto box = [](float x, float y, float z, float e) { return aabb{ { x, y, z }, { e, e, e } }; };
+    REQUIRE(intersects(f, box(0, 0, 10, 1)));
+    REQUIRE(!intersects(f, box(0, 0, -10, 1)));
+    REQUIRE(!intersects(f, box(-50, 0, 10, 1)));
+    REQUIRE(!intersects(f, box(0, 0, 200, 1)));
+    REQUIRE(intersects(f, box(-12, 0, 10, 3))); // straddles the left plane
+    REQUIRE(intersects(f, box(0, 0, 0, 2))); // contains the near plane
+    REQUIRE(!intersects(f, box(0, 30, 10, 1)));
+
+    REQUIRE(intersects(f, bounding_sphere{ { 0, 0, 10 }, 1 }));
+    REQUIRE(intersects(f, bounding_sphere{ { -12, 0, 10 }, 2 }));
+    REQUIRE(!intersects(f, bounding_sphere{ { -12, 0, 10 }, 1 }));
+    REQUIRE(!intersects(f, bounding_sphere{ { 0, 0, -3 }, 1 }));
+
+    // the camera builds the same planes
+    w::ecs::camera camera;
+    camera.set_position(vector(0.0f, 0.0f, 0.0f, 0.0f));
+    camera.set_rotation(quaternion(identity[3]));
+    camera.set_perspective(std::numbers::pi_v<float> / 2, 1.0f, 1.0f, 100.0f);
+    frustum from_camera = camera.get_frustum();
+    for (size_t i = 0; i < frustum::plane_count; ++i) {
+        REQUIRE(near(from_camera.planes[i], f.planes[i], 1e-4f));
+    }
+}
+
+TEST_CASE("bounds_transform")
+{
+    matrix m = multiply(multiply(scale(vector(2.0f, 1.0f, 1.0f, 0.0f)), matrix(quaternion::from_angle_axis_normal(std::numbers::pi_v<float> / 2, identity[2]))), translate(vector(10.0f, 0.0f, 0.0f, 0.0f)));
+
+    aabb box = transform(m, aabb{ { 1, 0, 0 }, { 1, 2, 3 } });
+    REQUIRE(near(vector(box.center), vector(10.0f, 2.0f, 0.0f, 0.0f)));
+    REQUIRE(near(vector(box.extents), vector(2.0f, 2.0f, 3.0f, 0.0f)));
+
+    bounding_sphere sphere = transform(m, bounding_sphere{ { 1, 0, 0 }, 1.5f });
+    REQUIRE(near(vector(sphere.center), vector(10.0f, 2.0f, 0.0f, 0.0f)));
+    REQUIRE(std::abs(sphere.radius - 3.0f) < 1e-5f);
+
+    aabb from_points = aabb::from_min_max(vector(-1.0f, 0.0f, 2.0f, 0.0f), vector(3.0f, 4.0f, 2.0f, 0.0f));
+    REQUIRE(near(vector(from_points.center), vector(1.0f, 2.0f, 2.0f, 0.0f)));
+    REQUIRE(near(vector(from_points.extents), vector(2.0f, 2.0f, 0.0f, 0.0f)));
+}
+
+TEST_CASE("cull_matches_intersects")
+{
+    frustum f = test_frustum();
+    scene s = random_scene(1027);
+
+    for (auto level : { simd_level::sse41, simd_level::avx2, simd_level::avx512 }) {
+        if (level > supported_simd_level()) {
+            continue;
+        }
+        force_simd_level(level);
+
+        // every tail length of the 8 wide kernels
+        for (size_t count : { size_t(0), size_t(5), size_t(8), size_t(13), s.boxes.size() }) {
+            std::vector<uint8_t> visible(count, 0xff);
+            cull(std::span{ s.boxes }.first(count), f, visible);
+            check_matches_intersects(f, std::vector(s.boxes.begin(), s.boxes.begin() + count), visible);
+
+            std::fill(visible.begin(), visible.end(), 0xff);
+            cull(std::span{ s.spheres }.first(count), f, visible);
+            check_matches_intersects(f, std::vector(s.spheres.begin(), s.spheres.begin() + count), visible);
+        }
+    }
+    force_simd_level(supported_simd_level());
+}
+
+TEST_CASE("cull_parallel_matches_cull")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 4, .pin_threads = false });
+
+    frustum f = test_frustum();
+    scene s = random_scene(cull_chunk_size * 3 + 100);
+    std::vector<uint8_t> expected(s.boxes.size()), visible(s.boxes.size(), 0xff);
+
+    cull(s.boxes, f, expected);
+    cull_parallel(s.boxes, f, visible).get();
+    REQUIRE(visible == expected);
+
+    cull(s.spheres, f, expected);
+    std::fill(visible.begin(), visible.end(), 0xff);
+    cull_parallel(s.spheres, f, visible).get();
+    REQUIRE(visible == expected);
+
+    // a single chunk stays on this thread
+    std::vector<uint8_t> small(100, 0xff);
+    cull_parallel(std::span{ s.spheres }.first(100), f, small).get();
+    REQUIRE(std::equal(small.begin(), small.end(), expected.begin()));
+}
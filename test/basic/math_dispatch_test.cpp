@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+#include <math/matrix_math.h>
+#include <math/quaternion.h>
+#include <math/simd.h>
+#include <cmath>
+#include <vector>
+
+using namespace w::math;
+
+namespace {
+// plain loops over float4x4, independent of the kernels under test
+float4x4 reference_multiply(const float4x4& a, const float4x4& b)
+{
+    float4x4 result;
+    for (size_t r = 0; r < 4; ++r) {
+        for (size_t c = 0; c < 4; ++c) {
+            result.r[r][c] = a.r[r][0] * b.r[0][c] + a.r[r][1] * b.r[1][c] + a.r[r][2] * b.r[2][c] + a.r[r][3] * b.r[3][c];
+        }
+    }
+    return result;
+}
+
+// the components past the count are treated as 0, w as 1 unless all four are used
+float4 reference_transform(const float4x4& m, const float4& v, size_t components)
+{
+    float4 result;
+    for (size_t c = 0; c < 4; ++c) {
+        result[c] = components < 4 ? m.r[3][c] : 0.0f;
+        for (size_t i = 0; i < components; ++i) {
+            result[c] += v[i] * m.r[i][c];
+        }
+    }
+    return result;
+}
+
+// rotation for row vectors, v * m
+float4x4 reference_rotation(const float4& q)
+{
+    float x = q[0], y = q[1], z = q[2], w = q[3];
+    return {
+        1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0,
+        2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0,
+        2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0,
+        0, 0, 0, 1
+    };
+}
+
+// expansion along the first row
+float reference_determinant(const float4x4& m)
+{
+    auto minor = [&](size_t column) {
+        float r[3][3];
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0, k = 0; j < 4; ++j) {
+                if (j != column) {
+                    r[i][k++] = m.r[i + 1][j];
+                }
+            }
+        }
+        return r[0][0] * (r[1][1] * r[2][2] - r[1][2] * r[2][1])
+                - r[0][1] * (r[1][0] * r[2][2] - r[1][2] * r[2][0])
+                + r[0][2] * (r[1][0] * r[2][1] - r[1][1] * r[2][0]);
+    };
+    return m.r[0][0] * minor(0) - m.r[0][1] * minor(1) + m.r[0][2] * minor(2) - m.r[0][3] * minor(3);
+}
+
+bool near(float a, float b, float tolerance)
+{
+    return std::abs(a - b) <= tolerance * std::max(1.0f, std::abs(b));
+}
+
+bool near(float a, float b)
+{
+    return near(a, b, 1e-5f);
+}
+
+bool near(vector a, const float4& b)
+{
+    float4 value = a;
+    for (size_t i = 0; i < 4; ++i) {
+        if (!near(value[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool near(const matrix& a, const float4x4& b)
+{
+    for (size_t r = 0; r < 4; ++r) {
+        if (!near(a.r[r], b.r[r])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct value_source {
+    uint32_t state = 99;
+    float next() noexcept
+    {
+        state = state * 1664525u + 1013904223u;
+        return float(state >> 8) / float(1 << 22) - 2.0f;
+    }
+    float4 next_vector() noexcept
+    {
+        return { next(), next(), next(), next() };
+    }
+    float4x4 next_matrix() noexcept
+    {
+        return { next_vector(), next_vector(), next_vector(), next_vector() };
+    }
+};
+} // namespace
+
+TEST_CASE("simd_levels_match")
+{
+    REQUIRE(active_simd_level() == supported_simd_level());
+
+    for (auto level : { simd_level::sse41, simd_level::avx2, simd_level::avx512 }) {
+        if (level > supported_simd_level()) {
+            continue;
+        }
+        force_simd_level(level);
+        REQUIRE(active_simd_level() == level);
+
+        value_source values;
+        for (int i = 0; i < 64; ++i) {
+            float4x4 a = values.next_matrix();
+            float4x4 b = values.next_matrix();
+            REQUIRE(near(multiply(a, b), reference_multiply(a, b)));
+
+            float4x4 t = transpose(a);
+            for (size_t r = 0; r < 4; ++r) {
+                for (size_t c = 0; c < 4; ++c) {
+                    REQUIRE(t.r[r][c] == a.r[c][r]);
+                }
+            }
+
+            float4 v = values.next_vector();
+            REQUIRE(near(transform<1>(a, v), reference_transform(a, v, 1)));
+            REQUIRE(near(transform<2>(a, v), reference_transform(a, v, 2)));
+            REQUIRE(near(transform<3>(a, v), reference_transform(a, v, 3)));
+            REQUIRE(near(transform<4>(a, v), reference_transform(a, v, 4)));
+
+            float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+            float4 unit{ v[0] / length, v[1] / length, v[2] / length, v[3] / length };
+            REQUIRE(near(matrix(quaternion{ unit }), reference_rotation(unit)));
+
+            float det = reference_determinant(a);
+            REQUIRE(near(float(determinant(a)), det, 1e-4f));
+            if (std::abs(det) > 0.1f) {
+                vector inverse_det;
+                float4x4 product = multiply(inverse(a, &inverse_det), a);
+                REQUIRE(near(float(inverse_det), det, 1e-4f));
+                for (size_t r = 0; r < 4; ++r) {
+                    for (size_t c = 0; c < 4; ++c) {
+                        REQUIRE(std::abs(product.r[r][c] - (r == c ? 1.0f : 0.0f)) < 1e-3f);
+                    }
+                }
+            }
+        }
+    }
+
+    // forcing past the cpu is clamped
+    force_simd_level(simd_level::avx512);
+    REQUIRE(active_simd_level() == supported_simd_level());
+}
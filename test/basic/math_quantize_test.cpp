@@ -0,0 +1,191 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ecs/components.h>
+#include <math/quantize.h>
+#include <math/simd.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace w::math;
+
+namespace {
+std::vector<simd_level> levels()
+{
+    std::vector<simd_level> result;
+    for (auto level : { simd_level::sse41, simd_level::avx2, simd_level::avx512 }) {
+        if (level <= supported_simd_level()) {
+            result.push_back(level);
+        }
+    }
+    return result;
+}
+
+// largest component error, q and -q are the same rotation
+float quaternion_error(const float4& a, const float4& b)
+{
+    float same = 0.0f, flipped = 0.0f;
+    for (size_t i = 0; i < 4; ++i) {
+        same = std::max(same, std::abs(a[i] - b[i]));
+        flipped = std::max(flipped, std::abs(a[i] + b[i]));
+    }
+    return std::min(same, flipped);
+}
+
+// uniform unit quaternions plus the corner cases of the largest component
+std::vector<float4> test_quaternions(size_t count)
+{
+    std::vector<float4> result = {
+        { 0.0f, 0.0f, 0.0f, 1.0f },
+        { 0.0f, 0.0f, 0.0f, -1.0f },
+        { -1.0f, 0.0f, 0.0f, 0.0f },
+        { 0.5f, -0.5f, 0.5f, -0.5f }, // all tied
+        { -0.5f, 0.5f, -0.5f, 0.5f },
+        { 0.70710677f, 0.0f, -0.70710677f, 0.0f },
+    };
+    std::mt19937 rng(11);
+    std::normal_distribution<float> normal;
+    while (result.size() < count) {
+        float x = normal(rng), y = normal(rng), z = normal(rng), w = normal(rng);
+        float length = std::sqrt(x * x + y * y + z * z + w * w);
+        result.push_back({ x / length, y / length, z / length, w / length });
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("half_conversion")
+{
+    REQUIRE(to_half(1.0f) == 0x3c00);
+    REQUIRE(to_half(-2.0f) == 0xc000);
+    REQUIRE(to_half(65504.0f) == 0x7bff);
+    REQUIRE(to_half(65520.0f) == 0x7c00); // rounds up to infinity
+    REQUIRE(to_half(std::ldexp(1.0f, -24)) == 0x0001); // smallest denormal
+    REQUIRE(to_half(std::ldexp(1.0f, -26)) == 0x0000);
+    REQUIRE(to_half(1.0f + std::ldexp(1.0f, -11)) == 0x3c00); // tie to even
+    REQUIRE(to_half(1.0f + 3 * std::ldexp(1.0f, -11)) == 0x3c02);
+    REQUIRE(to_half(-std::numeric_limits<float>::infinity()) == 0xfc00);
+    REQUIRE(std::isnan(from_half(to_half(std::numeric_limits<float>::quiet_NaN()))));
+
+    // every half but NaN survives the way through float
+    for (uint32_t h = 0; h < 0x10000; ++h) {
+        if ((h & 0x7c00) != 0x7c00 || (h & 0x3ff) == 0) {
+            REQUIRE(to_half(from_half(uint16_t(h))) == h);
+        }
+    }
+
+    // the batches match the single conversions bit for bit
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> exponent(-30.0f, 20.0f);
+    std::vector<float3> scales(1001);
+    for (auto& s : scales) {
+        for (size_t c = 0; c < 3; ++c) {
+            s[c] = std::exp2(exponent(rng)) * (rng() % 2 ? 1.0f : -1.0f);
+        }
+    }
+    scales[5] = { std::numeric_limits<float>::infinity(), 0.0f, -0.0f };
+    for (auto level : levels()) {
+        force_simd_level(level);
+        std::vector<half3> packed(scales.size());
+        std::vector<float3> unpacked(scales.size());
+        pack_batch(scales, packed);
+        unpack_batch(packed, unpacked);
+        for (size_t i = 0; i < scales.size(); ++i) {
+            for (size_t c = 0; c < 3; ++c) {
+                float value = scales[i][c];
+                REQUIRE(packed[i].bits[c] == to_half(value));
+                REQUIRE(std::bit_cast<uint32_t>(unpacked[i][c]) == std::bit_cast<uint32_t>(from_half(packed[i].bits[c])));
+                if (std::abs(value) >= 6.1e-5f && std::abs(value) <= 65504.0f) {
+                    REQUIRE(std::abs(unpacked[i][c] - value) <= half_max_relative_error * std::abs(value));
+                }
+            }
+        }
+    }
+    force_simd_level(supported_simd_level());
+}
+
+TEST_CASE("quaternion_packing")
+{
+    auto rotations = test_quaternions(1003); // not a multiple of 8
+    float error32 = 0.0f, error48 = 0.0f;
+    for (const auto& q : rotations) {
+        error32 = std::max(error32, quaternion_error(unpack(pack32(quaternion(q))), q));
+        error48 = std::max(error48, quaternion_error(unpack(pack48(quaternion(q))), q));
+    }
+    REQUIRE(error32 <= packed_quat32_max_error);
+    REQUIRE(error48 <= packed_quat48_max_error);
+    // the bounds are tight enough to mean something
+    REQUIRE(error32 > packed_quat32_max_error / 4);
+    REQUIRE(error48 > packed_quat48_max_error / 4);
+
+    for (auto level : levels()) {
+        force_simd_level(level);
+        std::vector<packed_quat32> packed32(rotations.size());
+        std::vector<packed_quat48> packed48(rotations.size());
+        std::vector<float4> unpacked32(rotations.size()), unpacked48(rotations.size());
+        pack_batch(rotations, packed32);
+        pack_batch(rotations, packed48);
+        unpack_batch(packed32, unpacked32);
+        unpack_batch(packed48, unpacked48);
+        for (size_t i = 0; i < rotations.size(); ++i) {
+            REQUIRE(quaternion_error(unpacked32[i], rotations[i]) <= packed_quat32_max_error);
+            REQUIRE(quaternion_error(unpacked48[i], rotations[i]) <= packed_quat48_max_error);
+            // the codes of the batches decode like the single ones
+            REQUIRE(quaternion_error(unpacked32[i], unpack(packed32[i])) <= 1e-6f);
+            REQUIRE(quaternion_error(unpacked48[i], unpack(packed48[i])) <= 1e-6f);
+        }
+    }
+    force_simd_level(supported_simd_level());
+}
+
+TEST_CASE("position_packing")
+{
+    position_cell cell{ { 100.0f, -50.0f, 3.0f }, 64.0f };
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> offset(-64.0f, 64.0f);
+    std::vector<float3> positions(1001);
+    for (auto& p : positions) {
+        p = { cell.origin[0] + offset(rng), cell.origin[1] + offset(rng), cell.origin[2] + offset(rng) };
+    }
+    positions[7] = { 1000.0f, -1000.0f, 67.0f }; // clamped to the cube
+
+    // the rounding of origin + offset adds half an ulp of the position
+    float tolerance = cell.max_error() + std::ldexp(1.0f, -17);
+    for (auto level : levels()) {
+        force_simd_level(level);
+        std::vector<packed_position> packed(positions.size());
+        std::vector<float3> unpacked(positions.size());
+        pack_batch(positions, cell, packed);
+        unpack_batch(packed, cell, unpacked);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            REQUIRE(packed[i].value == pack(positions[i], cell).value);
+            vector single = unpack(packed[i], cell);
+            for (size_t c = 0; c < 3; ++c) {
+                float clamped = std::clamp(positions[i][c], cell.origin[c] - cell.extent, cell.origin[c] + cell.extent);
+                REQUIRE(std::abs(unpacked[i][c] - clamped) <= tolerance);
+                REQUIRE(std::abs(single[c] - clamped) <= tolerance);
+            }
+        }
+    }
+    force_simd_level(supported_simd_level());
+}
+
+TEST_CASE("packed_transform")
+{
+    position_cell cell{ { 0.0f, 0.0f, 0.0f }, 256.0f };
+    w::ecs::position p{ { 10.5f, -200.25f, 3.0f } };
+    w::ecs::rotation r{ { 0.0f, 0.70710677f, 0.0f, 0.70710677f } };
+    w::ecs::scale s{ { 1.0f, 2.5f, 0.125f } };
+
+    auto packed = w::ecs::pack(p, r, s, cell);
+    w::ecs::position p2;
+    w::ecs::rotation r2;
+    w::ecs::scale s2;
+    w::ecs::unpack(packed, cell, p2, r2, s2);
+    for (size_t c = 0; c < 3; ++c) {
+        REQUIRE(std::abs(p2.value[c] - p.value[c]) <= cell.max_error() + 1e-5f);
+        REQUIRE(s2.value[c] == s.value[c]); // exact in half
+    }
+    REQUIRE(quaternion_error(r2.value, r.value) <= packed_quat32_max_error);
+}
@@ -2,6 +2,7 @@
 #include <math/matrix_math.h>
 #include <math/quaternion_math.h>
 #include <ecs/camera.h>
+#include <cmath>
 
 using namespace w::math;
 
@@ -86,4 +87,100 @@ TEST_CASE("matrix_mul")
     auto v7 = transform(m4, scale_vector4);
 
     REQUIRE(equal(v7, v8));
-}
\ No newline at end of file
+}
+template<size_t Components = 4>
+static bool near(vector a, vector b)
+{
+    for (size_t i = 0; i < Components; ++i) {
+        if (!(std::abs(a[i] - b[i]) <= 1e-5f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("quaternion_conversions")
+{
+    constexpr vector z_axis{ 0.0f, 0.0f, 1.0f, 0.0f };
+    for (float angle : { -2.5f, 0.0f, 0.3f, 1.0f, 3.0f }) {
+        vector expected{ 0.0f, 0.0f, std::sin(angle * 0.5f), std::cos(angle * 0.5f) };
+        REQUIRE(near(quaternion::from_angle_axis_normal(angle, z_axis), expected));
+        REQUIRE(near(pitch_yaw_roll(vector(0.0f, 0.0f, angle, 0.0f)), expected));
+
+        quaternion identity_rotation = quaternion::from_angle_axis_normal(0.0f, z_axis);
+        quaternion rotation = quaternion::from_angle_axis_normal(angle + 0.1f, z_axis);
+        REQUIRE(near(slerp(identity_rotation, rotation, 0.0f), identity_rotation));
+        REQUIRE(near(slerp(identity_rotation, rotation, 1.0f), rotation));
+        REQUIRE(near(slerp(identity_rotation, rotation, 0.5f), quaternion::from_angle_axis_normal((angle + 0.1f) * 0.5f, z_axis)));
+    }
+
+    for (vector v : { vector(1.0f, 2.0f, 3.0f, 0.0f), vector(-1.0f, 0.5f, -2.0f, 0.0f), vector(-3.0f, -4.0f, 0.0f, 0.0f) }) {
+        REQUIRE(near<3>(spherical<>(v).to_cartesian(), v));
+        vector v2 = _mm_blend_ps(v, _mm_setzero_ps(), 0b1100);
+        REQUIRE(near(polar<>(v2).to_cartesian(), v2));
+    }
+}
+
+static bool near(const matrix& a, const matrix& b, float tolerance = 1e-5f)
+{
+    for (size_t r = 0; r < 4; ++r) {
+        for (size_t c = 0; c < 4; ++c) {
+            if (!(std::abs(a[r][c] - b[r][c]) <= tolerance * std::max(1.0f, std::abs(b[r][c])))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void test_inverse_constexpr()
+{
+    constexpr matrix m = multiply(scale(vector(2.0f, 4.0f, 0.5f, 1.0f)), translate(vector(1.0f, -2.0f, 3.0f, 0.0f)));
+    static_assert(determinant(m)[0] == 4.0f);
+    constexpr matrix i = inverse(m);
+    static_assert(i[0][0] == 0.5f && i[1][1] == 0.25f && i[2][2] == 2.0f);
+    static_assert(i[3][0] == -0.5f && i[3][1] == 0.5f && i[3][2] == -6.0f && i[3][3] == 1.0f);
+    constexpr matrix a = inverse_affine(m);
+    static_assert(a[0][0] == 0.5f && a[3][2] == -6.0f && a[3][3] == 1.0f);
+
+    constexpr matrix p = perspective(1.5707963f, 2.0f, 0.1f, 100.0f);
+    static_assert(p[1][1] > 0.99999f && p[1][1] < 1.00001f);
+    static_assert(p[0][0] > 0.49999f && p[0][0] < 0.50001f);
+    constexpr matrix o = orthographic(4.0f, 2.0f, 1.0f, 3.0f);
+    static_assert(o[0][0] == 0.5f && o[2][2] == 0.5f && o[3][2] == -0.5f);
+}
+
+TEST_CASE("matrix_inverse")
+{
+    constexpr vector z_axis{ 0.0f, 0.0f, 1.0f, 0.0f };
+    constexpr vector x_axis{ 1.0f, 0.0f, 0.0f, 0.0f };
+    for (float angle : { 0.0f, 0.4f, 2.0f, -1.3f }) {
+        // scale, rotation and translation like transform::world_matrix
+        matrix srt = multiply(multiply(scale(vector(1.5f, 0.5f, 2.0f, 1.0f)),
+                                       multiply(quaternion::from_angle_axis_normal(angle, z_axis), quaternion::from_angle_axis_normal(angle * 0.5f, x_axis))),
+                              translate(vector(angle, 3.0f, -2.0f, 1.0f)));
+        matrix general = inverse(srt);
+        matrix affine = inverse_affine(srt);
+        REQUIRE(near(affine, general, 1e-4f));
+        REQUIRE(near(multiply(srt, affine), identity, 1e-5f));
+        REQUIRE(std::abs(float(determinant(srt)) - 1.5f * 0.5f * 2.0f) < 1e-5f);
+    }
+
+    // projections against the general inverse, and a point through the pair
+    matrix p = perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    REQUIRE(near(inverse_perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f), inverse(p), 1e-4f));
+    vector clip = transform(p, vector(0.0f, 0.0f, 0.1f, 1.0f));
+    REQUIRE(std::abs(clip[2] / clip[3]) < 1e-6f); // near plane at depth 0
+    clip = transform(p, vector(0.0f, 0.0f, 1000.0f, 1.0f));
+    REQUIRE(std::abs(clip[2] / clip[3] - 1.0f) < 1e-6f); // far plane at depth 1
+
+    vector point(1.0f, -2.0f, 7.0f, 1.0f);
+    vector back = transform<4>(inverse_perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f), transform<4>(p, point));
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(std::abs(back[i] / back[3] - point[i]) < 1e-4f);
+    }
+
+    matrix o = orthographic(8.0f, 6.0f, 0.5f, 50.0f);
+    REQUIRE(near(inverse_orthographic(8.0f, 6.0f, 0.5f, 50.0f), inverse(o), 1e-5f));
+    REQUIRE(near(multiply(o, inverse_orthographic(8.0f, 6.0f, 0.5f, 50.0f)), identity));
+}
@@ -0,0 +1,219 @@
+#include <catch2/catch_test_macros.hpp>
+#include <math/simd.h>
+#include <math/transcendental.h>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace w::math;
+
+namespace {
+// distance in representable floats, 0 for equal values and for two NaN
+int64_t ulp_distance(float a, float b)
+{
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b) ? 0 : std::numeric_limits<int64_t>::max();
+    }
+    auto ordered = [](float f) {
+        int32_t bits = std::bit_cast<int32_t>(f);
+        return bits < 0 ? int64_t(std::numeric_limits<int32_t>::min()) - bits : int64_t(bits);
+    };
+    return std::abs(ordered(a) - ordered(b));
+}
+
+// error against the double precision reference in ulp,
+// results closer to 0 than near_zero only count their absolute error
+struct accuracy {
+    double near_zero = 0;
+    int64_t max_ulp = 0;
+    float worst_input = 0;
+    double max_absolute = 0;
+
+    void check(float input, float value, double reference)
+    {
+        if (std::abs(reference) < near_zero) {
+            max_absolute = std::max(max_absolute, std::abs(double(value) - reference));
+            return;
+        }
+        int64_t ulp = ulp_distance(value, float(reference));
+        if (ulp > max_ulp) {
+            max_ulp = ulp;
+            worst_input = input;
+        }
+    }
+};
+
+// evenly spaced samples plus every float in a window around each end
+std::vector<float> samples(float first, float last, size_t count = 1 << 16)
+{
+    std::vector<float> result;
+    for (size_t i = 0; i <= count; ++i) {
+        result.push_back(first + (last - first) * float(double(i) / double(count)));
+    }
+    for (float f = first, g = last; result.size() < count + 1024; f = std::nextafter(f, last), g = std::nextafter(g, first)) {
+        result.push_back(f);
+        result.push_back(g);
+    }
+    return result;
+}
+
+template<typename F>
+std::vector<float> evaluate(const std::vector<float>& in, F&& f)
+{
+    std::vector<float> out(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        out[i] = float(f(vector(in[i], broadcast)));
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("transcendental_accuracy")
+{
+    SECTION("sin_cos")
+    {
+        // the reduction error only shows near the zeros of the larger arguments
+        for (float range : { 64.0f, 8192.0f }) {
+            accuracy s{ range > 64.0f ? 1.0 / 4096 : 0.0 }, c = s;
+            for (float x : samples(-range, range, 1 << 20)) {
+                auto [sv, cv] = sincos(vector(x, broadcast));
+                REQUIRE(float(sv) == float(sin(vector(x, broadcast))));
+                REQUIRE(float(cv) == float(cos(vector(x, broadcast))));
+                s.check(x, float(sv), std::sin(double(x)));
+                c.check(x, float(cv), std::cos(double(x)));
+            }
+            INFO("sin " << s.max_ulp << " ulp at " << s.worst_input << ", cos " << c.max_ulp << " ulp at " << c.worst_input);
+            REQUIRE(s.max_ulp <= 2);
+            REQUIRE(c.max_ulp <= 2);
+            REQUIRE(s.max_absolute <= 2e-7);
+            REQUIRE(c.max_absolute <= 2e-7);
+        }
+        REQUIRE(float(sin(vector(0.0f, broadcast))) == 0.0f);
+        REQUIRE(float(cos(vector(0.0f, broadcast))) == 1.0f);
+    }
+    SECTION("acos")
+    {
+        accuracy a;
+        auto in = samples(-1.0f, 1.0f);
+        auto out = evaluate(in, [](vector v) { return acos(v); });
+        for (size_t i = 0; i < in.size(); ++i) {
+            a.check(in[i], out[i], std::acos(double(in[i])));
+        }
+        INFO("acos " << a.max_ulp << " ulp at " << a.worst_input);
+        REQUIRE(a.max_ulp <= 2);
+        REQUIRE(std::isnan(float(acos(vector(1.5f, broadcast)))));
+    }
+    SECTION("atan2")
+    {
+        accuracy a;
+        for (float angle : samples(-3.2f, 3.2f, 1 << 12)) {
+            for (float radius : { 1e-30f, 0.5f, 1.0f, 3.0f, 1e20f }) {
+                float y = radius * std::sin(angle), x = radius * std::cos(angle);
+                a.check(angle, float(atan2(vector(y, broadcast), vector(x, broadcast))), std::atan2(double(y), double(x)));
+            }
+        }
+        INFO("atan2 " << a.max_ulp << " ulp at angle " << a.worst_input);
+        REQUIRE(a.max_ulp <= 3);
+
+        // signed zeros and the axes
+        for (float y : { 0.0f, -0.0f, 1.0f, -1.0f }) {
+            for (float x : { 0.0f, -0.0f, 1.0f, -1.0f }) {
+                REQUIRE(float(atan2(vector(y, broadcast), vector(x, broadcast))) == std::atan2(y, x));
+            }
+        }
+    }
+    SECTION("exp")
+    {
+        accuracy a;
+        auto in = samples(-104.0f, 88.7f, 1 << 20);
+        auto out = evaluate(in, [](vector v) { return exp(v); });
+        for (size_t i = 0; i < in.size(); ++i) {
+            a.check(in[i], out[i], std::exp(double(in[i])));
+        }
+        INFO("exp " << a.max_ulp << " ulp at " << a.worst_input);
+        REQUIRE(a.max_ulp <= 2);
+        REQUIRE(float(exp(vector(0.0f, broadcast))) == 1.0f);
+        REQUIRE(float(exp(vector(-200.0f, broadcast))) == 0.0f);
+        REQUIRE(std::isinf(float(exp(vector(89.0f, broadcast)))));
+        REQUIRE(std::isnan(float(exp(vector(std::numeric_limits<float>::quiet_NaN(), broadcast)))));
+    }
+    SECTION("log")
+    {
+        accuracy a;
+        auto in = samples(0.5f, 2.0f);
+        for (float x : samples(std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::max(), 1 << 20)) {
+            in.push_back(x);
+        }
+        for (float x = 1e-44f; x < 1e30f; x *= 1.37f) {
+            in.push_back(x);
+        }
+        auto out = evaluate(in, [](vector v) { return log(v); });
+        for (size_t i = 0; i < in.size(); ++i) {
+            a.check(in[i], out[i], std::log(double(in[i])));
+        }
+        INFO("log " << a.max_ulp << " ulp at " << a.worst_input);
+        REQUIRE(a.max_ulp <= 2);
+        REQUIRE(float(log(vector(1.0f, broadcast))) == 0.0f);
+        REQUIRE(float(log(vector(0.0f, broadcast))) == -std::numeric_limits<float>::infinity());
+        REQUIRE(float(log(vector(std::numeric_limits<float>::infinity(), broadcast))) == std::numeric_limits<float>::infinity());
+        REQUIRE(std::isnan(float(log(vector(-1.0f, broadcast)))));
+    }
+}
+
+TEST_CASE("transcendental_batch_matches_vector")
+{
+    std::vector<float> in, positive, out(1027), out2(1027);
+    for (size_t i = 0; i < out.size(); ++i) {
+        in.push_back(float(i) * 0.37f - 190.0f);
+        positive.push_back(float(i) * 0.37f + 1e-3f);
+    }
+
+    for (auto level : { simd_level::sse41, simd_level::avx2, simd_level::avx512 }) {
+        if (level > supported_simd_level()) {
+            continue;
+        }
+        force_simd_level(level);
+
+        // the batches may round differently without FMA, but stay within the documented error
+        auto same = [](float batch, vector single) { return ulp_distance(batch, float(single)) <= 1; };
+        auto reference = [&](std::span<const float> values, auto&& f) {
+            for (size_t i = 0; i < out.size(); ++i) {
+                REQUIRE(same(out[i], f(vector(values[i], broadcast))));
+            }
+        };
+
+        sin(in, out);
+        reference(in, [](vector v) { return sin(v); });
+        cos(in, out);
+        reference(in, [](vector v) { return cos(v); });
+        sincos(in, out, out2);
+        for (size_t i = 0; i < out.size(); ++i) {
+            auto [s, c] = sincos(vector(in[i], broadcast));
+            REQUIRE(same(out[i], s));
+            REQUIRE(same(out2[i], c));
+        }
+        acos(std::span{ in }.subspan(500, 10), std::span{ out }.first(10)); // near 0
+        for (size_t i = 0; i < 10; ++i) {
+            REQUIRE(same(out[i], acos(vector(in[500 + i], broadcast))));
+        }
+        atan2(in, positive, out);
+        for (size_t i = 0; i < out.size(); ++i) {
+            REQUIRE(same(out[i], atan2(vector(in[i], broadcast), vector(positive[i], broadcast))));
+        }
+        exp(std::span{ in }.subspan(200), std::span{ out }.first(out.size() - 200));
+        for (size_t i = 0; i + 200 < out.size(); ++i) {
+            REQUIRE(same(out[i], exp(vector(in[200 + i], broadcast))));
+        }
+        log(positive, out);
+        reference(positive, [](vector v) { return log(v); });
+
+        // in place
+        std::vector<float> copy = in;
+        sin(copy, copy);
+        for (size_t i = 0; i < copy.size(); ++i) {
+            REQUIRE(same(copy[i], sin(vector(in[i], broadcast))));
+        }
+    }
+    force_simd_level(supported_simd_level());
+}
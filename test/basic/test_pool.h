@@ -0,0 +1,10 @@
+#pragma once
+#include <base/thread_pool.h>
+
+namespace w::test {
+// small unpinned pool, tests run next to each other and on machines with few cores
+inline w::base::thread_pool_config test_pool_config()
+{
+    return { .worker_count = 4, .pin_threads = false };
+}
+} // namespace w::test
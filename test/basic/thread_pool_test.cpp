@@ -0,0 +1,407 @@
+#include <catch2/catch_test_macros.hpp>
+#include <base/await.h>
+#include <base/thread_pool.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std::chrono_literals;
+using test_clock = std::chrono::steady_clock;
+
+namespace {
+void spin_for(test_clock::duration d)
+{
+    auto end = test_clock::now() + d;
+    while (test_clock::now() < end) {
+        _mm_pause();
+    }
+}
+
+void update_max(std::atomic<int>& max, int value)
+{
+    auto current = max.load(std::memory_order::relaxed);
+    while (current < value && !max.compare_exchange_weak(current, value, std::memory_order::relaxed)) {
+    }
+}
+
+// low tasks that finished between submitting and running a probe
+w::fire_and_forget high_probe(std::atomic<int>& completed, std::atomic<int>& max_overtaken, std::latch& done)
+{
+    int submitted = completed.load(std::memory_order::relaxed);
+    co_await w::resume_background(w::priority::high);
+    update_max(max_overtaken, completed.load(std::memory_order::relaxed) - submitted);
+    done.count_down();
+}
+
+// Binary tree of low priority work, children are pushed after the probe,
+// so without lanes LIFO order would run the whole subtree before the probe
+w::fire_and_forget low_flood(int depth, std::atomic<int>& completed, std::atomic<int>& max_overtaken, std::latch& done)
+{
+    co_await w::resume_background(w::priority::low);
+    spin_for(20us);
+    if (depth > 0) {
+        if (depth == 5) {
+            high_probe(completed, max_overtaken, done);
+        }
+        low_flood(depth - 1, completed, max_overtaken, done);
+        low_flood(depth - 1, completed, max_overtaken, done);
+    }
+    completed.fetch_add(1, std::memory_order::relaxed);
+    done.count_down();
+}
+
+w::fire_and_forget deadline_probe(std::atomic<int>& completed, int& completed_before_probe, std::latch& done)
+{
+    co_await w::resume_background(test_clock::now()); // already late
+    completed_before_probe = completed.load(std::memory_order::relaxed);
+    done.count_down();
+}
+
+w::fire_and_forget normal_work(std::atomic<int>& completed, std::latch& done)
+{
+    co_await w::resume_background();
+    spin_for(20us);
+    completed.fetch_add(1, std::memory_order::relaxed);
+    done.count_down();
+}
+
+w::fire_and_forget deadline_root(std::atomic<int>& completed, int& completed_before_probe, std::latch& done, int work_count)
+{
+    co_await w::resume_affine(0);
+    deadline_probe(completed, completed_before_probe, done);
+    for (int i = 0; i < work_count; ++i) {
+        normal_work(completed, done);
+    }
+}
+
+auto resume_affine_on(w::base::thread_pool& pool, size_t worker) noexcept
+{
+    struct awaitable {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_resume() const noexcept
+        {
+        }
+        bool await_suspend(std::coroutine_handle<> handle) const noexcept
+        {
+            return pool.submit_affine(handle, worker);
+        }
+        w::base::thread_pool& pool;
+        size_t worker;
+    };
+    return awaitable{ pool, worker };
+}
+
+w::fire_and_forget affine_probe(w::base::thread_pool& pool, size_t worker, std::atomic<size_t>& mismatches, std::latch& done)
+{
+    co_await resume_affine_on(pool, worker);
+    if (pool.current_unit() != worker) {
+        mismatches.fetch_add(1, std::memory_order::relaxed);
+    }
+    done.count_down();
+}
+auto resume_on(w::base::thread_pool& pool) noexcept
+{
+    struct awaitable {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_resume() const noexcept
+        {
+        }
+        void await_suspend(std::coroutine_handle<> handle) const noexcept
+        {
+            pool.submit(handle);
+        }
+        w::base::thread_pool& pool;
+    };
+    return awaitable{ pool };
+}
+
+// ends on to, submitted from a worker of from, or from the calling thread if from is null
+w::fire_and_forget hop(w::base::thread_pool* from, w::base::thread_pool& to, std::atomic<int>& arrived, std::latch& done)
+{
+    if (from) {
+        co_await resume_on(*from);
+    }
+    co_await resume_on(to);
+    arrived.fetch_add(1, std::memory_order::relaxed);
+    done.count_down();
+}
+
+w::fire_and_forget sleeper(test_clock::duration duration, std::atomic<int64_t>& early, std::atomic<int>& order, int& position, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    auto start = test_clock::now();
+    co_await w::sleep_for(duration);
+    if (test_clock::now() - start < duration) {
+        early.fetch_add(1, std::memory_order::relaxed);
+    }
+    position = order.fetch_add(1, std::memory_order::relaxed);
+    done.count_down();
+}
+} // namespace
+
+TEST_CASE("timer_wheel_cascades")
+{
+    w::base::timer_wheel wheel;
+    auto base = test_clock::now();
+    auto id = [](uintptr_t i) { return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(i * 8)); };
+
+    // one timer per level, and one beyond the wheel
+    std::array<test_clock::duration, 5> after{ 3ms, 200ms, 30s, 2h, 10h };
+    std::array<w::base::timer_node, 5> nodes;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].deadline = base + after[i];
+        nodes[i].handle = id(i + 1);
+        REQUIRE(wheel.schedule(&nodes[i]) == (i == 0));
+    }
+
+    std::vector<std::coroutine_handle<>> expired;
+    auto collect = [&](std::coroutine_handle<> handle) { expired.push_back(handle); };
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        REQUIRE(wheel.next_deadline() == nodes[i].deadline);
+        REQUIRE(wheel.expire(nodes[i].deadline - 1ms, collect));
+        REQUIRE(expired.size() == i); // not a tick early
+        REQUIRE(wheel.expire(nodes[i].deadline, collect));
+        REQUIRE(expired.size() == i + 1);
+        REQUIRE(expired.back() == id(i + 1));
+    }
+    REQUIRE(wheel.empty());
+}
+
+TEST_CASE("timer_wheel_cancel")
+{
+    w::base::timer_wheel wheel;
+    auto base = test_clock::now();
+    auto id = [](uintptr_t i) { return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(i * 8)); };
+
+    std::array<test_clock::duration, 4> after{ 2ms, 5ms, 300ms, 10h };
+    std::array<w::base::timer_node, 4> nodes;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].deadline = base + after[i];
+        nodes[i].handle = id(i + 1);
+        wheel.schedule(&nodes[i]);
+    }
+
+    std::vector<std::coroutine_handle<>> expired;
+    auto collect = [&](std::coroutine_handle<> handle) { expired.push_back(handle); };
+    REQUIRE(wheel.cancel(&nodes[0])); // not sorted in yet
+    REQUIRE(wheel.next_deadline() == nodes[1].deadline);
+    REQUIRE(wheel.cancel(&nodes[2])); // in a higher level
+    REQUIRE(wheel.expire(nodes[1].deadline, collect));
+    REQUIRE(expired == std::vector{ id(2) });
+    REQUIRE(!wheel.cancel(&nodes[1])); // expired before
+
+    REQUIRE(wheel.expire(nodes[2].deadline, collect));
+    REQUIRE(expired.size() == 1);
+    REQUIRE(wheel.next_deadline() == nodes[3].deadline);
+    REQUIRE(wheel.cancel(&nodes[3]));
+    REQUIRE(wheel.empty());
+}
+
+TEST_CASE("sleep_for_resumes_in_order")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 4, .pin_threads = false });
+
+    std::array<test_clock::duration, 4> durations{ 40ms, 2ms, 80ms, 15ms };
+    std::array<int, 4> positions{};
+    std::atomic<int64_t> early{ 0 };
+    std::atomic<int> order{ 0 };
+    std::latch done{ 4 };
+    for (size_t i = 0; i < durations.size(); ++i) {
+        sleeper(durations[i], early, order, positions[i], done);
+    }
+    done.wait();
+
+    REQUIRE(early.load() == 0);
+    REQUIRE(positions == std::array{ 2, 0, 3, 1 });
+}
+
+TEST_CASE("high_priority_overtakes_low_flood")
+{
+    // one worker, so the order does not depend on timing
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 1, .pin_threads = false });
+
+    constexpr int depth = 10;
+    constexpr int flood_tasks = (1 << (depth + 1)) - 1;
+    constexpr int probes = 1 << (depth - 5);
+
+    std::atomic<int> completed{ 0 };
+    std::atomic<int> max_overtaken{ 0 };
+    std::latch done{ flood_tasks + probes };
+    low_flood(depth, completed, max_overtaken, done);
+    done.wait();
+
+    // a probe waits for the running low task, never for the queued ones
+    REQUIRE(max_overtaken.load() <= 1);
+}
+
+TEST_CASE("late_deadline_preempts_queue_order")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 1, .pin_threads = false });
+
+    constexpr int work_count = 1000;
+    std::atomic<int> completed{ 0 };
+    int completed_before_probe = -1;
+    std::latch done{ work_count + 1 };
+    deadline_root(completed, completed_before_probe, done, work_count);
+    done.wait();
+
+    REQUIRE(completed_before_probe == 0);
+
+    // outside the workers it still runs and wakes a parked worker
+    std::latch external{ 1 };
+    deadline_probe(completed, completed_before_probe, external);
+    external.wait();
+    REQUIRE(completed_before_probe == work_count);
+}
+
+TEST_CASE("submits_from_outside_the_pool")
+{
+    // the small pool's only worker index is out of range for most workers of the large one
+    w::base::thread_pool small{ { .worker_count = 1, .pin_threads = false, .topology = w::base::cpu_topology::flat(1) } };
+    w::base::thread_pool large{ { .worker_count = 4, .pin_threads = false, .topology = w::base::cpu_topology::flat(4) } };
+
+    constexpr int submitters = 4;
+    constexpr int per_submitter = 2000;
+    std::atomic<int> arrived{ 0 };
+    std::latch done{ submitters * per_submitter * 2 };
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < submitters; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < per_submitter; ++i) {
+                    hop(nullptr, small, arrived, done);
+                    hop(&large, small, arrived, done);
+                }
+            });
+        }
+    }
+    done.wait();
+    small.stop();
+    large.stop();
+
+    REQUIRE(arrived.load() == submitters * per_submitter * 2);
+}
+
+TEST_CASE("configured_affine_workers")
+{
+    w::base::thread_pool pool{ {
+            .worker_count = 4,
+            .affine_workers = { 1, 3 },
+            .deque_capacity = 16,
+            .affine_queue_capacity = 4, // smaller than the burst below, submitters have to wait
+            .thread_name = "test worker",
+            .stack_size = 256 * 1024,
+            .pin_threads = false,
+            .topology = w::base::cpu_topology::flat(4),
+    } };
+    REQUIRE(pool.size() == 4);
+    REQUIRE(pool.get_unit(1).accepts_affine_tasks());
+    REQUIRE(!pool.get_unit(0).accepts_affine_tasks());
+    REQUIRE(!pool.submit_affine(std::noop_coroutine(), 0));
+    REQUIRE(!pool.submit_affine(std::noop_coroutine(), 4));
+
+    constexpr int probes = 64;
+    std::atomic<size_t> mismatches{ 0 };
+    std::latch done{ probes * 2 };
+    for (int i = 0; i < probes; ++i) {
+        affine_probe(pool, 1, mismatches, done);
+        affine_probe(pool, 3, mismatches, done);
+    }
+    done.wait();
+    pool.stop();
+
+    REQUIRE(mismatches.load() == 0);
+}
+
+TEST_CASE("worker_counters_and_trace")
+{
+    w::base::trace_recorder recorder{ 2 };
+    w::base::thread_pool pool{ {
+            .worker_count = 2,
+            .affine_workers = { 0, 1 },
+            .pin_threads = false,
+            .topology = w::base::cpu_topology::flat(2),
+            .trace = &recorder,
+    } };
+
+    constexpr int probes = 100;
+    std::atomic<size_t> mismatches{ 0 };
+    std::latch done{ probes };
+    recorder.start();
+    for (int i = 0; i < probes; ++i) {
+        affine_probe(pool, i % 2, mismatches, done);
+    }
+    done.wait();
+    pool.stop();
+    recorder.stop();
+
+    std::ostringstream json;
+    recorder.write_chrome_trace(json);
+    auto trace = json.str();
+    size_t task_events = 0;
+    for (auto pos = trace.find(R"("name":"task")"); pos != std::string::npos; pos = trace.find(R"("name":"task")", pos + 1)) {
+        ++task_events;
+    }
+
+    if constexpr (w::base::thread_pool_stats_enabled) {
+        auto counters = pool.get_counters();
+        REQUIRE(counters[w::base::pool_counter::tasks_executed] >= probes);
+        REQUIRE(counters[w::base::pool_counter::steals] <= counters[w::base::pool_counter::steal_attempts]);
+        REQUIRE(task_events + recorder.dropped_events() >= probes);
+    } else {
+        REQUIRE(pool.get_counters()[w::base::pool_counter::tasks_executed] == 0);
+        REQUIRE(task_events == 0);
+    }
+    REQUIRE(trace.starts_with(R"({"displayTimeUnit")"));
+
+    // the configured name is escaped, the trace stays valid JSON
+    std::ostringstream named;
+    recorder.write_chrome_trace(named, "say \"hi\"\\\n");
+    REQUIRE(named.str().find(R"("args":{"name":"say \"hi\"\\\n 0"})") != std::string::npos);
+}
+
+#if defined(__linux__)
+TEST_CASE("topology_follows_affinity")
+{
+    // restricted to a single cpu like under taskset, on a thread so the test process keeps its affinity
+    std::vector<uint32_t> detected;
+    uint32_t allowed = 0;
+    bool pinned_outside = true;
+    std::thread([&] {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        sched_getaffinity(0, sizeof(set), &set);
+        while (!CPU_ISSET(allowed, &set)) {
+            ++allowed;
+        }
+        CPU_ZERO(&set);
+        CPU_SET(allowed, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+        auto topology = w::base::cpu_topology::detect();
+        for (auto& cpu : topology.get_cpus()) {
+            detected.push_back(cpu.id);
+        }
+        pinned_outside = w::base::pin_current_thread(allowed + 1);
+    }).join();
+
+    REQUIRE(detected == std::vector{ allowed });
+    REQUIRE(!pinned_outside);
+}
+#endif
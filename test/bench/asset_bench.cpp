@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <asset/package.h>
+#include <asset/package_writer.h>
+#include <base/tasks.h>
+#include <base/thread_pool.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr size_t asset_count = 256;
+constexpr size_t asset_size = 256 << 10;
+
+// loosely compressible, roughly like text or mesh data
+std::string asset_contents(size_t seed)
+{
+    std::string result;
+    uint32_t state = uint32_t(seed) * 7919u + 1;
+    while (result.size() < asset_size) {
+        state = state * 1664525u + 1013904223u;
+        result += "vertex " + std::to_string(state % 4096) + ' ';
+    }
+    result.resize(asset_size);
+    return result;
+}
+
+// the loose files and both packages, removed again afterwards
+struct asset_set {
+    asset_set()
+        : directory(std::filesystem::temp_directory_path() / "w_asset_bench")
+    {
+        std::filesystem::create_directories(directory / "loose");
+        for (size_t i = 0; i < asset_count; ++i) {
+            auto contents = asset_contents(i);
+            names.push_back(std::to_string(i) + ".bin");
+            std::ofstream{ directory / "loose" / names.back(), std::ios::binary }.write(contents.data(), std::streamsize(contents.size()));
+        }
+        for (auto codec : { w::asset::compression::none, w::asset::compression::lz4 }) {
+            w::asset::package_writer writer;
+            (void)writer.add_directory(directory / "loose", codec);
+            (void)writer.write(package_path(codec));
+        }
+    }
+    ~asset_set()
+    {
+        std::error_code ignored;
+        std::filesystem::remove_all(directory, ignored);
+    }
+    std::filesystem::path package_path(w::asset::compression codec) const
+    {
+        return directory / (codec == w::asset::compression::lz4 ? "lz4.wpak" : "plain.wpak");
+    }
+
+    std::filesystem::path directory;
+    std::vector<std::string> names;
+};
+
+uint64_t checksum(std::span<const std::byte> bytes)
+{
+    uint64_t sum = 0;
+    for (auto b : bytes) {
+        sum += uint8_t(b);
+    }
+    return sum;
+}
+
+uint64_t load_fread(const asset_set& assets)
+{
+    uint64_t sum = 0;
+    std::vector<std::byte> buffer(asset_size);
+    for (auto& name : assets.names) {
+        auto* file = std::fopen((assets.directory / "loose" / name).string().c_str(), "rb");
+        auto read = std::fread(buffer.data(), 1, buffer.size(), file);
+        std::fclose(file);
+        sum += checksum(std::span{ buffer }.first(read));
+    }
+    return sum;
+}
+
+uint64_t load_mapped(const asset_set& assets)
+{
+    auto package = w::asset::package::open(assets.package_path(w::asset::compression::none));
+    uint64_t sum = 0;
+    for (auto& name : assets.names) {
+        sum += checksum(package.value.view(*package.value.find(name)));
+    }
+    return sum;
+}
+
+w::fire_and_forget load_all(const w::asset::package& package, const asset_set& assets, uint64_t& sum, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    std::vector<w::task<w::result<w::asset::asset_data>>> loads;
+    for (auto& name : assets.names) {
+        loads.push_back(package.load_async(*package.find(name)));
+    }
+    for (auto& loaded : co_await w::when_all(std::span{ loads })) {
+        sum += checksum(loaded.value.bytes);
+    }
+    done.count_down();
+}
+
+uint64_t load_compressed(const asset_set& assets)
+{
+    auto package = w::asset::package::open(assets.package_path(w::asset::compression::lz4));
+    uint64_t sum = 0;
+    std::latch done{ 1 };
+    load_all(package.value, assets, sum, done);
+    done.wait();
+    return sum;
+}
+} // namespace
+
+TEST_CASE("asset_loading", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+    asset_set assets;
+
+    BENCHMARK("fread, 256 files x 256 KiB")
+    {
+        return load_fread(assets);
+    };
+    BENCHMARK("mapped package, 256 x 256 KiB")
+    {
+        return load_mapped(assets);
+    };
+    BENCHMARK("lz4 package, parallel decompression, 256 x 256 KiB")
+    {
+        return load_compressed(assets);
+    };
+}
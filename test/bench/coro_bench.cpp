@@ -0,0 +1,197 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <base/async_sync.h>
+#include <base/tasks.h>
+#include <base/thread_pool.h>
+#include <chrono>
+#include <latch>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+w::task<uint32_t> work(uint32_t iterations)
+{
+    uint32_t x = iterations;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        x = x * 1664525u + 1013904223u;
+    }
+    co_return x;
+}
+
+// the old when_all: every child is awaited in turn
+w::task<void> sequential(std::span<w::task<uint32_t>> tasks)
+{
+    for (auto& task : tasks) {
+        co_await task;
+    }
+}
+
+w::fire_and_forget join_root(size_t count, uint32_t iterations, bool parallel, std::latch& done)
+{
+    co_await w::resume_background();
+    std::vector<w::task<uint32_t>> tasks;
+    tasks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        tasks.push_back(work(iterations));
+    }
+    if (parallel) {
+        co_await w::when_all(std::span{ tasks });
+    } else {
+        co_await sequential(tasks);
+    }
+    done.count_down();
+}
+
+void join(size_t count, uint32_t iterations, bool parallel)
+{
+    std::latch done{ 1 };
+    join_root(count, iterations, parallel, done);
+    done.wait();
+}
+
+struct global_frame {
+};
+
+// Lazily started, self-destroying coroutine, frames from frame_allocator or the global operator new
+template<bool pooled>
+struct spawn_task {
+    struct promise_type : std::conditional_t<pooled, w::base::frame_allocated, global_frame> {
+        spawn_task get_return_object() noexcept { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() const noexcept { }
+    };
+    std::coroutine_handle<> handle;
+};
+
+template<bool pooled>
+spawn_task<pooled> spawned(std::latch* done)
+{
+    if (done) {
+        done->count_down();
+    }
+    co_return;
+}
+
+template<bool pooled>
+void spawn_local(size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        spawned<pooled>(nullptr).handle.resume();
+    }
+}
+
+// frames are allocated on worker 0 and mostly freed on the workers that stole them
+template<bool pooled>
+w::fire_and_forget spawn_remote_root(size_t count, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    std::vector<std::coroutine_handle<>> handles(count);
+    for (auto& handle : handles) {
+        handle = spawned<pooled>(&done).handle;
+    }
+    w::detail::resume_background(handles);
+}
+
+template<bool pooled>
+void spawn_remote(size_t count)
+{
+    std::latch done{ std::ptrdiff_t(count) };
+    spawn_remote_root<pooled>(count, done);
+    done.wait();
+}
+// short critical section between pool hops, the std::mutex variant blocks the worker while waiting
+template<typename Mutex>
+w::fire_and_forget contend(Mutex& mutex, uint64_t& shared, size_t rounds, std::latch& done)
+{
+    co_await w::resume_affine(0);
+    for (size_t i = 0; i < rounds; ++i) {
+        co_await w::resume_background();
+        if constexpr (std::is_same_v<Mutex, w::async_mutex>) {
+            auto guard = co_await mutex.scoped_lock();
+            shared = shared * 6364136223846793005ull + work(16).get();
+        } else {
+            std::lock_guard guard{ mutex };
+            shared = shared * 6364136223846793005ull + work(16).get();
+        }
+    }
+    done.count_down();
+}
+
+template<typename Mutex>
+void contention(size_t coroutines, size_t rounds)
+{
+    Mutex mutex;
+    uint64_t shared = 0;
+    std::latch done{ std::ptrdiff_t(coroutines) };
+    for (size_t i = 0; i < coroutines; ++i) {
+        contend(mutex, shared, rounds, done);
+    }
+    done.wait();
+}
+} // namespace
+
+TEST_CASE("when_all", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+
+    // 8 children of ~100us each, a frame graph node
+    BENCHMARK("sequential, 8 x 100k iterations")
+    {
+        join(8, 100'000, false);
+    };
+    BENCHMARK("when_all, 8 x 100k iterations")
+    {
+        join(8, 100'000, true);
+    };
+
+    // combinator overhead, children are almost empty
+    BENCHMARK("sequential, 1000 x 10 iterations")
+    {
+        join(1000, 10, false);
+    };
+    BENCHMARK("when_all, 1000 x 10 iterations")
+    {
+        join(1000, 10, true);
+    };
+}
+
+TEST_CASE("frame_allocation", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+
+    BENCHMARK("spawn/complete 10k, operator new")
+    {
+        spawn_local<false>(10'000);
+    };
+    BENCHMARK("spawn/complete 10k, frame_allocator")
+    {
+        spawn_local<true>(10'000);
+    };
+    BENCHMARK("spawn on worker 0, complete anywhere 10k, operator new")
+    {
+        spawn_remote<false>(10'000);
+    };
+    BENCHMARK("spawn on worker 0, complete anywhere 10k, frame_allocator")
+    {
+        spawn_remote<true>(10'000);
+    };
+}
+
+TEST_CASE("async_mutex_contention", "[!benchmark]")
+{
+    for (uint32_t workers : { 2u, 4u, 8u }) {
+        auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = workers });
+
+        BENCHMARK("std::mutex, " + std::to_string(workers) + " workers, 64 x 200 locks")
+        {
+            contention<std::mutex>(64, 200);
+        };
+        BENCHMARK("async_mutex, " + std::to_string(workers) + " workers, 64 x 200 locks")
+        {
+            contention<w::async_mutex>(64, 200);
+        };
+    }
+}
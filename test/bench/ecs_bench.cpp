@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <base/thread_pool.h>
+#include <ecs/components.h>
+#include <ecs/registry.h>
+#include <ecs/transform_hierarchy.h>
+#include <ecs/transform.h>
+#include <string>
+#include <vector>
+
+using namespace w::ecs;
+namespace math = w::math;
+
+TEST_CASE("ecs_iteration", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+    const math::vector delta(0.1f, 0.0f, -0.1f, 0.0f);
+
+    for (size_t size : { 100'000, 1'000'000 }) {
+        // the same data both ways: position, rotation and scale, the transform also carries its cached matrix
+        std::vector<transform> objects(size);
+        registry reg;
+        for (size_t i = 0; i < size; ++i) {
+            math::float3 p{ float(i), 0.0f, 0.0f };
+            objects[i].set_position(math::vector(p));
+            reg.create(position{ p }, rotation{}, scale{});
+        }
+        auto name = std::to_string(size / 1000) + "k";
+
+        BENCHMARK(name + " std::vector<transform>, move")
+        {
+            for (auto& t : objects) {
+                t.set_position(t.get_position() + delta);
+            }
+            return objects.back().get_position()[0];
+        };
+        BENCHMARK(name + " view<position>, move")
+        {
+            reg.view<position>().each([&](position& p) {
+                p.value = math::vector(p.value) + delta;
+            });
+            return reg.view<position>().size();
+        };
+        BENCHMARK(name + " view<position>, move, chunks in parallel")
+        {
+            reg.view<position>().each_chunk_parallel([&](std::span<const entity>, std::span<position> p) {
+                for (auto& x : p) {
+                    x.value = math::vector(x.value) + delta;
+                }
+            }).get();
+            return reg.view<position>().size();
+        };
+    }
+}
+
+TEST_CASE("transform_hierarchy", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+
+    // 1000 roots, every other node hangs below a random node of the older half
+    constexpr size_t size = 1'000'000;
+    std::vector<uint32_t> parents(size);
+    uint64_t seed = 1;
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        parents[i] = i < 1000 ? transform_hierarchy::no_parent : uint32_t(i / 2 + (seed >> 33) % (i - i / 2));
+    }
+
+    std::vector<transform> objects(size);
+    transform_hierarchy hierarchy;
+    for (size_t i = 0; i < size; ++i) {
+        math::vector offset(float(i % 7), 1.0f, 0.5f, 0.0f);
+        objects[i].set_position(offset);
+        objects[i].set_scale(math::vector(1.0f, 1.0f, 1.0f, 0.0f));
+        objects[i].set_rotation(math::quaternion(math::identity[3]));
+        if (parents[i] != transform_hierarchy::no_parent) {
+            objects[i].set_parent(&objects[parents[i]]);
+        }
+        hierarchy.add(parents[i], math::translate(offset));
+    }
+    hierarchy.update();
+
+    BENCHMARK("1M nodes, recursive transform::world_matrix")
+    {
+        for (auto& t : objects) {
+            t.set_dirty();
+        }
+        float sum = 0.0f;
+        for (auto& t : objects) {
+            sum += t.world_matrix()[3][0];
+        }
+        return sum;
+    };
+    BENCHMARK("1M nodes, all dirty, update")
+    {
+        for (transform_hierarchy::node n = 0; n < 1000; ++n) {
+            hierarchy.set_local(n, hierarchy.local(n));
+        }
+        return hierarchy.update();
+    };
+    BENCHMARK("1M nodes, all dirty, update_parallel")
+    {
+        for (transform_hierarchy::node n = 0; n < 1000; ++n) {
+            hierarchy.set_local(n, hierarchy.local(n));
+        }
+        return hierarchy.update_parallel().get();
+    };
+    BENCHMARK("1M nodes, 1% of the leaves moved, update")
+    {
+        for (transform_hierarchy::node n = size / 2; n < size; n += 100) {
+            hierarchy.set_local(n, hierarchy.local(n));
+        }
+        return hierarchy.update();
+    };
+}
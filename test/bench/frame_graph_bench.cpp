@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <base/frame_graph.h>
+#include <base/thread_pool.h>
+#include <array>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+using w::base::frame_graph;
+
+namespace {
+// fixed arithmetic instead of sleeping, so the systems keep their worker busy
+float burn(size_t iterations)
+{
+    float x = 1.0f;
+    for (size_t i = 0; i < iterations; ++i) {
+        x = x * 1.0000001f + 0.5f;
+    }
+    return x;
+}
+
+// A frame of a game without a window: input, three simulation systems, the transforms,
+// culling and command recording for each view, audio next to the rendering and the submit at the end.
+struct synthetic_frame {
+    explicit synthetic_frame(size_t iterations, size_t views = 4)
+    {
+        auto input = graph.add_resource();
+        auto physics = graph.add_resource();
+        auto animation = graph.add_resource();
+        auto ai = graph.add_resource();
+        auto transforms = graph.add_resource();
+        auto audio = graph.add_resource();
+        std::vector<frame_graph::resource> commands;
+
+        add({}, std::array{ input }, iterations);
+        add(std::array{ input }, std::array{ physics }, iterations * 4);
+        add(std::array{ input }, std::array{ animation }, iterations * 2);
+        add(std::array{ input }, std::array{ ai }, iterations * 2);
+        add(std::array{ physics, animation }, std::array{ transforms }, iterations);
+        add(std::array{ ai }, std::array{ audio }, iterations);
+        for (size_t v = 0; v < views; ++v) {
+            auto visible = graph.add_resource();
+            commands.push_back(graph.add_resource());
+            add(std::array{ transforms }, std::array{ visible }, iterations * 2);
+            add(std::array{ visible }, std::array{ commands.back() }, iterations * 3);
+        }
+        // the submit reads every command list and the audio
+        commands.push_back(audio);
+        add(commands, {}, iterations);
+        graph.compile();
+    }
+
+    void add(std::span<const frame_graph::resource> reads, std::span<const frame_graph::resource> writes, size_t iterations)
+    {
+        size_t index = results.size();
+        results.push_back(0.0f);
+        serial.push_back([this, index, iterations] { results[index] = burn(iterations); });
+        graph.add_system(serial.back(), reads, writes);
+    }
+
+    frame_graph graph;
+    std::vector<std::function<void()>> serial;
+    std::vector<float> results;
+};
+} // namespace
+
+TEST_CASE("frame_graph", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+
+    for (size_t iterations : { 0, 2'000, 20'000 }) {
+        synthetic_frame frame(iterations);
+        auto name = std::to_string(frame.graph.size()) + " systems, " + std::to_string(iterations) + " iterations";
+
+        BENCHMARK(name + ", serial loop")
+        {
+            for (auto& s : frame.serial) {
+                s();
+            }
+            return frame.results[0];
+        };
+        BENCHMARK(name + ", frame_graph")
+        {
+            frame.graph.run().get();
+            return frame.results[0];
+        };
+    }
+
+    // scheduling cost per system, nothing depends on anything
+    for (size_t count : { 16, 256 }) {
+        frame_graph graph;
+        std::vector<int> counters(count);
+        for (size_t i = 0; i < count; ++i) {
+            graph.add_system([&counters, i] { ++counters[i]; }, {}, {});
+        }
+        graph.compile();
+        BENCHMARK(std::to_string(count) + " independent empty systems, frame_graph")
+        {
+            graph.run().get();
+            return counters[0];
+        };
+    }
+}
@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <base/io.h>
+#include <base/tasks.h>
+#include <base/thread_pool.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <string>
+#include <vector>
+
+namespace {
+// tmpfs where available, so the numbers show the submission path rather than the disk
+std::filesystem::path bench_directory()
+{
+    std::error_code ignored;
+    std::filesystem::path shm{ "/dev/shm" };
+    auto base = std::filesystem::is_directory(shm, ignored) ? shm : std::filesystem::temp_directory_path();
+    return base / "w_io_bench";
+}
+
+struct file_set {
+    file_set(size_t count, size_t size)
+        : directory(bench_directory())
+    {
+        std::filesystem::create_directories(directory);
+        std::string contents(size, 'w');
+        for (size_t i = 0; i < count; ++i) {
+            paths.push_back(directory / std::to_string(i));
+            std::ofstream{ paths.back(), std::ios::binary }.write(contents.data(), std::streamsize(size));
+        }
+    }
+    ~file_set()
+    {
+        std::error_code ignored;
+        std::filesystem::remove_all(directory, ignored);
+    }
+
+    std::filesystem::path directory;
+    std::vector<std::filesystem::path> paths;
+};
+
+w::fire_and_forget read_async(const std::filesystem::path& path, std::atomic<size_t>& bytes, std::latch& done)
+{
+    co_await w::resume_background();
+    auto read = co_await w::io::read_file_async(path);
+    bytes.fetch_add(read ? 0 : read.value.size, std::memory_order::relaxed);
+    done.count_down();
+}
+
+// the same fan-out, but every coroutine blocks its worker in the read
+w::fire_and_forget read_blocking(const std::filesystem::path& path, std::atomic<size_t>& bytes, std::latch& done)
+{
+    co_await w::resume_background();
+    std::ifstream file{ path, std::ios::binary | std::ios::ate };
+    std::string contents(size_t(file.tellg()), '\0');
+    file.seekg(0).read(contents.data(), std::streamsize(contents.size()));
+    bytes.fetch_add(size_t(file.gcount()), std::memory_order::relaxed);
+    done.count_down();
+}
+
+template<typename Read>
+size_t read_all(const file_set& files, Read read)
+{
+    std::atomic<size_t> bytes{ 0 };
+    std::latch done{ std::ptrdiff_t(files.paths.size()) };
+    for (auto& path : files.paths) {
+        read(path, bytes, done);
+    }
+    done.wait();
+    return bytes.load();
+}
+} // namespace
+
+TEST_CASE("read_many_files", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped({ .worker_count = 4 });
+    for (size_t size : { size_t(4096), size_t(256) << 10 }) {
+        file_set files{ 256, size };
+
+        BENCHMARK("blocking reads, 256 x " + std::to_string(size >> 10) + " KiB")
+        {
+            return read_all(files, read_blocking);
+        };
+        BENCHMARK("read_file_async, 256 x " + std::to_string(size >> 10) + " KiB")
+        {
+            return read_all(files, read_async);
+        };
+    }
+}
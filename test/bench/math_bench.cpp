@@ -0,0 +1,306 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <base/thread_pool.h>
+#include <math/batch.h>
+#include <math/culling.h>
+#include <math/matrix_math.h>
+#include <math/quantize.h>
+#include <math/simd.h>
+#include <math/transcendental.h>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace w::math;
+
+namespace {
+constexpr size_t batch_sizes[] = { 1 << 10, 1 << 14, 1 << 18, 1 << 20 };
+
+float4x4a test_matrix(size_t seed)
+{
+    float4x4a result;
+    for (size_t i = 0; i < 16; ++i) {
+        result.r[i / 4][i % 4] = float((seed * 31 + i * 7) % 17) * 0.125f - 1.0f;
+    }
+    return result;
+}
+
+std::string size_name(size_t size)
+{
+    return size >= (1 << 20) ? std::to_string(size >> 20) + "M" : std::to_string(size >> 10) + "k";
+}
+
+const char* level_name(simd_level level)
+{
+    constexpr const char* names[] = { ", SSE4.1", ", AVX2", ", AVX-512" };
+    return names[size_t(level)];
+}
+
+// benchmarks the batch function on every supported level
+template<typename F>
+void bench_levels(const std::string& name, F&& batch)
+{
+    for (auto level : { simd_level::sse41, simd_level::avx2, simd_level::avx512 }) {
+        if (level > supported_simd_level()) {
+            continue;
+        }
+        force_simd_level(level);
+        BENCHMARK(name + level_name(level))
+        {
+            return batch();
+        };
+    }
+    force_simd_level(supported_simd_level());
+}
+} // namespace
+
+TEST_CASE("multiply_batch", "[!benchmark]")
+{
+    for (size_t size : batch_sizes) {
+        std::vector<float4x4a> a(size), b(size), out(size);
+        for (size_t i = 0; i < size; ++i) {
+            a[i] = test_matrix(i);
+            b[i] = test_matrix(i + 1);
+        }
+        auto name = size_name(size) + " matrices";
+
+        BENCHMARK(name + ", scalar loop")
+        {
+            for (size_t i = 0; i < size; ++i) {
+                out[i] = multiply(a[i], b[i]);
+            }
+            return out.back().r[0][0];
+        };
+        bench_levels(name, [&] {
+            multiply_batch(a, b, out);
+            return out.back().r[0][0];
+        });
+
+        // the same matrices as structure of arrays
+        std::vector<float> a_soa(16 * size), b_soa(16 * size), out_soa(16 * size);
+        float4x4_soa a_view, b_view, out_view;
+        for (size_t e = 0; e < 16; ++e) {
+            a_view.m[e] = std::span{ a_soa }.subspan(e * size, size);
+            b_view.m[e] = std::span{ b_soa }.subspan(e * size, size);
+            out_view.m[e] = std::span{ out_soa }.subspan(e * size, size);
+            for (size_t i = 0; i < size; ++i) {
+                a_view.m[e][i] = a[i].r[e / 4][e % 4];
+                b_view.m[e][i] = b[i].r[e / 4][e % 4];
+            }
+        }
+        bench_levels(name + ", SoA", [&] {
+            multiply_batch(a_view, b_view, out_view);
+            return out_soa.back();
+        });
+    }
+}
+
+TEST_CASE("transform_points", "[!benchmark]")
+{
+    matrix m = test_matrix(3);
+    for (size_t size : batch_sizes) {
+        std::vector<float3> points(size), out(size);
+        std::vector<float> x(size), y(size), z(size), out_x(size), out_y(size), out_z(size);
+        for (size_t i = 0; i < size; ++i) {
+            points[i] = { float(i % 101), float(i % 37), float(i % 11) };
+            x[i] = points[i][0];
+            y[i] = points[i][1];
+            z[i] = points[i][2];
+        }
+        auto name = size_name(size) + " points";
+
+        BENCHMARK(name + ", scalar loop")
+        {
+            for (size_t i = 0; i < size; ++i) {
+                out[i] = transform(m, vector(points[i]));
+            }
+            return out.back()[0];
+        };
+        bench_levels(name, [&] {
+            transform_points(points, m, out);
+            return out.back()[0];
+        });
+        bench_levels(name + ", SoA", [&] {
+            transform_points(const_float3_soa{ x, y, z }, m, float3_soa{ out_x, out_y, out_z });
+            return out_x.back();
+        });
+    }
+}
+
+TEST_CASE("inverse", "[!benchmark]")
+{
+    size_t size = batch_sizes[1];
+    std::vector<float4x4a> in(size), out(size);
+    for (size_t i = 0; i < size; ++i) {
+        in[i] = multiply(scale(vector(1.0f + float(i % 7), 2.0f, 0.5f, 1.0f)), translate(vector(float(i), 1.0f, 2.0f, 1.0f)));
+    }
+    auto name = size_name(size) + " matrices";
+
+    BENCHMARK(name + ", inverse")
+    {
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = inverse(in[i]);
+        }
+        return out.back().r[0][0];
+    };
+    BENCHMARK(name + ", inverse_affine")
+    {
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = inverse_affine(in[i]);
+        }
+        return out.back().r[0][0];
+    };
+}
+
+TEST_CASE("transcendental", "[!benchmark]")
+{
+    using batch_fn = void (*)(std::span<const float>, std::span<float>) noexcept;
+    struct function {
+        const char* name;
+        float (*libm)(float);
+        batch_fn batch;
+        float first, last;
+    };
+    const function functions[] = {
+        { "sin", [](float x) { return std::sin(x); }, sin, -100.0f, 100.0f },
+        { "cos", [](float x) { return std::cos(x); }, cos, -100.0f, 100.0f },
+        { "acos", [](float x) { return std::acos(x); }, acos, -1.0f, 1.0f },
+        { "exp", [](float x) { return std::exp(x); }, exp, -80.0f, 80.0f },
+        { "log", [](float x) { return std::log(x); }, log, 1e-3f, 1e6f },
+    };
+
+    for (size_t size : { batch_sizes[1], batch_sizes[3] }) {
+        std::vector<float> in(size), out(size), out2(size);
+        for (auto& f : functions) {
+            for (size_t i = 0; i < size; ++i) {
+                in[i] = f.first + (f.last - f.first) * float(i) / float(size);
+            }
+            auto name = size_name(size) + " " + f.name;
+
+            BENCHMARK(name + ", libm loop")
+            {
+                for (size_t i = 0; i < size; ++i) {
+                    out[i] = f.libm(in[i]);
+                }
+                return out.back();
+            };
+            bench_levels(name, [&] {
+                f.batch(in, out);
+                return out.back();
+            });
+        }
+
+        // sin and cos of the same angles, once separately and once with the shared reduction
+        for (size_t i = 0; i < size; ++i) {
+            in[i] = float(i) * 1e-3f;
+        }
+        auto name = size_name(size);
+        BENCHMARK(name + " sin and cos, libm loop")
+        {
+            for (size_t i = 0; i < size; ++i) {
+                out[i] = std::sin(in[i]);
+                out2[i] = std::cos(in[i]);
+            }
+            return out.back() + out2.back();
+        };
+        bench_levels(name + " sincos", [&] {
+            sincos(in, out, out2);
+            return out.back() + out2.back();
+        });
+        bench_levels(name + " atan2", [&] {
+            atan2(in, out2, out);
+            return out.back();
+        });
+    }
+}
+
+TEST_CASE("cull", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+    frustum f(multiply(look_to(vector(0.0f, 0.0f, 0.0f, 0.0f), identity[2], identity[1]), perspective(1.2f, 16.0f / 9.0f, 0.1f, 500.0f)));
+
+    for (size_t size : { 10'000, 100'000, 1'000'000 }) {
+        // objects spread around the camera, about a tenth of them visible
+        std::vector<aabb> boxes(size);
+        std::vector<bounding_sphere> spheres(size);
+        std::vector<uint8_t> visible(size);
+        for (size_t i = 0; i < size; ++i) {
+            float3 center{ float((i * 7919) % 1000) - 500.0f, float((i * 104729) % 200) - 100.0f, float((i * 31) % 1000) - 500.0f };
+            boxes[i] = { center, { 1.0f, 2.0f, 1.0f } };
+            spheres[i] = { center, 2.0f };
+        }
+        auto name = std::to_string(size / 1000) + "k objects";
+
+        BENCHMARK(name + ", intersects loop")
+        {
+            for (size_t i = 0; i < size; ++i) {
+                visible[i] = intersects(f, boxes[i]);
+            }
+            return visible.back();
+        };
+        bench_levels(name + ", aabb", [&] {
+            cull(boxes, f, visible);
+            return visible.back();
+        });
+        bench_levels(name + ", sphere", [&] {
+            cull(spheres, f, visible);
+            return visible.back();
+        });
+        BENCHMARK(name + ", aabb parallel")
+        {
+            cull_parallel(boxes, f, visible).get();
+            return visible.back();
+        };
+    }
+}
+
+TEST_CASE("quantize", "[!benchmark]")
+{
+    position_cell cell{ { 0.0f, 0.0f, 0.0f }, 1024.0f };
+    for (size_t size : batch_sizes) {
+        std::vector<float4> rotations(size), unpacked_rotations(size);
+        std::vector<float3> values(size), unpacked_values(size);
+        for (size_t i = 0; i < size; ++i) {
+            rotations[i] = quaternion::from_angle_axis_normal(float(i % 628) * 0.01f, identity[i % 3]);
+            values[i] = { float(i % 2000) * 0.5f - 500.0f, float(i % 7), float(i % 13) * 0.25f };
+        }
+        std::vector<packed_quat32> packed32(size);
+        std::vector<packed_quat48> packed48(size);
+        std::vector<half3> halves(size);
+        std::vector<packed_position> positions(size);
+        auto name = size_name(size);
+
+        bench_levels(name + ", pack quat32", [&] {
+            pack_batch(rotations, packed32);
+            return packed32.back().bits;
+        });
+        bench_levels(name + ", unpack quat32", [&] {
+            unpack_batch(packed32, unpacked_rotations);
+            return unpacked_rotations.back()[0];
+        });
+        bench_levels(name + ", pack quat48", [&] {
+            pack_batch(rotations, packed48);
+            return packed48.back().bits[0];
+        });
+        bench_levels(name + ", unpack quat48", [&] {
+            unpack_batch(packed48, unpacked_rotations);
+            return unpacked_rotations.back()[0];
+        });
+        bench_levels(name + ", pack half3", [&] {
+            pack_batch(values, halves);
+            return halves.back().bits[0];
+        });
+        bench_levels(name + ", unpack half3", [&] {
+            unpack_batch(halves, unpacked_values);
+            return unpacked_values.back()[0];
+        });
+        bench_levels(name + ", pack position", [&] {
+            pack_batch(values, cell, positions);
+            return positions.back().value[0];
+        });
+        bench_levels(name + ", unpack position", [&] {
+            unpack_batch(positions, cell, unpacked_values);
+            return unpacked_values.back()[0];
+        });
+    }
+}
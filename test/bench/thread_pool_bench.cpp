@@ -0,0 +1,235 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <base/await.h>
+#include <base/thread_pool.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <latch>
+#include <string>
+#include <vector>
+
+namespace {
+w::fire_and_forget fan_out_child(std::latch& done)
+{
+    co_await w::resume_background();
+    done.count_down();
+}
+
+// Spawns every child from a single worker, so its deque has to hold the whole burst
+w::fire_and_forget fan_out_root(std::latch& done, size_t count)
+{
+    co_await w::resume_affine(0);
+    for (size_t i = 0; i < count; ++i) {
+        fan_out_child(done);
+    }
+}
+
+void fan_out(size_t count)
+{
+    std::latch done{ std::ptrdiff_t(count) };
+    fan_out_root(done, count);
+    done.wait();
+}
+
+// Lazily started, self-destroying coroutine, so raw handles can be handed to a private pool
+struct detached_task {
+    struct promise_type {
+        detached_task get_return_object() noexcept { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() const noexcept { }
+    };
+    std::coroutine_handle<> handle;
+};
+
+detached_task tiny_task(std::latch& done)
+{
+    done.count_down();
+    co_return;
+}
+
+detached_task submit_root(w::base::thread_pool& pool, std::span<const std::coroutine_handle<>> handles, bool bulk)
+{
+    if (bulk) {
+        pool.submit_bulk(handles);
+    } else {
+        for (auto handle : handles) {
+            pool.submit(handle);
+        }
+    }
+    co_return;
+}
+
+void submit_tiny_tasks(w::base::thread_pool& pool, std::vector<std::coroutine_handle<>>& handles, bool bulk)
+{
+    std::latch done{ std::ptrdiff_t(handles.size()) };
+    for (auto& handle : handles) {
+        handle = tiny_task(done).handle;
+    }
+    // submit from a worker, the deque of the submitting thread is the one that gets filled
+    pool.submit_affine(submit_root(pool, handles, bulk).handle, 0);
+    done.wait();
+}
+using clock = std::chrono::steady_clock;
+
+detached_task wake_probe(clock::time_point submitted, std::atomic<int64_t>& latency_ns)
+{
+    latency_ns.store((clock::now() - submitted).count(), std::memory_order::release);
+    latency_ns.notify_one();
+    co_return;
+}
+
+// Runs on worker 0 and keeps it busy, so every probe has to be picked up by another worker
+detached_task wake_driver(w::base::thread_pool& pool, std::vector<int64_t>& samples, clock::duration idle_gap, std::latch& done)
+{
+    std::atomic<int64_t> latency_ns{ -1 };
+    for (auto& sample : samples) {
+        std::this_thread::sleep_for(idle_gap); // let the other workers go idle or park
+        latency_ns.store(-1, std::memory_order::relaxed);
+        pool.submit(wake_probe(clock::now(), latency_ns).handle);
+        latency_ns.wait(-1, std::memory_order::acquire);
+        sample = latency_ns.load(std::memory_order::relaxed);
+    }
+    done.count_down();
+    co_return;
+}
+
+// Binary tree of small tasks, every node spawns its children on the worker that ran it
+detached_task tree_task(w::base::thread_pool& pool, int depth, std::latch& done)
+{
+    volatile uint32_t sink = 0;
+    for (uint32_t i = 0; i < 256; ++i) {
+        sink = sink + i;
+    }
+    if (depth > 0) {
+        pool.submit(tree_task(pool, depth - 1, done).handle);
+        pool.submit(tree_task(pool, depth - 1, done).handle);
+    }
+    done.count_down();
+    co_return;
+}
+
+void run_tree(w::base::thread_pool& pool, int depth)
+{
+    std::latch done{ (std::ptrdiff_t(1) << (depth + 1)) - 1 };
+    pool.submit_affine(tree_task(pool, depth, done).handle, 0);
+    done.wait();
+}
+
+void report_steal_locality(const char* name, const w::base::thread_pool& pool)
+{
+    constexpr const char* tiers[] = { "same core", "shared L2", "shared L3", "same node", "remote" };
+    std::array<size_t, w::base::worker_placement::tier_count> steals{};
+    size_t total = 0;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        auto unit_steals = pool.get_unit(i).steals_by_distance();
+        for (size_t t = 0; t < steals.size(); ++t) {
+            steals[t] += unit_steals[t];
+            total += unit_steals[t];
+        }
+    }
+    std::printf("%s: %zu steals\n", name, total);
+    for (size_t t = 0; t < steals.size(); ++t) {
+        std::printf("  %-10s %5.1f%%\n", tiers[t], total ? 100.0 * double(steals[t]) / double(total) : 0.0);
+    }
+}
+
+void report_wake_latency(const char* name, w::base::idle_policy policy, clock::duration idle_gap)
+{
+    w::base::thread_pool pool{ { .worker_count = std::max(std::thread::hardware_concurrency(), 2u), .idle = policy } };
+    std::vector<int64_t> samples(1000);
+    std::latch done{ 1 };
+    pool.submit_affine(wake_driver(pool, samples, idle_gap, done).handle, 0);
+    done.wait();
+    pool.stop();
+
+    std::sort(samples.begin(), samples.end());
+    std::printf("%s, idle gap %lldus: p50 %lldns, p99 %lldns\n", name,
+                (long long)std::chrono::duration_cast<std::chrono::microseconds>(idle_gap).count(),
+                (long long)samples[samples.size() / 2], (long long)samples[samples.size() * 99 / 100]);
+}
+} // namespace
+
+TEST_CASE("fan_out", "[!benchmark]")
+{
+    auto token = w::base::global_thread_pool_token::init_scoped();
+
+    BENCHMARK("fan-out 1k")
+    {
+        fan_out(1'000);
+    };
+    BENCHMARK("fan-out 100k")
+    {
+        fan_out(100'000);
+    };
+}
+
+TEST_CASE("bulk_submit", "[!benchmark]")
+{
+    constexpr size_t task_count = 10'000;
+    std::vector<std::coroutine_handle<>> handles(task_count);
+
+    for (uint32_t workers = 1; workers <= std::max(std::thread::hardware_concurrency(), 2u); workers *= 2) {
+        w::base::thread_pool pool{ { .worker_count = workers } };
+
+        BENCHMARK("per-task submit, " + std::to_string(workers) + " workers")
+        {
+            submit_tiny_tasks(pool, handles, false);
+        };
+        BENCHMARK("bulk submit, " + std::to_string(workers) + " workers")
+        {
+            submit_tiny_tasks(pool, handles, true);
+        };
+        pool.stop();
+    }
+}
+
+TEST_CASE("wake_latency", "[!benchmark]")
+{
+    using namespace std::chrono_literals;
+    for (auto gap : { 0us, 50us, 2000us }) {
+        report_wake_latency("latency", w::base::idle_policy::latency(), gap);
+        report_wake_latency("power saving", w::base::idle_policy::power_saving(), gap);
+    }
+}
+
+TEST_CASE("steal_locality", "[!benchmark]")
+{
+    // 2 sockets, one L3 each, 4 cores with 2 threads per core
+    auto simulated = w::base::cpu_topology::simulated(2, 1, 4, 2);
+    auto workers = uint32_t(simulated.cpu_count());
+
+    // a uniform pick would go remote for 8 of the 15 other workers
+    std::printf("uniform victim choice: %.1f%% remote steals expected\n", 100.0 * 8.0 / 15.0);
+    {
+        w::base::thread_pool pool{ { .worker_count = workers, .pin_threads = false, .topology = simulated } };
+        BENCHMARK("tree 64k, simulated 2 socket topology")
+        {
+            run_tree(pool, 16);
+        };
+        pool.stop();
+        report_steal_locality("topology aware", pool);
+    }
+    {
+        w::base::thread_pool pool{ { .worker_count = workers, .pin_threads = false, .topology = w::base::cpu_topology::flat(workers) } };
+        BENCHMARK("tree 64k, flat topology")
+        {
+            run_tree(pool, 16);
+        };
+        pool.stop();
+    }
+
+    // real machine, threads pinned
+    auto detected = w::base::cpu_topology::detect();
+    if (detected.node_count() > 1) {
+        w::base::thread_pool pool{ { .worker_count = uint32_t(detected.cpu_count()), .topology = detected } };
+        BENCHMARK("tree 64k, detected topology")
+        {
+            run_tree(pool, 16);
+        };
+        pool.stop();
+        report_steal_locality("detected", pool);
+    }
+}
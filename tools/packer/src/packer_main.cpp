@@ -0,0 +1,58 @@
+#include <asset/package_writer.h>
+#include <charconv>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+// packer <input directory> <output package> [--lz4] [--align=N] [--chunk=N]
+int main(int argc, char** argv)
+{
+    std::span<char*> args(argv + 1, argc - 1);
+
+    std::string_view input;
+    std::string_view output;
+    auto codec = w::asset::compression::none;
+    uint32_t alignment = w::asset::package_writer::default_alignment;
+    uint32_t chunk_size = w::asset::package_writer::default_chunk_size;
+    auto parse = [](std::string_view arg, size_t prefix, uint32_t& value) {
+        return std::from_chars(arg.data() + prefix, arg.data() + arg.size(), value).ec == std::errc{};
+    };
+    for (std::string_view arg : args) {
+        if (arg == "--lz4") {
+            codec = w::asset::compression::lz4;
+        } else if (arg.starts_with("--align=")) {
+            if (!parse(arg, 8, alignment)) {
+                std::cerr << "Invalid alignment: " << arg.substr(8) << std::endl;
+                return -1;
+            }
+        } else if (arg.starts_with("--chunk=")) {
+            if (!parse(arg, 8, chunk_size)) {
+                std::cerr << "Invalid chunk size: " << arg.substr(8) << std::endl;
+                return -1;
+            }
+        } else if (input.empty()) {
+            input = arg;
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            std::cerr << "Unexpected argument: " << arg << std::endl;
+            return -1;
+        }
+    }
+    if (output.empty()) {
+        std::cerr << "Usage: packer <input directory> <output package> [--lz4] [--align=N] [--chunk=N]" << std::endl;
+        return -1;
+    }
+
+    w::asset::package_writer writer{ alignment, chunk_size };
+    if (auto result = writer.add_directory(input, codec); !result) {
+        std::cerr << "Could not collect " << input << ": " << result.message << std::endl;
+        return -1;
+    }
+    if (auto result = writer.write(output); !result) {
+        std::cerr << "Could not write " << output << ": " << result.message << std::endl;
+        return -1;
+    }
+    std::cout << "Packed " << writer.size() << " assets into " << output << std::endl;
+    return 0;
+}